@@ -66,6 +66,39 @@ OciConnection* OciConnection::CreateFromESqlContext(void* context)
 }
 #endif
 
+void StatementCache::lookup(const tstring &sql)
+{
+	std::map<tstring, std::list<tstring>::iterator>::iterator it = _keys.find(sql);
+	if (it != _keys.end())
+	{
+		++_hits;
+		_lru.splice(_lru.begin(), _lru, it->second);
+		return;
+	}
+	++_misses;
+	_lru.push_front(sql);
+	_keys[sql] = _lru.begin();
+	trim();
+}
+
+void StatementCache::remove(const tstring &sql)
+{
+	std::map<tstring, std::list<tstring>::iterator>::iterator it = _keys.find(sql);
+	if (it == _keys.end())
+		return;
+	_lru.erase(it->second);
+	_keys.erase(it);
+}
+
+void StatementCache::trim()
+{
+	while (_lru.size() > _size)
+	{
+		_keys.erase(_lru.back());
+		_lru.pop_back();
+	}
+}
+
 /// cancel a pending OCI call in the worker thread
 void OciConnection::cancel()
 {
@@ -38,6 +38,9 @@
 #include "trotl_export.h"
 #include "trotl_handle.h"
 
+#include <list>
+#include <map>
+
 namespace trotl
 {
 /// encapsulation of the OCIServer handle, used in OCIPL::OciLogin
@@ -352,6 +355,39 @@ protected:
 	bool	_connected;
 };
 
+/// client side statement cache (OCIStmtPrepare2/OCIStmtRelease) settings and counters
+/// the session must be started in OCI_STMT_CACHE mode
+struct TROTL_EXPORT StatementCache
+{
+	StatementCache()
+		: _size(0)
+		, _hits(0)
+		, _misses(0)
+	{}
+
+	bool enabled() const
+	{
+		return _size != 0;
+	}
+
+	/* Count a hit or a miss of OCIStmtPrepare2 for sql without another OCI call.
+	 * The statements are kept in LRU order, like OCI does with its cache of _size entries
+	 */
+	void lookup(const tstring &sql);
+	// statement released with OCI_STRLS_CACHE_DELETE
+	void remove(const tstring &sql);
+	// drop least recently used statements above _size
+	void trim();
+
+	ub4 _size;		// OCI_ATTR_STMTCACHESIZE, 0 = cache not used
+	unsigned long _hits;	// statement handle found in the cache
+	unsigned long _misses;	// statement was parsed
+
+private:
+	std::list<tstring> _lru;	// most recently used first
+	std::map<tstring, std::list<tstring>::iterator> _keys;
+};
+
 /// wrap OCIEnv and OCISvcCtx together
 struct TROTL_EXPORT OciConnection
 {
@@ -426,7 +462,18 @@ struct TROTL_EXPORT OciConnection
 #endif
 	}
 
-	//StatementCache	_stmt_cache; TODO
+	/* Enable statement cache of given size, the session must be started with OCI_STMT_CACHE mode
+	 * 0 disables the cache, statements are prepared by OCIStmtPrepare then
+	 */
+	void set_stmt_cache_size(ub4 size)
+	{
+		sword res = OCICALL(OCIAttrSet(_svc_ctx, OCI_HTYPE_SVCCTX, &size, 0, OCI_ATTR_STMTCACHESIZE, _env._errh));
+		oci_check_error(__TROTL_HERE__, _env._errh, res);
+		_stmt_cache._size = size;
+		_stmt_cache.trim();
+	}
+
+	StatementCache	_stmt_cache;
 
 private:
 	OciConnection(const OciConnection&);	// disallow copy constructor calls
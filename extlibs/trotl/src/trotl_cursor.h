@@ -62,7 +62,7 @@ public:
 	{
 	public:
 		CursorStatement(OciConnection& conn, OciHandle<OCIStmt> handle, ub4 lang=OCI_NTV_SYNTAX, int bulk_rows=g_OCIPL_BULK_ROWS)
-			: SqlStatement(conn, handle, bulk_rows)
+			: SqlStatement(conn, handle, lang, bulk_rows)
 		{
 			_stmt_type = STMT_SELECT;
 			_state |= PREPARED | DESCRIBED | EXECUTED;
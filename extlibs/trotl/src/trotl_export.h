@@ -48,11 +48,13 @@ namespace trotl
 // Todo this needs to be fixed on windows
 #if defined(TROTL_MAKE_DLL) || defined(__GNUC__)
 extern int TROTL_EXPORT g_OCIPL_BULK_ROWS;
+extern int TROTL_EXPORT g_OCIPL_MAX_BULK_ROWS;
 extern int TROTL_EXPORT g_OCIPL_MAX_LONG;
 extern const char TROTL_EXPORT *g_TROTL_DEFAULT_NUM_FTM;
 extern const char TROTL_EXPORT *g_TROTL_DEFAULT_DATE_FTM;
 #else
 int TROTL_EXPORT g_OCIPL_BULK_ROWS;
+int TROTL_EXPORT g_OCIPL_MAX_BULK_ROWS;
 int TROTL_EXPORT g_OCIPL_MAX_LONG;
 const char TROTL_EXPORT *g_TROTL_DEFAULT_NUM_FTM;
 const char TROTL_EXPORT *g_TROTL_DEFAULT_DATE_FTM;
@@ -46,6 +46,7 @@
 
 #include <algorithm>
 #include <cctype>       // std::toupper
+#include <chrono>
 #include <string>
 //#include <assert.h>
 
@@ -54,30 +55,35 @@ namespace trotl
 
 
 int TROTL_EXPORT g_OCIPL_BULK_ROWS = 256;
+int TROTL_EXPORT g_OCIPL_MAX_BULK_ROWS = 10000;
 int TROTL_EXPORT g_OCIPL_MAX_LONG = 0x20000; //128 KB
 const char TROTL_EXPORT *g_TROTL_DEFAULT_NUM_FTM = "TM";
 const char TROTL_EXPORT *g_TROTL_DEFAULT_DATE_FTM = "YYYY:MM:DD HH24:MI:SS";
 
 SqlStatement::SqlStatement(OciConnection& conn, const tstring& stmt, ub4 lang, int bulk_rows)
-	: super(conn._env),
+	: super(conn._env, NULL), // handle is allocated in prepare(), possibly by the statement cache
 //_svchp(conn._svc_ctx),
 	  _conn(conn),
 	  _lang(lang),
 	  _orig_stmt(stmt),
 	  _parsed_stmt(""),
 	  _state(UNINITIALIZED),
+	  _cached(false),
 	  _stmt_type(STMT_NONE),
 	  _param_count(0), _column_count(0),
 	  _in_cnt(0), _out_cnt(0),
 	  _last_row(-1),
 	  _last_fetched_row(-1),
 	  _in_pos(0), _out_pos(0), _iters(0),
-	  _last_buff_row(0), _buff_size(g_OCIPL_BULK_ROWS), _fetch_rows(g_OCIPL_BULK_ROWS),
+	  _last_buff_row(0), _buff_size(bulk_rows), _fetch_rows(bulk_rows),
+	  _fetch_generation(0), _fetch_nsecs(0),
+	  _bulk_memory(0), _bulk_max_rows(0),
+	  _prefetch_rows(0), _prefetch_memory(0),
+	  _batch_errors(false),
 	  _all_binds(NULL), _all_defines(NULL),
 	  _in_binds(NULL), _out_binds(NULL),
 	  _bound(false)
 //	_res(NULL),
-//	_bulk_rows(bulk_rows),
 //	_result_buffers(0),
 {
 	_errh.alloc(_env);
@@ -89,7 +95,9 @@ SqlStatement::SqlStatement(OciConnection& conn, const tstring& stmt, ub4 lang, i
 
 	_parsed_stmt= parser.getNonColored();
 
-	prepare(_parsed_stmt, lang);
+	try
+	{
+		prepare(_parsed_stmt, lang);
 
 // 	if(get_bindpar_count() != parser._bindvars.size())
 // 		throw_ocipl_exception(
@@ -97,55 +105,65 @@ SqlStatement::SqlStatement(OciConnection& conn, const tstring& stmt, ub4 lang, i
 // 					     ).arg(get_bindpar_count()).arg(parser._bindvars.size())
 // 		);
 
-	if(get_stmt_type() == STMT_SELECT)
-	{
-		execute_describe();
-	}
+		if(get_stmt_type() == STMT_SELECT)
+			execute_describe();
 
-	if(get_bindpar_count())
-	{
-		_all_binds = new std::unique_ptr<BindPar> [get_bindpar_count()+1];
-		_in_binds = new unsigned [get_bindpar_count()+1];
-		_out_binds = new unsigned [get_bindpar_count()+1];
-	}
+		if(get_bindpar_count())
+		{
+			_all_binds = new std::unique_ptr<BindPar> [get_bindpar_count()+1];
+			_in_binds = new unsigned [get_bindpar_count()+1];
+			_out_binds = new unsigned [get_bindpar_count()+1];
+		}
 
 
-	if( get_stmt_type() == STMT_SELECT ||
-	                get_stmt_type() == STMT_UPDATE ||
-	                get_stmt_type() == STMT_DELETE ||
-	                get_stmt_type() == STMT_INSERT ||
-	                get_stmt_type() == STMT_BEGIN  ||
-	                get_stmt_type() == STMT_DECLARE )
-	{
-		int ipos=1;
-		for(std::vector<BindVarDecl>::iterator it = parser._bindvars.begin(); it != parser._bindvars.end(); ++it, ++ipos)
+		if( get_stmt_type() == STMT_SELECT ||
+		                get_stmt_type() == STMT_UPDATE ||
+		                get_stmt_type() == STMT_DELETE ||
+		                get_stmt_type() == STMT_INSERT ||
+		                get_stmt_type() == STMT_BEGIN  ||
+		                get_stmt_type() == STMT_DECLARE )
 		{
-			if(it->inout == "in")
-			{
-				_in_binds[++_in_pos] = ipos;
-			}
-			else if(it->inout == "inout")
-			{
-				_in_binds[++_in_pos] = ipos;
-				_out_binds[++_out_pos] = ipos;
-			}
-			else if(it->inout == "out")
-			{
-				_out_binds[++_out_pos] = ipos;
-			}
-			else
+			int ipos=1;
+			for(std::vector<BindVarDecl>::iterator it = parser._bindvars.begin(); it != parser._bindvars.end(); ++it, ++ipos)
 			{
-				throw_oci_exception(OciException(__TROTL_HERE__, "Unsupported bindpar parameter: %s\n").arg(it->inout));
-			};
+				if(it->inout == "in")
+				{
+					_in_binds[++_in_pos] = ipos;
+				}
+				else if(it->inout == "inout")
+				{
+					_in_binds[++_in_pos] = ipos;
+					_out_binds[++_out_pos] = ipos;
+				}
+				else if(it->inout == "out")
+				{
+					_out_binds[++_out_pos] = ipos;
+				}
+				else
+				{
+					throw_oci_exception(OciException(__TROTL_HERE__, "Unsupported bindpar parameter: %s\n").arg(it->inout));
+				};
 
 
-			//Create BindPar instance, constructor takes two arguments (position, BindVarDecl&)
-			_all_binds[ipos] = BindParFactTwoParmSing::Instance().create(it->bindtype, ipos, *this, *it);
+				//Create BindPar instance, constructor takes two arguments (position, BindVarDecl&)
+				_all_binds[ipos] = BindParFactTwoParmSing::Instance().create(it->bindtype, ipos, *this, *it);
 
-			if ( _all_binds[ipos].get() == NULL )
-				throw_oci_exception(OciException(__TROTL_HERE__, "BindPar: Data type not registered: %s\n").arg(it->bindtype));
+				if ( _all_binds[ipos].get() == NULL )
+					throw_oci_exception(OciException(__TROTL_HERE__, "BindPar: Data type not registered: %s\n").arg(it->bindtype));
+			}
 		}
 	}
+	catch(...)
+	{
+		// destructor is not called, ~OciHandle must not free the cached handle
+		for(std::vector<DescribeColumn*>::iterator it = _columns.begin(); it != _columns.end(); ++it)
+			delete *it;
+		delete [] _all_binds;
+		delete [] _in_binds;
+		delete [] _out_binds;
+		release_handle(true);
+		throw;
+	}
 
 	_in_cnt = _in_pos;
 	_in_pos=0;
@@ -164,18 +182,22 @@ SqlStatement::SqlStatement(OciConnection& conn, OciHandle<OCIStmt>& handle, ub4
 	  _orig_stmt(""),
 	  _parsed_stmt(""),
 	  _state(UNINITIALIZED),
+	  _cached(false),
 	  _stmt_type(STMT_NONE),
 	  _param_count(0), _column_count(0),
 	  _in_cnt(0), _out_cnt(0),
 	  _last_row(-1),
 	  _last_fetched_row(-1),
 	  _in_pos(0), _out_pos(0), _iters(0),
-	  _last_buff_row(0), _buff_size(g_OCIPL_BULK_ROWS), _fetch_rows(g_OCIPL_BULK_ROWS),
+	  _last_buff_row(0), _buff_size(bulk_rows), _fetch_rows(bulk_rows),
+	  _fetch_generation(0), _fetch_nsecs(0),
+	  _bulk_memory(0), _bulk_max_rows(0),
+	  _prefetch_rows(0), _prefetch_memory(0),
+	  _batch_errors(false),
 	  _all_binds(NULL), _all_defines(NULL),
 	  _in_binds(NULL), _out_binds(NULL),
 	  _bound(false)
 //	_res(NULL),
-//	_bulk_rows(bulk_rows),
 //	_result_buffers(0),
 {
 	_errh.alloc(_env);
@@ -187,7 +209,26 @@ void SqlStatement::prepare(const tstring& sql, ub4 lang)
 	ub4 size = sizeof(stmt_type);
 	sword res;
 
-	res = OCICALL(OCIStmtPrepare(_handle/*stmtp*/, _errh, (text*)sql.c_str(), (ub4)sql.length(), lang, OCI_DEFAULT));
+	if (_conn._stmt_cache.enabled())
+	{
+		if (_handle)
+			destroy();
+		_conn._stmt_cache.lookup(sql);
+		res = OCICALL(OCIStmtPrepare2(_conn._svc_ctx, &_handle, _errh, (text*)sql.c_str(), (ub4)sql.length(),
+		                              NULL, 0, lang, OCI_DEFAULT));
+		_cached = res == OCI_SUCCESS || res == OCI_SUCCESS_WITH_INFO;
+		if (!_cached)
+		{
+			_handle = NULL;
+			_conn._stmt_cache.remove(sql);
+		}
+	}
+	else
+	{
+		if (!_handle)
+			alloc();
+		res = OCICALL(OCIStmtPrepare(_handle/*stmtp*/, _errh, (text*)sql.c_str(), (ub4)sql.length(), lang, OCI_DEFAULT));
+	}
 	check_error(__TROTL_HERE__, res);
 
 	/* NOTE this call alse returns other values than mentioned in OCI docs.
@@ -238,41 +279,99 @@ void SqlStatement::execute_describe()
 	_state |= DESCRIBED;
 }
 
+/* Memory allocated per row by OCI for descriptor based defines (LOB locators, rowids, objects, cursors),
+ * the define buffer holds just a pointer to it. The size is not known, a rough estimate is used.
+ */
+static const ub4 DESCRIPTOR_ROW_SIZE = 128;
+
+/* Size of define buffers for one row of a column (value, indicator and lengths) as allocated
+ * by its DefinePar constructor.
+ */
+static ub4 define_row_size(BindPar const &define)
+{
+	ub4 size = define.value_sz + sizeof(OCIInd) + sizeof(ub2) + (define.alenp ? sizeof(ub4) : 0);
+	switch(define.dty)
+	{
+	case SQLT_CLOB:
+	case SQLT_BLOB:
+	case SQLT_CFILEE:
+	case SQLT_BFILEE:
+	case SQLT_RDD:
+	case SQLT_RSET:
+	case SQLT_NTY:
+		return size + DESCRIPTOR_ROW_SIZE;
+	default:
+		return size;
+	}
+}
+
+static std::unique_ptr<BindPar> create_define(SqlStatement &stmt, unsigned dpos, DescribeColumn *dc)
+{
+	// Use column datatype for lookup in a hash table
+	// and call appropriate create function from the factory
+	std::unique_ptr<BindPar> retval;
+	if( dc->_data_type != SQLT_NTY)
+		retval = DefineParFactTwoParmSing::Instance().create(dc->_data_type, dpos, stmt, dc);
+	else
+		retval = CustDefineParFactTwoParmSing::Instance().create(dc->_reg_name.c_str(), dpos, stmt, dc);
+
+	if(retval.get() == NULL)
+		throw_oci_exception(OciException(__TROTL_HERE__, "DefinePar: Data type not registered: %s(%d:%d:%d:%s:%s)\n")
+		                    .arg(dc->_type_name)
+		                    .arg(dc->_data_type)
+		                    .arg(dc->_typecode)
+		                    .arg(dc->_collection_typecode)
+		                    .arg(dc->_collection_data_type)
+		                    .arg(dc->_reg_name)
+		                   );
+	return retval;
+}
+
+void SqlStatement::set_bulk_rows(ub4 rows)
+{
+	if(_state & DEFINED)
+		throw_oci_exception(OciException(__TROTL_HERE__, "Bulk size can not be changed after execute"));
+	_buff_size = _fetch_rows = std::max((ub4)1, rows);
+	_bulk_memory = 0;
+}
+
+void SqlStatement::set_bulk_memory(ub4 memory, ub4 max_rows)
+{
+	if(_state & DEFINED)
+		throw_oci_exception(OciException(__TROTL_HERE__, "Bulk size can not be changed after execute"));
+	_bulk_memory = memory;
+	_bulk_max_rows = std::max((ub4)1, max_rows);
+}
+
+void SqlStatement::set_prefetch(ub4 rows, ub4 memory)
+{
+	_prefetch_rows = rows;
+	_prefetch_memory = memory;
+}
+
 void SqlStatement::define_all()
 {
 	_columns.resize(get_column_count()+1);	// we do not use zero-th position
 	_all_defines= new std::unique_ptr<BindPar> [get_column_count()+1];
 
+	for(unsigned dpos = 1; dpos <= get_column_count(); ++dpos)
+		_columns[dpos] = new DescribeColumn(_conn, *this, dpos, "");
+
+	// Define buffers are allocated by DefinePar constructors, so the array size must be known
+	// before they are created. Create them for one row first to learn their row sizes.
+	if(_bulk_memory)
+	{
+		ub4 row_size = 0;
+		_buff_size = 1;
+		for(unsigned dpos = 1; dpos <= get_column_count(); ++dpos)
+			row_size += define_row_size(*create_define(*this, dpos, _columns[dpos]));
+		_buff_size = std::max((ub4)1, std::min(_bulk_max_rows, _bulk_memory / std::max((ub4)1, row_size)));
+		_fetch_rows = _buff_size;
+	}
+
 	for(unsigned dpos = 1; dpos <= get_column_count(); ++dpos)
 	{
-		DescribeColumn *dc = new DescribeColumn(_conn, *this, dpos, "");
-		_columns[dpos] = dc;
-
-		// Use column datatype for lookup in a hash table
-		// and call appropriate create function from the factory
-		if( _columns[dpos]->_data_type != SQLT_NTY)
-			_all_defines[dpos] = DefineParFactTwoParmSing::Instance().create(
-			                             _columns[dpos]->_data_type,
-			                             dpos,
-			                             *this,
-			                             dc
-			                     );
-		else
-			_all_defines[dpos] = CustDefineParFactTwoParmSing::Instance().create(
-			                             _columns[dpos]->_reg_name.c_str(),
-			                             dpos,
-			                             *this,
-			                             dc );
-
-		if(_all_defines[dpos].get() == NULL)
-			throw_oci_exception(OciException(__TROTL_HERE__, "DefinePar: Data type not registered: %s(%d:%d:%d:%s:%s)\n")
-			                    .arg(_columns[dpos]->_type_name)
-			                    .arg(_columns[dpos]->_data_type)
-			                    .arg(_columns[dpos]->_typecode)
-			                    .arg(_columns[dpos]->_collection_typecode)
-			                    .arg(_columns[dpos]->_collection_data_type)
-			                    .arg(_columns[dpos]->_reg_name)
-			                   );
+		_all_defines[dpos] = create_define(*this, dpos, _columns[dpos]);
 		define(*_all_defines[dpos]);
 
 		// When using piecewise callbacks fetch rows one by one
@@ -411,15 +510,23 @@ bool SqlStatement::execute_internal(ub4 rows, ub4 mode)
 
 	_state &= ~FETCHED & ~EOF_DATA & ~EOF_QUERY & ~STMT_ERROR; // Clear three flags
 
+	ub4 prefetch_rows = _prefetch_rows, prefetch_memory = _prefetch_memory;
 	//	TODO replace rows by something else - &FETCHED
-	if (rows==0 && get_stmt_type() == STMT_SELECT)
+	if (rows==0 && prefetch_rows == 0 && prefetch_memory == 0)
+	{
+		prefetch_memory = 1500;
+		//prefetch_rows = 10;
+		prefetch_rows = g_OCIPL_BULK_ROWS;
+	}
+	if ((prefetch_rows || prefetch_memory) && get_stmt_type() == STMT_SELECT)
 	{
 		// Optimizing of TCP packets by transfering multiple datasets in one packet
 		try
 		{
-			set_attribute(OCI_ATTR_PREFETCH_MEMORY, 1500);
-			//set_attribute(OCI_ATTR_PREFETCH_ROWS, 10);
-			set_attribute(OCI_ATTR_PREFETCH_ROWS, g_OCIPL_BULK_ROWS);
+			if (prefetch_memory)
+				set_attribute(OCI_ATTR_PREFETCH_MEMORY, prefetch_memory);
+			if (prefetch_rows)
+				set_attribute(OCI_ATTR_PREFETCH_ROWS, prefetch_rows);
 		}
 		catch(std::exception&)
 		{
@@ -442,17 +549,14 @@ bool SqlStatement::execute_internal(ub4 rows, ub4 mode)
 		break;
 	case STMT_UPDATE:
 	case STMT_MERGE:
-		_iters = 1;
-		break;
 	case STMT_DELETE:
-		_iters = 1;
-		break;
 	case STMT_INSERT:
 		_iters = 1;
 		if( _in_cnt == 0 )
 			break;
+		// array DML - the statement is executed once for each element of input vectors
 		_iters  = _all_binds[_in_binds[1]]->_cnt;
-		// Loop over input bind vars - insert can have out binds too(i.e. returning clause)
+		// Loop over input bind vars - DML can have out binds too(i.e. returning clause)
 		// and check vector lengths
 		for(unsigned i=1; i<=_in_cnt; ++i)
 			if(_all_binds[_in_binds[i]]->_cnt != _iters)
@@ -491,6 +595,13 @@ bool SqlStatement::execute_internal(ub4 rows, ub4 mode)
 	}
 	_bound = true;
 
+	_batch_error_rows.clear();
+	const bool batch_errors = _batch_errors && _iters > 1 &&
+	                          (get_stmt_type() == STMT_INSERT || get_stmt_type() == STMT_UPDATE ||
+	                           get_stmt_type() == STMT_DELETE || get_stmt_type() == STMT_MERGE);
+	if (batch_errors)
+		mode |= OCI_BATCH_ERRORS;
+
 	//define_all();
 
 	// execute and do not fetch
@@ -507,6 +618,7 @@ bool SqlStatement::execute_internal(ub4 rows, ub4 mode)
 
 	_state |= EXECUTED;
 	_last_row = _last_buff_row = 0;
+	++_fetch_generation;
 	if(get_stmt_type() == STMT_SELECT)
 	{
 		if((_state & DEFINED) == 0)
@@ -540,12 +652,49 @@ bool SqlStatement::execute_internal(ub4 rows, ub4 mode)
 			_state = (_state|EXECUTED) & ~FETCHED;
 		if(res != OCI_SUCCESS_WITH_INFO)
 			check_error(__TROTL_HERE__, res);
+		else if (batch_errors)
+			check_batch_errors();
 		return true;	// There may be more rows available to be fetched (for queries) or the DML statement succeeded.
 	}
 }
 
+void SqlStatement::check_batch_errors()
+{
+	ub4 errors = 0;
+	sword res = OCICALL(OCIAttrGet(_handle, get_type_id(), &errors, NULL, OCI_ATTR_NUM_DML_ERRORS, _errh));
+	oci_check_error(__TROTL_HERE__, _errh, res);
+	if (errors == 0)
+		return;
+
+	// each failing iteration has its own error handle, the first one is thrown
+	OciError batch_errh;
+	batch_errh.alloc(_conn._env);
+	std::unique_ptr<OciException> first;
+	ub4 first_row = 0;
+	for (ub4 i = 0; i < errors; ++i)
+	{
+		OCIError *row_errh = batch_errh;
+		ub4 row_offset = 0;
+		res = OCICALL(OCIParamGet(_errh, OCI_HTYPE_ERROR, _errh, (dvoid**)&row_errh, i));
+		oci_check_error(__TROTL_HERE__, _errh, res);
+		res = OCICALL(OCIAttrGet(row_errh, OCI_HTYPE_ERROR, &row_offset, NULL, OCI_ATTR_DML_ROW_OFFSET, _errh));
+		oci_check_error(__TROTL_HERE__, _errh, res);
+		if (!first || row_offset < first_row)
+		{
+			first_row = row_offset;
+			first.reset(new OciException(__TROTL_HERE__, row_errh));
+		}
+		_batch_error_rows.push_back(row_offset);
+	}
+	std::sort(_batch_error_rows.begin(), _batch_error_rows.end());
+	_state |= STMT_ERROR;
+	throw_oci_exception(*first);
+}
+
 void SqlStatement::fetch(ub4 rows/*=-1*/)
 {
+	++_fetch_generation;
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 	sword res = OCICALL(OCIStmtFetch(_handle, _errh, rows, OCI_FETCH_NEXT, OCI_DEFAULT));
 
 	while (res == OCI_NEED_DATA)
@@ -595,6 +744,7 @@ void SqlStatement::fetch(ub4 rows/*=-1*/)
 		if(res == OCI_NEED_DATA || res == OCI_NO_DATA || res == OCI_SUCCESS || res == OCI_SUCCESS_WITH_INFO)
 			BPp->fetch_hook(iter, idx, piece, alen, indptr);
 	}
+	_fetch_nsecs += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
 
 	switch(res)
 	{
@@ -739,9 +889,23 @@ SqlStatement::~SqlStatement()
 		delete [] _in_binds;
 		delete [] _out_binds;
 	}
+
+	// statements which failed are not worth keeping in the cache
+	release_handle((_state & STMT_ERROR) != 0);
 	_state |= 0xff;
 };
 
+void SqlStatement::release_handle(bool drop)
+{
+	if (!_cached || !_handle)
+		return;
+	OCICALL(OCIStmtRelease(_handle, _errh, NULL, 0, drop ? OCI_STRLS_CACHE_DELETE : OCI_DEFAULT));
+	if (drop)
+		_conn._stmt_cache.remove(_parsed_stmt);
+	_handle = NULL; // do not call OCIHandleFree in ~OciHandle
+	_cached = false;
+}
+
 template<>
 SqlStatement& SqlStatement::operator<< <int>(const int &val)
 {
@@ -94,7 +94,40 @@ public:
 
 	bool execute_internal(ub4 rows, ub4 mode);
 	ub4 row_count() const;
+
+	/*** array fetch tuning for SELECT statements, must be called before the statement is executed */
+	// rows fetched by one OCIStmtFetch call (size of define buffers)
+	void set_bulk_rows(ub4 rows);
+	// size define buffers from described column widths, so they fit into memory budget (bytes)
+	void set_bulk_memory(ub4 memory, ub4 max_rows = g_OCIPL_MAX_BULK_ROWS);
+	// OCI_ATTR_PREFETCH_ROWS and OCI_ATTR_PREFETCH_MEMORY, 0 = leave OCI default
+	void set_prefetch(ub4 rows, ub4 memory);
+	ub4 get_bulk_rows() const
+	{
+		return _buff_size;
+	};
 	ub4 fetched_rows() const;
+	/*** array DML: with batch errors all the iterations are executed (OCI_BATCH_ERRORS),
+	 * the failing ones are listed by get_batch_error_rows() and the first error is thrown */
+	void set_batch_errors(bool batch_errors)
+	{
+		_batch_errors = batch_errors;
+	};
+	// iterations (from 0) of the last array DML which failed
+	const std::vector<ub4>& get_batch_error_rows() const
+	{
+		return _batch_error_rows;
+	};
+	// bumped whenever the define buffers are refilled (execute or fetch)
+	unsigned get_fetch_generation() const
+	{
+		return _fetch_generation;
+	};
+	// total time spent in OCIStmtFetch round trips (ns)
+	unsigned long long get_fetch_nsecs() const
+	{
+		return _fetch_nsecs;
+	};
 
 	inline STMT_TYPE get_stmt_type() const
 	{
@@ -310,6 +343,11 @@ protected:
 	void define_all();
 
 	void check_error(tstring where, sword res) const;
+	// collect OCI_BATCH_ERRORS of array DML, throws the error of the first failing iteration
+	void check_batch_errors();
+
+	/* return statement handle into _conn._stmt_cache (drop=false) or remove it from the cache */
+	void release_handle(bool drop);
 
 public:	//todo delete me - these fields should not be public
 	inline void pre_read_value()
@@ -352,11 +390,18 @@ public:	//todo delete me - these fields should not be public
 	mutable tstring _parsed_stmt;
 
 	unsigned _state;
+	bool _cached;	// handle was got from _conn._stmt_cache, it is released by OCIStmtRelease
 	STMT_TYPE _stmt_type;
 	mutable ub4 _param_count, _column_count, _in_cnt, _out_cnt;
 	ub4 _last_row, _last_fetched_row, _in_pos, _out_pos, _iters;
 
 	ub4 _last_buff_row, _buff_size, _fetch_rows; // used in select statements
+	unsigned _fetch_generation;
+	unsigned long long _fetch_nsecs;
+	ub4 _bulk_memory, _bulk_max_rows;            // automatic _buff_size (0 = fixed size)
+	ub4 _prefetch_rows, _prefetch_memory;
+	bool _batch_errors;
+	std::vector<ub4> _batch_error_rows;
 
 	std::vector<DescribeColumn*> _columns; // TODO move into some SQL-result class
 
@@ -421,8 +421,8 @@ BindPar::BindPar(unsigned int pos, SqlStatement &stmt, DescribeColumn *ct)
 	, _env(stmt._env)
 	, _stmt(stmt)
 	, _pos(pos)
-	, _max_cnt(g_OCIPL_BULK_ROWS)
-	, _cnt(g_OCIPL_BULK_ROWS)
+	, _max_cnt(stmt._buff_size)
+	, _cnt(stmt._buff_size)
 	, _bound(false)
 	, _type_name("")
 	, _reg_name("")
@@ -67,6 +67,7 @@ namespace ToConfiguration
                 , RefConstraintsBool
                 , ConstraintsAsAlterBool
                 , XPlanFormat
+                , StatementCacheInt        // size of OCI client side statement cache (per session), 0 = disabled
             };
             virtual QVariant defaultValue(int option) const;
             static QString planTable(QString const& schema);
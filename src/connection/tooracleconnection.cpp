@@ -84,6 +84,7 @@ toConnectionSub* toOracleConnectionImpl::createConnection(void)
     QString oldSid;
 
     QSet<QString> options = parentConnection().options();
+    int stmtCacheSize = toConfigurationNewSingle::Instance().option(ToConfiguration::Oracle::StatementCacheInt).toInt();
 
     bool sqlNet = (options.find("SQL*Net") != options.end());
     if (!sqlNet)
@@ -102,6 +103,8 @@ toConnectionSub* toOracleConnectionImpl::createConnection(void)
         else if (options.find("SYS_ASM") != options.end())
             session_mode = OCI_SYSASM;
 #endif
+        if (stmtCacheSize > 0)
+            session_mode |= OCI_STMT_CACHE;
 
         do
         {
@@ -211,6 +214,18 @@ toConnectionSub* toOracleConnectionImpl::createConnection(void)
         }
     }
 
+    if (stmtCacheSize > 0)
+    {
+        try
+        {
+            conn->set_stmt_cache_size(stmtCacheSize);
+        }
+        catch (::trotl::OciException const& e)
+        {
+            TLOG(5, toDecorator, __HERE__) << "Failed to set statement cache size:\n" << e.what();
+        }
+    }
+
     try
     {
         QString alterSessionSQL = QString::fromLatin1("ALTER SESSION SET NLS_DATE_FORMAT = '");
@@ -311,6 +326,17 @@ void toOracleConnectionSub::cancel()
 
 void toOracleConnectionSub::close()
 {
+    delete _hasTransactionStat;
+    _hasTransactionStat = NULL;
+    try
+    {
+        _login->disconnect();
+    }
+    catch (const ::trotl::OciException &exc)
+    {
+        TLOG(5, toDecorator, __HERE__) << "Logoff failed: " << exc.what() << std::endl;
+    }
+    Broken = true;
 }
 
 void toOracleConnectionSub::commit()
@@ -359,6 +385,29 @@ toQueryParams toOracleConnectionSub::sessionId()
     return retval << _login->sid() << _login->serial();
 }
 
+bool toOracleConnectionSub::ping()
+{
+    try
+    {
+        _conn->ping();
+    }
+    catch (const ::trotl::OciException &exc)
+    {
+        TLOG(5, toDecorator, __HERE__) << "Ping failed: " << exc.what() << std::endl;
+        Broken = true;
+    }
+    return !Broken;
+}
+
+QString toOracleConnectionSub::statistics()
+{
+    if (!_conn->_stmt_cache.enabled())
+        return QString();
+    return QObject::tr("Statement cache hits: %1 misses: %2")
+           .arg(_conn->_stmt_cache._hits)
+           .arg(_conn->_stmt_cache._misses);
+}
+
 bool toOracleConnectionSub::hasTransaction()
 {
     // NOTE: do not use OCI_ATTR_TRANSACTION_IN_PROGRESS, it is Oracle 12c feature
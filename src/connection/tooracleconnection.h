@@ -94,6 +94,8 @@ class toOracleConnectionSub: public toConnectionSub
         QString version() override;
         toQueryParams sessionId() override;
         bool hasTransaction() override;
+        bool ping() override;
+        QString statistics() override;
         queryImpl* createQuery(toQueryAbstr *query) override;
 
         toQAdditionalDescriptions* decribe(toCache::ObjectRef const&) override;
@@ -0,0 +1,196 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "connection/tooraclenumber.h"
+
+#include <limits>
+
+namespace
+{
+    // exact powers of ten representable by double
+    const double POW10[] =
+    {
+        1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+        1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+    };
+
+    // mantissa (integer) must be exact in double
+    const quint64 MAX_REAL_MANTISSA = Q_UINT64_C(1) << 53;
+    const unsigned MAX_REAL_DIGITS = 8;
+
+    /* Split the OCINumber into sign, exponent and mantissa digits (0..99)
+     * @return number of mantissa digits or -1 for invalid numbers (and infinities)
+     */
+    inline int unpack(unsigned char const *num, bool &negative, int &exponent, unsigned char *digits)
+    {
+        unsigned len = num[0];
+        if (len < 2 || len > 21)
+            return -1;
+
+        unsigned char exp = num[1];
+        unsigned char const *m = num + 2;
+        unsigned count = len - 1;
+
+        negative = (exp & 0x80) == 0;
+        if (negative)
+        {
+            exponent = ((~exp) & 0x7F) - 65;
+            if (m[count - 1] == 102)
+                count--;
+            for (unsigned i = 0; i < count; i++)
+            {
+                digits[i] = 101 - m[i];
+                if (m[i] < 2 || m[i] > 101)
+                    return -1;
+            }
+        }
+        else
+        {
+            if (exp == 0xFF) // +infinity
+                return -1;
+            exponent = (exp & 0x7F) - 65;
+            for (unsigned i = 0; i < count; i++)
+            {
+                digits[i] = m[i] - 1;
+                if (m[i] < 1 || m[i] > 100)
+                    return -1;
+            }
+        }
+        return count == 0 ? -1 : (int)count;
+    }
+}
+
+toOracleNumber::Kind toOracleNumber::decode(unsigned char const *num, Cell &cell)
+{
+    if (num[0] == 1 && num[1] == 0x80)
+    {
+        cell.Type = Integer;
+        cell.Int = 0;
+        return Integer;
+    }
+
+    bool negative;
+    int exponent;
+    unsigned char digits[20];
+    int count = unpack(num, negative, exponent, digits);
+    if (count < 0)
+        return cell.Type = Unsupported;
+
+    // number of base-100 digits after the decimal point
+    int scale = count - 1 - exponent;
+    if (scale <= 0)
+    {
+        // qint64 has at most 10 base-100 digits in integral part
+        if (exponent > 9)
+            return cell.Type = Decimal;
+
+        quint64 acc = 0;
+        for (int i = 0; i <= exponent; i++)
+        {
+            unsigned d = i < count ? digits[i] : 0;
+            if (acc > (std::numeric_limits<quint64>::max() - d) / 100)
+                return cell.Type = Decimal;
+            acc = acc * 100 + d;
+        }
+        quint64 limit = (quint64)std::numeric_limits<qint64>::max() + (negative ? 1 : 0);
+        if (acc > limit)
+            return cell.Type = Decimal;
+        cell.Int = negative ? (qint64)(0 - acc) : (qint64)acc;
+        return cell.Type = Integer;
+    }
+
+    if ((unsigned)count > MAX_REAL_DIGITS || 2 * scale > 22)
+        return cell.Type = Unsupported;
+
+    quint64 mantissa = 0;
+    for (int i = 0; i < count; i++)
+        mantissa = mantissa * 100 + digits[i];
+    if (mantissa > MAX_REAL_MANTISSA)
+        return cell.Type = Unsupported;
+    // one correctly rounded division of two exact values
+    double d = (double)mantissa / POW10[2 * scale];
+    cell.Real = negative ? -d : d;
+    return cell.Type = Real;
+}
+
+void toOracleNumber::decodeColumn(unsigned char const *buffer, size_t stride, unsigned count, Cell *out)
+{
+    for (unsigned i = 0; i < count; i++, buffer += stride)
+        decode(buffer, out[i]);
+}
+
+toOracleNumber::Cell const& toOracleNumber::ColumnCache::at(unsigned generation, unsigned row, unsigned char const *buffer, size_t stride, unsigned count)
+{
+    if (!Valid || Generation != generation)
+    {
+        Cells.resize(count);
+        if (count)
+            decodeColumn(buffer, stride, count, Cells.data());
+        Generation = generation;
+        Valid = true;
+    }
+    Q_ASSERT(row < Cells.size());
+    return Cells[row];
+}
+
+bool toOracleNumber::toText(unsigned char const *num, char *text)
+{
+    if (num[0] == 1 && num[1] == 0x80)
+    {
+        text[0] = '0';
+        text[1] = '\0';
+        return true;
+    }
+
+    bool negative;
+    int exponent;
+    unsigned char digits[20];
+    int count = unpack(num, negative, exponent, digits);
+    // sign + 2 chars per digit + terminator
+    if (count < 0 || count - 1 > exponent || 2 * (exponent + 1) + 2 > (int)TEXT_SIZE)
+        return false;
+
+    char *p = text;
+    if (negative)
+        *p++ = '-';
+    for (int i = 0; i <= exponent; i++)
+    {
+        unsigned d = i < count ? digits[i] : 0;
+        if (i > 0 || d >= 10) // no leading zero
+            *p++ = '0' + d / 10;
+        *p++ = '0' + d % 10;
+    }
+    *p = '\0';
+    return true;
+}
@@ -0,0 +1,108 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#pragma once
+
+#include <QtCore/QtGlobal>
+
+#include <cstddef>
+#include <vector>
+
+/** Decoder of Oracle NUMBER internal format (as stored in OCINumber define buffers).
+ *
+ * OCINumber is 22 bytes: length, exponent byte and up to 20 base-100 mantissa digits.
+ * Positive numbers: exponent byte 0xC1 + e, digits stored as d+1.
+ * Negative numbers: exponent byte 0x3E - e, digits stored as 101-d, optionally terminated by 102.
+ * Zero is a single byte 0x80, infinities are 0x00 and 0xFF 0x65.
+ *
+ * The decoder handles common cases without any OCI call, everything else (infinities,
+ * reals which can not be converted exactly, huge numbers) is reported as Unsupported
+ * and the caller has to use OCINumberTo* functions.
+ */
+namespace toOracleNumber
+{
+    enum Kind
+    {
+        Integer,     // fits into qint64
+        Real,        // converted to double (correctly rounded)
+        Decimal,     // integer out of qint64 range, use toText()
+        Unsupported  // use OCI
+    };
+
+    struct Cell
+    {
+        Kind Type;
+        union
+        {
+            qint64 Int;
+            double Real;
+        };
+    };
+
+    /** Size of the buffer for toText() */
+    static const size_t TEXT_SIZE = 48;
+
+    /** Decode one OCINumber.
+     * @param num pointer to OCINumber bytes
+     * @return Kind of the result, cell.Int or cell.Real is set for Integer and Real
+     */
+    Kind decode(unsigned char const *num, Cell &cell);
+
+    /** Decode count OCINumbers stored stride bytes apart in a define buffer (null cells are decoded too,
+     * the caller checks indicators)
+     */
+    void decodeColumn(unsigned char const *buffer, size_t stride, unsigned count, Cell *out);
+
+    /** Write decimal representation of an integer OCINumber (Integer or Decimal kind).
+     * @return false if the number is not an integer or does not fit into TEXT_SIZE
+     */
+    bool toText(unsigned char const *num, char *text);
+
+    /** Decoded copy of one define buffer column.
+     * The column is decoded at once when a row of a new fetch is read. The fetch is identified by
+     * a generation number the statement bumps on every OCIStmtFetch, so a chunk is never mistaken
+     * for the previous one, even when its first row is null or it is not longer than the previous one.
+     */
+    class ColumnCache
+    {
+        public:
+            ColumnCache() : Generation(0), Valid(false) {}
+
+            Cell const& at(unsigned generation, unsigned row, unsigned char const *buffer, size_t stride, unsigned count);
+        private:
+            std::vector<Cell> Cells;
+            unsigned Generation;
+            bool Valid;
+    };
+}
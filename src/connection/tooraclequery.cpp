@@ -72,6 +72,15 @@ void oracleQuery::execute(void)
         Query = new oracleQuery::trotlQuery(*conn->_conn, ::std::string(sql.toUtf8().constData()));
         TLOG(0, toDecorator, __HERE__) << "SQL(conn=" << conn->_conn << ", this=" << Query << "): " << ::std::string(sql.toUtf8().constData()) << std::endl;
         conn->_hasTransaction = toOracleConnectionSub::DIRTY_FLAG;
+
+        // array fetch hints, the statement is executed with the last bind variable (below)
+        toQueryAbstr::FetchOptions const& options = query()->fetchOptions();
+        if (options.BulkRows)
+            Query->set_bulk_rows(options.BulkRows);
+        else if (options.MemoryBudget)
+            Query->set_bulk_memory(options.MemoryBudget);
+        if (options.PrefetchRows || options.PrefetchMemory)
+            Query->set_prefetch(options.PrefetchRows, options.PrefetchMemory);
         // TODO autocommit ??
         // Query->set_commit(0);
     }
@@ -175,6 +184,69 @@ void oracleQuery::execute(void)
     }
 }
 
+void oracleQuery::executeArray(QList<toQueryParams> const &rows)
+{
+    toOracleConnectionSub *conn = dynamic_cast<toOracleConnectionSub*>(query()->connectionSubPtr());
+    if (!conn)
+        throw QString::fromLatin1("Internal error, not an Oracle sub connection");
+    try
+    {
+        if (Query) delete Query;
+        Query = NULL;
+
+        if (Cancel)
+            throw QString::fromLatin1("Query aborted before started");
+        Running = true;
+
+        QString sql = this->query()->sql();
+        sql.remove('\r');
+
+        Query = new oracleQuery::trotlQuery(*conn->_conn, ::std::string(sql.toUtf8().constData()));
+        TLOG(0, toDecorator, __HERE__) << "SQL(conn=" << conn->_conn << ", this=" << Query << ", rows=" << rows.size() << "): "
+                                       << ::std::string(sql.toUtf8().constData()) << std::endl;
+        conn->_hasTransaction = toOracleConnectionSub::DIRTY_FLAG;
+        // execute all the rows, the failing ones are reported by OCI_ATTR_DML_ROW_OFFSET
+        Query->set_batch_errors(true);
+
+        // bind variable columns, the statement is executed with the last one
+        int columns = rows.isEmpty() ? 0 : rows.first().size();
+        for (int c = 0; c < columns; c++)
+        {
+            std::vector< ::trotl::tstring> values;
+            values.reserve(rows.size());
+            Q_FOREACH(toQueryParams const &row, rows)
+                values.push_back(::trotl::tstring(((QString) row.at(c)).toUtf8().constData()));
+            (*Query) << values;
+        }
+    }
+    catch (const ::trotl::OciException &exc)
+    {
+        TLOG(0, toDecorator, __HERE__)
+                << "What:" << exc.what() << std::endl
+                << exc.get_sql() << std::endl
+                << "--------------------------------------------------------------------------------"
+                << std::endl;
+        // index of the first failing row (iteration) of the array
+        int failed = -1;
+        if (Query && !Query->get_batch_error_rows().empty())
+            failed = Query->get_batch_error_rows().front();
+        delete Query;
+        Query = NULL;
+        Running = false;
+        if (exc.is_critical())
+            conn->Broken = true;
+        try
+        {
+            ReThrowException(exc);
+        }
+        catch (toConnection::exception &e)
+        {
+            e.setRow(failed);
+            throw;
+        }
+    }
+}
+
 void oracleQuery::execute(QString const& sql)
 {
     toOracleConnectionSub *conn = dynamic_cast<toOracleConnectionSub*>(query()->connectionSubPtr());
@@ -227,6 +299,31 @@ toQValue oracleQuery::readValue(void)
     }
 }
 
+unsigned oracleQuery::readBatch(toQueryBatch &batch, unsigned rows)
+{
+    if (!Query || Query->get_stmt_type() != ::trotl::SqlStatement::STMT_SELECT)
+        return queryImpl::readBatch(batch, rows);
+
+    toOracleConnectionSub *conn = dynamic_cast<toOracleConnectionSub*>(query()->connectionSubPtr());
+    unsigned row = 0;
+    try
+    {
+        for (; row < rows && !eof(); row++)
+            for (unsigned i = 0; i < batch.columns(); i++)
+                Query->readCell(batch);
+        return row;
+    }
+    catch (const ::trotl::OciException &exc)
+    {
+        delete Query;
+        Query = NULL;
+        Running = false;
+        if (exc.is_critical())
+            conn->Broken = true;
+        ReThrowException(exc);
+    }
+}
+
 void oracleQuery::cancel(void)
 {
     toOracleConnectionSub *conn = dynamic_cast<toOracleConnectionSub*>(query()->connectionSubPtr());
@@ -296,13 +393,80 @@ oracleQuery::trotlQuery::trotlQuery(::trotl::OciConnection &conn,
         execute_internal(::trotl::g_OCIPL_BULK_ROWS, OCI_DEFAULT);
 };
 
+toOracleNumber::Cell const& oracleQuery::trotlQuery::decodedNumber(::trotl::BindPar const &BP)
+{
+    if (DecodedNumbers.size() <= BP._pos)
+        DecodedNumbers.resize(_column_count + 1);
+
+    // decode the whole define buffer column once per fetched chunk
+    return DecodedNumbers[BP._pos].at(get_fetch_generation(), _last_buff_row,
+                                      (unsigned char const*)BP.valuep, BP.value_sz, fetched_rows());
+}
+
 void oracleQuery::trotlQuery::readValue(toQValue &value)
 {
     pre_read_value();
     trotl::BindPar const &BP(get_stmt_type() == STMT_SELECT ?
                              get_next_column() :
                              get_next_out_bindpar());
+    valueOf(BP, value);
+    post_read_value(BP);
+}
 
+void oracleQuery::trotlQuery::readCell(toQueryBatch &batch)
+{
+    pre_read_value();
+    trotl::BindPar const &BP(get_next_column());
+
+    if (BP._bind_type == BP.DEFINE_SELECT && BP.dty != SQLT_NTY)
+    {
+        if (BP.is_null(_last_buff_row))
+        {
+            batch.appendNull();
+            post_read_value(BP);
+            return;
+        }
+        switch (BP.dty)
+        {
+            case SQLT_NUM:
+            case SQLT_VNU:
+                {
+                    toOracleNumber::Cell const &cell = decodedNumber(BP);
+                    if (cell.Type == toOracleNumber::Integer)
+                    {
+                        batch.appendInt(cell.Int, true);
+                        post_read_value(BP);
+                        return;
+                    }
+                    if (cell.Type == toOracleNumber::Real)
+                    {
+                        batch.appendDouble(cell.Real);
+                        post_read_value(BP);
+                        return;
+                    }
+                }
+                break;
+            case SQLT_STR:
+                {
+                    // BindParVarchar: null terminated UTF-8, value_sz bytes per row
+                    char const *str = (char const*)BP.valuep + _last_buff_row * BP.value_sz;
+                    batch.appendUtf8(str, qstrnlen(str, BP.value_sz));
+                    post_read_value(BP);
+                }
+                return;
+            default:
+                break;
+        }
+    }
+
+    toQValue value;
+    valueOf(BP, value);
+    batch.append(value);
+    post_read_value(BP);
+}
+
+void oracleQuery::trotlQuery::valueOf(::trotl::BindPar const &BP, toQValue &value)
+{
     if (BP.is_null(_last_buff_row) && BP.dty != SQLT_NTY)
     {
         value = toQValue();
@@ -316,6 +480,30 @@ void oracleQuery::trotlQuery::readValue(toQValue &value)
             case SQLT_VNU:
                 {
                     OCINumber* vnu = (OCINumber*) & ((char*)BP.valuep)[_last_buff_row * BP.value_sz ];
+                    toOracleNumber::Cell cell;
+                    if (get_stmt_type() == STMT_SELECT && BP._bind_type == BP.DEFINE_SELECT)
+                        cell = decodedNumber(BP);
+                    else
+                        toOracleNumber::decode((unsigned char const*)vnu, cell);
+
+                    if (cell.Type == toOracleNumber::Integer)
+                    {
+                        value = toQValue((qlonglong)cell.Int);
+                        break;
+                    }
+                    if (cell.Type == toOracleNumber::Real)
+                    {
+                        value = toQValue(cell.Real);
+                        break;
+                    }
+                    char text[toOracleNumber::TEXT_SIZE];
+                    if (cell.Type == toOracleNumber::Decimal && toOracleNumber::toText((unsigned char const*)vnu, text))
+                    {
+                        value = toQValue(QString::fromLatin1(text));
+                        break;
+                    }
+
+                    // edge cases (infinities, reals not exact in double, huge numbers) are converted by OCI
                     sword res;
                     boolean isint;
                     res = OCINumberIsInt(_errh, vnu, &isint);
@@ -478,6 +666,4 @@ void oracleQuery::trotlQuery::readValue(toQValue &value)
                 break;
         }
     }
-
-    post_read_value(BP);
 }
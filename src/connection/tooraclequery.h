@@ -44,6 +44,7 @@
 #include "core/toqueryimpl.h"
 #include "connection/tooracleconnection.h"
 #include "connection/tooracledatatype.h"
+#include "connection/tooraclenumber.h"
 
 #include "trotl.h"
 #include "trotl_convertor.h"
@@ -62,6 +63,18 @@ class oracleQuery : public queryImpl
                 trotlQuery(::trotl::OciConnection &conn, const ::trotl::tstring &stmt, ub4 lang = OCI_NTV_SYNTAX, int bulk_rows =::trotl::g_OCIPL_BULK_ROWS);
 
                 void readValue(toQValue &value);
+
+                /** Append the next cell of a SELECT into batch, numbers and strings are copied
+                 * straight from the define buffers without boxing into toQValue */
+                void readCell(toQueryBatch &batch);
+
+            private:
+                void valueOf(::trotl::BindPar const &BP, toQValue &value);
+
+                // NUMBER column of the current define buffer decoded by toOracleNumber
+                toOracleNumber::Cell const& decodedNumber(::trotl::BindPar const &BP);
+
+                std::vector<toOracleNumber::ColumnCache> DecodedNumbers;
         };
         trotlQuery * Query;
 
@@ -73,8 +86,19 @@ class oracleQuery : public queryImpl
 
         virtual void execute(QString const&);
 
+        virtual void executeArray(QList<toQueryParams> const &rows);
+
         virtual toQValue readValue(void);
 
+        virtual unsigned readBatch(toQueryBatch &batch, unsigned rows);
+
+        virtual qint64 fetchNsecs(void)
+        {
+            if (!Query)
+                return -1;
+            return Query->get_fetch_nsecs();
+        }
+
         virtual void cancel(void);
 
         virtual bool eof(void);
@@ -63,6 +63,15 @@ static toSQL SQLListObjectInSchema("toConnection:ListObjectsInSchema",
                                    , "0800"
                                    , "Oracle");
 
+static toSQL SQLListSchemaSignatures("toConnection:ListSchemaSignatures",
+                                     "select owner,\n"
+                                     "       to_char(max(last_ddl_time), 'YYYYMMDDHH24MISS') || ':' || count(*)\n"
+                                     "  from sys.all_objects\n"
+                                     " group by owner\n"
+                                     , "Per schema signature of cached objects, changes when an object is created, altered or dropped"
+                                     , "0800"
+                                     , "Oracle");
+
 /*
 ** 11g version, see $ORACLE_HOME/rdbms/admin/utlxplan.sql
 */
@@ -74,5 +74,10 @@ class toOracleTraits: public toConnectionTraits
             return true;
         }
 
+        bool hasArrayDML() const override
+        {
+            return true;
+        }
+
         QList<QString> primaryKeys(toConnection &, toCache::ObjectRef const&) const override;
 };
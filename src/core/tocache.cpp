@@ -38,6 +38,7 @@
 #include "core/toconnectionsub.h"
 #include "core/toconnectionsubloan.h"
 #include "core/toquery.h"
+#include "core/toquerybatch.h"
 #include "core/tosql.h"
 #include "core/toraversion.h"
 #include "core/utils.h"
@@ -47,78 +48,261 @@
 
 #include <QtCore/QtDebug>
 #include <QtCore/QDir>
+#include <QtCore/QFile>
+#include <QtCore/QVector>
 #include <QtCore/QDateTime>
 #include <QtCore/QTextStream>
-#include <QtCore/QDataStream>
 #include <QtCore/QMutexLocker>
 #include <QtCore/QThread>
 #include <QProgressDialog>
+
+#include <algorithm>
+#include <cstring>
 //#include <boost/preprocessor/iteration/detail/local.hpp>
 
+namespace
+{
+    // rows of ListObjectsInDatabase (and disk cache entries) added into toCache::BulkLoad at once
+    const unsigned CACHE_BATCH_ROWS = 4096;
+
+    /* Disk cache file layout, the file is memory mapped when loaded:
+     *   DiskHeader, DiskSchema[SchemaCount], DiskEntry[EntryCount], DiskString[UserCount], QChar[CharCount]
+     * Strings are (offset, length) in QChars into the pool at the end of the file.
+     * Entries of each schema are stored together. Bump DISK_FORMAT when the layout changes.
+     */
+    const char DISK_MAGIC[8] = { 'T', 'O', 'R', 'A', 'C', 'A', 'C', 'H' };
+    const quint32 DISK_FORMAT = 2;
+    const quint32 DISK_BYTE_ORDER = 0x01020304;
+    const quint32 DISK_OWNERS_READ = 1;
+    const quint32 DISK_USERS_READ = 2;
+
+    struct DiskHeader
+    {
+        char Magic[8];
+        quint32 Format;
+        quint32 ByteOrder;
+        quint32 State;
+        quint32 Flags;
+        quint32 SchemaCount;
+        quint32 EntryCount;
+        quint32 UserCount;
+        quint32 CharCount;
+        qint64 Written;           // ms since epoch
+    };
+
+    struct DiskString
+    {
+        quint32 Offset;
+        quint32 Length;
+
+        bool valid(quint32 chars) const
+        {
+            return Offset <= chars && Length <= chars - Offset;
+        }
+
+        QString toString(QChar const *pool) const
+        {
+            return QString(pool + Offset, Length);
+        }
+    };
+
+    struct DiskSchema
+    {
+        DiskString Name;
+        DiskString Signature;     // see toConnection:ListSchemaSignatures
+        quint32 FirstEntry;
+        quint32 Entries;
+    };
+
+    struct DiskEntry
+    {
+        DiskString Name;
+        DiskString Comment;
+        quint32 Schema;           // index of DiskSchema
+        quint32 Type;             // toCache::CacheEntryType
+    };
+
+    DiskString poolString(QString &pool, QString const &str)
+    {
+        DiskString retval;
+        retval.Offset = pool.size();
+        retval.Length = str.size();
+        pool.append(str);
+        return retval;
+    }
+
+    template <class T> bool writeArray(QFile &file, QVector<T> const &array)
+    {
+        qint64 bytes = array.size() * sizeof(T);
+        return array.isEmpty() || file.write((char const*)array.constData(), bytes) == bytes;
+    }
+
+    bool entryNameLess(toCache::CacheEntry const *e1, toCache::CacheEntry const *e2)
+    {
+        return e1->name.second < e2->name.second;
+    }
+
+    QString cellString(toQueryBatch &batch, unsigned row, unsigned col)
+    {
+        if (batch.isNull(row, col))
+            return QString();
+        if (batch.columnType(col) == toQueryBatch::StringColumn)
+            return batch.stringAt(row, col).toString();
+        return (QString)batch.value(row, col);
+    }
+
+    /** Read next batch of (owner, name, type, comment) rows and append them as cache entries */
+    void readEntries(toQuery &query, QList<toCache::CacheEntry*> &entries)
+    {
+        toQueryBatch rows(4);
+        query.readBatch(rows, CACHE_BATCH_ROWS);
+        for (unsigned row = 0; row < rows.rows(); row++)
+        {
+            toCache::CacheEntry *e = toCache::createCacheEntry(cellString(rows, row, 0)
+                                     , cellString(rows, row, 1)
+                                     , cellString(rows, row, 2)
+                                     , cellString(rows, row, 3));
+            if (e)
+                entries.append(e);
+        }
+    }
+
 /* This method runs as a separate thread executed from:
  toCache::readObjects(toTask * t)
  */
 void toCacheWorker::process()
 {
-    QMutexLocker bLock(&parentConnection().getCache().backgroundThreadLock);
+    toCache &cache = parentConnection().getCache();
+    QMutexLocker bLock(&cache.backgroundThreadLock);
 
-    parentConnection().getCache().setCacheState(toCache::READING_FROM_DISK);
-    bool diskloaded = parentConnection().getCache().loadDiskCache();
-    if (diskloaded)
+    // When schema signatures are known (rereadCache) only the changes are read
+    bool loaded = cache.hasSignatures();
+    if (!loaded)
     {
-        // TODO: Check if really whole cache was loaded.
-        // the file image could contain only some schemas or part of the schema
-        parentConnection().getCache().setCacheState(toCache::DONE);
-        return;
+        cache.setCacheState(toCache::READING_FROM_DISK);
+        loaded = cache.loadDiskCache();
     }
 
-    parentConnection().getCache().setCacheState(toCache::READING_FROM_DB);
+    cache.setCacheState(toCache::READING_FROM_DB);
     try
     {
-        toConnectionSubLoan conn(parentConnection());
-        toQuery objects(conn
-                        , toSQL::sql("toConnection:ListObjectsInDatabase",parentConnection())
-                        , toQueryParams());
-        while (!objects.eof())
-        {
-            if (parentConnection().Abort)
-            {
-                parentConnection().getCache().setCacheState(toCache::FAILED);
-                return;
-            }
-            // TODO #warning  "check connection's parent Abort flag"
-            QString owner = (QString)objects.readValue();
-            QString name = (QString)objects.readValue();
-            QString type = (QString)objects.readValue();
-            QString comment = (QString)objects.readValue();
-            toCache::CacheEntry *e = toCache::createCacheEntry(owner, name,
-                                     type, comment);
-            if (e)
-                parentConnection().getCache().upsertEntry(e);
-        }
+        QMap<QString, QString> signatures;
+        bool incremental = readSignatures(signatures);
+        if (loaded && incremental)
+            readChanged(signatures);
+        else if (!loaded)
+            readAll(signatures);
+        // else: provider can not tell what changed, use the disk cache as it is
     }
     catch (toConnection::exception const &exc)
     {
-        parentConnection().getCache().setCacheState(toCache::FAILED);
+        cache.setCacheState(toCache::FAILED);
         TLOG(2, toDecorator, __HERE__) << exc << std::endl;
         return;
     }
     catch (QString const &exc)
     {
-        parentConnection().getCache().setCacheState(toCache::FAILED);
+        cache.setCacheState(toCache::FAILED);
         TLOG(2, toDecorator, __HERE__) << exc << std::endl;
         return;
     }
 
-    parentConnection().getCache().ownersRead = true;
-    parentConnection().getCache().setCacheState(toCache::DONE);
+    if (parentConnection().Abort)
+    {
+        cache.setCacheState(toCache::FAILED);
+        return;
+    }
+    cache.ownersRead = true;
+    cache.setCacheState(toCache::DONE);
 }
-;
 
-// Forward declarations
-// Allow cache entries to be serialized / de-serialized
-QDataStream& operator<<(QDataStream& stream, const toCache::CacheEntry& e);
-QDataStream& operator>>(QDataStream& stream, toCache::CacheEntry& e);
+bool toCacheWorker::readSignatures(QMap<QString, QString> &signatures)
+{
+    try
+    {
+        toSQL::string("toConnection:ListSchemaSignatures", parentConnection());
+        toSQL::string("toConnection:ListObjectsInSchema", parentConnection());
+    }
+    catch (QString const &)
+    {
+        return false;
+    }
+
+    toConnectionSubLoan conn(parentConnection());
+    toQuery query(conn
+                  , toSQL::sql("toConnection:ListSchemaSignatures", parentConnection())
+                  , toQueryParams());
+    while (!query.eof())
+    {
+        QString owner = (QString)query.readValue();
+        QString signature = (QString)query.readValue();
+        signatures.insert(owner, signature);
+    }
+    return true;
+}
+
+void toCacheWorker::readAll(QMap<QString, QString> const &signatures)
+{
+    // Build the whole cache image off-lock, readers keep using the old one till it is published
+    toCache::BulkLoad image;
+    toConnectionSubLoan conn(parentConnection());
+    toQuery objects(conn
+                    , toSQL::sql("toConnection:ListObjectsInDatabase",parentConnection())
+                    , toQueryParams());
+    while (!objects.eof())
+    {
+        if (parentConnection().Abort)
+            return;
+        QList<toCache::CacheEntry*> batch;
+        readEntries(objects, batch);
+        image.add(batch);
+    }
+    // signatures were read before the objects, so a change in between is caught by the next refresh
+    for (QMap<QString, QString>::const_iterator i = signatures.constBegin(); i != signatures.constEnd(); ++i)
+        image.setSignature(i.key(), i.value());
+    image.finish();
+    parentConnection().getCache().publish(image);
+}
+
+void toCacheWorker::readChanged(QMap<QString, QString> const &signatures)
+{
+    toCache &cache = parentConnection().getCache();
+    QMap<QString, QString> cached;
+    {
+        QReadLocker lock(&cache.cacheLock);
+        cached = cache.schemaSignatures;
+    }
+
+    unsigned changed = 0;
+    toConnectionSubLoan conn(parentConnection());
+    for (QMap<QString, QString>::const_iterator i = signatures.constBegin(); i != signatures.constEnd(); ++i)
+    {
+        if (cached.contains(i.key()) && cached.value(i.key()) == i.value())
+            continue;
+        if (parentConnection().Abort)
+            return;
+
+        QList<toCache::CacheEntry*> rows;
+        toQuery objects(conn
+                        , toSQL::sql("toConnection:ListObjectsInSchema", parentConnection())
+                        , toQueryParams() << i.key());
+        while (!objects.eof())
+            readEntries(objects, rows);
+        cache.replaceSchema(i.key(), rows, i.value());
+        changed++;
+    }
+
+    // Schemas dropped since the last read
+    for (QMap<QString, QString>::const_iterator i = cached.constBegin(); i != cached.constEnd(); ++i)
+    {
+        if (signatures.contains(i.key()))
+            continue;
+        cache.replaceSchema(i.key(), QList<toCache::CacheEntry*>(), QString());
+        changed++;
+    }
+    TLOG(5, toDecorator, __HERE__) << "Object cache refreshed, schemas re-read: " << changed
+                                   << " of " << signatures.size() << std::endl;
+}
 
 QString toCache::ObjectRef::toString() const
 {
@@ -138,7 +322,6 @@ toCache::toCache(toConnection &parentConnection, QString const &description)
     , refCount(1) // we assume that we were created from 1st toConnection
     , m_threadWorker(new QThread(this))
     , m_cacheWorker(new toCacheWorker(parentConn))
-    , m_trie(new QmlJS::PersistentTrie::Trie())
 {
     m_threadWorker->setObjectName("toCacheWorker thread");
     m_cacheWorker->moveToThread(m_threadWorker);
@@ -234,32 +417,49 @@ toCache::CacheEntry const* toCache::findEntry(toCache::ObjectRef const& o) const
 
 QStringList toCache::completeEntry(QString const& schema, QString const& object) const
 {
-    using namespace QmlJS::PersistentTrie;
-    auto i(m_schemaTrie.find(schema));
-    if (i != m_schemaTrie.end())
+    toCompletionIndex index;
+    bool pending;
+    {
+        // Index is immutable, take a copy and do not hold the lock while completing
+        QReadLocker lock(&cacheLock);
+        index = m_completion.value(schema);
+        pending = m_pendingCompletion.contains(schema);
+    }
+    if (pending)
     {
-    	QStringList retvalSchema = m_schemaTrie.value(schema).complete(object, schema + '.', LookupFlags(CaseInsensitive));
-    	//QStringList retvalPublic = m_schemaTrie.value("PUBLIC").complete(object, "PUBLIC.", LookupFlags(CaseInsensitive));
-    	if(retvalSchema.size() < 200) retvalSchema.sort();
-    	//if(retvalPublic.size() < 800) retvalPublic.sort();
-    	//retvalSchema.append(retvalPublic);
-    	return retvalSchema;
+        // Merge names added one by one since the last lookup, the index is rebuilt once for all of them
+        QWriteLocker lock(&cacheLock);
+        index = m_completion.value(schema).inserted(m_pendingCompletion.take(schema));
+        if (!index.isEmpty())
+            m_completion.insert(schema, index);
     }
-    return QStringList();
+    QStringList retval = index.complete(object, schema + '.');
+    // Nothing starts with the word, offer names containing its letters, best matches first
+    if (retval.isEmpty() && !object.isEmpty())
+        retval = index.match(object, schema + '.');
+    return retval;
 }
 
 QList<toCache::CacheEntry const*> toCache::getEntriesInSchema(QString const& schema, CacheEntryType type) const
 {
-    QReadLocker lock(&cacheLock);
     QString schemaU = schema.toUpper();
     QList<toCache::CacheEntry const*> retval;
-
-    QList<ObjectRef> objs = entryMap.keys(); // TODO there must be a better way of searching QMap (do not copy keys)
-    Q_FOREACH(ObjectRef const & o, objs)
     {
-        if ((entryMap.value(o)->type == type || type == toCache::ANY) && o.first == schemaU)
-            retval.append(entryMap.value(o));
+        QReadLocker lock(&cacheLock);
+        SchemaIndex::const_iterator s = schemaIndex.constFind(schemaU);
+        if (s == schemaIndex.constEnd())
+            return retval;
+        if (type == toCache::ANY)
+        {
+            Q_FOREACH(EntryHash const & entries, s.value())
+            {
+                retval.append(entries.values());
+            }
+        }
+        else
+            retval = s.value().value(type).values();
     }
+    sortEntries(retval);
     return retval;
 }
 
@@ -348,16 +548,9 @@ void toCache::upsertEntry(toCache::CacheEntry* e)
     switch (e->type)
     {
         case SYNONYM:
-            synonymMap.insert(e->name, e);
-            // no break
         case TABLE:
         case VIEW:
-            m_trie->insert(e->name.second);
-            {
-            	if(!m_schemaTrie.contains(e->name.first))
-            		m_schemaTrie.insert(e->name.first, QmlJS::PersistentTrie::Trie());
-                m_schemaTrie[e->name.first].insert(e->name.second);
-            }
+            m_pendingCompletion[e->name.first].append(e->name.second);
             // no break
         case PROCEDURE:
         case FUNCTION:
@@ -371,10 +564,9 @@ void toCache::upsertEntry(toCache::CacheEntry* e)
             {
                 QString const& schema = e->name.first;
 
-                CacheEntry const* oldValue = entryMap.value(e->name, NULL);
+                CacheEntry const* oldValue = insertEntry(entryMap, synonymMap, schemaIndex, e);
                 if (oldValue)
-                    delete oldValue;
-                entryMap.insert(e->name, e);
+                    retiredEntries.append(oldValue);
 
                 if (!usersMap.contains(schema))
                 {
@@ -407,6 +599,113 @@ void toCache::upsertEntry(toCache::CacheEntry* e)
     }
 }
 
+void toCache::publish(BulkLoad &image)
+{
+    {
+        QWriteLocker lock(&cacheLock);
+        // keep users read by upsertUserList which do not own any object
+        for (QMap<QString, CacheEntry const*>::iterator i = usersMap.begin(); i != usersMap.end();)
+        {
+            if (image.usersMap.contains(i.key()))
+            {
+                ++i;
+                continue;
+            }
+            image.usersMap.insert(i.key(), i.value());
+            i = usersMap.erase(i);
+        }
+        entryMap.swap(image.entryMap);
+        synonymMap.swap(image.synonymMap);
+        schemaIndex.swap(image.schemaIndex);
+        schemaSignatures.swap(image.signatures);
+        usersMap.swap(image.usersMap);
+        ownersMap.swap(image.ownersMap);
+        m_completion.swap(image.completion);
+        m_pendingCompletion.clear();
+
+        // the image holds the previous entries now, readers may still use them
+        retiredEntries.append(image.entryMap.values());
+        retiredEntries.append(image.usersMap.values());
+        image.entryMap.clear();
+        image.synonymMap.clear();
+        image.schemaIndex.clear();
+        image.usersMap.clear();
+        image.ownersMap.clear();
+    }
+    emit userListRefreshed();
+}
+
+toCache::BulkLoad::BulkLoad()
+{
+}
+
+toCache::BulkLoad::~BulkLoad()
+{
+    // ownersMap points into usersMap
+    Q_FOREACH(CacheEntry const * e, entryMap)
+    {
+        delete e;
+    }
+    Q_FOREACH(CacheEntry const * e, usersMap)
+    {
+        delete e;
+    }
+}
+
+void toCache::BulkLoad::add(QList<CacheEntry*> const& batch)
+{
+    Q_FOREACH(CacheEntry * e, batch)
+    {
+        switch (e->type)
+        {
+            case SYNONYM:
+            case TABLE:
+            case VIEW:
+                schemaNames[e->name.first].append(e->name.second);
+                // no break
+            case PROCEDURE:
+            case FUNCTION:
+            case PACKAGE:
+            case PACKAGE_BODY:
+            case INDEX:
+            case SEQUENCE:
+            case TRIGGER:
+            case DATABASE:
+            case TORA_SCHEMA_LIST:
+                {
+                    QString const& schema = e->name.first;
+
+                    delete insertEntry(entryMap, synonymMap, schemaIndex, e); // not published yet
+
+                    if (!usersMap.contains(schema))
+                        usersMap.insert(schema, new toCacheEntryUser(schema));
+                    if (!ownersMap.contains(schema))
+                        ownersMap.insert(schema, usersMap.value(schema));
+                }
+                break;
+            case USER:
+                if (usersMap.contains(e->name.first))
+                    delete e;
+                else
+                    usersMap.insert(e->name.first, e);
+                break;
+            default:
+                // HERE we ignore directories, dblinks, ... OTHER
+                delete e;
+                break;
+        }
+    }
+}
+
+void toCache::BulkLoad::finish()
+{
+    for (QMap<QString, QStringList>::const_iterator i = schemaNames.constBegin(); i != schemaNames.constEnd(); ++i)
+    {
+        completion.insert(i.key(), toCompletionIndex(i.value()));
+    }
+    schemaNames.clear();
+}
+
 void toCache::upsertSchemaEntries(QString const& schema, QString const& objType, QList<toCache::CacheEntry*> const& rows)
 {
     QWriteLocker lock(&cacheLock);
@@ -416,18 +715,22 @@ void toCache::upsertSchemaEntries(QString const& schema, QString const& objType,
     if (type == ANY)
         throw QString("toCache: Unsupported object type ANY");
 
-    // Clear whole schema
-    QList<ObjectRef> objs = entryMap.keys(); // TODO there must be a better way of deleting from QMap
-    Q_FOREACH(ObjectRef const & o, objs)
+    // Clear objects of this type in schema
+    EntryHash old = schemaIndex[schema].take(type);
+    for (EntryHash::const_iterator i = old.constBegin(); i != old.constEnd(); ++i)
     {
-        if (o.first == schema && entryMap.value(o)->type == type)
-            entryMap.remove(o);
+        entryMap.remove(i.key());
+        if (type == SYNONYM)
+            synonymMap.remove(i.key());
+        retiredEntries.append(i.value());
     }
 
     // Add new entries in the schema
     Q_FOREACH(CacheEntry * e, rows)
     {
-        entryMap.insert(e->name, e);
+        CacheEntry const* oldValue = insertEntry(entryMap, synonymMap, schemaIndex, e);
+        if (oldValue)
+            retiredEntries.append(oldValue);
     }
 
     // Check if user/owner exists
@@ -442,21 +745,6 @@ void toCache::upsertSchemaEntries(QString const& schema, QString const& objType,
             ownersMap.insert(schema, usersMap.value(schema));
         }
     }
-
-    if (type == SYNONYM)
-    {
-        QList<ObjectRef> objs = synonymMap.keys(); // TODO there must be a better way of deleting from QMap
-        Q_FOREACH(ObjectRef const & o, objs)
-        {
-            if (o.first == schema)
-                synonymMap.remove(o);
-        }
-
-        Q_FOREACH(CacheEntry * e, rows)
-        {
-            synonymMap.insert(e->name, e);
-        }
-    }
 }
 
 /** Clear current list of users and generate a new one */
@@ -529,11 +817,15 @@ toCache::CacheState toCache::cacheState() const
 
 void toCache::rereadCache()
 {
-    /** delete cache file to force reload
+    /** Without schema signatures there is no way to find out what changed,
+     * delete cache file to force reload
      */
-    QFileInfo filename(cacheFile());
-    if (filename.isFile())
-        QFile::remove(filename.absoluteFilePath());
+    if (!hasSignatures())
+    {
+        QFileInfo filename(cacheFile());
+        if (filename.isFile())
+            QFile::remove(filename.absoluteFilePath());
+    }
 
     readCache();
 }
@@ -650,45 +942,84 @@ void toCache::writeDiskCache()
     if (!dir.exists())
         dir.mkdir(dir.absolutePath());
 
-    QString version = QString::fromLatin1(TORAVERSION);
-
-    QFile file(fileInfo.absoluteFilePath());
-//TODO #warn "throw something here"
-    if (!file.open(QIODevice::ReadWrite | QIODevice::Truncate))
-        return;
-
+    DiskHeader header;
+    memset(&header, 0, sizeof(header));
+    QVector<DiskSchema> schemas;
+    QVector<DiskEntry> entries;
+    QVector<DiskString> users;
+    QString pool;
     {
         QReadLocker lock(&cacheLock);
 
-        QDataStream out(&file);
-        out << (quint8) 0;
-        out << version; // Tora version
-        out << (quint8) state; // cache state
-        out << ownersRead;
-        out << usersRead;
-        out << ConnectionDescription;
-        file.flush();
-
-        out << (quint32) usersMap.size();
-        out << (quint32) entryMap.size();
+        QStringList names = schemaIndex.keys();
+        Q_FOREACH(QString const& schema, schemaSignatures.keys())
+        {
+            if (!schemaIndex.contains(schema))
+                names.append(schema);
+        }
+        names.sort();
 
-        QList<CacheEntry const*> vUsersMap = usersMap.values();
-        Q_FOREACH(CacheEntry const*e, vUsersMap)
+        Q_FOREACH(QString const& schema, names)
         {
-            out << (*e);
+            DiskSchema s;
+            s.Name = poolString(pool, schema);
+            s.Signature = poolString(pool, schemaSignatures.value(schema));
+            s.FirstEntry = entries.size();
+            Q_FOREACH(EntryHash const& typeEntries, schemaIndex.value(schema))
+            {
+                Q_FOREACH(CacheEntry const *e, typeEntries)
+                {
+                    DiskEntry d;
+                    d.Name = poolString(pool, e->name.second);
+                    d.Comment = poolString(pool, e->comment);
+                    d.Schema = schemas.size();
+                    d.Type = e->type;
+                    entries.append(d);
+                }
+            }
+            s.Entries = entries.size() - s.FirstEntry;
+            schemas.append(s);
         }
 
-        QList<CacheEntry const*> vEntryMap = entryMap.values();
-        Q_FOREACH(CacheEntry const*e, vEntryMap)
+        Q_FOREACH(CacheEntry const *e, usersMap)
         {
-            out << (*e);
+            users.append(poolString(pool, e->name.first));
         }
 
-        file.seek(0L);
-        out << (quint8) 1;
-        file.flush();
-        file.close();
+        header.State = state;
+        header.Flags = (ownersRead ? DISK_OWNERS_READ : 0) | (usersRead ? DISK_USERS_READ : 0);
+    }
+
+    memcpy(header.Magic, DISK_MAGIC, sizeof(header.Magic));
+    header.Format = DISK_FORMAT;
+    header.ByteOrder = DISK_BYTE_ORDER;
+    header.SchemaCount = schemas.size();
+    header.EntryCount = entries.size();
+    header.UserCount = users.size();
+    header.CharCount = pool.size();
+    header.Written = QDateTime::currentDateTime().toMSecsSinceEpoch();
+
+    // Write a new file and replace the old one, so an interrupted write does not leave a damaged cache
+    QString path(fileInfo.absoluteFilePath());
+    QFile file(path + ".new");
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        TLOG(2, toDecorator, __HERE__) << "Can not write object cache: " << file.fileName() << std::endl;
+        return;
+    }
+    bool ok = file.write((char const*)&header, sizeof(header)) == sizeof(header);
+    ok = ok && writeArray(file, schemas);
+    ok = ok && writeArray(file, entries);
+    ok = ok && writeArray(file, users);
+    ok = ok && file.write((char const*)pool.constData(), pool.size() * sizeof(QChar)) == (qint64)(pool.size() * sizeof(QChar));
+    file.close();
+    if (!ok)
+    {
+        file.remove();
+        return;
     }
+    QFile::remove(path);
+    file.rename(path);
 }
 
 bool toCache::loadDiskCache()
@@ -697,81 +1028,180 @@ bool toCache::loadDiskCache()
         return false;
 
     QFileInfo fileInfo(cacheFile());
-    QDir dir(cacheDir());
-
-    if (!dir.exists())
-        dir.mkdir(dir.absolutePath());
-
-    QDateTime today;
 
     if (!fileInfo.isReadable())
         return false;
 
-    if (fileInfo.lastModified().addDays(toConfigurationNewSingle::Instance().option(ToConfiguration::Database::CacheTimeout).toInt()) < today)
+    if (fileInfo.lastModified().addDays(toConfigurationNewSingle::Instance().option(ToConfiguration::Database::CacheTimeout).toInt()) < QDateTime::currentDateTime())
         return false;
 
-    clearCache();
-
-//#warn TODO "throw something here
-    quint32 usersMapSize, entryMapSize;
     QFile file(fileInfo.absoluteFilePath());
-    file.open(QIODevice::ReadOnly);
+    if (!file.open(QIODevice::ReadOnly))
+        return false;
 
-    quint8 s1, s2;
-    bool oRead, uRead;
-    QString version;
+    quint64 size = file.size();
+    uchar *data = size >= sizeof(DiskHeader) ? file.map(0, size) : NULL;
+    DiskHeader const *header = (DiskHeader const*) data;
+
+    // Assume the cache file is corrupted (or written by different version of TOra) if
+    // - it does not start with the magic of the expected format
+    // - it was written on a platform of a different byte order
+    // - cache state != toCache::DONE
+    // - size does not match the counts in the header
+    if (header == NULL
+            || memcmp(header->Magic, DISK_MAGIC, sizeof(header->Magic)) != 0
+            || header->Format != DISK_FORMAT
+            || header->ByteOrder != DISK_BYTE_ORDER
+            || header->State != toCache::DONE
+            || size != sizeof(DiskHeader)
+            + (quint64) header->SchemaCount * sizeof(DiskSchema)
+            + (quint64) header->EntryCount * sizeof(DiskEntry)
+            + (quint64) header->UserCount * sizeof(DiskString)
+            + (quint64) header->CharCount * sizeof(QChar))
+    {
+        file.close();
+        file.remove();
+        return false;
+    }
 
-    QDataStream in(&file);
+    DiskSchema const *schemas = (DiskSchema const*)(header + 1);
+    DiskEntry const *entries = (DiskEntry const*)(schemas + header->SchemaCount);
+    DiskString const *users = (DiskString const*)(entries + header->EntryCount);
+    QChar const *pool = (QChar const*)(users + header->UserCount);
+    quint32 chars = header->CharCount;
+
+    // Entries are decoded straight from the mapping, one copy of each string, no parsing
+    BulkLoad image;
+    bool valid = true;
+    QList<CacheEntry*> batch;
+    for (quint32 i = 0; i < header->UserCount && valid; i++)
     {
-        QWriteLocker lock(&cacheLock);
+        valid = users[i].valid(chars);
+        if (valid)
+            batch.append(new toCacheEntryUser(users[i].toString(pool)));
+    }
+    image.add(batch);
+    batch.clear();
+
+    for (quint32 i = 0; i < header->SchemaCount && valid; i++)
+    {
+        DiskSchema const &s = schemas[i];
+        valid = s.Name.valid(chars) && s.Signature.valid(chars)
+                && s.FirstEntry <= header->EntryCount && s.Entries <= header->EntryCount - s.FirstEntry;
+        if (!valid)
+            break;
 
-        in >> s1;
-        in >> version; // Tora version
-        in >> s2; // cache state
-        in >> oRead;
-        in >> uRead;
-        in >> ConnectionDescription;
-
-        // Assume the cache file is corrupted if
-        // - 1st byte != 0x01 -- see writeDistCache() for details
-        // - application version differs
-        // - cache state != toCache::DONE
-        if (s1 != 1 || version != QString::fromLatin1(TORAVERSION)
-                || s2 != toCache::DONE)
+        QString schema(s.Name.toString(pool));
+        if (s.Signature.Length)
+            image.setSignature(schema, s.Signature.toString(pool));
+        for (quint32 j = s.FirstEntry; j < s.FirstEntry + s.Entries && valid; j++)
         {
-            file.close();
-            file.remove();
-            return false;
+            DiskEntry const &e = entries[j];
+            valid = e.Name.valid(chars) && e.Comment.valid(chars) && e.Schema == i && e.Type < OTHER;
+            if (!valid)
+                break;
+            CacheEntry *entry = createCacheEntry(schema, e.Name.toString(pool), (CacheEntryType) e.Type, e.Comment.toString(pool));
+            if (entry == NULL && e.Type == TORA_SCHEMA_LIST)
+                entry = new CacheEntry(schema, e.Name.toString(pool), TORA_SCHEMA_LIST, e.Comment.toString(pool));
+            if (entry != NULL)
+                batch.append(entry);
+            if (batch.size() >= (int) CACHE_BATCH_ROWS)
+            {
+                image.add(batch);
+                batch.clear();
+            }
         }
+    }
+    image.add(batch);
 
-        in >> usersMapSize;
-        in >> entryMapSize;
+    quint32 flags = header->Flags;
+    file.unmap(data);
+    file.close();
+    if (!valid)
+    {
+        file.remove();
+        return false;
     }
 
-    for (quint32 i = 0; i < usersMapSize; i++)
+    image.finish();
+    publish(image);
+
     {
-        CacheEntry e, *cloned;
-        in >> e;
-        cloned = cloneCacheEntry(e);
-        if (cloned != NULL)
-            upsertEntry(cloned);
+        QWriteLocker lock(&cacheLock);
+        usersRead = flags & DISK_USERS_READ;
+        ownersRead = flags & DISK_OWNERS_READ;
     }
+    return true;
+}
 
-    for (quint32 i = 0; i < entryMapSize; i++)
+void toCache::replaceSchema(QString const& schema, QList<CacheEntry*> const& rows, QString const& signature)
+{
+    // Build completion index off-lock
+    QStringList names;
+    Q_FOREACH(CacheEntry const *e, rows)
     {
-        CacheEntry e, *cloned;
-        in >> e;
-        cloned = cloneCacheEntry(e);
-        if (cloned != NULL)
-            upsertEntry(cloned);
+        if (e->type == TABLE || e->type == VIEW || e->type == SYNONYM)
+            names.append(e->name.second);
     }
+    toCompletionIndex completion(names);
 
-    state = (CacheState) s2;
-    usersRead = uRead;
-    ownersRead = oRead;
+    QList<CacheEntry const*> old;
+    bool newUser = false;
+    {
+        QWriteLocker lock(&cacheLock);
+        QHash<int, EntryHash> types = schemaIndex.take(schema);
+        for (QHash<int, EntryHash>::const_iterator t = types.constBegin(); t != types.constEnd(); ++t)
+        {
+            // Keep the markers of object lists read by schema browser
+            if (t.key() == TORA_SCHEMA_LIST)
+            {
+                schemaIndex[schema].insert(t.key(), t.value());
+                continue;
+            }
+            for (EntryHash::const_iterator i = t.value().constBegin(); i != t.value().constEnd(); ++i)
+            {
+                entryMap.remove(i.key());
+                synonymMap.remove(i.key());
+                old.append(i.value());
+            }
+        }
 
-    file.close();
-    return true;
+        Q_FOREACH(CacheEntry * e, rows)
+        {
+            CacheEntry const* oldValue = insertEntry(entryMap, synonymMap, schemaIndex, e);
+            if (oldValue)
+                old.append(oldValue);
+        }
+
+        m_pendingCompletion.remove(schema);
+        if (completion.isEmpty())
+            m_completion.remove(schema);
+        else
+            m_completion.insert(schema, completion);
+
+        if (signature.isEmpty())
+            schemaSignatures.remove(schema);
+        else
+            schemaSignatures.insert(schema, signature);
+
+        if (!rows.isEmpty() && !usersMap.contains(schema))
+        {
+            usersMap.insert(schema, new toCacheEntryUser(schema));
+            newUser = true;
+        }
+        if (!rows.isEmpty() && !ownersMap.contains(schema))
+            ownersMap.insert(schema, usersMap.value(schema));
+        retiredEntries.append(old);
+    }
+
+    if (newUser)
+        emit userListRefreshed();
+}
+
+bool toCache::hasSignatures() const
+{
+    QReadLocker lock(&cacheLock);
+    return !schemaSignatures.isEmpty();
 }
 
 /**
@@ -787,6 +1217,8 @@ void toCache::clearCache()
 
     entryMap.clear();
     synonymMap.clear();
+    schemaIndex.clear();
+    schemaSignatures.clear();
     columnCache.clear();
 
     QList<CacheEntry const*> u = usersMap.values();
@@ -797,11 +1229,38 @@ void toCache::clearCache()
     ownersMap.clear();
     usersMap.clear();
 
-    m_trie = QSharedPointer<QmlJS::PersistentTrie::Trie>(new QmlJS::PersistentTrie::Trie());
-    m_schemaTrie.clear();
+    qDeleteAll(retiredEntries);
+    retiredEntries.clear();
+
+    m_completion.clear();
+    m_pendingCompletion.clear();
 }
 ;
 
+toCache::CacheEntry const* toCache::insertEntry(QMap<ObjectRef, CacheEntry const*> &entries
+                          , QMap<ObjectRef, CacheEntry const*> &synonyms
+                          , SchemaIndex &index
+                          , CacheEntry const *e)
+{
+    CacheEntry const* oldValue = entries.value(e->name, NULL);
+    if (oldValue)
+    {
+        index[oldValue->name.first][oldValue->type].remove(oldValue->name);
+        if (oldValue->type == SYNONYM)
+            synonyms.remove(oldValue->name);
+    }
+    entries.insert(e->name, e);
+    index[e->name.first][e->type].insert(e->name, e);
+    if (e->type == SYNONYM)
+        synonyms.insert(e->name, e);
+    return oldValue;
+}
+
+void toCache::sortEntries(QList<CacheEntry const*> &entries)
+{
+    std::sort(entries.begin(), entries.end(), entryNameLess);
+}
+
 /*static*/toCache::CacheEntryType toCache::cacheEntryType(
     QString const& objType)
 {
@@ -912,36 +1371,6 @@ bool toCache::CacheEntry::operator ==(const toCache::CacheEntry &other) const
 }
 ;
 
-QDataStream& operator<<(QDataStream& stream, const toCache::ObjectRef& o)
-{
-    stream << o.first << o.second;
-    return stream;
-}
-
-QDataStream& operator>>(QDataStream& stream, toCache::ObjectRef& o)
-{
-    stream >> o.first >> o.second;
-    return stream;
-}
-
-QDataStream& operator<<(QDataStream& stream, const toCache::CacheEntry& e)
-{
-    stream << e.name << (quint8) e.type << e.comment << e.timestamp
-           << e.details;
-    return stream;
-}
-
-QDataStream& operator>>(QDataStream& stream, toCache::CacheEntry& e)
-{
-    quint8 type;
-
-    stream >> e.name >> type >> e.comment >> e.timestamp >> e.details;
-
-    e.type = (toCache::CacheEntryType) type;
-    e.described = false;
-    return stream;
-}
-
 toCacheEntryTable::toCacheEntryTable(const QString &owner, const QString &name,
                                      const QString &comment) :
     toCache::CacheEntry(owner, name, toCache::TABLE, comment)
@@ -46,12 +46,15 @@
 #include <QtCore/QSet>
 #include <QtCore/QPointer>
 #include <QtCore/QMap>
+#include <QtCore/QHash>
 #include <QtCore/QVariant>
 #include <QtCore/QString>
 #include <QtCore/QReadWriteLock>
 #include <QtCore/QMutex>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QStringList>
 
-#include "persistenttrie.h"
+#include "core/tocompletionindex.h"
 //#include <map>
 
 class QThread;
@@ -102,6 +105,15 @@ class toCacheWorker: public QObject
         virtual void process(void);
 
     private:
+        /** Read change signature of every schema, returns false if the provider does not support it */
+        bool readSignatures(QMap<QString, QString> &signatures);
+
+        /** Read all the objects in database */
+        void readAll(QMap<QString, QString> const &signatures);
+
+        /** Re-read the schemas whose signature differs from the cached one, drop the schemas which disappeared */
+        void readChanged(QMap<QString, QString> const &signatures);
+
         toConnection &m_parentConnection;
 };
 
@@ -153,6 +165,11 @@ class TORA_EXPORT toCache : public QObject
                     return first < other.first || (!(other.first < first) && second < other.second);
                 }
 
+                friend uint qHash(const ObjectRef &o)
+                {
+                    return qHash(o.first) * 31 + qHash(o.second);
+                }
+
                 /** convert object reference into a string */
                 QString toString() const;
 
@@ -306,6 +323,54 @@ class TORA_EXPORT toCache : public QObject
 			DATABASES
         };
 
+        typedef QHash<ObjectRef, CacheEntry const*> EntryHash;
+        /** Secondary index of entryMap, schema => entry type => entries */
+        typedef QHash<QString, QHash<int, EntryHash> > SchemaIndex;
+
+        /** Image of the object maps and completion indexes built while (re)loading the whole cache.
+         *  Batches of entries are added without holding cacheLock, then the image is
+         *  published by @ref toCache::publish with a single swap under the write lock.
+         *  Entries which were not published (or the old ones swapped out) are deleted by destructor.
+         */
+        class TORA_EXPORT BulkLoad
+        {
+            public:
+                BulkLoad();
+                ~BulkLoad();
+
+                /** Take ownership of the entries, same rules as @ref toCache::upsertEntry apply */
+                void add(QList<CacheEntry*> const& batch);
+
+                /** Build completion indexes, call it once all the batches were added */
+                void finish();
+
+                /** Number of objects (without users) collected */
+                int size() const
+                {
+                    return entryMap.size();
+                }
+
+                /** Set change signature of schema (see toConnection:ListSchemaSignatures) */
+                void setSignature(QString const& schema, QString const& signature)
+                {
+                    signatures.insert(schema, signature);
+                }
+
+            private:
+                friend class toCache;
+
+                QMap<ObjectRef, CacheEntry const*> entryMap;
+                QMap<ObjectRef, CacheEntry const*> synonymMap;
+                SchemaIndex schemaIndex;
+                QMap<QString, CacheEntry const*> ownersMap, usersMap;
+                QMap<QString, QStringList> schemaNames; // completion names per schema, indexes are built by finish()
+                QMap<QString, toCompletionIndex> completion;
+                QMap<QString, QString> signatures;
+
+                BulkLoad(BulkLoad const&);
+                BulkLoad& operator=(BulkLoad const&);
+        };
+
         /** Constructuctors, destructors
         */
         toCache(toConnection &parentConnection, QString const &description);
@@ -363,6 +428,11 @@ class TORA_EXPORT toCache : public QObject
         /** add/update new entry into cache */
         void upsertEntry(CacheEntry* e);
 
+        /** Replace content of the object cache by the image (users read by upsertUserList are kept).
+         *  The image holds the previous content afterwards and deletes it outside of cacheLock.
+         */
+        void publish(BulkLoad &image);
+
         /** add/update a list of objects in cache.
         * This should add any new object to the list as well as remove no longer
         * existing ones - within defined schema
@@ -382,9 +452,9 @@ class TORA_EXPORT toCache : public QObject
         */
         void readCache();
 
-        /** Reread the object and column cache from database
-        * Starts a new thread which will read all objects and synonyms from the database.
-        * also: deletes disk cache file
+        /** Refresh the object cache from database
+        * Starts a new thread which re-reads the schemas changed since the last read
+        * (or all objects if the provider can not tell which schemas changed).
         */
         void rereadCache();
 
@@ -414,8 +484,13 @@ class TORA_EXPORT toCache : public QObject
 
         QMap<ObjectRef, CacheEntry const*> entryMap;
         QMap<ObjectRef, CacheEntry const*> synonymMap;
+        SchemaIndex schemaIndex;
+        QMap<QString, QString> schemaSignatures; // schema => signature of its objects at the time they were read
         QMap<QString, CacheEntry const*> columnCache;
         QMap<QString, CacheEntry const*> ownersMap, usersMap, databasesMap;
+        /** Entries replaced by a refresh. findEntry and getEntriesInSchema hand out pointers
+         * which are used after cacheLock is released, so these are freed only by clearCache */
+        QList<CacheEntry const*> retiredEntries;
         bool ownersRead, usersRead, databasesRead;
         toConnection &parentConn;
 
@@ -430,10 +505,17 @@ class TORA_EXPORT toCache : public QObject
         static QDir cacheDir();
 
         /** Load cache information for current connection from a file on disk
+        * The file is memory mapped and entries are decoded straight from the mapping
         * @return True if cache was loaded
         */
         bool loadDiskCache(void);
 
+        /** Replace all the objects of the schema (except TORA_SCHEMA_LIST markers), empty rows drop the schema */
+        void replaceSchema(QString const& schema, QList<CacheEntry*> const& rows, QString const& signature);
+
+        /** True if change signatures of schemas are known, the cache can be refreshed incrementally */
+        bool hasSignatures() const;
+
         /** write disk cache
         */
         void writeDiskCache(void);
@@ -441,6 +523,16 @@ class TORA_EXPORT toCache : public QObject
         /** remove all the entries from all the maps, Note: caller should lock instance state first */
         void clearCache();
 
+        /** Insert the entry into entry map, synonym map and schema index.
+         * @return the entry it replaces (or NULL), the caller deletes or retires it */
+        static CacheEntry const* insertEntry(QMap<ObjectRef, CacheEntry const*> &entries
+                                , QMap<ObjectRef, CacheEntry const*> &synonyms
+                                , SchemaIndex &index
+                                , CacheEntry const *e);
+
+        /** Sort entries by object name, order of entryMap */
+        static void sortEntries(QList<CacheEntry const*> &entries);
+
         /** This lock is used by all getters and setters
         an Instance of toCache is shared between multiple connections.
         */
@@ -462,8 +554,11 @@ class TORA_EXPORT toCache : public QObject
         QThread *m_threadWorker;
         toCacheWorker *m_cacheWorker;
 
-        QSharedPointer<QmlJS::PersistentTrie::Trie> m_trie;
-        QMap<QString,QmlJS::PersistentTrie::Trie> m_schemaTrie;
+        /** Completion of table, view and synonym names per schema
+         * (mutable: completeEntry merges the pending names) */
+        mutable QMap<QString, toCompletionIndex> m_completion;
+        /** Names added by upsertEntry, merged into m_completion by the next completeEntry of the schema */
+        mutable QMap<QString, QStringList> m_pendingCompletion;
 
     signals:
         void userListRefreshed(void);
@@ -0,0 +1,332 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/tocompletionindex.h"
+
+#include <algorithm>
+
+namespace
+{
+    // Character by character folding keeps offsets of Names and Folded the same
+    QString fold(QString const& str)
+    {
+        QString retval(str);
+        QChar *c = retval.data();
+        for (int i = 0; i < retval.size(); i++)
+            c[i] = c[i].toUpper();
+        return retval;
+    }
+
+    int compare(QChar const *a, int aLen, QChar const *b, int bLen)
+    {
+        int len = qMin(aLen, bLen);
+        for (int i = 0; i < len; i++)
+        {
+            if (a[i].unicode() != b[i].unicode())
+                return a[i].unicode() < b[i].unicode() ? -1 : 1;
+        }
+        return aLen - bLen;
+    }
+
+    struct Key
+    {
+        QString Folded;
+        QString Name;
+
+        bool operator<(Key const& other) const
+        {
+            int c = compare(Folded.constData(), Folded.size(), other.Folded.constData(), other.Folded.size());
+            if (c != 0)
+                return c < 0;
+            return compare(Name.constData(), Name.size(), other.Name.constData(), other.Name.size()) < 0;
+        }
+
+        bool operator==(Key const& other) const
+        {
+            return Name == other.Name;
+        }
+    };
+
+    struct ShorterFirst
+    {
+        QVector<quint32> const &Offsets;
+
+        ShorterFirst(QVector<quint32> const &offsets) : Offsets(offsets) {}
+
+        bool operator()(int a, int b) const
+        {
+            quint32 aLen = Offsets[a + 1] - Offsets[a], bLen = Offsets[b + 1] - Offsets[b];
+            return aLen != bLen ? aLen < bLen : a < b;
+        }
+    };
+
+    bool isWordStart(QChar const *str, int pos)
+    {
+        return pos == 0 || !str[pos - 1].isLetterOrNumber();
+    }
+
+    /* Score of @param pattern as a subsequence of @param str, -1 if it is not one.
+     * Characters are matched greedily from the left, a match scores more at a start
+     * of a word (after '_', '$', ...) and when it continues the previous match.
+     */
+    int subsequenceScore(QChar const *str, int len, QChar const *pattern, int patternLen)
+    {
+        int score = 0;
+        int last = -2;
+        int p = 0;
+        for (int i = 0; i < len && p < patternLen && len - i >= patternLen - p; i++)
+        {
+            if (str[i] != pattern[p])
+                continue;
+            score++;
+            if (last == i - 1)
+                score += 2;
+            else if (isWordStart(str, i))
+                score += 3;
+            last = i;
+            p++;
+        }
+        return p == patternLen ? score : -1;
+    }
+
+    struct Match
+    {
+        int Score;
+        quint32 Rank;
+        int Index;
+
+        bool operator<(Match const& other) const
+        {
+            if (Score != other.Score)
+                return Score > other.Score;
+            return Rank < other.Rank;
+        }
+    };
+}
+
+toCompletionIndex::toCompletionIndex()
+{
+}
+
+toCompletionIndex::toCompletionIndex(QStringList const& names)
+{
+    if (names.isEmpty())
+        return;
+
+    QVector<Key> keys;
+    keys.reserve(names.size());
+    int chars = 0;
+    Q_FOREACH(QString const& name, names)
+    {
+        Key k;
+        k.Folded = fold(name);
+        k.Name = name;
+        keys.append(k);
+        chars += name.size();
+    }
+    std::sort(keys.begin(), keys.end());
+    keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+
+    Data *data = new Data;
+    data->Names.reserve(chars);
+    data->Folded.reserve(chars);
+    data->Offsets.reserve(keys.size() + 1);
+    Q_FOREACH(Key const& k, keys)
+    {
+        data->Offsets.append(data->Names.size());
+        data->Names.append(k.Name);
+        data->Folded.append(k.Folded);
+    }
+    data->Offsets.append(data->Names.size());
+
+    QVector<int> order(keys.size());
+    for (int i = 0; i < order.size(); i++)
+        order[i] = i;
+    std::sort(order.begin(), order.end(), ShorterFirst(data->Offsets));
+    data->Rank.resize(order.size());
+    for (int i = 0; i < order.size(); i++)
+        data->Rank[order[i]] = i;
+
+    d = QSharedPointer<Data const>(data);
+}
+
+toCompletionIndex toCompletionIndex::inserted(QStringList const& names) const
+{
+    if (names.isEmpty())
+        return *this;
+    QStringList all(this->names());
+    all.append(names);
+    return toCompletionIndex(all);
+}
+
+int toCompletionIndex::size() const
+{
+    return d.isNull() ? 0 : d->Offsets.size() - 1;
+}
+
+QString toCompletionIndex::name(int i) const
+{
+    return d->Names.mid(d->Offsets[i], d->Offsets[i + 1] - d->Offsets[i]);
+}
+
+QStringList toCompletionIndex::names() const
+{
+    QStringList retval;
+    for (int i = 0; i < size(); i++)
+        retval.append(name(i));
+    return retval;
+}
+
+int toCompletionIndex::lowerBound(QString const& key) const
+{
+    QChar const *folded = d->Folded.constData();
+    quint32 const *offsets = d->Offsets.constData();
+    int first = 0, count = size();
+    while (count > 0)
+    {
+        int step = count / 2, i = first + step;
+        if (compare(folded + offsets[i], offsets[i + 1] - offsets[i], key.constData(), key.size()) < 0)
+        {
+            first = i + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+    return first;
+}
+
+int toCompletionIndex::prefixEnd(QString const& key, int first) const
+{
+    // names from first on are not less than key, those starting with key come first
+    QChar const *folded = d->Folded.constData();
+    quint32 const *offsets = d->Offsets.constData();
+    int count = size() - first;
+    while (count > 0)
+    {
+        int step = count / 2, i = first + step;
+        quint32 len = offsets[i + 1] - offsets[i];
+        if (len >= (quint32)key.size() && compare(folded + offsets[i], key.size(), key.constData(), key.size()) == 0)
+        {
+            first = i + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+    return first;
+}
+
+QStringList toCompletionIndex::complete(QString const& prefix, QString const& base, int limit) const
+{
+    QStringList retval;
+    if (isEmpty())
+        return retval;
+
+    QString key(fold(prefix));
+    int first = lowerBound(key);
+    int last = prefixEnd(key, first);
+    if (limit >= 0)
+        last = qMin(last, first + limit);
+    retval.reserve(last - first);
+    for (int i = first; i < last; i++)
+        retval.append(base + name(i));
+    return retval;
+}
+
+QStringList toCompletionIndex::match(QString const& pattern, QString const& base, int limit) const
+{
+    QStringList retval;
+    if (isEmpty())
+        return retval;
+
+    QString key(fold(pattern));
+    int first = lowerBound(key);
+    int last = prefixEnd(key, first);
+
+    // Prefix matches win, scored above anything a subsequence can get
+    int const prefixScore = 6 * key.size() + 1;
+    QVector<Match> matches;
+    for (int i = first; i < last; i++)
+    {
+        Match m = { prefixScore, d->Rank[i], i };
+        matches.append(m);
+    }
+
+    QChar const *folded = d->Folded.constData();
+    quint32 const *offsets = d->Offsets.constData();
+    int n = size();
+    for (int i = 0; i < n; i++)
+    {
+        if (i == first && last > first)
+        {
+            i = last - 1;
+            continue;
+        }
+        int score = subsequenceScore(folded + offsets[i], offsets[i + 1] - offsets[i], key.constData(), key.size());
+        if (score < 0)
+            continue;
+        Match m = { score, d->Rank[i], i };
+        matches.append(m);
+    }
+
+    if (limit >= 0 && limit < matches.size())
+    {
+        std::partial_sort(matches.begin(), matches.begin() + limit, matches.end());
+        matches.resize(limit);
+    }
+    else
+    {
+        std::sort(matches.begin(), matches.end());
+    }
+
+    retval.reserve(matches.size());
+    Q_FOREACH(Match const& m, matches)
+        retval.append(base + name(m.Index));
+    return retval;
+}
+
+bool toCompletionIndex::contains(QString const& name) const
+{
+    if (isEmpty())
+        return false;
+    QString key(fold(name));
+    int i = lowerBound(key);
+    return i < size()
+           && compare(d->Folded.constData() + d->Offsets[i], d->Offsets[i + 1] - d->Offsets[i], key.constData(), key.size()) == 0;
+}
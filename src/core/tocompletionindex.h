@@ -0,0 +1,110 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TOCOMPLETIONINDEX_H
+#define TOCOMPLETIONINDEX_H
+
+#include "core/tora_export.h"
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QVector>
+#include <QtCore/QSharedPointer>
+
+/** Immutable index of names for code completion (object names of one schema).
+ *
+ * Names are stored in one character arena sorted by their case folded form,
+ * so a case insensitive prefix is a contiguous range found by binary search.
+ * Subsequence (fuzzy) matching is a linear scan over the folded arena,
+ * ties are broken by a rank computed when the index is built (shorter names first).
+ *
+ * The index is built once and never modified, copies share the data
+ * and can be used without locking.
+ */
+class TORA_EXPORT toCompletionIndex
+{
+    public:
+        /** Empty index */
+        toCompletionIndex();
+
+        /** Build an index, names need not be sorted nor unique */
+        explicit toCompletionIndex(QStringList const& names);
+
+        /** Return new index containing also @param names, the index is rebuilt once */
+        toCompletionIndex inserted(QStringList const& names) const;
+
+        /** Names starting with @param prefix (case insensitive) in sorted order, each prepended by @param base
+         * @param limit maximal number of names returned, -1 for all of them
+         */
+        QStringList complete(QString const& prefix, QString const& base = QString(), int limit = -1) const;
+
+        /** Names containing the characters of @param pattern in the same order (case insensitive),
+         * best matches first: prefix matches, then matches at word starts and contiguous runs.
+         */
+        QStringList match(QString const& pattern, QString const& base = QString(), int limit = -1) const;
+
+        /** True if the index contains @param name (case insensitive) */
+        bool contains(QString const& name) const;
+
+        /** All the names in sorted order */
+        QStringList names() const;
+
+        int size() const;
+
+        bool isEmpty() const
+        {
+            return size() == 0;
+        }
+
+    private:
+        struct Data
+        {
+            QString Names;              // all names concatenated, sorted by folded form
+            QString Folded;             // Names, case folded character by character (same offsets)
+            QVector<quint32> Offsets;   // name i is Names.mid(Offsets[i], Offsets[i + 1] - Offsets[i])
+            QVector<quint32> Rank;      // static rank of name i, lower is better
+        };
+
+        /** First name whose folded form is not less than @param key */
+        int lowerBound(QString const& key) const;
+
+        /** End of the range of names starting with @param key, begins at @param first */
+        int prefixEnd(QString const& key, int first) const;
+
+        QString name(int i) const;
+
+        QSharedPointer<Data const> d;
+};
+
+#endif
@@ -46,6 +46,125 @@
 #include "core/todatabaseconfig.h"
 
 #include <QMenu>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+#include <QtCore/QRunnable>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+
+#include <exception>
+
+namespace
+{
+    // how long borrowSub waits for a free session when the pool is exhausted
+    const int POOL_WAIT_MS = 60000;
+
+    // Minimal number of sessions, it can not exceed the number of cached idle sessions
+    // otherwise putBackSub would evict sessions the warmer logs on again
+    int poolMin()
+    {
+        return qMin(toConfigurationNewSingle::Instance().option(ToConfiguration::Database::PoolMinInt).toInt(),
+                    toConfigurationNewSingle::Instance().option(ToConfiguration::Database::CachedConnectionsInt).toInt());
+    }
+
+    bool isGuiThread()
+    {
+        return QCoreApplication::instance() && QThread::currentThread() == QCoreApplication::instance()->thread();
+    }
+
+    // Logons block for seconds, they get their own threads instead of QThreadPool::globalInstance()
+    // where they would hold up the filter, sort and export jobs
+    class LogonThreadPool : public QThreadPool
+    {
+        public:
+            LogonThreadPool()
+            {
+                // the warmer must not delay a logon the GUI thread waits for
+                setMaxThreadCount(qMax(2, QThread::idealThreadCount()));
+            }
+    };
+
+    Q_GLOBAL_STATIC(LogonThreadPool, logonPool)
+}
+
+/** Logs on the minimal number of sessions in a background thread, so that the first
+ *  background queries do not have to wait for a logon.
+ */
+class toConnection::PoolWarmer : public QRunnable
+{
+    public:
+        PoolWarmer(toConnection *conn) : Connection(conn) {}
+
+        void run() override
+        {
+            Connection->warmPool();
+        }
+    private:
+        toConnection *Connection;
+};
+
+/** Logs on one session in the logon pool for a thread which must not block (GUI) */
+class toConnection::Logon : public QRunnable
+{
+    public:
+        // Shared with the waiting thread, which may give up waiting (application exit)
+        struct State
+        {
+            QMutex Lock;
+            QEventLoop *Loop;       // NULL once the waiter gave up
+            bool Done;
+            toConnectionSub *Result;
+            std::exception_ptr Error;
+        };
+
+        Logon(toConnection *conn, QSharedPointer<State> const &state)
+            : Connection(conn)
+            , Shared(state)
+        {}
+
+        void run() override
+        {
+            toConnectionSub *sub = NULL;
+            std::exception_ptr error;
+            try
+            {
+                sub = Connection->addConnection();
+            }
+            catch (...)
+            {
+                error = std::current_exception();
+            }
+
+            {
+                QMutexLocker lock(&Shared->Lock);
+                Shared->Done = true;
+                Shared->Result = sub;
+                Shared->Error = error;
+                if (Shared->Loop)
+                {
+                    // queued, the loop may not be running yet
+                    QMetaObject::invokeMethod(Shared->Loop, "quit", Qt::QueuedConnection);
+                    return;
+                }
+            }
+
+            // nobody waits for the session, keep it in the pool (see addConnectionInBackground)
+            QMutexLocker clock(&Connection->ConnectionLock);
+            Connection->PoolCreating--;
+            if (sub)
+            {
+                Connection->Connections.insert(sub);
+                Connection->PoolStats.Created++;
+            }
+            Connection->PoolCondition.wakeAll();
+        }
+
+    private:
+        toConnection *Connection;
+        QSharedPointer<State> Shared;
+};
 
 toConnection::toConnection(const QString &provider,
                            const QString &user, const QString &password,
@@ -67,6 +186,9 @@ toConnection::toConnection(const QString &provider,
     , ConnectionOptions(provider, host, database, user, password, schema, color , 0, options)
     , pCache(NULL)
     , LoanCnt(0)
+    , InitGeneration(0)
+    , PoolCreating(0)
+    , PoolWarming(false)
 {
     pConnectionImpl = toConnectionProviderRegistrySing::Instance().get(provider).createConnectionImpl(*this);
     pTrait = toConnectionProviderRegistrySing::Instance().get(provider).createConnectionTrait();
@@ -74,6 +196,7 @@ toConnection::toConnection(const QString &provider,
     toConnectionSub* connSub = addConnection();
     Version = connSub->version();
     Connections.insert(connSub);
+    PoolStats.Created++;
 
     setDefaultSchema(schema);
 
@@ -86,6 +209,7 @@ toConnection::toConnection(const QString &provider,
         if (toConfigurationNewSingle::Instance().option(ToConfiguration::Database::ObjectCacheInt).toInt() == toCache::ON_CONNECT)
             pCache->readCache();
     }
+    startPoolWarmer();
 }
 
 toConnection::toConnection(const toConnectionOptions &opts)
@@ -103,6 +227,9 @@ toConnection::toConnection(const toConnectionOptions &opts)
     , ConnectionOptions(opts)
     , pCache(NULL)
     , LoanCnt(0)
+    , InitGeneration(0)
+    , PoolCreating(0)
+    , PoolWarming(false)
 {
     pConnectionImpl = toConnectionProviderRegistrySing::Instance().get(Provider).createConnectionImpl(*this);
     pTrait = toConnectionProviderRegistrySing::Instance().get(Provider).createConnectionTrait();
@@ -110,6 +237,7 @@ toConnection::toConnection(const toConnectionOptions &opts)
     toConnectionSub* connSub = addConnection();
     Version = connSub->version();
     Connections.insert(connSub);
+    PoolStats.Created++;
 
     setDefaultSchema(opts.schema);
 
@@ -122,6 +250,7 @@ toConnection::toConnection(const toConnectionOptions &opts)
         if (toConfigurationNewSingle::Instance().option(ToConfiguration::Database::ObjectCacheInt) == toCache::ON_CONNECT)
             pCache->readCache();
     }
+    startPoolWarmer();
 }
 
 toConnection::toConnection(const toConnection &other)
@@ -140,6 +269,9 @@ toConnection::toConnection(const toConnection &other)
     , ConnectionOptions(other.ConnectionOptions)
     , pCache(NULL)
     , LoanCnt(0)
+    , InitGeneration(0)
+    , PoolCreating(0)
+    , PoolWarming(false)
 {
     //tool Connection = toConnectionProvider::connection(Provider, this);
     //ConnectionPool = new toConnectionPool(this);
@@ -165,15 +297,14 @@ toConnectionSub* toConnection::addConnection()
 
 void toConnection::closeConnection(toConnectionSub *sub)
 {
-    if (Connections.contains(sub))
     {
-        sub->close();
+        QMutexLocker clock(&ConnectionLock);
+        if (!Connections.contains(sub))
+            throw exception("Can not close non-existing toConnectionSub");
         Connections.remove(sub);
-//    } else if (LentConnections.contains(sub)) {
-//    	sub->cancel();
+        PoolStats.Evicted++;
     }
-    else
-        throw exception("Can not close non-existing toConnectionSub");
+    evictConnections(QList<toConnectionSub*>() << sub);
 }
 
 QList<QString> toConnection::running(void) const
@@ -211,6 +342,13 @@ toConnection::~toConnection()
     Q_ASSERT_X( LoanCnt.loadAcquire() == 0 , qPrintable(__QHERE__), "toConnection deleted while BG query is running");
 #endif
 
+    {
+        // wait for sessions being logged on in background
+        QMutexLocker lock(&ConnectionLock);
+        while (PoolWarming || PoolCreating)
+            PoolCondition.wait(&ConnectionLock);
+    }
+
     if(pCache)
     {
     	unsigned cacheNewRefCnt;
@@ -231,7 +369,13 @@ toConnection::~toConnection()
         //delete ConnectionPool;
         //ConnectionPool = 0;
 
-        QMutexLocker lock(&ConnectionLock);
+        QList<toConnectionSub*> idle;
+        {
+            QMutexLocker lock(&ConnectionLock);
+            idle = Connections.toList();
+            Connections.clear();
+        }
+        evictConnections(idle);
     }
     delete pConnectionImpl;
 }
@@ -335,12 +479,29 @@ void toConnection::connectionsMenu(QMenu *menu)
         delete a;
     }
 
+    PoolStatistics stats = poolStatistics();
+    menu->addAction(tr("Sessions: %1 busy, %2 idle, %3 logging on")
+                    .arg(stats.Lent).arg(stats.Idle).arg(stats.Creating))->setEnabled(false);
+    menu->addAction(tr("Logons: %1, evicted: %2, waits: %3 (avg %4 ms, max %5 ms)")
+                    .arg(stats.Created)
+                    .arg(stats.Evicted)
+                    .arg(stats.Waits)
+                    .arg(stats.Waits ? stats.WaitMs / stats.Waits : 0)
+                    .arg(stats.MaxWaitMs))->setEnabled(false);
+    menu->addAction(tr("Schema switches: %1, avoided: %2")
+                    .arg(stats.SchemaSwitched)
+                    .arg(stats.SchemaReused))->setEnabled(false);
+    menu->addSeparator();
+
     QMutexLocker clock(&ConnectionLock);
     QMenu *active = menu->addMenu(tr("Active connections"));
     active->setDisabled(true);
     Q_FOREACH(toConnectionSub* conn, LentConnections)
     {
         QMenu *sess = menu->addMenu(conn->sessionId().first()+" "+conn->lastSql());
+        QString stats = conn->statistics();
+        if (!stats.isEmpty())
+            sess->addAction(stats)->setEnabled(false);
         QAction *cancel = new QAction("Cancel", this);
         cancel->setData(VPtr<toConnectionSub>::asQVariant(conn));
         sess->addAction(cancel);
@@ -353,6 +514,9 @@ void toConnection::connectionsMenu(QMenu *menu)
     Q_FOREACH(toConnectionSub* conn, Connections)
     {
         QMenu *sess = menu->addMenu(conn->sessionId().first()+" "+conn->lastSql());
+        QString stats = conn->statistics();
+        if (!stats.isEmpty())
+            sess->addAction(stats)->setEnabled(false);
         QAction *close = new QAction("Close", this);
         close->setData(VPtr<toConnectionSub>::asQVariant(conn));
         sess->addAction(close);
@@ -418,16 +582,32 @@ void toConnection::setDefaultSchema(QString const & schema)
 
 void toConnection::setInit(const QString &key, const QString &sql)
 {
+    QMutexLocker clock(&ConnectionLock);
+    // pooled sessions rerun the init SQL on a generation change, so skip no-op updates
+    QMap<QString, QString>::const_iterator i = InitStrings.constFind(key);
+    if (i != InitStrings.constEnd() && i.value() == sql)
+        return;
     InitStrings.insert(key, sql);
+    InitGeneration++;
 }
 
 void toConnection::delInit(const QString &key)
 {
-    InitStrings.remove(key);
+    QMutexLocker clock(&ConnectionLock);
+    if (InitStrings.remove(key))
+        InitGeneration++;
 }
 
 QList<QString> toConnection::initStrings() const
 {
+    QMutexLocker clock(&ConnectionLock);
+    return InitStrings.values();
+}
+
+QList<QString> toConnection::initStrings(int &generation) const
+{
+    QMutexLocker clock(&ConnectionLock);
+    generation = InitGeneration;
     return InitStrings.values();
 }
 
@@ -443,15 +623,112 @@ toConnection& toConnection::currentConnection(QObject *cur)
     throw qApp->translate("toConnection::currentConnection", "Couldn't find parent connection. Internal error.");
 }
 
-toConnectionSub* toConnection::borrowSub()
+toConnectionSub* toConnection::borrowSub(QString const& schema)
 {
-    QMutexLocker clock(&ConnectionLock);
-    if (!Connections.empty())
+    QElapsedTimer timer;
+    timer.start();
+    bool waited = false;
+    // GUI thread must not block, it gets a session over the limit (PoolMaxInt) instead
+    // and logs it on in the logon pool
+    bool overflow = isGuiThread();
+
+    forever
     {
-        toConnectionSub* retval = *(Connections.begin());
-        Connections.remove(retval);
-        LentConnections.insert(retval);
-        LoanCnt.fetchAndAddAcquire(1);
+        toConnectionSub *retval = NULL;
+        {
+            QMutexLocker clock(&ConnectionLock);
+            int max = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::PoolMaxInt).toInt();
+            while (!overflow && Connections.empty() && max > 0 && Connections.size() + LentConnections.size() + PoolCreating >= max)
+            {
+                waited = true;
+                qint64 left = POOL_WAIT_MS - timer.elapsed();
+                if (left <= 0 || !PoolCondition.wait(&ConnectionLock, (unsigned long) left))
+                    throw exception(tr("All %1 database sessions are busy").arg(max));
+            }
+
+            if (!Connections.empty())
+            {
+                // Prefer session already switched into the schema, then one with current init strings.
+                // Take the most recently used one of equal sessions, so the others can age out
+                int best = -1;
+                Q_FOREACH(toConnectionSub *conn, Connections)
+                {
+                    int score = (!schema.isEmpty() && conn->schema() == schema ? 2 : 0)
+                                + (conn->initGeneration() == InitGeneration ? 1 : 0);
+                    if (score > best || (score == best && conn->lastUsed() > retval->lastUsed()))
+                    {
+                        retval = conn;
+                        best = score;
+                    }
+                }
+                Connections.remove(retval);
+                LentConnections.insert(retval);
+                LoanCnt.fetchAndAddAcquire(1);
+            }
+            else
+            {
+                waited = true;
+                PoolCreating++;
+            }
+        }
+
+        if (retval)
+        {
+            // Validate session which was idle longer than test interval
+            int interval = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::ConnTestIntervalInt).toInt();
+            if (interval > 0 && retval->lastUsed().secsTo(QDateTime::currentDateTime()) >= interval && !retval->ping())
+            {
+                {
+                    QMutexLocker clock(&ConnectionLock);
+                    LentConnections.remove(retval);
+                    LoanCnt.deref();
+                    PoolStats.Evicted++;
+                    PoolCondition.wakeOne();
+                }
+                TLOG(7, toDecorator, __HERE__) << "Idle session failed validation, evicted" << std::endl;
+                evictConnections(QList<toConnectionSub*>() << retval);
+                continue;
+            }
+        }
+        else
+        {
+            // Log on outside of ConnectionLock, other threads can still borrow and put back sessions
+            try
+            {
+                retval = overflow ? addConnectionInBackground() : addConnection();
+            }
+            catch (...)
+            {
+                QMutexLocker clock(&ConnectionLock);
+                PoolCreating--;
+                PoolCondition.wakeOne();
+                throw;
+            }
+        }
+
+        QMutexLocker clock(&ConnectionLock);
+        if (!LentConnections.contains(retval))
+        {
+            PoolCreating--;
+            PoolStats.Created++;
+            LentConnections.insert(retval);
+            LoanCnt.fetchAndAddAcquire(1);
+        }
+        PoolStats.Borrows++;
+        if (!schema.isEmpty())
+        {
+            if (retval->schema() == schema)
+                PoolStats.SchemaReused++;
+            else
+                PoolStats.SchemaSwitched++;
+        }
+        if (waited)
+        {
+            quint64 ms = timer.elapsed();
+            PoolStats.Waits++;
+            PoolStats.WaitMs += ms;
+            PoolStats.MaxWaitMs = qMax(PoolStats.MaxWaitMs, ms);
+        }
 #if QT_VERSION < 0x050000
         Q_ASSERT_X((int)LoanCnt == LentConnections.size(), qPrintable(__QHERE__), "Invalid number of lent toConnectionSub(s)");
 #else
@@ -459,50 +736,190 @@ toConnectionSub* toConnection::borrowSub()
 #endif
         return retval;
     }
-    else
+}
+
+void toConnection::putBackSub(toConnectionSub *conn)
+{
+    try
+    {
+        if (conn->hasTransaction())
+            conn->rollback();
+    }
+    TOCATCH
+
+    QList<toConnectionSub*> evicted;
     {
-        toConnectionSub* retval = addConnection();
-        LoanCnt.fetchAndAddAcquire(1);
-        LentConnections.insert(retval);
+        QMutexLocker clock(&ConnectionLock);
+        Q_ASSERT_X( !Connections.contains(conn) , qPrintable(__QHERE__), "Invalid use of toConnectionSubLoan");
+        LoanCnt.deref();
+
+        bool removed = LentConnections.remove(conn);
+        Q_ASSERT_X(removed, qPrintable(__QHERE__), "Lent connection not found");
+
+        int max = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::PoolMaxInt).toInt();
+        if (conn->isBroken())
+            evicted << conn;
+        else if (Connections.size() >= toConfigurationNewSingle::Instance().option(ToConfiguration::Database::CachedConnectionsInt).toInt())
+            evicted << conn;
+        else if (max > 0 && Connections.size() + LentConnections.size() + PoolCreating >= max)
+            evicted << conn; // session lent to GUI thread over the limit
+        else
+        {
+            conn->setLastUsed();
+            Connections.insert(conn);
+        }
+        evicted << agedConnections();
+        PoolStats.Evicted += evicted.size();
+        PoolCondition.wakeOne();
 #if QT_VERSION < 0x050000
         Q_ASSERT_X((int)LoanCnt == LentConnections.size(), qPrintable(__QHERE__), "Invalid number of lent toConnectionSub(s)");
 #else
         Q_ASSERT_X(LoanCnt.loadAcquire() == LentConnections.size(), qPrintable(__QHERE__), "Invalid number of lent toConnectionSub(s)");
 #endif
-        return retval;
+    }
+
+    if (!evicted.isEmpty())
+    {
+        evictConnections(evicted);
+        startPoolWarmer();
     }
 }
 
-void toConnection::putBackSub(toConnectionSub *conn)
+toConnectionSub* toConnection::addConnectionInBackground()
 {
+    QEventLoop loop;
+    QSharedPointer<Logon::State> state(new Logon::State);
+    state->Loop = &loop;
+    state->Done = false;
+    state->Result = NULL;
+    logonPool()->start(new Logon(this, state));
+
+    // keep repainting, but do not let the user start anything else meanwhile
+    loop.exec(QEventLoop::ExcludeUserInputEvents);
+
+    QMutexLocker lock(&state->Lock);
+    state->Loop = NULL;
+    if (!state->Done)
+    {
+        // the loop was quit by the application, the job puts the session into the pool
+        // and holds the PoolCreating count (released by the caller) until it finishes
+        QMutexLocker clock(&ConnectionLock);
+        PoolCreating++;
+        throw exception(tr("Logon interrupted"));
+    }
+    if (state->Error)
+        std::rethrow_exception(state->Error);
+    return state->Result;
+}
+
+void toConnection::startPoolWarmer()
+{
+    if (ConnectionOptions.options.contains("TEST"))
+        return;
+
     QMutexLocker clock(&ConnectionLock);
-    Q_ASSERT_X( !Connections.contains(conn) , qPrintable(__QHERE__), "Invalid use of toConnectionSubLoan");
-    LoanCnt.deref();
+    int min = poolMin();
+    if (Abort || PoolWarming || Connections.size() + LentConnections.size() + PoolCreating >= min)
+        return;
+    PoolWarming = true;
+    logonPool()->start(new PoolWarmer(this));
+}
 
-    try
+void toConnection::warmPool()
+{
+    forever
     {
-        if (conn->hasTransaction())
-            conn->rollback();
+        {
+            QMutexLocker clock(&ConnectionLock);
+            int min = poolMin();
+            int max = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::PoolMaxInt).toInt();
+            int total = Connections.size() + LentConnections.size() + PoolCreating;
+            if (Abort || total >= min || (max > 0 && total >= max))
+            {
+                PoolWarming = false;
+                PoolCondition.wakeAll();
+                return;
+            }
+            PoolCreating++;
+        }
+
+        toConnectionSub *sub = NULL;
+        try
+        {
+            sub = addConnection();
+        }
+        catch (QString const& e)
+        {
+            TLOG(1, toDecorator, __HERE__) << "Background logon failed: " << e << std::endl;
+        }
+        catch (...)
+        {
+            TLOG(1, toDecorator, __HERE__) << "Background logon failed" << std::endl;
+        }
+
+        QMutexLocker clock(&ConnectionLock);
+        PoolCreating--;
+        if (sub == NULL)
+        {
+            // Do not retry, the next put back session will queue a new job
+            PoolWarming = false;
+            PoolCondition.wakeAll();
+            return;
+        }
+        Connections.insert(sub);
+        PoolStats.Created++;
+        PoolCondition.wakeAll();
     }
-    TOCATCH
+}
+
+QList<toConnectionSub*> toConnection::agedConnections()
+{
+    QList<toConnectionSub*> retval;
+    int timeout = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::PoolIdleTimeoutInt).toInt();
+    if (timeout <= 0)
+        return retval;
 
-    if (conn->isBroken())
+    int min = poolMin();
+    int total = Connections.size() + LentConnections.size() + PoolCreating;
+    QDateTime now = QDateTime::currentDateTime();
+    Q_FOREACH(toConnectionSub *conn, Connections)
     {
-        delete conn;
+        if (total - retval.size() <= min)
+            break;
+        if (conn->lastUsed().secsTo(now) >= timeout)
+            retval << conn;
+    }
+    Q_FOREACH(toConnectionSub *conn, retval)
+    {
+        Connections.remove(conn);
     }
-    else if (Connections.size() >= toConfigurationNewSingle::Instance().option(ToConfiguration::Database::CachedConnectionsInt).toInt())
+    return retval;
+}
+
+void toConnection::evictConnections(QList<toConnectionSub*> const& subs)
+{
+    Q_FOREACH(toConnectionSub *conn, subs)
     {
+        try
+        {
+            conn->close();
+        }
+        catch (QString const& e)
+        {
+            TLOG(1, toDecorator, __HERE__) << "Failed to close session: " << e << std::endl;
+        }
         delete conn;
     }
-    else
-        Connections.insert(conn);
-    bool removed = LentConnections.remove(conn);
-    Q_ASSERT_X(removed, qPrintable(__QHERE__), "Lent connection not found");
-#if QT_VERSION < 0x050000
-    Q_ASSERT_X((int)LoanCnt == LentConnections.size(), qPrintable(__QHERE__), "Invalid number of lent toConnectionSub(s)");
-#else
-    Q_ASSERT_X(LoanCnt.loadAcquire() == LentConnections.size(), qPrintable(__QHERE__), "Invalid number of lent toConnectionSub(s)");
-#endif
+}
+
+toConnection::PoolStatistics toConnection::poolStatistics() const
+{
+    QMutexLocker clock(&ConnectionLock);
+    PoolStatistics retval(PoolStats);
+    retval.Idle = Connections.size();
+    retval.Lent = LentConnections.size();
+    retval.Creating = PoolCreating;
+    return retval;
 }
 
 void toConnection::allExecute(QString const& sql)
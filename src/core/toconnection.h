@@ -45,6 +45,7 @@
 #include <QtCore/QMap>
 #include <QtCore/QMetaType>
 #include <QtCore/QMutex>
+#include <QtCore/QWaitCondition>
 #include <QtCore/QVariant>
 #include <QtCore/QDateTime>
 #include <QtCore/QAtomicInt>
@@ -110,6 +111,32 @@ class toConnection : public QObject
          */
         virtual ~toConnection();
 
+        /** Counters of the pool of @ref toConnectionSub instances */
+        struct PoolStatistics
+        {
+            int Idle;          // sessions waiting in the pool
+            int Lent;          // sessions running a query
+            int Creating;      // sessions being logged on
+            quint64 Borrows;   // number of borrowSub calls
+            quint64 Waits;     // borrows which had to wait for a session
+            quint64 WaitMs;    // total time spent waiting for a session
+            quint64 MaxWaitMs; // longest wait for a session
+            quint64 Created;   // sessions logged on
+            quint64 Evicted;   // sessions closed by the pool (broken, surplus, aged out)
+            quint64 SchemaReused;   // borrows for a schema which got a session already switched into it
+            quint64 SchemaSwitched; // borrows for a schema which need to switch the session
+
+            PoolStatistics()
+                : Idle(0), Lent(0), Creating(0)
+                , Borrows(0), Waits(0), WaitMs(0), MaxWaitMs(0)
+                , Created(0), Evicted(0)
+                , SchemaReused(0), SchemaSwitched(0)
+            {}
+        };
+
+        /** Get a snapshot of connection pool counters */
+        PoolStatistics poolStatistics() const;
+
         // GETTERS
         /** Get provider name of connection. */
         inline QString const& provider() const
@@ -284,10 +311,10 @@ class toConnection : public QObject
          */
         class exception : public QString
         {
-                int Offset, Line, Column;
+                int Offset, Line, Column, Row;
             public:
                 /** Create an empty exception */
-                inline exception() : QString(), Offset(-1), Line(-1), Column(-1) {}
+                inline exception() : QString(), Offset(-1), Line(-1), Column(-1), Row(-1) {}
 
                 /** Create an exception with a string description. */
                 inline exception(const QString &str, int offset = -1, int line = -1, int column = -1)
@@ -295,6 +322,7 @@ class toConnection : public QObject
                     , Offset(offset)
                     , Line(line)
                     , Column(column)
+                    , Row(-1)
                 {}
 
                 /** Get the offset of the error of the current statement. */
@@ -312,6 +340,17 @@ class toConnection : public QObject
                 {
                     return Column;
                 }
+
+                /** Row of array DML (@ref toQueryArray) which failed, -1 if not known */
+                inline int row() const
+                {
+                    return Row;
+                }
+
+                inline void setRow(int row)
+                {
+                    Row = row;
+                }
         };
 
         /** This class is an abstract baseclass to actually implement the communication with the
@@ -369,13 +408,32 @@ class toConnection : public QObject
                 }
         };
 
-        toConnectionSub* borrowSub();
+        /** Lend a session, prefer an idle one already switched into the schema and with current init strings */
+        toConnectionSub* borrowSub(QString const& schema = QString());
         void putBackSub(toConnectionSub*);
+
+        /** Get init strings together with their generation (incremented by setInit/delInit) */
+        QList<QString> initStrings(int &generation) const;
         friend class toConnectionSubLoan;
 
         toConnectionSub* addConnection(void);
+        /** addConnection() run in the logon thread pool, the calling thread processes events meanwhile */
+        toConnectionSub* addConnectionInBackground(void);
         void closeConnection(toConnectionSub *sub);
 
+        /** Queue @ref PoolWarmer job unless the pool already holds its minimal size */
+        void startPoolWarmer(void);
+        /** Log on sessions until the pool holds its minimal size, runs in PoolWarmer job */
+        void warmPool(void);
+        /** Remove sessions idle for too long (above pool minimum) from Connections, ConnectionLock must be held */
+        QList<toConnectionSub*> agedConnections(void);
+        /** Close sessions removed from the pool, called outside of ConnectionLock */
+        void evictConnections(QList<toConnectionSub*> const&);
+        class PoolWarmer;
+        friend class PoolWarmer;
+        class Logon;
+        friend class Logon;
+
         QString Provider;
         QString User;
         QString Password;
@@ -394,6 +452,12 @@ class toConnection : public QObject
         toCache *pCache;
         QAtomicInt LoanCnt;
         QSet<QAction*> ConnectionActions;
+        int InitGeneration;           // incremented whenever InitStrings change
+
+        QWaitCondition PoolCondition; // signalled when a session is put back or logon finishes
+        int PoolCreating;             // sessions being logged on outside of ConnectionLock
+        bool PoolWarming;             // PoolWarmer job is queued or running
+        PoolStatistics PoolStats;
 }; // toConnection
 
 Q_DECLARE_METATYPE(toConnection::exception);
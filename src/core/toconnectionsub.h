@@ -21,7 +21,7 @@ class TORA_EXPORT toConnectionSub
     public:
 
         /** Create connection to database. */
-        toConnectionSub() : Query(NULL), Broken(false), Initialized(false), mutex(QMutex::NonRecursive) {}
+        toConnectionSub() : Query(NULL), Broken(false), InitGeneration(-1), LastUsed(QDateTime::currentDateTime()), mutex(QMutex::NonRecursive) {}
 
         /** Close connection. */
         virtual ~toConnectionSub() {}
@@ -65,6 +65,18 @@ class TORA_EXPORT toConnectionSub
 
         virtual bool hasTransaction();
 
+        /** Check that the session is still alive (cheap round trip). Providers without it rely on the Broken flag */
+        virtual bool ping()
+        {
+            return !Broken;
+        }
+
+        /** Provider specific usage statistics (e.g. statement cache hits), empty if none */
+        virtual QString statistics()
+        {
+            return QString();
+        }
+
         virtual queryImpl* createQuery(toQueryAbstr *query) = 0;
 
         /** get additional details about db object */
@@ -87,14 +99,15 @@ class TORA_EXPORT toConnectionSub
             return Broken;
         }
 
-        inline bool isInitialized()
+        /** Generation of @ref toConnection::initStrings executed in this session, -1 if none */
+        inline int initGeneration() const
         {
-            return Initialized;
+            return InitGeneration;
         }
 
-        inline void setInitialized(bool initialized)
+        inline void setInitGeneration(int generation)
         {
-            Initialized = initialized;
+            InitGeneration = generation;
         }
 
         inline QString const& schema() const
@@ -122,7 +135,8 @@ class TORA_EXPORT toConnectionSub
         }
 
         toQueryAbstr *Query;
-        bool Broken, Initialized;
+        bool Broken;
+        int InitGeneration;
         QString Schema;
         QDateTime LastUsed; // last time this db connection was actually used
 
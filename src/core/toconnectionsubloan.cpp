@@ -47,7 +47,7 @@ toConnectionSubLoan::toConnectionSubLoan(toConnection &con, QString const & sche
     : ParentConnection(con)
     , SchemaInitialized(false)
     , Schema(schema)
-    , ConnectionSub(con.borrowSub())
+    , ConnectionSub(con.borrowSub(schema))
 {
     Q_ASSERT_X(!schema.isEmpty(), qPrintable(__QHERE__), "schema is empty");
     SchemaInitialized = ConnectionSub->schema() == schema;
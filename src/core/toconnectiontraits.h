@@ -91,6 +91,15 @@ class toConnectionTraits
          */
         virtual bool hasAsyncBreak() const = 0;
 
+        /** Check if connection provider can execute DML statement for a batch of bind
+         *  variable rows at once (see @ref toQueryArray).
+         *  Bind variables use the trotl syntax :name<char[length],in[rows]>
+         */
+        virtual bool hasArrayDML() const
+        {
+            return false;
+        }
+
         /**
          * Return list of primary key columns for a table
          * By default return an empty list => table can not be modified using toResultTableViewEdit
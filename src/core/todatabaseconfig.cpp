@@ -77,6 +77,26 @@ QVariant ToConfiguration::Database::defaultValue(int option) const
             return QVariant((bool)true);
         case IncludeParallelBool:
             return QVariant((bool)true);
+        case QueryThreadsInt:
+            return QVariant((int)8);
+        case QueryThreadWaitInt:
+            return QVariant((int)2000);
+        case AdaptiveFetchBool:
+            return QVariant((bool)true);
+        case FetchTimeBudgetInt:
+            return QVariant((int)200);
+        case FetchByteBudgetInt:
+            return QVariant((int)4096);
+        case FetchArrayMemoryInt:
+            return QVariant((int)1024);
+        case ResultSpillThresholdInt:
+            return QVariant((int)512);
+        case PoolMinInt:
+            return QVariant((int)2);
+        case PoolMaxInt:
+            return QVariant((int)32);
+        case PoolIdleTimeoutInt:
+            return QVariant((int)600);
         default:
             Q_ASSERT_X( false, qPrintable(__QHERE__), qPrintable(QString("Context Database un-registered enum value: %1").arg(option)));
             return QVariant();
@@ -64,6 +64,16 @@ namespace ToConfiguration
                 , IncludeHeaderBool        // #define CONF_EXT_INC_HEADER
                 , IncludePromptBool        // #define CONF_EXT_INC_PROMPT
                 , IncludeParallelBool      // #define CONF_EXT_INC_PARALLEL
+                , QueryThreadsInt          // number of pooled toEventQuery worker threads
+                , QueryThreadWaitInt       // ms a queued query waits before an extra thread is spawned
+                , AdaptiveFetchBool        // size fetched chunks of rows by time/memory budget
+                , FetchTimeBudgetInt       // ms per fetched chunk of rows (adaptive fetch)
+                , FetchByteBudgetInt       // KB per fetched chunk of rows (adaptive fetch)
+                , FetchArrayMemoryInt      // KB of array fetch buffers per statement (0 = fixed array size)
+                , ResultSpillThresholdInt  // MB of result rows held in memory, the rest is spilled to disk (0 = never)
+                , PoolMinInt               // sessions per connection logged on in advance
+                , PoolMaxInt               // max. sessions per connection, background borrowers wait, GUI thread exceeds it (0 = unlimited)
+                , PoolIdleTimeoutInt       // seconds after which an idle session above PoolMinInt is closed (0 = never)
             };
             virtual QVariant defaultValue(int) const;
     };
@@ -36,11 +36,14 @@
 #include "core/utils.h"
 #include "core/tologger.h"
 #include "core/toeventqueryworker.h"
+#include "core/toeventquerypool.h"
 //#include "widgets/toresultstats.h"
 #include "core/toconnection.h"
 #include "core/toconnectionsub.h"
 #include "core/toconnectionsubloan.h"
 #include "core/toconnectiontraits.h"
+#include "core/toconfiguration.h"
+#include "core/todatabaseconfig.h"
 
 toEventQuery::toEventQuery(QObject *parent
                            , toConnection &conn
@@ -51,6 +54,9 @@ toEventQuery::toEventQuery(QObject *parent
                            //, toResultStats *stats
                           )
     : QObject(parent)
+    , BatchRow(0)
+    , BatchColumn(0)
+    , Buffered(0)
     , SQL(sql)
     , Param(param)
     , ColumnCount(0)
@@ -60,16 +66,15 @@ toEventQuery::toEventQuery(QObject *parent
     , Worker(NULL)
     , Started(false)
     , WorkDone(false)
+    , Queued(false)
+    , Priority(PRIORITY_NORMAL)
+    , QueueWait(0)
     , Connection(new toConnectionSubLoan(conn))
     , CancelCondition(new toEventQuery::WaitConditionWithMutex())
     , Mode(mode)
 {
-    /* BIG FAT WARNING QThread's parent must be  NULL, so it is not disposed when toEventQuery is deleted.
-     * Theoretically (and practically) it can be freed after ~toEventQuery is processed
-     */
-    Thread = new BGThread(NULL);
-    Thread->setObjectName("toEventQuery");
     TLOG(7, toDecorator, __HERE__) << "toEventQuery created" << std::endl;
+    FetchOpts.MemoryBudget = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::FetchArrayMemoryInt).toInt() * 1024;
 }
 
 toEventQuery::toEventQuery(QObject *parent
@@ -81,6 +86,9 @@ toEventQuery::toEventQuery(QObject *parent
                            //, toResultStats *stats
                           )
     : QObject(parent)
+    , BatchRow(0)
+    , BatchColumn(0)
+    , Buffered(0)
     , SQL(sql)
     , Param(param)
     , ColumnCount(0)
@@ -90,16 +98,15 @@ toEventQuery::toEventQuery(QObject *parent
     , Worker(NULL)
     , Started(false)
     , WorkDone(false)
+    , Queued(false)
+    , Priority(PRIORITY_NORMAL)
+    , QueueWait(0)
     , Connection(conn)
     , CancelCondition(new toEventQuery::WaitConditionWithMutex())
     , Mode(mode)
 {
-    /* BIG FAT WARNING QThread's parent must be  NULL, so it is not disposed when toEventQuery is deleted.
-     * Theoretically (and practically) it can be freed after ~toEventQuery is processed
-     */
-    Thread = new BGThread(NULL);
-    Thread->setObjectName("toEventQuery");
     TLOG(7, toDecorator, __HERE__) << "toEventQuery created" << std::endl;
+    FetchOpts.MemoryBudget = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::FetchArrayMemoryInt).toInt() * 1024;
 }
 
 toEventQuery::~toEventQuery()
@@ -111,9 +118,21 @@ toEventQuery::~toEventQuery()
 
 void toEventQuery::start()
 {
-    if ( Worker || Started || WorkDone )
+    if ( Worker || Started || WorkDone || Queued )
         throw tr("toEventQuery::start - can not restart already stared query");
 
+    TLOG(7, toDecorator, __HERE__) << "toEventQuery start" << std::endl;
+    // the pool calls attachThread once a thread is available (possibly right now)
+    Queued = true;
+    toEventQueryPoolSingle::Instance().schedule(this);
+}
+
+void toEventQuery::attachThread(BGThread *thread, unsigned long waited)
+{
+    Queued = false;
+    QueueWait = waited;
+    Thread = thread;
+
     Worker = new toEventQueryWorker(this, Connection, CancelCondition, SQL, Param);
     Worker->moveToThread(Thread);
     Thread->Slave = Worker;
@@ -122,8 +141,8 @@ void toEventQuery::start()
     connect(Worker, SIGNAL(headers(toQColumnDescriptionList &, int)),      //  BG -> main
             this, SLOT(slotDesc(toQColumnDescriptionList &, int)));
 
-    connect(Worker, SIGNAL(data(const ValuesList &)),                      //  BG -> main
-            this, SLOT(slotData(const ValuesList &)));
+    connect(Worker, SIGNAL(data(toQueryBatchPtr)),                         //  BG -> main
+            this, SLOT(slotData(toQueryBatchPtr)));
 
     connect(Worker, SIGNAL(error(const toConnection::exception &)),        //  BG -> main
             this, SLOT(slotError(const toConnection::exception &)));
@@ -135,26 +154,24 @@ void toEventQuery::start()
             this, SLOT(slotRowsProcessed(unsigned long)));
 
     connect(this,   SIGNAL(dataRequested()),  Worker, SLOT(slotRead()));   // main -> BG
+    connect(this,   SIGNAL(dataRequested()),  this,   SLOT(slotDataRequested()));
 
-    connect(this,   SIGNAL(consumed()),       Worker, SLOT(slotRead()));   // main -> BG
+    connect(this,   SIGNAL(consumed()),       Worker, SLOT(slotConsumed()));   // main -> BG
 
     // Connect to QThread's API
     //  error handling
     connect(Worker, SIGNAL(error(toConnection::exception const &))         //  BG -> main
             , this, SLOT(slotError(toConnection::exception const &)));
     //  initization
-    connect(Thread, SIGNAL(started()),        Worker, SLOT(init()));       // main -> BG
     connect(Worker, SIGNAL(started()),        this,   SLOT(slotStarted()));// BG   -> main
-    //  finish
-    connect(Worker, SIGNAL(finished()),       Thread, SLOT(quit()));          // BG -> BG?? (quit event loop)
-    connect(Worker, SIGNAL(finished()),       Worker, SLOT(deleteLater()));   // BG -> BG
-    connect(Thread, SIGNAL(finished()),       Thread, SLOT(deleteLater()));   // BG -> main
-    connect(Thread, SIGNAL(destroyed()),      this,   SLOT(slotThreadEnd())); // main -> main
-    connect(this,   SIGNAL(stopRequested()),  Worker, SLOT(slotStop()));      // main -> BG
-
-    TLOG(7, toDecorator, __HERE__) << "toEventQuery start" << std::endl;
-    // finally start the thread
-    Thread->start();
+    //  finish, the thread keeps running and is returned into the pool
+    connect(Worker, SIGNAL(finished()),       Worker, SLOT(deleteLater()));         // BG -> BG
+    connect(Worker, SIGNAL(destroyed()),      Thread, SLOT(slotSlaveDestroyed()));  // BG -> main
+    connect(Worker, SIGNAL(destroyed()),      this,   SLOT(slotThreadEnd()));       // BG -> main
+    connect(this,   SIGNAL(stopRequested()),  Worker, SLOT(slotStop()));            // main -> BG
+
+    // the thread is already running, init is processed by its event loop
+    QMetaObject::invokeMethod(Worker, "init", Qt::QueuedConnection);
 }
 
 void toEventQuery::setFetchMode(FETCH_MODE m)
@@ -164,6 +181,59 @@ void toEventQuery::setFetchMode(FETCH_MODE m)
     Mode = m;
 }
 
+void toEventQuery::setPriority(PRIORITY p)
+{
+    Priority = p;
+}
+
+toEventQuery::PRIORITY toEventQuery::priority(void) const
+{
+    return Priority;
+}
+
+unsigned long toEventQuery::queueWait(void) const
+{
+    return QueueWait;
+}
+
+void toEventQuery::setFetchOptions(toQueryAbstr::FetchOptions const& options)
+{
+    FetchOpts = options;
+}
+
+toQueryAbstr::FetchOptions const& toEventQuery::fetchOptions(void) const
+{
+    return FetchOpts;
+}
+
+toEventQuery::FetchStatistics::FetchStatistics()
+    : Batches(0)
+    , FirstBatch(0)
+    , MinBatch(0)
+    , MaxBatch(0)
+    , LastBatch(0)
+    , Rows(0)
+    , Bytes(0)
+{}
+
+QString toEventQuery::FetchStatistics::toString() const
+{
+    if (Batches == 0)
+        return QString();
+    return toEventQuery::tr("%1 rows fetched in %2 chunks (first %3, min %4, max %5, last %6 rows)")
+           .arg(Rows)
+           .arg(Batches)
+           .arg(FirstBatch)
+           .arg(MinBatch)
+           .arg(MaxBatch)
+           .arg(LastBatch);
+}
+
+toEventQuery::FetchStatistics const& toEventQuery::fetchStatistics(void) const
+{
+    return FetchStats;
+}
+
 toQColumnDescriptionList const& toEventQuery::describe(void) const
 {
     return Description;
@@ -189,13 +259,53 @@ unsigned long toEventQuery::rowsProcessed(void) const
  */
 toQValue toEventQuery::readValue()
 {
-    if (Values.isEmpty())
+    if (Batches.isEmpty())
         throw tr("Read past end of query");
 
-    if ((Values.size() == ColumnCount) && !eof())
+    if ((Buffered == ColumnCount) && !eof())
         emit dataRequested();
 
-    return Values.takeFirst();
+    toQueryBatchPtr batch = Batches.first();
+    toQValue retval = batch->value(BatchRow, BatchColumn);
+    Buffered--;
+    if (++BatchColumn == batch->columns())
+    {
+        BatchColumn = 0;
+        if (++BatchRow == batch->rows())
+        {
+            BatchRow = 0;
+            Batches.removeFirst();
+        }
+    }
+    return retval;
+}
+
+toQueryBatchPtr toEventQuery::takeBatch(unsigned maxRows)
+{
+    if (Batches.isEmpty())
+        throw tr("Read past end of query");
+    if (BatchColumn != 0)
+        throw tr("toEventQuery::takeBatch - row was partially read");
+
+    toQueryBatchPtr batch = Batches.first();
+    unsigned rows = qMin(maxRows, batch->rows() - BatchRow);
+    toQueryBatchPtr retval = (BatchRow == 0 && rows == batch->rows())
+                             ? batch                             // hand over whole batch, no copy
+                             : batch->extract(BatchRow, rows);
+
+    // same as in readValue, request next chunk of rows when the last row is being read
+    bool request = Buffered > ColumnCount;
+    Buffered -= rows * batch->columns();
+    BatchRow += rows;
+    if (BatchRow == batch->rows())
+    {
+        BatchRow = 0;
+        Batches.removeFirst();
+    }
+    if (request && Buffered <= ColumnCount && !eof())
+        emit dataRequested();
+
+    return retval;
 }
 
 bool toEventQuery::eof(void) const
@@ -212,7 +322,7 @@ QString const& toEventQuery::sql(void) const
 
 bool toEventQuery::hasMore(void) const
 {
-    return !Values.isEmpty();
+    return !Batches.isEmpty();
 }
 
 void toEventQuery::stop(void)
@@ -221,7 +331,13 @@ void toEventQuery::stop(void)
     if (WorkDone)
         return;
 
-    if (Thread && Thread->isRunning())
+    if (Queued)
+    {
+        toEventQueryPoolSingle::Instance().cancel(this);
+        Queued = false;
+    }
+
+    if (Worker)
     {
         Utils::toBusy busy;
         TLOG(7, toDecorator, __HERE__) << "toEventQuery stop Thread is running" << std::endl;
@@ -252,19 +368,32 @@ void toEventQuery::slotStarted()
     emit dataRequested();             // request 1st chunk of rows
 }
 
-// warning: values is a reference only bg thread's stack
-void toEventQuery::slotData(const ValuesList &values)
+// batch is not accessed by bg thread anymore
+void toEventQuery::slotData(toQueryBatchPtr batch)
 {
     //TLOG(7, toDecorator, __HERE__) << "toEventQuery slot data" << std::endl;
-    Values << values;
+    Batches << batch;
+    Buffered += batch->rows() * batch->columns();
+
+    unsigned rows = batch->rows();
+    if (FetchStats.Batches == 0)
+        FetchStats.FirstBatch = FetchStats.MinBatch = rows;
+    FetchStats.Batches++;
+    FetchStats.LastBatch = rows;
+    FetchStats.MinBatch = qMin(FetchStats.MinBatch, rows);
+    FetchStats.MaxBatch = qMax(FetchStats.MaxBatch, rows);
+    FetchStats.Rows += rows;
+    FetchStats.Bytes += batch->byteSize();
 
     if (Mode == READ_ALL)
         emit consumed();
+    else if (Thread)
+        toEventQueryPoolSingle::Instance().setParked(Thread, true); // idle until dataRequested
 
     // TODO: this signal can also be emitted asynchronically
     // from QTime - once per second
     emit dataAvailable(this);
-    emit dataAvailable(this, Values);
+    emit dataAvailable(this, batch);
 
     try
     {
@@ -278,6 +407,12 @@ void toEventQuery::slotData(const ValuesList &values)
     }
 }
 
+void toEventQuery::slotDataRequested()
+{
+    if (Thread)
+        toEventQueryPoolSingle::Instance().setParked(Thread, false);
+}
+
 void toEventQuery::slotDesc(toQColumnDescriptionList &desc, int columns)
 {
     TLOG(7, toDecorator, __HERE__) << "toEventQuery slot desc" << std::endl;
@@ -312,7 +447,7 @@ void toEventQuery::slotRowsProcessed(unsigned long rows)
 
 void toEventQuery::slotThreadEnd()
 {
-    TLOG(7, toDecorator, __HERE__) << "toEventQuery thread end" << std::endl;
+    TLOG(7, toDecorator, __HERE__) << "toEventQuery worker end" << std::endl;
     Thread = NULL;
     Worker = NULL;
 }
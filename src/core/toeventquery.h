@@ -41,6 +41,7 @@
 #include "core/toconnectionsubloan.h"
 //#include "widgets/toresultstats.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QPointer>
@@ -49,6 +50,7 @@
 
 class toResultStats;
 class toEventQueryWorker;
+class toEventQueryPool;
 class BGThread;
 
 /**
@@ -61,6 +63,7 @@ class toEventQuery : public QObject
         Q_OBJECT;
 
         friend class toEventQueryWorker;
+        friend class toEventQueryPool;
     public:
         enum FETCH_MODE
         {
@@ -68,6 +71,16 @@ class toEventQuery : public QObject
             READ_ALL
         };
 
+        /**
+         * Order in which queries waiting for a thread in @ref toEventQueryPool are served.
+         */
+        enum PRIORITY
+        {
+            PRIORITY_BACKGROUND,  // periodic refresh of charts, monitors...
+            PRIORITY_NORMAL,
+            PRIORITY_INTERACTIVE  // worksheet, never waits for a pooled thread
+        };
+
         class Client
         {
             protected:
@@ -96,6 +109,21 @@ class toEventQuery : public QObject
                 virtual void eqDone(toEventQuery*) = 0;
         };
 
+        /**
+         * Sizes of row chunks received from toEventQueryWorker
+         * (see Database::AdaptiveFetchBool)
+         */
+        struct FetchStatistics
+        {
+            FetchStatistics();
+            QString toString() const;
+
+            unsigned Batches;
+            unsigned FirstBatch, MinBatch, MaxBatch, LastBatch;
+            quint64 Rows;
+            quint64 Bytes;
+        };
+
         class WaitConditionWithMutex
         {
             public:
@@ -148,6 +176,30 @@ class toEventQuery : public QObject
 
         void setFetchMode(FETCH_MODE);
 
+        /**
+         * Set priority of the query, must be called before start()
+         */
+        void setPriority(PRIORITY);
+
+        PRIORITY priority(void) const;
+
+        /**
+         * Time (in ms) the query was waiting for a thread from @ref toEventQueryPool
+         */
+        unsigned long queueWait(void) const;
+
+        /**
+         * Set array fetch hints for the provider, must be called before start().
+         * By default the array size is derived from column widths (see FetchArrayMemoryInt).
+         * Non zero BulkRows also sets the number of rows in each batch, InitialFetchInt
+         * and adaptive fetch are not used then
+         */
+        void setFetchOptions(toQueryAbstr::FetchOptions const&);
+
+        toQueryAbstr::FetchOptions const& fetchOptions(void) const;
+
+        FetchStatistics const& fetchStatistics(void) const;
+
         /**
          * Get description of columns.
          * @return Description of columns list.
@@ -171,6 +223,13 @@ class toEventQuery : public QObject
          */
         toQValue readValue(void);
 
+        /**
+         * Take (up to) maxRows of buffered rows at once, cells are not boxed into toQValue.
+         * Must not be called in the middle of a row read by readValue().
+         * @return Batch of rows, the caller becomes the only owner of it.
+         */
+        toQueryBatchPtr takeBatch(unsigned maxRows);
+
         /**
          * Check if at end of query.
          * @return True if query is done.
@@ -205,7 +264,7 @@ class toEventQuery : public QObject
          * @param rows Number of rows to be read
          */
         void dataAvailable(toEventQuery*);
-        void dataAvailable(toEventQuery*, const ValuesList&);
+        void dataAvailable(toEventQuery*, toQueryBatchPtr);
 
         /**
          * Emitted with error string
@@ -231,7 +290,7 @@ class toEventQuery : public QObject
         void slotStarted();
 
         // handle worker's data() signal. emits dataAvailable()
-        void slotData(const ValuesList &values);
+        void slotData(toQueryBatchPtr batch);
 
         // handle worker's headers() signal emits descriptionAvailable()
         void slotDesc(toQColumnDescriptionList &desc, int columns);
@@ -242,17 +301,28 @@ class toEventQuery : public QObject
         // handle worker's finish
         void slotFinished(void);
 
+        // READ_FIRST worker fetches again, its thread counts against toEventQueryPool size
+        void slotDataRequested(void);
+
         // sets Processed. signal is sent if > 0
         void slotRowsProcessed(unsigned long rows);
 
-        // emitted immediately before the Thread is destroyed
+        // emitted when the Worker was destroyed, the Thread is returned into toEventQueryPool
         void slotThreadEnd();
 
     private:
         /** Undefined copy contructor.Don't clone me. */
         toEventQuery(toEventQuery const& other);
 
-        ValuesList Values;
+        /** Called by toEventQueryPool when a thread is available for this query */
+        void attachThread(BGThread *thread, unsigned long waited);
+
+        // rows received from the Worker, the first one is being read by readValue/takeBatch
+        QList<toQueryBatchPtr> Batches;
+        unsigned BatchRow, BatchColumn;
+
+        // Number of buffered (not read yet) cells
+        unsigned long Buffered;
 
         // SQL to execute.
         QString SQL;
@@ -269,12 +339,20 @@ class toEventQuery : public QObject
         // Description of result
         toQColumnDescriptionList Description;
 
-        // reference to a BG producer thread, these are deleted from event loop
+        // reference to a BG producer thread (owned by toEventQueryPool), Worker is deleted from event loop
         BGThread *Thread;
         toEventQueryWorker *Worker;
 
         bool Started;
         bool WorkDone;
+        bool Queued;
+
+        PRIORITY Priority;
+        unsigned long QueueWait;
+
+        toQueryAbstr::FetchOptions FetchOpts;
+
+        FetchStatistics FetchStats;
 
         // connection for this query
         QSharedPointer<toConnectionSubLoan> Connection;
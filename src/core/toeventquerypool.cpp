@@ -0,0 +1,276 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/toeventquerypool.h"
+#include "core/toeventquery.h"
+#include "core/toeventqueryworker.h"
+#include "core/toconfiguration.h"
+#include "core/todatabaseconfig.h"
+#include "core/tologger.h"
+
+#include <QApplication>
+#include <QtCore/QMutexLocker>
+
+// how long shutdown waits for a thread still running a query
+static const unsigned long SHUTDOWN_WAIT_MS = 5000;
+
+toEventQueryPool::Statistics::Statistics()
+    : Threads(0)
+    , BusyThreads(0)
+    , ParkedThreads(0)
+    , QueueDepth(0)
+    , PeakQueueDepth(0)
+    , Scheduled(0)
+    , Reused(0)
+    , Overflows(0)
+    , TotalWaitMs(0)
+    , MaxWaitMs(0)
+{}
+
+toEventQueryPool::toEventQueryPool()
+    : QObject(NULL)
+{
+    WaitTimer.setInterval(100);
+    connect(&WaitTimer, SIGNAL(timeout()), this, SLOT(slotDispatch()));
+    connect(qApp, SIGNAL(aboutToQuit()), this, SLOT(slotShutdown()));
+}
+
+toEventQueryPool::~toEventQueryPool()
+{
+    slotShutdown();
+}
+
+void toEventQueryPool::schedule(toEventQuery *query)
+{
+    Request req;
+    req.Query = query;
+    req.Priority = query->priority();
+    req.Waiting.start();
+
+    // keep the queue sorted, new request goes behind all requests having the same priority
+    int pos = 0;
+    while (pos < Queue.size() && Queue.at(pos).Priority >= req.Priority)
+        pos++;
+    Queue.insert(pos, req);
+    {
+        QMutexLocker lock(&StatsLock);
+        Stats.PeakQueueDepth = qMax(Stats.PeakQueueDepth, (unsigned) Queue.size());
+    }
+    dispatch();
+}
+
+void toEventQueryPool::cancel(toEventQuery *query)
+{
+    for (int i = 0; i < Queue.size(); i++)
+    {
+        if (Queue.at(i).Query == query)
+        {
+            Queue.removeAt(i);
+            break;
+        }
+    }
+    if (Queue.isEmpty())
+        WaitTimer.stop();
+
+    QMutexLocker lock(&StatsLock);
+    updateCounts();
+}
+
+void toEventQueryPool::setParked(BGThread *thread, bool parked)
+{
+    if (!parked)
+    {
+        Parked.remove(thread);
+        QMutexLocker lock(&StatsLock);
+        updateCounts();
+        return;
+    }
+    if (!Busy.contains(thread) || Parked.contains(thread))
+        return;
+    Parked.insert(thread);
+    dispatch(); // a queued query can use the pool slot
+}
+
+toEventQueryPool::Statistics toEventQueryPool::statistics() const
+{
+    QMutexLocker lock(&StatsLock);
+    return Stats;
+}
+
+void toEventQueryPool::updateCounts()
+{
+    Stats.Threads = Idle.size() + Busy.size();
+    Stats.BusyThreads = Busy.size();
+    Stats.ParkedThreads = Parked.size();
+    Stats.QueueDepth = Queue.size();
+}
+
+void toEventQueryPool::dispatch()
+{
+    int poolSize = qMax(1, toConfigurationNewSingle::Instance().option(ToConfiguration::Database::QueryThreadsInt).toInt());
+    int maxWait = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::QueryThreadWaitInt).toInt();
+
+    while (!Queue.isEmpty())
+    {
+        if (Queue.first().Query.isNull()) // toEventQuery was deleted while waiting
+        {
+            Queue.removeFirst();
+            continue;
+        }
+
+        BGThread *thread = NULL;
+        bool reused = false, overflow = false;
+        if (!Idle.isEmpty())
+        {
+            thread = Idle.takeFirst();
+            reused = true;
+        }
+        else if (Busy.size() - Parked.size() < poolSize)
+        {
+            thread = createThread();
+        }
+        else if (Queue.first().Priority == toEventQuery::PRIORITY_INTERACTIVE
+                 || (maxWait >= 0 && Queue.first().Waiting.elapsed() >= maxWait))
+        {
+            thread = createThread();
+            overflow = true;
+        }
+        else
+        {
+            break;
+        }
+
+        Request req = Queue.takeFirst();
+        quint64 waited = req.Waiting.elapsed();
+        {
+            QMutexLocker lock(&StatsLock);
+            Stats.Scheduled++;
+            Stats.Reused += reused;
+            Stats.Overflows += overflow;
+            Stats.TotalWaitMs += waited;
+            Stats.MaxWaitMs = qMax(Stats.MaxWaitMs, waited);
+        }
+        if (waited > 0)
+            TLOG(7, toDecorator, __HERE__) << "toEventQueryPool query waited(ms): " << waited << std::endl;
+
+        Busy.insert(thread);
+        thread->Parent = req.Query;
+        req.Query->attachThread(thread, waited);
+    }
+
+    if (Queue.isEmpty())
+        WaitTimer.stop();
+    else if (!WaitTimer.isActive())
+        WaitTimer.start();
+
+    QMutexLocker lock(&StatsLock);
+    updateCounts();
+}
+
+void toEventQueryPool::slotDispatch()
+{
+    dispatch();
+}
+
+void toEventQueryPool::slotThreadReleased(BGThread *thread)
+{
+    if (!Busy.remove(thread))
+        return;
+    Parked.remove(thread);
+    thread->Parent = NULL;
+
+    int poolSize = qMax(1, toConfigurationNewSingle::Instance().option(ToConfiguration::Database::QueryThreadsInt).toInt());
+    if (Idle.size() + Busy.size() >= poolSize)
+        retireThread(thread);
+    else
+        Idle.append(thread);
+
+    dispatch();
+}
+
+void toEventQueryPool::slotShutdown()
+{
+    WaitTimer.stop();
+    Queue.clear();
+    while (!Idle.isEmpty())
+    {
+        BGThread *thread = Idle.takeFirst();
+        thread->quit();
+        thread->wait();
+        delete thread;
+    }
+
+    // Workers of busy threads finish the current fetch (if any), then the event loop quits
+    Q_FOREACH(BGThread *thread, Busy)
+    {
+        disconnect(thread, SIGNAL(released(BGThread*)), this, SLOT(slotThreadReleased(BGThread*)));
+        thread->quit();
+    }
+    Q_FOREACH(BGThread *thread, Busy)
+    {
+        if (thread->wait(SHUTDOWN_WAIT_MS))
+            delete thread;
+        else
+            TLOG(1, toDecorator, __HERE__) << "toEventQueryPool thread did not finish its query" << std::endl;
+    }
+    Busy.clear();
+    Parked.clear();
+
+    QMutexLocker lock(&StatsLock);
+    updateCounts();
+    TLOG(7, toDecorator, __HERE__) << "toEventQueryPool queries: " << Stats.Scheduled
+                                   << " reused threads: " << Stats.Reused
+                                   << " overflows: " << Stats.Overflows
+                                   << " peak queue: " << Stats.PeakQueueDepth
+                                   << " max wait(ms): " << Stats.MaxWaitMs << std::endl;
+}
+
+BGThread* toEventQueryPool::createThread()
+{
+    /* BIG FAT WARNING QThread's parent must be NULL, so it is not disposed when toEventQuery is deleted.
+     * Threads are owned by the pool and outlive the queries they have served.
+     */
+    BGThread *thread = new BGThread(NULL);
+    thread->setObjectName("toEventQuery");
+    connect(thread, SIGNAL(released(BGThread*)), this, SLOT(slotThreadReleased(BGThread*)));
+    connect(thread, SIGNAL(finished()), thread, SLOT(deleteLater()));
+    thread->start();
+    return thread;
+}
+
+void toEventQueryPool::retireThread(BGThread *thread)
+{
+    disconnect(thread, SIGNAL(released(BGThread*)), this, SLOT(slotThreadReleased(BGThread*)));
+    thread->quit(); // thread is deleted from event loop once finished
+}
@@ -0,0 +1,138 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TOEVENTQUERYPOOL_H
+#define TOEVENTQUERYPOOL_H
+
+#include "loki/Singleton.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QList>
+#include <QtCore/QSet>
+#include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QMutex>
+
+class toEventQuery;
+class BGThread;
+
+/**
+ * Bounded pool of long lived worker threads shared by all instances of @ref toEventQuery.
+ *
+ * Instead of creating (and destroying) one BGThread per query, toEventQuery::start asks
+ * the pool for a thread. When none is idle and the pool already owns QueryThreadsInt threads
+ * the query is queued. Queries are served by priority, FIFO within the same priority.
+ *
+ * Observe that a query keeps its thread until its worker is finished. A READ_FIRST query
+ * waiting for its consumer to read the rows fetched so far is "parked": it still owns
+ * its thread, but the thread is not counted against QueryThreadsInt, so open result
+ * grids do not block new queries. The bound is "soft": interactive queries never wait
+ * and any other query waiting longer than QueryThreadWaitInt ms gets an extra thread.
+ * Threads above the pool size are discarded as soon as they are released.
+ *
+ * All the methods must be called from the main thread, except statistics().
+ */
+class toEventQueryPool : public QObject
+{
+        Q_OBJECT;
+    public:
+        struct Statistics
+        {
+            Statistics();
+
+            unsigned Threads;         // threads currently owned by the pool
+            unsigned BusyThreads;     // threads running a toEventQueryWorker
+            unsigned ParkedThreads;   // ... of which wait for their READ_FIRST consumer
+            unsigned QueueDepth;      // queries waiting for a thread
+            unsigned PeakQueueDepth;  // max. value QueueDepth ever reached
+            quint64 Scheduled;        // queries handed over to a thread
+            quint64 Reused;           // ... of which got an already running thread
+            quint64 Overflows;        // threads spawned above the pool size
+            quint64 TotalWaitMs;      // sum of time queries spent in the queue
+            quint64 MaxWaitMs;        // longest time a query spent in the queue
+        };
+
+        toEventQueryPool();
+        ~toEventQueryPool();
+
+        /** Run query on pooled thread. Either immediately or once a thread is available. */
+        void schedule(toEventQuery *query);
+
+        /** Remove a query from the queue (if it did not get a thread yet) */
+        void cancel(toEventQuery *query);
+
+        /** Thread's worker waits for its READ_FIRST consumer (parked) or fetches again */
+        void setParked(BGThread *thread, bool parked);
+
+        /** Snapshot of the pool counters, can be called from any thread */
+        Statistics statistics() const;
+
+    private slots:
+        // a toEventQueryWorker was deleted, the thread can serve another query
+        void slotThreadReleased(BGThread *thread);
+
+        // periodically checks whether the head of the queue waits for too long
+        void slotDispatch();
+
+        // quit all the threads (busy ones included) before QApplication is gone
+        void slotShutdown();
+
+    private:
+        struct Request
+        {
+            QPointer<toEventQuery> Query;
+            int Priority;
+            QElapsedTimer Waiting;
+        };
+
+        void dispatch();
+        BGThread* createThread();
+        void retireThread(BGThread *thread);
+        // copy sizes of the containers into Stats, StatsLock must be held
+        void updateCounts();
+
+        QList<Request> Queue;        // sorted by priority, FIFO within the same priority
+        QList<BGThread*> Idle;
+        QSet<BGThread*> Busy;
+        QSet<BGThread*> Parked;      // subset of Busy, not counted against the pool size
+        QTimer WaitTimer;
+
+        mutable QMutex StatsLock;
+        Statistics Stats;
+};
+
+typedef Loki::SingletonHolder<toEventQueryPool, Loki::CreateUsingNew, Loki::NoDestroy> toEventQueryPoolSingle;
+
+#endif
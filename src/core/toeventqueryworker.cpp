@@ -50,6 +50,13 @@
 #include <QApplication>
 #include <QtCore/QMutexLocker>
 #include <QtCore/QTimer>
+#include <QtCore/QElapsedTimer>
+
+#include <climits>
+
+// adaptive fetch: 1st chunk is small so the first rows are displayed asap
+static const unsigned FIRST_FETCH_SIZE = 20;
+static const unsigned MAX_FETCH_SIZE = 100000;
 
 /* It is not allowed to throw an exception from event slot.
  * So let's catch all the possible errors in slot handlers
@@ -84,33 +91,8 @@ void toEventQueryWorker::toQueryPriv::init()
 {
     try
     {
-        // Try to switch the current db schema
-        if (m_ConnectionSubLoan.SchemaInitialized == false && !m_ConnectionSubLoan.Schema.isEmpty())
-        {
-            QString sql = m_ConnectionSubLoan.ParentConnection.getTraits().schemaSwitchSQL(m_ConnectionSubLoan.Schema);
-            if (!sql.isEmpty())
-            {
-                m_Query = m_ConnectionSubLoan->createQuery(this);
-                m_ConnectionSubLoan->setQuery(this);
-                m_Query->execute(sql);
-                delete m_Query;
-            }
-            m_ConnectionSubLoan.SchemaInitialized = true;
-            m_ConnectionSubLoan->setSchema(m_ConnectionSubLoan.Schema); // assign value in toConnectionSub from toConnectionSubLoan
-        }
-
-        // Try to switch the current NLS_SETTINGS (not implemented yet)
-        if ( m_ConnectionSubLoan->isInitialized() == false)
-        {
-            Q_FOREACH(QString sql, m_ConnectionSubLoan.ParentConnection.initStrings())
-            {
-                m_Query = m_ConnectionSubLoan->createQuery(this);
-                m_ConnectionSubLoan->setQuery(this);
-                m_Query->execute(sql);
-                delete m_Query;
-            }
-            m_ConnectionSubLoan->setInitialized(true);
-        }
+        // Switch schema and run init strings when the session is not in the requested state
+        initSession();
 #if defined(TORA_EXPERIMENTAL) && 0
 // This breaks Mysql, PostgreSQL, ODBC
         {
@@ -147,12 +129,15 @@ toEventQueryWorker::toEventQueryWorker(toEventQuery *c
     , Connection(conn)
     , CancelCondition(wait)
     , ColumnCount(0)
+    , FetchSize(0)
+    , ReadAll(false)
     , Stopped(false)
     , Closed(false)
     , Query(*Connection, SQL, Params)
 {
     TLOG(7, toDecorator, __HERE__) << "toEventQueryWorker created" << std::endl;
     connect(this, SIGNAL(readRequested()), this, SLOT(slotRead()));
+    Query.setFetchOptions(c->FetchOpts);
     Query.moveToThread(c->Thread);
 }
 
@@ -222,16 +207,27 @@ void toEventQueryWorker::slotRead()
             return;
         }
 
+        // consumer asked for fixed size arrays (e.g. export), rows are not displayed
+        unsigned bulk = Query.fetchOptions().BulkRows;
         unsigned maxRead = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::InitialFetchInt).toInt();
-        ValuesList values;
-        for (unsigned row = 0; row < maxRead; row++)
+        bool adaptive = bulk == 0 && toConfigurationNewSingle::Instance().option(ToConfiguration::Database::AdaptiveFetchBool).toBool();
+        unsigned rows = bulk > 0 ? bulk : adaptive ? nextFetchSize(maxRead) : maxRead;
+
+        // time the fetch round trips only, rows already buffered by the provider cost nothing
+        QElapsedTimer timer;
+        timer.start();
+        qint64 fetched = Query.fetchNsecs();
+        toQueryBatchPtr batch(new toQueryBatch(ColumnCount));
+        Query.readBatch(*batch, rows);
+        if (adaptive)
         {
-            for (unsigned i = 0; i < ColumnCount && !Query.eof(); i++)
-                values.append(Query.readValue());
+            qint64 elapsed = fetched < 0 ? timer.nsecsElapsed() : Query.fetchNsecs() - fetched;
+            if (elapsed > 0)
+                adaptFetchSize(batch->rows(), batch->byteSize(), elapsed);
         }
 
-        if (values.size() > 0)
-            emit data(values);    // must not access after this line
+        if (batch->rows() > 0)
+            emit data(batch);    // must not access after this line
 
         if (Query.eof())
         {
@@ -241,3 +237,39 @@ void toEventQueryWorker::slotRead()
     }
     CATCH_ALL
 }
+
+void toEventQueryWorker::slotConsumed()
+{
+    ReadAll = true;
+    slotRead();
+}
+
+unsigned toEventQueryWorker::nextFetchSize(unsigned maxRead)
+{
+    if (FetchSize == 0)
+        FetchSize = FIRST_FETCH_SIZE;
+    // READ_FIRST consumer does not need more rows than InitialFetchInt at once
+    if (ReadAll)
+        return FetchSize;
+    return qMin(FetchSize, maxRead);
+}
+
+void toEventQueryWorker::adaptFetchSize(unsigned rows, size_t bytes, qint64 nsecs)
+{
+    if (rows == 0)
+        return;
+
+    int timeBudget = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::FetchTimeBudgetInt).toInt();
+    int byteBudget = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::FetchByteBudgetInt).toInt() * 1024;
+
+    // scale the last chunk so it takes timeBudget ms and fits into byteBudget bytes
+    double factor = 4.0;
+    if (nsecs > 0 && timeBudget > 0)
+        factor = timeBudget * 1000000.0 / nsecs;
+    if (bytes > 0 && byteBudget > 0)
+        factor = qMin(factor, (double) byteBudget / bytes);
+    // change the size gradually, one slow round trip should not collapse it
+    factor = qBound(0.5, factor, 4.0);
+
+    FetchSize = qBound(1u, (unsigned)(rows * factor), MAX_FETCH_SIZE);
+}
@@ -39,6 +39,7 @@
 #include "core/toconnection.h"
 #include "core/toquery.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
 #include "core/tocache.h"
 #include "core/toeventquery.h"
 #include "core/utils.h"
@@ -55,7 +56,9 @@ class toResultStats;
 class toEventQuery;
 class toEventQueryWorker;
 
-/* This class is just a temporary wrapper for QThread */
+/* This class is just a temporary wrapper for QThread
+ * Instances are owned by toEventQueryPool and serve one toEventQueryWorker at a time
+ */
 class BGThread : public QThread
 {
         Q_OBJECT;
@@ -70,6 +73,17 @@ class BGThread : public QThread
         {
             QThread::msleep(s);
         }
+
+    signals:
+        /** Emitted (in the main thread) when the Slave was deleted */
+        void released(BGThread*);
+
+    public slots:
+        void slotSlaveDestroyed()
+        {
+            Slave = NULL;
+            emit released(this);
+        }
     protected:
         void run(void)
         {
@@ -124,9 +138,9 @@ class toEventQueryWorker : public QObject
         // also QObject's will have it's affinity set to background thread
         // and should be disposed within the context of the main thread
         /**
-        * Data read from query
+        * Data read from query, the batch is not touched by the worker after emit
         */
-        void data(const ValuesList &values);
+        void data(toQueryBatchPtr batch);
 
         /**
         * Emitted when sql query is done
@@ -156,9 +170,18 @@ class toEventQueryWorker : public QObject
     private slots:
         void slotRead();
 
+        // consumer reads all the data (READ_ALL), fetched chunks are not limited by InitialFetchInt
+        void slotConsumed();
+
     private:
         void close(void);
 
+        // number of rows to be read by the next slotRead
+        unsigned nextFetchSize(unsigned maxRead);
+
+        // adjust FetchSize for the next round (AdaptiveFetchBool), nsecs spent in fetch round trips
+        void adaptFetchSize(unsigned rows, size_t bytes, qint64 nsecs);
+
         toEventQuery *Consumer;
 
         // sql and bind parameters
@@ -170,6 +193,10 @@ class toEventQueryWorker : public QObject
 
         unsigned ColumnCount;
 
+        // adaptive fetch: size of the next chunk of rows (0 = not started yet)
+        unsigned FetchSize;
+        bool ReadAll;
+
         bool Stopped, Closed;
 
         // the real query object
@@ -0,0 +1,145 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/togzipdevice.h"
+
+#include <zlib.h>
+
+toGzipDevice::toGzipDevice(QIODevice *target, int level)
+    : QIODevice()
+    , Target(target)
+    , Level(level)
+    , Stream(NULL)
+{
+}
+
+toGzipDevice::~toGzipDevice()
+{
+    if (isOpen())
+        close();
+    release();
+}
+
+bool toGzipDevice::open(OpenMode mode)
+{
+    if ((mode & ReadOnly) || !Target->isWritable())
+    {
+        setErrorString(QObject::tr("Compressed file can only be written"));
+        return false;
+    }
+    release();
+    Stream = new z_stream;
+    Stream->zalloc = Z_NULL;
+    Stream->zfree = Z_NULL;
+    Stream->opaque = Z_NULL;
+    // 16 + window bits: gzip header and trailer instead of zlib ones
+    if (deflateInit2(Stream, Level, Z_DEFLATED, 16 + MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+    {
+        setErrorString(QObject::tr("Can not initialize compression: %1").arg(QString::fromLatin1(Stream->msg ? Stream->msg : "")));
+        delete Stream;
+        Stream = NULL;
+        return false;
+    }
+    Output.resize(OUTPUT_SIZE);
+    return QIODevice::open(mode);
+}
+
+void toGzipDevice::close()
+{
+    if (!isOpen())
+        return;
+    if (Stream)
+    {
+        Stream->next_in = Z_NULL;
+        Stream->avail_in = 0;
+        compress(Z_FINISH);
+    }
+    release();
+    QIODevice::close();
+}
+
+void toGzipDevice::release()
+{
+    if (!Stream)
+        return;
+    deflateEnd(Stream);
+    delete Stream;
+    Stream = NULL;
+}
+
+qint64 toGzipDevice::readData(char *, qint64)
+{
+    return -1;
+}
+
+qint64 toGzipDevice::writeData(const char *data, qint64 len)
+{
+    if (!Stream)
+        return -1;
+    qint64 done = 0;
+    while (done < len)
+    {
+        // avail_in is 32 bits wide
+        uInt chunk = uInt(qMin<qint64>(len - done, 0x40000000));
+        Stream->next_in = (Bytef*)(data + done);
+        Stream->avail_in = chunk;
+        if (!compress(Z_NO_FLUSH))
+            return -1;
+        done += chunk;
+    }
+    return len;
+}
+
+bool toGzipDevice::compress(int flush)
+{
+    for (;;)
+    {
+        Stream->next_out = (Bytef*) Output.data();
+        Stream->avail_out = uInt(Output.size());
+        int rc = ::deflate(Stream, flush);
+        if (rc == Z_STREAM_ERROR)
+        {
+            setErrorString(QObject::tr("Compression failed"));
+            return false;
+        }
+        int ready = Output.size() - int(Stream->avail_out);
+        if (ready > 0 && Target->write(Output.constData(), ready) != ready)
+        {
+            setErrorString(Target->errorString());
+            return false;
+        }
+        if (flush == Z_FINISH ? rc == Z_STREAM_END : Stream->avail_in == 0 && Stream->avail_out > 0)
+            return true;
+    }
+}
@@ -0,0 +1,86 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TOGZIPDEVICE_H
+#define TOGZIPDEVICE_H
+
+#include <QtCore/QByteArray>
+#include <QtCore/QIODevice>
+
+struct z_stream_s;
+
+/**
+ * Write only device compressing the data into gzip format (RFC 1952).
+ *
+ * The data are streamed through one zlib deflate stream with gzip framing,
+ * the compressed output is written into the target whenever OUTPUT_SIZE
+ * bytes are ready.
+ */
+class toGzipDevice : public QIODevice
+{
+    public:
+        /** Size of the buffer for compressed data */
+        static const int OUTPUT_SIZE = 256 * 1024;
+
+        /** Device writing into target (which must be open), level as in zlib (0-9) */
+        explicit toGzipDevice(QIODevice *target, int level = 6);
+        virtual ~toGzipDevice();
+
+        /** Only WriteOnly mode is supported */
+        virtual bool open(OpenMode mode);
+
+        /** Finish the gzip stream, target is not closed */
+        virtual void close();
+
+        virtual bool isSequential() const
+        {
+            return true;
+        }
+
+    protected:
+        virtual qint64 readData(char *data, qint64 maxlen);
+        virtual qint64 writeData(const char *data, qint64 len);
+
+    private:
+        /** Run deflate with flush mode until the input is consumed (or the stream ends for Z_FINISH) */
+        bool compress(int flush);
+        void release(void);
+
+        QIODevice *Target;
+        int Level;
+        QByteArray Output;
+        z_stream_s *Stream;
+};
+
+#endif
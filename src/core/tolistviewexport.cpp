@@ -0,0 +1,264 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/tolistviewexport.h"
+#include "core/utils.h"
+
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QIODevice>
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QTimer>
+
+class toListViewExport::Writer : public QThread
+{
+    public:
+        Writer(toListViewExport *owner)
+            : Owner(owner)
+        {}
+
+        virtual void run()
+        {
+            toListViewExport &o = *Owner;
+            QTextStream out(o.Device);
+            out.setCodec(Utils::toGetCodec());
+
+            int columns = o.Formatter->exportColumns().size();
+            QVector<QVariant> values(columns);
+            bool done = false;
+
+            o.Formatter->writeHeader(out);
+            while (!done)
+            {
+                Chunk chunk;
+                {
+                    QMutexLocker lock(&o.Lock);
+                    while (o.Chunks.isEmpty() && !o.End && !int(o.Cancelled))
+                        o.NotEmpty.wait(&o.Lock);
+                    if (int(o.Cancelled))
+                        return;
+                    if (!o.Chunks.isEmpty())
+                        chunk = o.Chunks.dequeue();
+                    else
+                        done = true;
+                }
+
+                int rows = columns ? chunk.size() / columns : 0;
+                for (int r = 0; r < rows; r++)
+                {
+                    for (int i = 0; i < columns; i++)
+                        values[i] = chunk.at(r * columns + i);
+                    o.Formatter->writeRow(out, values);
+                }
+                if (rows)
+                    QMetaObject::invokeMethod(Owner, "slotWritten", Qt::QueuedConnection, Q_ARG(int, rows));
+            }
+            o.Formatter->writeFooter(out);
+            out.flush();
+
+            QString error;
+            if (out.status() != QTextStream::Ok)
+                error = toListViewExport::tr("Couldn't write data to file");
+            QMetaObject::invokeMethod(Owner, "slotWriterDone", Qt::QueuedConnection, Q_ARG(QString, error));
+        }
+
+    private:
+        toListViewExport *Owner;
+};
+
+toListViewExport::toListViewExport(toListViewFormatter *formatter,
+                                   toExportSettings const &settings,
+                                   const QAbstractItemModel *model,
+                                   QIODevice *device,
+                                   QObject *parent)
+    : QObject(parent)
+    , Formatter(formatter)
+    , Settings(settings)
+    , Model(model)
+    , Device(device)
+    , Total(0)
+    , Next(0)
+    , Written(0)
+    , Measuring(false)
+    , Running(false)
+    , End(false)
+{
+    Formatter->setLineEnd(Utils::toLineEnd());
+}
+
+toListViewExport::~toListViewExport()
+{
+    stopWriter();
+}
+
+void toListViewExport::start()
+{
+    Rows = toListViewFormatter::exportRows(Settings, Model->rowCount());
+    Total = Rows.count(true);
+    Next = 0;
+    Written = 0;
+    End = false;
+    Error.clear();
+    Cancelled.fetchAndStoreAcquire(0);
+    Running = true;
+
+    Formatter->startExport(Settings, Model, Total);
+    Measuring = Formatter->needsMeasure();
+    if (!Measuring)
+    {
+        WriterThread.reset(new Writer(this));
+        WriterThread->start();
+    }
+    QTimer::singleShot(0, this, SLOT(slotRead()));
+}
+
+void toListViewExport::cancel()
+{
+    if (!Running)
+        return;
+    stopWriter();
+    Running = false;
+    emit finished(false);
+}
+
+void toListViewExport::stopWriter()
+{
+    {
+        QMutexLocker lock(&Lock);
+        Cancelled.fetchAndStoreAcquire(1);
+        Chunks.clear();
+        NotEmpty.wakeAll();
+    }
+    if (WriterThread)
+        WriterThread->wait();
+}
+
+bool toListViewExport::readChunk(Chunk &chunk)
+{
+    QVector<int> const &columns = Formatter->exportColumns();
+    chunk.reserve(CHUNK_ROWS * columns.size());
+    for (int read = 0; Next < Rows.size() && read < CHUNK_ROWS; Next++)
+    {
+        if (!Rows.testBit(Next))
+            continue;
+        foreach(int column, columns)
+            chunk.append(Model->data(Model->index(Next, column), Qt::EditRole));
+        read++;
+    }
+    return Next >= Rows.size();
+}
+
+void toListViewExport::push(Chunk const &chunk, bool last)
+{
+    QMutexLocker lock(&Lock);
+    Chunks.enqueue(chunk);
+    End = last;
+    NotEmpty.wakeAll();
+}
+
+void toListViewExport::slotRead()
+{
+    if (!Running || int(Cancelled))
+        return;
+
+    if (!Model)
+    {
+        stopWriter();
+        Running = false;
+        Error = tr("The data changed while being exported, the export is incomplete");
+        emit finished(false);
+        return;
+    }
+
+    if (Measuring)
+    {
+        // first pass, only the formatter sees the values
+        Chunk chunk;
+        bool last = readChunk(chunk);
+        int columns = Formatter->exportColumns().size();
+        QVector<QVariant> values(columns);
+        for (int r = 0; columns && r < chunk.size() / columns; r++)
+        {
+            for (int i = 0; i < columns; i++)
+                values[i] = chunk.at(r * columns + i);
+            Formatter->measureRow(values);
+        }
+        if (last)
+        {
+            Measuring = false;
+            Next = 0;
+            WriterThread.reset(new Writer(this));
+            WriterThread->start();
+        }
+        QTimer::singleShot(0, this, SLOT(slotRead()));
+        return;
+    }
+
+    {
+        QMutexLocker lock(&Lock);
+        if (Chunks.size() >= QUEUED_CHUNKS)
+        {
+            // writer is behind, do not block the event loop waiting for it
+            lock.unlock();
+            QTimer::singleShot(10, this, SLOT(slotRead()));
+            return;
+        }
+    }
+
+    Chunk chunk;
+    bool last = readChunk(chunk);
+    push(chunk, last);
+    if (!last)
+        QTimer::singleShot(0, this, SLOT(slotRead()));
+}
+
+void toListViewExport::slotWritten(int rows)
+{
+    if (!Running)
+        return;
+    Written += rows;
+    emit progress(Written, Total);
+}
+
+void toListViewExport::slotWriterDone(QString error)
+{
+    if (!Running)
+        return;
+    WriterThread->wait();
+    Running = false;
+    Error = error;
+    emit finished(Error.isEmpty());
+}
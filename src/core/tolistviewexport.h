@@ -0,0 +1,155 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TOLISTVIEWEXPORT_H
+#define TOLISTVIEWEXPORT_H
+
+#include "core/tolistviewformatter.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QBitArray>
+#include <QtCore/QMutex>
+#include <QtCore/QPointer>
+#include <QtCore/QQueue>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QVector>
+#include <QtCore/QVariant>
+#include <QtCore/QWaitCondition>
+
+class QAbstractItemModel;
+class QIODevice;
+
+/**
+ * Streams an export (@ref toListViewFormatter) of a model into a QIODevice.
+ *
+ * Rows are read from the model in chunks of CHUNK_ROWS in the model's thread
+ * (from the event loop, so the GUI stays responsive) and passed through a bounded
+ * queue to a writer thread which formats them and writes them to the device.
+ * At most QUEUED_CHUNKS chunks are held in memory whatever the size of the export.
+ *
+ * The model must not change while the export is running. If it is deleted
+ * (the result was refreshed or closed) the export fails.
+ */
+class toListViewExport : public QObject
+{
+        Q_OBJECT;
+
+    public:
+        /** Rows read from the model at once */
+        static const int CHUNK_ROWS = 1024;
+
+        /** Chunks waiting for the writer thread */
+        static const int QUEUED_CHUNKS = 8;
+
+        /** Takes ownership of formatter, device must be open for writing */
+        toListViewExport(toListViewFormatter *formatter,
+                         toExportSettings const &settings,
+                         const QAbstractItemModel *model,
+                         QIODevice *device,
+                         QObject *parent = 0);
+
+        /** Cancels the export and waits for the writer thread */
+        virtual ~toListViewExport();
+
+        /** Start the export, finished() is emitted when done */
+        void start(void);
+
+        /** Number of rows to be exported */
+        int total(void) const
+        {
+            return Total;
+        }
+
+        bool running(void) const
+        {
+            return Running;
+        }
+
+        /** Error of the last export, empty when successful or cancelled */
+        QString const& errorString(void) const
+        {
+            return Error;
+        }
+
+    public slots:
+        /** Stop the export, finished(false) is emitted */
+        void cancel(void);
+
+    signals:
+        /** Rows written so far */
+        void progress(int rows, int total);
+
+        /** Emitted when all the rows were written (ok) or the export failed or was cancelled */
+        void finished(bool ok);
+
+    private slots:
+        void slotRead(void);
+        void slotWritten(int rows);
+        void slotWriterDone(QString error);
+
+    private:
+        class Writer;
+        friend class Writer;
+
+        // Rows read from the model, row by row, exportColumns() values each
+        typedef QVector<QVariant> Chunk;
+
+        bool readChunk(Chunk &chunk);
+        void push(Chunk const &chunk, bool last);
+        void stopWriter(void);
+
+        QScopedPointer<toListViewFormatter> Formatter;
+        toExportSettings Settings;
+        QPointer<const QAbstractItemModel> Model;
+        QIODevice *Device;
+        QScopedPointer<Writer> WriterThread;
+
+        QBitArray Rows;         // model rows to be exported
+        int Total;
+        int Next;               // next model row to be read
+        int Written;
+        bool Measuring;         // first pass for formatters needing all the rows (see toListViewFormatter::needsMeasure)
+        bool Running;
+        QString Error;
+
+        // queue shared with the writer thread
+        QMutex Lock;
+        QWaitCondition NotEmpty;
+        QQueue<Chunk> Chunks;
+        bool End;
+        QAtomicInt Cancelled;
+};
+
+#endif
@@ -33,8 +33,12 @@
  * END_COMMON_COPYRIGHT_HEADER */
 
 #include "core/tolistviewformatter.h"
+#include "widgets/toresultmodel.h"
 #include "ts_log/ts_log_utils.h"
 
+#include <QtCore/QAbstractItemModel>
+#include <QtCore/QTextStream>
+
 QVariant ToConfiguration::Exporter::defaultValue(int option) const
 {
     switch (option)
@@ -52,45 +56,160 @@ QVariant ToConfiguration::Exporter::defaultValue(int option) const
 ToConfiguration::Exporter toExportSettings::s_Exporter;
 
 toListViewFormatter::toListViewFormatter()
+    : ColumnsHeader(false)
+    , Rows(0)
 {
+#ifdef Q_OS_WIN32
+    LineEnd = "\r\n";
+#else
+    LineEnd = "\n";
+#endif
 }
 
 toListViewFormatter::~toListViewFormatter()
 {
 }
 
+QString toListViewFormatter::getFormattedString(toExportSettings &settings, const QAbstractItemModel * model)
+{
+    QString output;
+    QTextStream out(&output, QIODevice::WriteOnly);
+    writeFormatted(out, settings, model);
+    return output;
+}
+
+void toListViewFormatter::writeFormatted(QTextStream &out, toExportSettings &settings, const QAbstractItemModel * model)
+{
+    QBitArray rows = exportRows(settings, model->rowCount());
+    startExport(settings, model, rows.count(true));
+
+    QVector<QVariant> values(Columns.size());
+    if (needsMeasure())
+    {
+        for (int row = 0; row < rows.size(); row++)
+        {
+            if (!rows.testBit(row))
+                continue;
+            for (int i = 0; i < Columns.size(); i++)
+                values[i] = model->data(model->index(row, Columns.at(i)), Qt::EditRole);
+            measureRow(values);
+        }
+    }
+
+    writeHeader(out);
+    for (int row = 0; row < rows.size(); row++)
+    {
+        if (!rows.testBit(row))
+            continue;
+        for (int i = 0; i < Columns.size(); i++)
+            values[i] = model->data(model->index(row, Columns.at(i)), Qt::EditRole);
+        writeRow(out, values);
+    }
+    writeFooter(out);
+    out.flush();
+}
+
+void toListViewFormatter::startExport(toExportSettings &settings, const QAbstractItemModel * model, int rows)
+{
+    int columns = model->columnCount();
+    QBitArray clist = selectedColumns(settings.selected, columns);
+
+    // Data types are known for toResultModel only
+    toResultModel::HeaderList hdr;
+    const toResultModel *resultModel = qobject_cast<const toResultModel*>(model);
+    if (resultModel)
+        hdr = resultModel->headers();
+
+    Columns.clear();
+    Headers.clear();
+    Datatypes.clear();
+    for (int column = 0; column < columns; column++)
+    {
+        if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.testBit(column))
+            continue;
+        if ((!settings.rowsHeader || skipRowNumber()) && column == 0)
+            continue;
+        Columns.append(column);
+        Headers.append(model->headerData(column, Qt::Horizontal, Qt::DisplayRole).toString());
+        Datatypes.append(column < hdr.size() ? hdr.at(column).datatype : QString());
+    }
+    ColumnsHeader = settings.columnsHeader;
+    Rows = rows;
+    prepare(settings);
+}
+
+void toListViewFormatter::startExport(toExportSettings &settings, toQColumnDescriptionList const &columns, int rows)
+{
+    Columns.clear();
+    Headers.clear();
+    Datatypes.clear();
+    for (int column = 0; column < columns.size(); column++)
+    {
+        Columns.append(column);
+        Headers.append(columns.at(column).Name);
+        Datatypes.append(columns.at(column).Datatype);
+    }
+    ColumnsHeader = settings.columnsHeader;
+    Rows = rows;
+    prepare(settings);
+}
+
+void toListViewFormatter::prepare(toExportSettings &)
+{
+}
+
+void toListViewFormatter::measureRow(QVector<QVariant> const &)
+{
+}
+
+void toListViewFormatter::writeHeader(QTextStream &)
+{
+}
+
+void toListViewFormatter::writeFooter(QTextStream &)
+{
+}
+
 void toListViewFormatter::endLine(QString &output)
 {
-#ifdef Q_OS_WIN32
-    output += "\r\n";
-#else
-    output += "\n";
-#endif
+    output += LineEnd;
+}
+
+void toListViewFormatter::endLine(QTextStream &out)
+{
+    out << LineEnd;
 }
 
-QVector<int> toListViewFormatter::selectedRows(const QModelIndexList &selected)
+QBitArray toListViewFormatter::exportRows(toExportSettings const &settings, int rows)
 {
+    if (settings.rowsExport == toExportSettings::RowsSelected)
+        return selectedRows(settings.selected, rows);
+    return QBitArray(rows, true);
+}
 
-    QVector<int> ret;
+QBitArray toListViewFormatter::selectedRows(const QModelIndexList &selected, int rows)
+{
+    QBitArray ret(rows, false);
     for (QList<QModelIndex>::const_iterator it = selected.begin(); it != selected.end(); it++)
     {
         int r = (*it).row();
-        if (!ret.contains(r))
-            ret.append(r);
+        if (r >= 0 && r < rows)
+            ret.setBit(r);
     }
 
     return ret;
 }
 
-QVector<int> toListViewFormatter::selectedColumns(const QModelIndexList &selected)
+QBitArray toListViewFormatter::selectedColumns(const QModelIndexList &selected, int columns)
 {
-    QVector<int> ret;
-    ret.append(0); // for later check for row headers
+    QBitArray ret(columns, false);
+    if (columns > 0)
+        ret.setBit(0); // for later check for row headers
     for (QList<QModelIndex>::const_iterator it = selected.begin(); it != selected.end(); it++)
     {
         int c = (*it).column();
-        if (!ret.contains(c))
-            ret.append(c);
+        if (c >= 0 && c < columns)
+            ret.setBit(c);
     }
 
     return ret;
@@ -35,10 +35,16 @@
 #pragma once
 
 #include "core/toconfenum.h"
+#include "core/tocache.h"
 
 #include <QtCore/QString>
+#include <QtCore/QStringList>
 #include <QtCore/QModelIndexList>
 #include <QtCore/QVector>
+#include <QtCore/QVariant>
+#include <QtCore/QBitArray>
+
+class QTextStream;
 
 class toListView;
 class toResultModel;
@@ -124,6 +130,9 @@ class toExportSettings
                 case 4:
                     extension = "*.sql";
                     break;
+                case 5:
+                    extension = "*.xlsx";
+                    break;
             };
         }
 
@@ -136,16 +145,82 @@ class toExportSettings
 };
 
 
+/**
+ * Base class of the export formats.
+ *
+ * Formatters write the export row by row (startExport(), writeHeader(),
+ * writeRow() for each row, writeFooter()), so the export can be streamed
+ * into a file by @ref toListViewExport without holding all of it in memory.
+ * startExport() is called in the model's thread, the write methods only
+ * see the values read from the model and can run in a worker thread.
+ */
 class toListViewFormatter
 {
 public:
 	toListViewFormatter();
 	virtual ~toListViewFormatter();
-	virtual QString getFormattedString(toExportSettings &settings, const QAbstractItemModel * model) = 0;
+
+	/** Format the whole export into one string (clipboard copy, small exports) */
+	virtual QString getFormattedString(toExportSettings &settings, const QAbstractItemModel * model);
+
+	/** Format the whole export into out, binary formats (xlsx) need a stream with a device */
+	void writeFormatted(QTextStream &out, toExportSettings &settings, const QAbstractItemModel * model);
+
+	/** Prepare the export of rows (number of rows to be written) from model,
+	 * reads the column headers and decides exported columns
+	 */
+	void startExport(toExportSettings &settings, const QAbstractItemModel * model, int rows);
+
+	/** Prepare the export of query result (all the columns), rows is -1 if unknown */
+	void startExport(toExportSettings &settings, toQColumnDescriptionList const &columns, int rows);
+
+	/** Model columns exported (in this order), writeRow() gets values of these columns */
+	QVector<int> const& exportColumns(void) const
+	{
+		return Columns;
+	}
+
+	/** True if all the rows have to be passed to measureRow() before writeHeader() */
+	virtual bool needsMeasure(void) const
+	{
+		return false;
+	}
+	virtual void measureRow(QVector<QVariant> const &values);
+
+	virtual void writeHeader(QTextStream &out);
+	virtual void writeRow(QTextStream &out, QVector<QVariant> const &values) = 0;
+	virtual void writeFooter(QTextStream &out);
+
+	/** Line end written by endLine(), platform line end by default */
+	void setLineEnd(QString const &lineEnd)
+	{
+		LineEnd = lineEnd;
+	}
+
+	/** Bit set for the model rows to be exported */
+	static QBitArray exportRows(toExportSettings const &settings, int rows);
 
 protected:
+	/** Called by startExport() when Columns, Headers and Datatypes are known */
+	virtual void prepare(toExportSettings &settings);
+
 	virtual void endLine(QString &output);
-	// build a vector of selected rows for easy searching
-	virtual QVector<int> selectedRows(const QModelIndexList &selected);
-	virtual QVector<int> selectedColumns(const QModelIndexList &selected);
+	void endLine(QTextStream &out);
+
+	/** True if the row number (model column 0) is never exported */
+	virtual bool skipRowNumber(void) const
+	{
+		return false;
+	}
+
+	// bit sets of selected rows and columns for easy searching
+	static QBitArray selectedRows(const QModelIndexList &selected, int rows);
+	static QBitArray selectedColumns(const QModelIndexList &selected, int columns);
+
+	QVector<int> Columns;       // exported model columns
+	QStringList Headers;        // headers of exported columns
+	QStringList Datatypes;      // data types of exported columns (empty if unknown)
+	bool ColumnsHeader;         // write column headers
+	int Rows;                   // number of exported rows, -1 if unknown
+	QString LineEnd;
 };
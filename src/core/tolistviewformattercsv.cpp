@@ -36,7 +36,7 @@
 #include "core/tolistviewformatterfactory.h"
 #include "core/tolistviewformatteridentifier.h"
 
-#include <QtCore/QRegExp>
+#include <QtCore/QTextStream>
 
 #include <iostream>
 #include <vector>
@@ -63,77 +63,39 @@ toListViewFormatterCSV::~toListViewFormatterCSV()
 
 QString toListViewFormatterCSV::QuoteString(const QString &str)
 {
-    static QRegExp quote(QString::fromLatin1("\""));
+    // no static QRegExp here, rows can be written by a worker thread
     QString t = str;
-    t.replace(quote, QString::fromLatin1("\"\""));
+    t.replace(QChar('"'), QString::fromLatin1("\"\""));
     return t;
 }
 
-QString toListViewFormatterCSV::getFormattedString(toExportSettings &settings,
-        //const toResultModel *model);
-        const QAbstractItemModel * model)
+void toListViewFormatterCSV::prepare(toExportSettings &settings)
 {
-    int     columns   = model->columnCount();
-    int     rows      = model->rowCount();
-    QString separator = settings.separator;
-    QString delimiter = settings.delimiter;
-
-    QString output;
-    QString indent;
-
-    QVector<int> rlist = selectedRows(settings.selected);
-    QVector<int> clist = selectedColumns(settings.selected);
+    Separator = settings.separator;
+    Delimiter = settings.delimiter;
+}
 
-    if (settings.columnsHeader)
+void toListViewFormatterCSV::writeLine(QTextStream &out, QStringList const &values)
+{
+    for (int i = 0; i < values.size(); i++)
     {
-        for (int j = (settings.rowsHeader ? 0 : 1); j < columns; j++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(j))
-                continue;
-            output += QString::fromLatin1("%1%2%3%4").
-                      arg(delimiter).
-                      arg(QuoteString(model->headerData(
-                                          j,
-                                          Qt::Horizontal,
-                                          Qt::DisplayRole).toString())).
-                      arg(delimiter).
-                      arg(separator);
-        }
-        if (output.length() > 0)
-            output = output.left(output.length() - separator.length());
-
-        endLine(output);
+        if (i > 0)
+            out << Separator;
+        out << Delimiter << QuoteString(values.at(i)) << Delimiter;
     }
+    endLine(out);
+}
 
-    QModelIndex mi;
-    for (int row = 0; row < rows; row++)
-    {
-        if (settings.rowsExport == toExportSettings::RowsSelected && !rlist.contains(row))
-            continue;
-
-        QString line;
-        for (int i = 0; i < columns; i++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(i))
-                continue;
-            if (!settings.rowsHeader && i == 0)
-                continue;
-
-            mi = model->index(row, i);
-            QString text = model->data(mi, Qt::EditRole).toString();
-            line += indent;
-
-            line += QString::fromLatin1("%1%2%3%4").
-                    arg(delimiter,
-                        QuoteString(text),
-                        delimiter,
-                        separator);
-        }
-
-        line = line.left(line.length() - separator.length());
-        output += line;
-        endLine(output);
-    }
+void toListViewFormatterCSV::writeHeader(QTextStream &out)
+{
+    if (ColumnsHeader)
+        writeLine(out, Headers);
+}
 
-    return output;
+void toListViewFormatterCSV::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    QStringList line;
+    foreach(QVariant const &v, values)
+        line.append(v.toString());
+    writeLine(out, line);
 }
@@ -46,8 +46,17 @@ class toListViewFormatterCSV : public toListViewFormatter
     public:
         toListViewFormatterCSV();
         virtual ~toListViewFormatterCSV();
-        virtual QString getFormattedString(toExportSettings &settings,
-                                           const QAbstractItemModel * model);
+        virtual void writeHeader(QTextStream &out);
+        virtual void writeRow(QTextStream &out, QVector<QVariant> const &values);
+
+    protected:
+        virtual void prepare(toExportSettings &settings);
+
+    private:
+        void writeLine(QTextStream &out, QStringList const &values);
+
+        QString Separator;
+        QString Delimiter;
 };
 
 #endif
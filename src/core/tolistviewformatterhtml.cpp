@@ -37,6 +37,7 @@
 #include "core/tolistviewformatteridentifier.h"
 #include "core/utils.h"
 
+#include <QtCore/QTextStream>
 #include <QtGui/QTextDocument>
 
 #include <iostream>
@@ -61,80 +62,43 @@ toListViewFormatterHTML::~toListViewFormatterHTML()
 {
 }
 
-QString toListViewFormatterHTML::getFormattedString(toExportSettings &settings, const QAbstractItemModel * model)
+void toListViewFormatterHTML::writeCell(QTextStream &out, QString const &tag, QString const &text)
 {
-    int     columns   = model->columnCount();
-    int     rows      = model->rowCount();
-
-    QString output;
-    QString indent;
-
-    QVector<int> rlist = selectedRows(settings.selected);
-    QVector<int> clist = selectedColumns(settings.selected);
+    out << "\t<" << tag << ">";
+    endLine(out);
+    out << "\t\t" << TO_ESCAPE(text);
+    endLine(out);
+    out << "\t</" << tag << ">";
+    endLine(out);
+}
 
-    output = QString("<HTML><HEAD><TITLE>Export</TITLE></HEAD><BODY><TABLE>");
-    endLine(output);
+void toListViewFormatterHTML::writeHeader(QTextStream &out)
+{
+    out << "<HTML><HEAD><TITLE>Export</TITLE></HEAD><BODY><TABLE>";
+    endLine(out);
 
-    QString bgcolor;
-    if (settings.columnsHeader)
+    if (ColumnsHeader)
     {
-        output += QString("<TR>");
-        endLine(output);
-
-        for (int column = 0; column < columns; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
-            if (!settings.rowsHeader && column == 0)
-                continue;
-            output += QString("\t<TH>");
-            endLine(output);
-
-            QString text = TO_ESCAPE(QString(model->headerData(column, Qt::Horizontal, Qt::DisplayRole).toString()));
-
-            output += "\t\t" + text;
-
-            endLine(output);
-            output += QString("\t</TH>");
-            endLine(output);
-        }
-
-        output += "</TR>";
-        endLine(output);
+        out << "<TR>";
+        endLine(out);
+        foreach(QString const &header, Headers)
+            writeCell(out, "TH", header);
+        out << "</TR>";
+        endLine(out);
     }
+}
 
-    QModelIndex mi;
-    for (int row = 0; row < rows; row++)
-    {
-        if (settings.rowsExport == toExportSettings::RowsSelected && !rlist.contains(row))
-            continue;
-
-        output += "<TR>";
-        endLine(output);
-
-        for (int i = 0; i < columns; i++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(i))
-                continue;
-            if (!settings.rowsHeader && i == 0)
-                continue;
-            output += QString("\t<TD>");
-            endLine(output);
-
-            mi = model->index(row, i);
-            QString text = TO_ESCAPE(QString(model->data(mi, Qt::EditRole).toString()));
-
-            output += "\t\t" + text;
-            endLine(output);
-
-            output += QString("\t</TD>");
-            endLine(output);
-        }
-
-        output += "</TR>";
-        endLine(output);
-    }
+void toListViewFormatterHTML::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    out << "<TR>";
+    endLine(out);
+    foreach(QVariant const &v, values)
+        writeCell(out, "TD", v.toString());
+    out << "</TR>";
+    endLine(out);
+}
 
-    output += "</TABLE></BODY></HTML>";
-    return output;
+void toListViewFormatterHTML::writeFooter(QTextStream &out)
+{
+    out << "</TABLE></BODY></HTML>";
 }
@@ -43,7 +43,11 @@ class toListViewFormatterHTML : public toListViewFormatter
 public:
 	toListViewFormatterHTML();
 	virtual ~toListViewFormatterHTML();
-	QString getFormattedString(toExportSettings &settings, const QAbstractItemModel * model) override;
+	void writeHeader(QTextStream &out) override;
+	void writeRow(QTextStream &out, QVector<QVariant> const &values) override;
+	void writeFooter(QTextStream &out) override;
+private:
+	void writeCell(QTextStream &out, QString const &tag, QString const &text);
 };
 
 #endif
@@ -36,5 +36,5 @@
 
 namespace toListViewFormatterIdentifier
 {
-    enum { TEXT, TAB_DELIMITED, CSV, HTML, SQL, XLSX};
+    enum { TEXT, TAB_DELIMITED, CSV, HTML, SQL, XLSX, XML_SPREADSHEET};
 }
@@ -47,6 +47,8 @@
 #include "core/utils.h"
 #include "widgets/toresultmodel.h"
 
+#include <QtCore/QTextStream>
+
 namespace
 {
     toListViewFormatter* createSQL()
@@ -57,31 +59,25 @@ namespace
 }
 
 
-toListViewFormatterSQL::toListViewFormatterSQL() : toListViewFormatter()
+toListViewFormatterSQL::toListViewFormatterSQL()
+    : toListViewFormatter()
+    , Traits(NULL)
 {}
 
 toListViewFormatterSQL::~toListViewFormatterSQL()
 {}
 
 
-QString toListViewFormatterSQL::getFormattedString(toExportSettings &settings,
-        //const toResultModel *model);
-        const QAbstractItemModel * model)
+void toListViewFormatterSQL::prepare(toExportSettings &settings)
 {
     using namespace ToConfiguration;
 
     toConnection &conn = toConnectionRegistrySing::Instance().currentConnection();
-
-    int     columns   = model->columnCount();
-    int     rows      = model->rowCount();
-
-    QVector<int> rlist = selectedRows(settings.selected);
-    QVector<int> clist = selectedColumns(settings.selected);
+    Traits = &conn.getTraits();
 
     QString sql;
     QString objectName;
     QString columnNames;
-    QString output;
 
     if (toConfigurationNewSingle::Instance().option(Editor::KeywordUpperBool).toBool())
         sql = "INSERT INTO %1%2 VALUES (%3);";
@@ -103,65 +99,42 @@ QString toListViewFormatterSQL::getFormattedString(toExportSettings &settings,
     }
 
     if (settings.columnsHeader)
-    {
-        columnNames += " (";
-        for (int j = 1; j < columns; j++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(j))
-                continue;
-            columnNames += model->headerData(
-                               j,
-                               Qt::Horizontal,
-                               Qt::DisplayRole).toString();
-            columnNames += ", ";
-        }
-        columnNames = columnNames.left(columnNames.length() - 2) + ")";
-    }
+        columnNames = " (" + Headers.join(", ") + ")";
 
-    const toResultModel *resultModel = reinterpret_cast<const toResultModel*>(model);
-    if (!model)
-        return "-- cannot access data result. Maybe it's not a SQL export";
+    // %3 is left for the values
+    Statement = sql.arg(objectName).arg(columnNames);
 
-    QModelIndex mi;
-    toResultModel::HeaderList hdr = resultModel->headers();
-    for (int row = 0; row < rows; row++)
+    Types.clear();
+    foreach(QString const &datatype, Datatypes)
     {
-        if (settings.rowsExport == toExportSettings::RowsSelected && !rlist.contains(row))
-            continue;
-
-        QString values;
-        for (int i = 1; i < columns; i++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(i))
-                continue;
-//             if (!settings.rowsHeader && i == 0)
-//                 continue;
-
-            mi = model->index(row, i);
-            QVariant currVal(model->data(mi, Qt::EditRole));
-
-            QString h(hdr.at(i).datatype.toUpper());
-            if (h.contains("DATE"))
-            {
-                if (currVal.toString().isEmpty())
-                    values += "NULL";
-                else
-                {
-                    values += conn.getTraits().formatDate(currVal);
-                }
-            }
-            else if (h.contains("CHAR"))
-            	values += currVal.toString().isEmpty() ? "NULL" : conn.getTraits().quoteVarchar(currVal.toString());
-            else
-                values += currVal.toString().isEmpty() ? "NULL" : currVal.toString();
-
-            values += ", ";
-        }
-        values = values.left(values.length() - 2);
-        QString line(sql.arg(objectName).arg(columnNames).arg(values));
-        endLine(line);
-        output += line;
+        QString h(datatype.toUpper());
+        if (h.contains("DATE"))
+            Types.append(DateValue);
+        else if (h.contains("CHAR"))
+            Types.append(CharValue);
+        else
+            Types.append(OtherValue);
     }
+}
 
-    return output;
+void toListViewFormatterSQL::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    QString line;
+    for (int i = 0; i < values.size(); i++)
+    {
+        QVariant const &currVal = values.at(i);
+        if (i > 0)
+            line += ", ";
+
+        if (currVal.toString().isEmpty())
+            line += "NULL";
+        else if (Types.at(i) == DateValue)
+            line += Traits->formatDate(currVal);
+        else if (Types.at(i) == CharValue)
+            line += Traits->quoteVarchar(currVal.toString());
+        else
+            line += currVal.toString();
+    }
+    out << QString(Statement).arg(line);
+    endLine(out);
 }
@@ -38,10 +38,13 @@
 #include "core/tolistviewformatter.h"
 
 #include <QtCore/QString>
+#include <QtCore/QVector>
 
 #include <map>
 #include <list>
 
+class toConnectionTraits;
+
 typedef std::map<QString, int> SQLTypeMap;
 
 class toListViewFormatterSQL : public toListViewFormatter
@@ -50,8 +53,27 @@ class toListViewFormatterSQL : public toListViewFormatter
     public:
         toListViewFormatterSQL();
         virtual ~toListViewFormatterSQL();
-        virtual QString getFormattedString(toExportSettings &settings,
-                                           const QAbstractItemModel * model);
+        virtual void writeRow(QTextStream &out, QVector<QVariant> const &values);
+
+    protected:
+        virtual void prepare(toExportSettings &settings);
+
+        virtual bool skipRowNumber(void) const
+        {
+            return true;
+        }
+
+    private:
+        enum ValueType
+        {
+            DateValue,
+            CharValue,
+            OtherValue
+        };
+
+        toConnectionTraits const *Traits;
+        QString Statement;          // insert statement with the table and column names filled in
+        QVector<ValueType> Types;   // type of exported columns
 };
 
 
@@ -36,6 +36,8 @@
 #include "core/tolistviewformatterfactory.h"
 #include "core/tolistviewformatteridentifier.h"
 
+#include <QtCore/QTextStream>
+
 #include <iostream>
 #include "tools/toresultview.h"
 
@@ -58,61 +60,21 @@ toListViewFormatterTabDel::~toListViewFormatterTabDel()
 {
 }
 
-QString toListViewFormatterTabDel::getFormattedString(toExportSettings &settings, const QAbstractItemModel * model)
+void toListViewFormatterTabDel::writeHeader(QTextStream &out)
 {
-    int     columns   = model->columnCount();
-    int     rows      = model->rowCount();
-    QString separator("\t");
-
-    QString output;
-    QString indent;
-
-    QVector<int> rlist = selectedRows(settings.selected);
-    QVector<int> clist = selectedColumns(settings.selected);
-
-    // write header data
-    if (settings.columnsHeader)
-    {
-        for (int column = 0; column < columns; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
-            if (!settings.rowsHeader && column == 0)
-                continue;
-            output += QString("%1\t").arg(model->headerData(
-                                              column,
-                                              Qt::Horizontal,
-                                              Qt::DisplayRole).toString());
-        }
-        if (output.length() > 0)
-            output = output.left(output.length() - separator.length());
-
-        endLine(output);
-    }
+    if (!ColumnsHeader)
+        return;
+    out << Headers.join("\t");
+    endLine(out);
+}
 
-    QModelIndex mi;
-    for (int row = 0; row < rows; row++)
+void toListViewFormatterTabDel::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    for (int i = 0; i < values.size(); i++)
     {
-        if (settings.rowsExport == toExportSettings::RowsSelected && !rlist.contains(row))
-            continue;
-
-        QString line;
-        for (int i = 0; i < columns; i++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(i))
-                continue;
-            if (!settings.rowsHeader && i == 0)
-                continue;
-            mi = model->index(row, i);
-            QString text = model->data(mi, Qt::EditRole).toString();
-            line += indent;
-            line += QString::fromLatin1("%1\t").arg(text);
-        }
-
-        line = line.left(line.length() - separator.length());
-        output += line;
-        endLine(output);
+        if (i > 0)
+            out << '\t';
+        out << values.at(i).toString();
     }
-
-    return output;
+    endLine(out);
 }
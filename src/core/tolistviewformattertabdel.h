@@ -44,8 +44,8 @@ class toListViewFormatterTabDel : public toListViewFormatter
         toListViewFormatterTabDel();
         virtual ~toListViewFormatterTabDel();
         //virtual QString getFormattedString(toListView& tListView);
-        virtual QString getFormattedString(toExportSettings &settings,
-                                           const QAbstractItemModel * model);
+        virtual void writeHeader(QTextStream &out);
+        virtual void writeRow(QTextStream &out, QVector<QVariant> const &values);
 };
 
 #endif
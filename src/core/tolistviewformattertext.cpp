@@ -36,6 +36,7 @@
 #include "core/tolistviewformatterfactory.h"
 #include "core/tolistviewformatteridentifier.h"
 
+#include <QtCore/QTextStream>
 #include <QtCore/QVector>
 
 #include <iostream>
@@ -54,115 +55,58 @@ toListViewFormatterText::toListViewFormatterText() : toListViewFormatter()
 {
 }
 
-QString toListViewFormatterText::getFormattedString(toExportSettings &settings, const QAbstractItemModel * model)
+QString toListViewFormatterText::text(QVariant const &data)
 {
-    int     columns   = model->columnCount();
-    int     rows      = model->rowCount();
-
-    QString output;
-    QVector<int> sizes(columns);
-
-    QVector<int> rlist = selectedRows(settings.selected);
-    QVector<int> clist = selectedColumns(settings.selected);
+    if (data.isNull())
+        return QString::fromLatin1("{null}");
+    return data.toString();
+}
 
-    // must get widest length for each column
+void toListViewFormatterText::prepare(toExportSettings &)
+{
     // zero array or (if writing headers, set their size)
-    for (int i = 0; i < columns - 1; i++)
-    {
-        if (settings.columnsHeader)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(i))
-                continue;
-            sizes[i] = model->headerData(
-                           i,
-                           Qt::Horizontal,
-                           Qt::DisplayRole).toString().length();
-        }
-        else
-            sizes[i] = 0;
-    }
+    Sizes.fill(0, Columns.size());
+    if (ColumnsHeader)
+        for (int i = 0; i < Columns.size(); i++)
+            Sizes[i] = Headers.at(i).length();
+}
 
-    // loop through model and get column widths
-    for (int row = 0; row < rows; row++)
-    {
-        for (int column = 0; column < columns - 1; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
-            if (!settings.rowsHeader && column == 0)
-                continue;
+void toListViewFormatterText::measureRow(QVector<QVariant> const &values)
+{
+    for (int i = 0; i < values.size(); i++)
+        Sizes[i] = (std::max)(Sizes[i], text(values.at(i)).length());
+}
 
-            QVariant data = model->data(model->index(row, column), Qt::EditRole);
-            QString v;
-            if (data.isNull())
-                v = "{null}";
-            else
-                v = data.toString();
-            sizes[column] = (std::max)(sizes[column], v.length());
-        }
-    }
+void toListViewFormatterText::writeHeader(QTextStream &out)
+{
+    if (!ColumnsHeader)
+        return;
 
     // write header data to fixed widths
-    if (settings.columnsHeader)
+    for (int i = 0; i < Columns.size(); i++)
     {
-        for (int column = 0; column < columns; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
-            if (!settings.rowsHeader && column == 0)
-                continue;
-            QString value = model->headerData(
-                                column,
-                                Qt::Horizontal,
-                                Qt::DisplayRole).toString();
-
-            output += value.leftJustified(sizes[column], ' ');
-            output += ' '; // gap between columns
-        }
-
-        endLine(output);
-
-        // write ==== border
-        for (int column = 0; column < columns; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
-            if (!settings.rowsHeader && column == 0)
-                continue;
-
-            output += QString::fromLatin1("=").leftJustified(sizes[column], '=');
-            output += ' '; // gap between columns
-        }
-
-        endLine(output);
+        out << Headers.at(i).leftJustified(Sizes.at(i), ' ');
+        out << ' '; // gap between columns
     }
+    endLine(out);
 
-    // write data
-    for (int row = 0; row < rows; row++)
+    // write ==== border
+    for (int i = 0; i < Columns.size(); i++)
     {
-        if (settings.rowsExport == toExportSettings::RowsSelected && !rlist.contains(row))
-            continue;
-
-        for (int column = 0; column < columns; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
-            if (!settings.rowsHeader && column == 0)
-                continue;
-            QVariant data = model->data(model->index(row, column), Qt::EditRole);
-            QString value;
-            if (data.isNull())
-                value = "{null}";
-            else
-                value = data.toString();
-
-            output += value;
-            for (int left = value.length(); left <= sizes[column]; left++)
-                output += ' ';
-        }
-
-        endLine(output);
+        out << QString::fromLatin1("=").leftJustified(Sizes.at(i), '=');
+        out << ' '; // gap between columns
     }
+    endLine(out);
+}
 
-    return output;
+void toListViewFormatterText::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    for (int i = 0; i < values.size(); i++)
+    {
+        QString value = text(values.at(i));
+        out << value;
+        for (int left = value.length(); left <= Sizes.at(i); left++)
+            out << ' ';
+    }
+    endLine(out);
 }
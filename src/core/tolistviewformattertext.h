@@ -41,5 +41,20 @@ class toListViewFormatterText : public toListViewFormatter
     public:
         toListViewFormatterText();
 
-        QString getFormattedString(toExportSettings &settings, const QAbstractItemModel * model) override;
+        bool needsMeasure(void) const override
+        {
+            return true;
+        }
+        void measureRow(QVector<QVariant> const &values) override;
+        void writeHeader(QTextStream &out) override;
+        void writeRow(QTextStream &out, QVector<QVariant> const &values) override;
+
+    protected:
+        void prepare(toExportSettings &settings) override;
+
+    private:
+        static QString text(QVariant const &data);
+
+        // widest value of each exported column
+        QVector<int> Sizes;
 };
@@ -31,15 +31,24 @@
  * All trademarks belong to their respective owners.
  *
  * END_COMMON_COPYRIGHT_HEADER */
-
 #include "core/tolistviewformatterxlsx.h"
 #include "core/tolistviewformatterfactory.h"
 #include "core/tolistviewformatteridentifier.h"
+#include "ts_log/ts_log_utils.h"
 
-#include <QtCore/QVector>
+#include <QtCore/QDateTime>
+#include <QtCore/QIODevice>
+#include <QtCore/QMutex>
+#include <QtCore/QRegExp>
+#include <QtCore/QRunnable>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+#include <QtCore/QThreadPool>
+#include <QtCore/QWaitCondition>
 
-#include <iostream>
-#include "tools/toresultview.h"
+#include <string.h>
+#include <zlib.h>
 
 namespace
 {
@@ -48,74 +57,644 @@ namespace
         return new toListViewFormatterXLSX();
     }
     const bool registered = toListViewFormatterFactory::Instance().Register(toListViewFormatterIdentifier::XLSX, createXLSX);
+
+    // Excel limit of rows in one worksheet (including the header row)
+    const int MAX_SHEET_ROWS = 1048576;
+    // start a new worksheet well before the 4GB limit of a (non zip64) zip entry
+    const quint64 MAX_SHEET_BYTES = Q_UINT64_C(0xF0000000);
+    // Excel limit of characters in one cell
+    const int MAX_CELL_LENGTH = 32767;
+    // uncompressed size of the chunks deflated in parallel
+    const int CHUNK_SIZE = 1024 * 1024;
+    // only short strings are looked up in the shared strings table, its size is bounded
+    const int MAX_SHARED_LENGTH = 128;
+    const int MAX_SHARED_STRINGS = 65536;
+
+    const quint16 ZIP_VERSION = 20;             // 2.0, deflate
+    const quint16 ZIP_FLAGS = 0x0008;           // sizes and crc in the data descriptor
+    const quint16 ZIP_DEFLATED = 8;
+
+    const char CONTENT_TYPES[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<Types xmlns=\"http://schemas.openxmlformats.org/package/2006/content-types\">"
+        "<Default Extension=\"rels\" ContentType=\"application/vnd.openxmlformats-package.relationships+xml\"/>"
+        // the number of worksheets is not known in advance, any other part has an override
+        "<Default Extension=\"xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.worksheet+xml\"/>"
+        "<Override PartName=\"/xl/workbook.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sheet.main+xml\"/>"
+        "<Override PartName=\"/xl/styles.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.styles+xml\"/>"
+        "<Override PartName=\"/xl/sharedStrings.xml\" ContentType=\"application/vnd.openxmlformats-officedocument.spreadsheetml.sharedStrings+xml\"/>"
+        "</Types>";
+
+    const char ROOT_RELS[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">"
+        "<Relationship Id=\"rId1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/officeDocument\" Target=\"xl/workbook.xml\"/>"
+        "</Relationships>";
+
+    // style 1 (bold) is used by the column headers
+    const char STYLES[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<styleSheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">"
+        "<fonts count=\"2\"><font><sz val=\"11\"/><name val=\"Calibri\"/></font>"
+        "<font><b/><sz val=\"11\"/><name val=\"Calibri\"/></font></fonts>"
+        "<fills count=\"2\"><fill><patternFill patternType=\"none\"/></fill>"
+        "<fill><patternFill patternType=\"gray125\"/></fill></fills>"
+        "<borders count=\"1\"><border><left/><right/><top/><bottom/><diagonal/></border></borders>"
+        "<cellStyleXfs count=\"1\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\"/></cellStyleXfs>"
+        "<cellXfs count=\"2\"><xf numFmtId=\"0\" fontId=\"0\" fillId=\"0\" borderId=\"0\" xfId=\"0\"/>"
+        "<xf numFmtId=\"0\" fontId=\"1\" fillId=\"0\" borderId=\"0\" xfId=\"0\" applyFont=\"1\"/></cellXfs>"
+        "<cellStyles count=\"1\"><cellStyle name=\"Normal\" xfId=\"0\" builtinId=\"0\"/></cellStyles>"
+        "</styleSheet>";
+
+    const char SHEET_START[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<worksheet xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\">";
+    const char SHEET_FROZEN_HEADER[] =
+        "<sheetViews><sheetView workbookViewId=\"0\">"
+        "<pane ySplit=\"1\" topLeftCell=\"A2\" activePane=\"bottomLeft\" state=\"frozen\"/>"
+        "</sheetView></sheetViews>";
+    const char SHEET_DATA_START[] = "<sheetData>";
+    const char SHEET_END[] = "</sheetData></worksheet>";
+
+    const char SHARED_STRINGS_START[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<sst xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\" count=\"%1\" uniqueCount=\"%2\">";
+    const char SHARED_STRINGS_END[] = "</sst>";
+
+    const char WORKBOOK_START[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<workbook xmlns=\"http://schemas.openxmlformats.org/spreadsheetml/2006/main\""
+        " xmlns:r=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships\"><sheets>";
+    const char WORKBOOK_SHEET[] = "<sheet name=\"Sheet%1\" sheetId=\"%1\" r:id=\"rId%1\"/>";
+    const char WORKBOOK_END[] = "</sheets></workbook>";
+
+    const char WORKBOOK_RELS_START[] =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\" standalone=\"yes\"?>\r\n"
+        "<Relationships xmlns=\"http://schemas.openxmlformats.org/package/2006/relationships\">";
+    const char WORKBOOK_RELS_SHEET[] =
+        "<Relationship Id=\"rId%1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/worksheet\" Target=\"worksheets/sheet%1.xml\"/>";
+    const char WORKBOOK_RELS_END[] =
+        "<Relationship Id=\"rId%1\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/styles\" Target=\"styles.xml\"/>"
+        "<Relationship Id=\"rId%2\" Type=\"http://schemas.openxmlformats.org/officeDocument/2006/relationships/sharedStrings\" Target=\"sharedStrings.xml\"/>"
+        "</Relationships>";
+
+    void put16(QByteArray &data, quint16 value)
+    {
+        data.append(char(value & 0xff));
+        data.append(char(value >> 8));
+    }
+
+    void put32(QByteArray &data, quint32 value)
+    {
+        put16(data, quint16(value & 0xffff));
+        put16(data, quint16(value >> 16));
+    }
+
+    /** Raw deflate of one chunk. The chunk ends by a sync flush (empty stored block,
+     * byte aligned) instead of a final block, so chunks compressed independently
+     * can be concatenated into one deflate stream.
+     */
+    bool deflateChunk(QByteArray const &input, QByteArray &output)
+    {
+        z_stream z;
+        memset(&z, 0, sizeof(z));
+        if (deflateInit2(&z, Z_DEFAULT_COMPRESSION, Z_DEFLATED, -MAX_WBITS, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            return false;
+
+        output.resize(int(deflateBound(&z, input.size())) + 16);
+        z.next_in = (Bytef*) input.constData();
+        z.avail_in = input.size();
+        int used = 0;
+        int rc;
+        do
+        {
+            if (used == output.size())
+                output.resize(output.size() * 2);
+            z.next_out = (Bytef*) output.data() + used;
+            z.avail_out = output.size() - used;
+            rc = ::deflate(&z, Z_SYNC_FLUSH);
+            used = output.size() - z.avail_out;
+        }
+        while (rc == Z_OK && z.avail_out == 0);
+        deflateEnd(&z);
+        output.resize(used);
+        return rc == Z_OK;
+    }
+
+    /** Plain decimal number which Excel keeps without loss of precision */
+    bool isNumber(QString const &text)
+    {
+        if (text.isEmpty() || text.size() > 32)
+            return false;
+        int digits = 0;
+        for (int i = 0; i < text.size(); i++)
+        {
+            ushort c = text.at(i).unicode();
+            if (c >= '0' && c <= '9')
+                digits++;
+            else if (c != '.' && c != '-' && c != '+' && c != 'e' && c != 'E')
+                return false;
+        }
+        if (digits == 0 || digits > 15)
+            return false;
+        bool ok;
+        text.toDouble(&ok);
+        return ok;
+    }
+
+    bool isNumericType(QVariant::Type type)
+    {
+        switch (type)
+        {
+            case QVariant::Int:
+            case QVariant::UInt:
+            case QVariant::LongLong:
+            case QVariant::ULongLong:
+            case QVariant::Double:
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    /** Text element of a string cell, characters not allowed in XML are left out */
+    QByteArray xmlText(QString const &text)
+    {
+        QString escaped;
+        escaped.reserve(text.size() + 16);
+        for (int i = 0; i < text.size(); i++)
+        {
+            QChar c = text.at(i);
+            switch (c.unicode())
+            {
+                case '&':
+                    escaped += QLatin1String("&amp;");
+                    break;
+                case '<':
+                    escaped += QLatin1String("&lt;");
+                    break;
+                case '>':
+                    escaped += QLatin1String("&gt;");
+                    break;
+                case '\t':
+                case '\n':
+                case '\r':
+                    escaped += c;
+                    break;
+                default:
+                    if (c.unicode() >= 0x20 && c.unicode() != 0xfffe && c.unicode() != 0xffff)
+                        escaped += c;
+            }
+        }
+
+        bool preserve = !text.isEmpty() && (text.at(0).isSpace() || text.at(text.size() - 1).isSpace());
+        QByteArray retval(preserve ? "<t xml:space=\"preserve\">" : "<t>");
+        retval += escaped.toUtf8();
+        retval += "</t>";
+        return retval;
+    }
 }
 
-toListViewFormatterXLSX::toListViewFormatterXLSX() : toListViewFormatter()
+/**
+ * Deflates chunks of one zip entry in the global thread pool. Chunks are taken
+ * in the order they were added, at most Limit chunks are in progress.
+ */
+class toListViewFormatterXLSX::Deflater
+{
+    public:
+        struct Block
+        {
+            QByteArray Input;
+            QByteArray Output;
+            quint32 Crc;
+            int Size;       // size of Input
+            bool Ok;
+            bool Done;
+        };
+        typedef QSharedPointer<Block> BlockPtr;
+
+        Deflater()
+            : Limit(qMax(2, QThread::idealThreadCount() * 2))
+        {}
+
+        ~Deflater()
+        {
+            // jobs refer to this object
+            while (!Pending.isEmpty())
+                take();
+        }
+
+        bool full(void) const
+        {
+            return Pending.size() >= Limit;
+        }
+
+        bool empty(void) const
+        {
+            return Pending.isEmpty();
+        }
+
+        void add(QByteArray const &input)
+        {
+            BlockPtr block(new Block);
+            block->Input = input;
+            block->Crc = 0;
+            block->Size = input.size();
+            block->Ok = false;
+            block->Done = false;
+            Pending.append(block);
+            QThreadPool::globalInstance()->start(new Job(this, block));
+        }
+
+        /** Wait for the oldest chunk */
+        BlockPtr take(void)
+        {
+            BlockPtr block = Pending.takeFirst();
+            QMutexLocker lock(&Lock);
+            while (!block->Done)
+                Finished.wait(&Lock);
+            return block;
+        }
+
+    private:
+        class Job : public QRunnable
+        {
+            public:
+                Job(Deflater *owner, BlockPtr const &block)
+                    : Owner(owner)
+                    , Data(block)
+                {}
+
+                virtual void run()
+                {
+                    Data->Ok = deflateChunk(Data->Input, Data->Output);
+                    Data->Crc = ::crc32(0, (Bytef const*) Data->Input.constData(), Data->Size);
+                    Data->Input = QByteArray();
+
+                    QMutexLocker lock(&Owner->Lock);
+                    Data->Done = true;
+                    Owner->Finished.wakeAll();
+                }
+
+            private:
+                Deflater *Owner;
+                BlockPtr Data;
+        };
+
+        QList<BlockPtr> Pending;
+        QMutex Lock;
+        QWaitCondition Finished;
+        int Limit;
+};
+
+toListViewFormatterXLSX::toListViewFormatterXLSX()
+    : toListViewFormatterXMLSpreadsheet()
+    , Device(NULL)
+    , Binary(false)
+    , Failed(false)
+    , Offset(0)
+    , Time(0)
+    , Date(0)
+    , Sheets(0)
+    , SheetRows(0)
+    , SharedCount(0)
 {
 }
 
-QString toListViewFormatterXLSX::getFormattedString(toExportSettings &settings, const QAbstractItemModel * model)
+toListViewFormatterXLSX::~toListViewFormatterXLSX()
 {
-    // Thx to ClipView tool
-    static QString const DOC_START(
-    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n"
-    "<?mso-application progid=\"Excel.Sheet\"?>\r\n"
-    "<Workbook xmlns=\"urn:schemas-microsoft-com:office:spreadsheet\"\r\n"
-    " xmlns:o=\"urn:schemas-microsoft-com:office:office\"\r\n"
-    " xmlns:x=\"urn:schemas-microsoft-com:office:excel\"\r\n"
-    " xmlns:ss=\"urn:schemas-microsoft-com:office:spreadsheet\"\r\n"
-    " xmlns:html=\"http://www.w3.org/TR/REC-html40\">\r\n"
-    " <Worksheet ss:Name=\"Sheet1\">\r\n"
-    "  <Table ss:ExpandedColumnCount=\"%1\" ss:ExpandedRowCount=\"%2\">\r\n"
-    );
-    static QString const ROW_START("   <Row>\r\n");
-    static QString const ROW_LINE ("    <Cell><Data ss:Type=\"%1\">%2</Data></Cell>\r\n");
-    static QString const ROW_END  ("   </Row>\r\n");
-    static QString const DOC_END  (
-    "  </Table>\r\n"
-    " </Worksheet>\r\n"
-    "</Workbook>\r\n"
-    );
+}
 
-    int columns = model->columnCount();
-    int rows    = model->rowCount();
+void toListViewFormatterXLSX::prepare(toExportSettings &settings)
+{
+    toListViewFormatterXMLSpreadsheet::prepare(settings);
 
-    QString output;
+    // local, QRegExp keeps the match state and exports may run in parallel
+    QRegExp numeric("^(NUMBER|NUMERIC|DECIMAL|DEC|FLOAT|REAL|DOUBLE|BINARY_FLOAT|BINARY_DOUBLE|(TINY|SMALL|MEDIUM|BIG)?INT(EGER)?)\\b",
+                    Qt::CaseInsensitive);
+    Numeric.fill(false, Columns.size());
+    for (int i = 0; i < Datatypes.size() && i < Numeric.size(); i++)
+        Numeric[i] = numeric.indexIn(Datatypes.at(i).trimmed()) == 0;
+}
 
-    QVector<int> rlist = selectedRows(settings.selected);
-    QVector<int> clist = selectedColumns(settings.selected);
+void toListViewFormatterXLSX::writeHeader(QTextStream &out)
+{
+    // string output (clipboard), zip can only be written into a device
+    Binary = out.device() != NULL;
+    if (!Binary)
+    {
+        toListViewFormatterXMLSpreadsheet::writeHeader(out);
+        return;
+    }
+
+    out.flush();
+    Device = out.device();
+    Compressor.reset(new Deflater());
+    Failed = false;
+    Offset = 0;
+    Entries.clear();
+    Sheets = 0;
+    SharedIndex.clear();
+    SharedStrings.clear();
+    SharedCount = 0;
 
-    // -1 for XLSX does not support row number
-    int columnCount = settings.columnsExport == toExportSettings::ColumnsSelected ? clist.size()-1 : columns;
-    int rowCount    = settings.rowsExport    == toExportSettings::RowsSelected    ? rlist.size()   : rows;
+    QDateTime now(QDateTime::currentDateTime());
+    Time = quint16((now.time().hour() << 11) | (now.time().minute() << 5) | (now.time().second() / 2));
+    Date = quint16(((qMax(now.date().year(), 1980) - 1980) << 9) | (now.date().month() << 5) | now.date().day());
 
-    output += DOC_START.arg(columnCount).arg(rowCount);
-    // write data
-    for (int row = 0; row < rows; row++)
+    writeEntry("[Content_Types].xml", CONTENT_TYPES);
+    writeEntry("_rels/.rels", ROOT_RELS);
+    writeEntry("xl/styles.xml", STYLES);
+    beginSheet();
+
+    if (Failed)
+        out.setStatus(QTextStream::WriteFailed);
+}
+
+void toListViewFormatterXLSX::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    if (!Binary)
     {
-        if (settings.rowsExport == toExportSettings::RowsSelected && !rlist.contains(row))
-            continue;
+        toListViewFormatterXMLSpreadsheet::writeRow(out, values);
+        return;
+    }
 
-        output += ROW_START;
-        for (int column = 1; column < columns; column++)
-        {
-            if (settings.columnsExport == toExportSettings::ColumnsSelected && !clist.contains(column))
-                continue;
+    if (SheetRows >= MAX_SHEET_ROWS || Current.Size + Chunk.size() >= MAX_SHEET_BYTES)
+    {
+        endSheet();
+        beginSheet();
+    }
+
+    QByteArray row("<row r=\"");
+    row += QByteArray::number(++SheetRows);
+    row += "\">";
+    for (int i = 0; i < values.size(); i++)
+        appendCell(row, values.at(i), i);
+    row += "</row>";
+    writeEntryData(row);
+
+    if (Failed)
+        out.setStatus(QTextStream::WriteFailed);
+}
+
+void toListViewFormatterXLSX::writeFooter(QTextStream &out)
+{
+    if (!Binary)
+    {
+        toListViewFormatterXMLSpreadsheet::writeFooter(out);
+        return;
+    }
+
+    endSheet();
+
+    beginEntry("xl/sharedStrings.xml");
+    writeEntryData(QString(SHARED_STRINGS_START).arg(SharedCount).arg(SharedStrings.size()).toUtf8());
+    foreach (QByteArray const &text, SharedStrings)
+    {
+        writeEntryData("<si>");
+        writeEntryData(text);
+        writeEntryData("</si>");
+    }
+    writeEntryData(SHARED_STRINGS_END);
+    endEntry();
+    SharedIndex.clear();
+    SharedStrings.clear();
+
+    QByteArray workbook(WORKBOOK_START);
+    QByteArray rels(WORKBOOK_RELS_START);
+    for (int i = 1; i <= Sheets; i++)
+    {
+        workbook += QString(WORKBOOK_SHEET).arg(i).toUtf8();
+        rels += QString(WORKBOOK_RELS_SHEET).arg(i).toUtf8();
+    }
+    workbook += WORKBOOK_END;
+    rels += QString(WORKBOOK_RELS_END).arg(Sheets + 1).arg(Sheets + 2).toUtf8();
+    writeEntry("xl/workbook.xml", workbook);
+    writeEntry("xl/_rels/workbook.xml.rels", rels);
+
+    writeCentralDirectory();
+    Compressor.reset();
+
+    if (Failed)
+        out.setStatus(QTextStream::WriteFailed);
+}
 
-            QVariant data = model->data(model->index(row, column), Qt::EditRole);
-            QVariant type = model->headerData(column, Qt::Horizontal, Qt::UserRole);
+void toListViewFormatterXLSX::beginSheet(void)
+{
+    Sheets++;
+    SheetRows = 0;
+    beginEntry(QString("xl/worksheets/sheet%1.xml").arg(Sheets).toUtf8());
+    writeEntryData(SHEET_START);
+    if (ColumnsHeader)
+        writeEntryData(SHEET_FROZEN_HEADER);
+    writeEntryData(SHEET_DATA_START);
+
+    // every worksheet starts by the column headers
+    if (ColumnsHeader)
+    {
+        QByteArray row("<row r=\"");
+        row += QByteArray::number(++SheetRows);
+        row += "\">";
+        foreach (QString const &header, Headers)
+            appendString(row, header, true);
+        row += "</row>";
+        writeEntryData(row);
+    }
+}
 
-            QString value;
-            if (data.isNull())
-                value = "{null}";
-            else
-                value = TO_ESCAPE(data.toString());
+void toListViewFormatterXLSX::endSheet(void)
+{
+    writeEntryData(SHEET_END);
+    endEntry();
+}
+
+void toListViewFormatterXLSX::appendCell(QByteArray &row, QVariant const &value, int column)
+{
+    // cells have no reference, so empty cells have to be written too
+    if (value.isNull())
+    {
+        row += "<c/>";
+        return;
+    }
+
+    QString text(value.toString());
+    if ((isNumericType(value.type()) || Numeric.value(column)) && isNumber(text))
+    {
+        row += "<c><v>";
+        row += text.toLatin1();
+        row += "</v></c>";
+        return;
+    }
+    appendString(row, text, false);
+}
+
+void toListViewFormatterXLSX::appendString(QByteArray &row, QString const &text, bool header)
+{
+    QString str(text);
+    if (str.size() > MAX_CELL_LENGTH)
+    {
+        str.truncate(MAX_CELL_LENGTH);
+        if (str.at(str.size() - 1).isHighSurrogate())
+            str.chop(1);
+    }
 
-            output += ROW_LINE.arg("String").arg(value);
+    if (!header && str.size() <= MAX_SHARED_LENGTH)
+    {
+        int index = SharedIndex.value(str, -1);
+        if (index < 0 && SharedStrings.size() < MAX_SHARED_STRINGS)
+        {
+            index = SharedStrings.size();
+            SharedIndex.insert(str, index);
+            SharedStrings.append(xmlText(str));
         }
-        output += ROW_END;
+        if (index >= 0)
+        {
+            SharedCount++;
+            row += "<c t=\"s\"><v>";
+            row += QByteArray::number(index);
+            row += "</v></c>";
+            return;
+        }
+    }
+
+    row += header ? "<c t=\"inlineStr\" s=\"1\"><is>" : "<c t=\"inlineStr\"><is>";
+    row += xmlText(str);
+    row += "</is></c>";
+}
+
+void toListViewFormatterXLSX::beginEntry(QByteArray const &name)
+{
+    Current.Name = name;
+    Current.Crc = 0;
+    Current.CompressedSize = 0;
+    Current.Size = 0;
+    Current.Offset = Offset;
+    Chunk.clear();
+
+    QByteArray header;
+    put32(header, 0x04034b50);
+    put16(header, ZIP_VERSION);
+    put16(header, ZIP_FLAGS);
+    put16(header, ZIP_DEFLATED);
+    put16(header, Time);
+    put16(header, Date);
+    put32(header, 0);   // crc and sizes follow the data
+    put32(header, 0);
+    put32(header, 0);
+    put16(header, quint16(name.size()));
+    put16(header, 0);
+    header += name;
+    writeBytes(header);
+}
+
+void toListViewFormatterXLSX::writeEntryData(QByteArray const &data)
+{
+    Chunk += data;
+    if (Chunk.size() >= CHUNK_SIZE)
+        flushChunk();
+}
+
+void toListViewFormatterXLSX::flushChunk(void)
+{
+    if (Chunk.isEmpty())
+        return;
+    if (Compressor->full())
+        writeChunk();
+    Current.Size += Chunk.size();
+    Compressor->add(Chunk);
+    Chunk = QByteArray();
+    Chunk.reserve(CHUNK_SIZE + CHUNK_SIZE / 8);
+}
+
+void toListViewFormatterXLSX::writeChunk(void)
+{
+    Deflater::BlockPtr block = Compressor->take();
+    if (!block->Ok)
+        Failed = true;
+    writeBytes(block->Output);
+    Current.CompressedSize += block->Output.size();
+    Current.Crc = quint32(crc32_combine(Current.Crc, block->Crc, block->Size));
+}
+
+void toListViewFormatterXLSX::endEntry(void)
+{
+    flushChunk();
+    while (!Compressor->empty())
+        writeChunk();
+
+    // final empty block of fixed huffman codes ends the deflate stream
+    static const char FINAL_BLOCK[] = { 0x03, 0x00 };
+    writeBytes(QByteArray(FINAL_BLOCK, sizeof(FINAL_BLOCK)));
+    Current.CompressedSize += sizeof(FINAL_BLOCK);
+
+    QByteArray descriptor;
+    put32(descriptor, 0x08074b50);
+    put32(descriptor, Current.Crc);
+    put32(descriptor, quint32(Current.CompressedSize));
+    put32(descriptor, quint32(Current.Size));
+    writeBytes(descriptor);
+
+    if (Current.Size > 0xffffffffu || Current.CompressedSize > 0xffffffffu || Current.Offset > 0xffffffffu)
+    {
+        TLOG(1, toDecorator, __HERE__) << "XLSX export exceeds the zip size limit: " << Current.Name.constData() << std::endl;
+        Failed = true;
     }
-    output += DOC_END;
+    Entries.append(Current);
+}
+
+void toListViewFormatterXLSX::writeEntry(QByteArray const &name, QByteArray const &data)
+{
+    beginEntry(name);
+    writeEntryData(data);
+    endEntry();
+}
+
+void toListViewFormatterXLSX::writeBytes(QByteArray const &data)
+{
+    if (Failed)
+        return;
+    if (Device->write(data) != data.size())
+        Failed = true;
+    Offset += data.size();
+}
+
+void toListViewFormatterXLSX::writeCentralDirectory(void)
+{
+    quint64 start = Offset;
+    QByteArray directory;
+    foreach (Entry const &entry, Entries)
+    {
+        put32(directory, 0x02014b50);
+        put16(directory, ZIP_VERSION);  // made by (MS-DOS attributes)
+        put16(directory, ZIP_VERSION);
+        put16(directory, ZIP_FLAGS);
+        put16(directory, ZIP_DEFLATED);
+        put16(directory, Time);
+        put16(directory, Date);
+        put32(directory, entry.Crc);
+        put32(directory, quint32(entry.CompressedSize));
+        put32(directory, quint32(entry.Size));
+        put16(directory, quint16(entry.Name.size()));
+        put16(directory, 0);    // extra field
+        put16(directory, 0);    // comment
+        put16(directory, 0);    // disk number
+        put16(directory, 0);    // internal attributes
+        put32(directory, 0);    // external attributes
+        put32(directory, quint32(entry.Offset));
+        directory += entry.Name;
+    }
+
+    quint32 size = directory.size();
+    put32(directory, 0x06054b50);
+    put16(directory, 0);    // disk number
+    put16(directory, 0);    // disk of the central directory
+    put16(directory, quint16(Entries.size()));
+    put16(directory, quint16(Entries.size()));
+    put32(directory, size);
+    put32(directory, quint32(start));
+    put16(directory, 0);
+    writeBytes(directory);
 
-    return output;
+    if (start > 0xffffffffu || Entries.size() > 0xffff)
+        Failed = true;
 }
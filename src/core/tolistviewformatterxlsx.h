@@ -31,14 +31,84 @@
  * All trademarks belong to their respective owners.
  *
  * END_COMMON_COPYRIGHT_HEADER */
-
 #pragma once
 
-#include "core/tolistviewformatter.h"
+#include "core/tolistviewformatterxmlspreadsheet.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QScopedPointer>
 
-class toListViewFormatterXLSX: public toListViewFormatter
+class QIODevice;
+
+/**
+ * Excel 2007+ workbook (.xlsx) export.
+ *
+ * The workbook is written as a zip archive directly into the device of the
+ * output stream: worksheet rows are streamed into chunks which are deflated
+ * in parallel by the global thread pool and written in order. Short repeated
+ * strings go to the shared strings table, other strings are written inline.
+ * A new worksheet is started when Excel's row limit is reached.
+ *
+ * When the output stream has no device (clipboard copy) SpreadsheetML 2003
+ * is produced instead, see @ref toListViewFormatterXMLSpreadsheet.
+ */
+class toListViewFormatterXLSX: public toListViewFormatterXMLSpreadsheet
 {
     public:
         toListViewFormatterXLSX();
-        QString getFormattedString(toExportSettings &settings, const QAbstractItemModel * model) override;
+        ~toListViewFormatterXLSX();
+
+        void writeHeader(QTextStream &out) override;
+        void writeRow(QTextStream &out, QVector<QVariant> const &values) override;
+        void writeFooter(QTextStream &out) override;
+
+    protected:
+        void prepare(toExportSettings &settings) override;
+
+    private:
+        class Deflater;
+
+        // zip archive member
+        struct Entry
+        {
+            QByteArray Name;
+            quint32 Crc;
+            quint64 CompressedSize;
+            quint64 Size;
+            quint64 Offset;
+        };
+
+        void beginEntry(QByteArray const &name);
+        void writeEntryData(QByteArray const &data);
+        void endEntry(void);
+        void writeEntry(QByteArray const &name, QByteArray const &data);
+        void flushChunk(void);
+        void writeChunk(void);
+        void writeBytes(QByteArray const &data);
+        void writeCentralDirectory(void);
+
+        void beginSheet(void);
+        void endSheet(void);
+        void appendCell(QByteArray &row, QVariant const &value, int column);
+        void appendString(QByteArray &row, QString const &text, bool header);
+
+        QIODevice *Device;
+        bool Binary;                // zip output (false for SpreadsheetML fallback)
+        bool Failed;                // write error or zip size limit
+        QScopedPointer<Deflater> Compressor;
+        QList<Entry> Entries;
+        Entry Current;              // entry being written
+        QByteArray Chunk;           // uncompressed data of Current not passed to Compressor yet
+        quint64 Offset;             // bytes written to Device
+        quint16 Time, Date;         // DOS time stamp of the entries
+
+        QVector<bool> Numeric;      // exported column has a numeric data type
+        int Sheets;
+        int SheetRows;
+
+        QHash<QString, int> SharedIndex;
+        QList<QByteArray> SharedStrings;    // escaped UTF-8 texts
+        quint64 SharedCount;                // number of shared string references
 };
@@ -0,0 +1,107 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/tolistviewformatterxmlspreadsheet.h"
+#include "core/tolistviewformatterfactory.h"
+#include "core/tolistviewformatteridentifier.h"
+
+#include <QtCore/QTextStream>
+#include <QtCore/QVector>
+
+#include <iostream>
+#include "tools/toresultview.h"
+
+namespace
+{
+    toListViewFormatter* createXMLSpreadsheet()
+    {
+        return new toListViewFormatterXMLSpreadsheet();
+    }
+    const bool registered = toListViewFormatterFactory::Instance().Register(toListViewFormatterIdentifier::XML_SPREADSHEET, createXMLSpreadsheet);
+}
+
+toListViewFormatterXMLSpreadsheet::toListViewFormatterXMLSpreadsheet() : toListViewFormatter()
+{
+}
+
+// Thx to ClipView tool
+static QString const DOC_START(
+    "<?xml version=\"1.0\" encoding=\"utf-8\"?>\r\n"
+    "<?mso-application progid=\"Excel.Sheet\"?>\r\n"
+    "<Workbook xmlns=\"urn:schemas-microsoft-com:office:spreadsheet\"\r\n"
+    " xmlns:o=\"urn:schemas-microsoft-com:office:office\"\r\n"
+    " xmlns:x=\"urn:schemas-microsoft-com:office:excel\"\r\n"
+    " xmlns:ss=\"urn:schemas-microsoft-com:office:spreadsheet\"\r\n"
+    " xmlns:html=\"http://www.w3.org/TR/REC-html40\">\r\n"
+    " <Worksheet ss:Name=\"Sheet1\">\r\n"
+    "  <Table ss:ExpandedColumnCount=\"%1\"%2>\r\n"
+);
+static QString const ROW_START("   <Row>\r\n");
+static QString const ROW_LINE_START("    <Cell><Data ss:Type=\"String\">");
+static QString const ROW_LINE_END("</Data></Cell>\r\n");
+static QString const ROW_END  ("   </Row>\r\n");
+static QString const DOC_END  (
+    "  </Table>\r\n"
+    " </Worksheet>\r\n"
+    "</Workbook>\r\n"
+);
+
+void toListViewFormatterXMLSpreadsheet::writeHeader(QTextStream &out)
+{
+    // row count is optional, it is not known when exporting a query directly
+    QString rowCount;
+    if (Rows >= 0)
+        rowCount = QString(" ss:ExpandedRowCount=\"%1\"").arg(Rows);
+    out << DOC_START.arg(Columns.size()).arg(rowCount);
+}
+
+void toListViewFormatterXMLSpreadsheet::writeRow(QTextStream &out, QVector<QVariant> const &values)
+{
+    out << ROW_START;
+    foreach(QVariant const &data, values)
+    {
+        out << ROW_LINE_START;
+        if (data.isNull())
+            out << "{null}";
+        else
+            out << TO_ESCAPE(data.toString());
+        out << ROW_LINE_END;
+    }
+    out << ROW_END;
+}
+
+void toListViewFormatterXMLSpreadsheet::writeFooter(QTextStream &out)
+{
+    out << DOC_END;
+}
@@ -132,42 +132,67 @@ toQValue toQueryAbstr::readValue(void)
     return m_Query->readValue();
 }
 
+unsigned toQueryAbstr::readBatch(toQueryBatch &batch, unsigned rows)
+{
+    if (connection().Abort)
+        throw qApp->translate("toQuery", "Query aborted");
+    if (!m_Query)
+        return 0;
+    return m_Query->readBatch(batch, rows);
+}
+
+qint64 toQueryAbstr::fetchNsecs(void)
+{
+    if (!m_Query)
+        return -1;
+    return m_Query->fetchNsecs();
+}
+
 toQColumnDescriptionList toQueryAbstr::describe(void)
 {
     return m_Query->describe();
 }
 
-void toQuery::init()
+void toQueryAbstr::initSession()
 {
-    try
+    // Try to switch the current db schema
+    if (m_ConnectionSubLoan.SchemaInitialized == false && !m_ConnectionSubLoan.Schema.isEmpty())
     {
-        // Try to switch the current db schema
-        if (m_ConnectionSubLoan.SchemaInitialized == false && !m_ConnectionSubLoan.Schema.isEmpty())
+        QString sql = m_ConnectionSubLoan.ParentConnection.getTraits().schemaSwitchSQL(m_ConnectionSubLoan.Schema);
+        if (!sql.isEmpty())
         {
-            QString sql = m_ConnectionSubLoan.ParentConnection.getTraits().schemaSwitchSQL(m_ConnectionSubLoan.Schema);
-            if (!sql.isEmpty())
-            {
-                m_Query = m_ConnectionSubLoan->createQuery(this);
-                m_ConnectionSubLoan->setQuery(this);
-                m_Query->execute(sql);
-                delete m_Query;
-            }
-            m_ConnectionSubLoan.SchemaInitialized = true;
-            m_ConnectionSubLoan->setSchema(m_ConnectionSubLoan.Schema); // assign value in toConnectionSub from toConnectionSubLoan
+            m_Query = m_ConnectionSubLoan->createQuery(this);
+            m_ConnectionSubLoan->setQuery(this);
+            m_Query->execute(sql);
+            delete m_Query;
+            m_Query = NULL;
         }
+        m_ConnectionSubLoan.SchemaInitialized = true;
+        m_ConnectionSubLoan->setSchema(m_ConnectionSubLoan.Schema); // assign value in toConnectionSub from toConnectionSubLoan
+    }
 
-        // Try to switch the current NLS_SETTINGS (not implemented yet)
-        if ( m_ConnectionSubLoan->isInitialized() == false)
+    // Run init strings unless this session already executed the current ones
+    int generation;
+    QList<QString> init = m_ConnectionSubLoan.ParentConnection.initStrings(generation);
+    if (m_ConnectionSubLoan->initGeneration() != generation)
+    {
+        Q_FOREACH(QString sql, init)
         {
-            Q_FOREACH(QString sql, m_ConnectionSubLoan.ParentConnection.initStrings())
-            {
-                m_Query = m_ConnectionSubLoan->createQuery(this);
-                m_ConnectionSubLoan->setQuery(this);
-                m_Query->execute(sql);
-                delete m_Query;
-            }
-            m_ConnectionSubLoan->setInitialized(true);
+            m_Query = m_ConnectionSubLoan->createQuery(this);
+            m_ConnectionSubLoan->setQuery(this);
+            m_Query->execute(sql);
+            delete m_Query;
+            m_Query = NULL;
         }
+        m_ConnectionSubLoan->setInitGeneration(generation);
+    }
+}
+
+void toQuery::init()
+{
+    try
+    {
+        initSession();
 
         m_Query = m_ConnectionSubLoan->createQuery(this);
         m_ConnectionSubLoan->setQuery(this);
@@ -183,6 +208,26 @@ void toQuery::init()
     }
 }
 
+void toQueryArray::init()
+{
+    try
+    {
+        initSession();
+
+        m_Query = m_ConnectionSubLoan->createQuery(this);
+        m_ConnectionSubLoan->setQuery(this);
+        m_Query->executeArray(m_Rows);
+    }
+    catch (...)
+    {
+        if (m_Query)
+            delete m_Query;
+        m_ConnectionSubLoan->setQuery(NULL);
+        m_Query = NULL;
+        throw;
+    }
+}
+
 toQList toQuery::readQuery(toConnection &conn, toSQL const& sql, toQueryParams const& params)
 {
     Utils::toBusy busy;
@@ -69,6 +69,23 @@ class toQueryAbstr : public QObject
         typedef QList<Row> RowList;
         typedef QList<HeaderDesc> HeaderList;
 
+        /** Array fetch hints passed to the provider. Zero means provider's default.
+         * Providers not supporting array fetch ignore them.
+         */
+        struct FetchOptions
+        {
+            FetchOptions()
+                : BulkRows(0)
+                , MemoryBudget(0)
+                , PrefetchRows(0)
+                , PrefetchMemory(0)
+            {}
+            unsigned BulkRows;       /* rows fetched by one round trip */
+            unsigned MemoryBudget;   /* if BulkRows is 0, size the array from column widths to fit into (bytes) */
+            unsigned PrefetchRows;   /* rows prefetched by client library */
+            unsigned PrefetchMemory; /* bytes prefetched by client library */
+        };
+
         /** Create a normal query.
          * @param conn Connection to create query on.
          * @param sql SQL to run.
@@ -124,6 +141,14 @@ class toQueryAbstr : public QObject
          */
         toQValue readValue(void);
 
+        /** Read up to rows rows into batch.
+         * @return Number of rows read.
+         */
+        unsigned readBatch(toQueryBatch &batch, unsigned rows);
+
+        /** Nanoseconds spent in fetch round trips so far, -1 if not known (see queryImpl::fetchNsecs) */
+        qint64 fetchNsecs(void);
+
         /** Check if end of query is reached.
          * @return True if end of query is reached.
          */
@@ -141,6 +166,17 @@ class toQueryAbstr : public QObject
         /** Get a list of descriptions for the columns. This function is relatively slow. */
         toQColumnDescriptionList describe(void);
 
+        /** Array fetch hints, must be set before the query is executed */
+        inline void setFetchOptions(FetchOptions const& options)
+        {
+            m_FetchOptions = options;
+        }
+
+        inline FetchOptions const& fetchOptions(void) const
+        {
+            return m_FetchOptions;
+        }
+
         /** Get the number of columns in the resultset of the query.*/
         inline unsigned columns(void) const
         {
@@ -155,12 +191,16 @@ class toQueryAbstr : public QObject
 
         virtual void init() = 0;
 
+        /** Switch the schema and run the connection init strings before the first query */
+        void initSession(void);
+
         toConnectionSubLoan& m_ConnectionSubLoan;
         toQueryParams m_Params;
         QString m_SQL;
         QString m_SQLName;
         bool m_eof;
         unsigned long m_rowsProcessed;
+        FetchOptions m_FetchOptions;
 
         queryImpl *m_Query;
         toQueryAbstr(const toQuery &);
@@ -210,5 +250,29 @@ private:
     void *operator new[](size_t);
 };
 
+/** Executes one DML statement for a batch of bind variable rows by array binding.
+ *  Only for connections having @ref toConnectionTraits::hasArrayDML.
+ *  Runs synchronously in foreground thread, rowsProcessed() is the total for all the rows.
+ */
+class toQueryArray : public toQueryAbstr
+{
+public:
+	toQueryArray(toConnectionSubLoan &conn, QString const& sql, QList<toQueryParams> const& rows)
+		: toQueryAbstr(conn, sql, toQueryParams())
+		, m_Rows(rows)
+	{
+		init();
+	}
+
+protected:
+	void init() override;
+private:
+	QList<toQueryParams> m_Rows;
+
+	// see toQuery
+	void *operator new(size_t);
+	void *operator new[](size_t);
+};
+
 #endif
 
@@ -0,0 +1,393 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/toquerybatch.h"
+#include "core/utils.h"
+
+// integers up to 2^53 are stored in double without loss
+static inline bool exactDouble(qint64 value)
+{
+    return value >= -(Q_INT64_C(1) << 53) && value <= (Q_INT64_C(1) << 53);
+}
+
+toQueryBatch::Column::Column()
+    : Type(NullColumn)
+    , LongInts(false)
+    , Size(0)
+{}
+
+toQueryBatch::toQueryBatch(unsigned columns)
+    : Columns(columns)
+    , Rows(0)
+    , Current(0)
+{}
+
+size_t toQueryBatch::byteSize() const
+{
+    size_t retval = 0;
+    for (std::vector<Column>::const_iterator c = Columns.begin(); c != Columns.end(); ++c)
+    {
+        retval += c->Ints.size() * sizeof(qint64);
+        retval += c->Doubles.size() * sizeof(double);
+        retval += c->Chars.size() * sizeof(QChar);
+        retval += c->Offsets.size() * sizeof(int);
+        retval += c->Variants.size() * sizeof(toQValue);
+        retval += c->Nulls.size() * sizeof(quint32);
+    }
+    return retval;
+}
+
+void toQueryBatch::append(toQValue const &value)
+{
+    Q_ASSERT_X(!Columns.empty(), qPrintable(__QHERE__), "toQueryBatch has no columns");
+    Column &c = Columns[Current];
+    if (value.isNull())
+        pushNull(c);
+    else
+        pushValue(c, value);
+    nextCell();
+}
+
+void toQueryBatch::appendNull()
+{
+    Q_ASSERT_X(!Columns.empty(), qPrintable(__QHERE__), "toQueryBatch has no columns");
+    pushNull(Columns[Current]);
+    nextCell();
+}
+
+void toQueryBatch::appendInt(qint64 value, bool longInt)
+{
+    Column &c = Columns[Current];
+    if (c.Type == IntColumn)
+    {
+        c.Ints.append(value);
+        c.LongInts |= longInt;
+    }
+    else if (c.Type == DoubleColumn && exactDouble(value))
+    {
+        c.Doubles.append((double) value);
+    }
+    else
+    {
+        pushValue(c, longInt ? toQValue((qlonglong) value) : toQValue((int) value));
+        nextCell();
+        return;
+    }
+    pushed(c);
+    nextCell();
+}
+
+void toQueryBatch::appendDouble(double value)
+{
+    Column &c = Columns[Current];
+    if (c.Type != DoubleColumn)
+    {
+        pushValue(c, toQValue(value));
+        nextCell();
+        return;
+    }
+    c.Doubles.append(value);
+    pushed(c);
+    nextCell();
+}
+
+void toQueryBatch::appendUtf8(char const *data, int len)
+{
+    Column &c = Columns[Current];
+    if (c.Type != StringColumn)
+    {
+        pushValue(c, toQValue(QString::fromUtf8(data, len)));
+        nextCell();
+        return;
+    }
+    c.Chars.append(QString::fromUtf8(data, len));
+    c.Offsets.append(c.Chars.size());
+    pushed(c);
+    nextCell();
+}
+
+void toQueryBatch::nextCell()
+{
+    if (++Current == Columns.size())
+    {
+        Current = 0;
+        Rows++;
+    }
+}
+
+toQueryBatch::ColumnType toQueryBatch::columnType(unsigned col) const
+{
+    return Columns.at(col).Type;
+}
+
+bool toQueryBatch::longInts(unsigned col) const
+{
+    return Columns.at(col).LongInts;
+}
+
+bool toQueryBatch::isNull(unsigned row, unsigned col) const
+{
+    Column const &c = Columns.at(col);
+    return c.Nulls.at(row / 32) & (1u << (row % 32));
+}
+
+qint64 toQueryBatch::intAt(unsigned row, unsigned col) const
+{
+    Q_ASSERT_X(Columns.at(col).Type == IntColumn, qPrintable(__QHERE__), "Not an IntColumn");
+    return Columns.at(col).Ints.at(row);
+}
+
+double toQueryBatch::doubleAt(unsigned row, unsigned col) const
+{
+    Q_ASSERT_X(Columns.at(col).Type == DoubleColumn, qPrintable(__QHERE__), "Not a DoubleColumn");
+    return Columns.at(col).Doubles.at(row);
+}
+
+QStringRef toQueryBatch::stringAt(unsigned row, unsigned col) const
+{
+    Q_ASSERT_X(Columns.at(col).Type == StringColumn, qPrintable(__QHERE__), "Not a StringColumn");
+    Column const &c = Columns.at(col);
+    return QStringRef(&c.Chars, c.Offsets.at(row), c.Offsets.at(row + 1) - c.Offsets.at(row));
+}
+
+toQValue toQueryBatch::value(unsigned row, unsigned col)
+{
+    return boxed(Columns[col], row);
+}
+
+toQueryBatchPtr toQueryBatch::extract(unsigned first, unsigned count)
+{
+    Q_ASSERT_X(first + count <= Rows, qPrintable(__QHERE__), "Rows out of range");
+    toQueryBatchPtr retval(new toQueryBatch(Columns.size()));
+    retval->Rows = count;
+
+    for (unsigned col = 0; col < Columns.size(); col++)
+    {
+        Column &src = Columns[col];
+        Column &dst = retval->Columns[col];
+        dst.Type = src.Type;
+        dst.LongInts = src.LongInts;
+        dst.Size = count;
+        switch (src.Type)
+        {
+            case NullColumn:
+                break;
+            case IntColumn:
+                dst.Ints = src.Ints.mid(first, count);
+                break;
+            case DoubleColumn:
+                dst.Doubles = src.Doubles.mid(first, count);
+                break;
+            case StringColumn:
+                {
+                    int base = src.Offsets.at(first);
+                    dst.Chars = src.Chars.mid(base, src.Offsets.at(first + count) - base);
+                    dst.Offsets.reserve(count + 1);
+                    for (unsigned row = first; row <= first + count; row++)
+                        dst.Offsets.append(src.Offsets.at(row) - base);
+                }
+                break;
+            case VariantColumn:
+                dst.Variants.reserve(count);
+                for (unsigned row = first; row < first + count; row++)
+                    dst.Variants.push_back(src.Variants[row]); // moves complex types
+                break;
+        }
+        dst.Nulls.fill(0, (count + 31) / 32);
+        for (unsigned row = 0; row < count; row++)
+            if (isNull(first + row, col))
+                dst.Nulls[row / 32] |= 1u << (row % 32);
+    }
+    return retval;
+}
+
+toQueryBatch::ColumnType toQueryBatch::typeOf(toQValue const &value)
+{
+    if (value.isNull())
+        return NullColumn;
+    if (value.isInt() || value.isLong())
+        return IntColumn;
+    if (value.isDouble())
+        return DoubleColumn;
+    if (value.isString())
+        return StringColumn;
+    return VariantColumn;
+}
+
+void toQueryBatch::pushNull(Column &c)
+{
+    switch (c.Type)
+    {
+        case NullColumn:
+            break; // arrays are filled in once the first value is known
+        case IntColumn:
+            c.Ints.append(0);
+            break;
+        case DoubleColumn:
+            c.Doubles.append(0);
+            break;
+        case StringColumn:
+            c.Offsets.append(c.Chars.size());
+            break;
+        case VariantColumn:
+            c.Variants.push_back(toQValue());
+            break;
+    }
+    if (c.Size % 32 == 0)
+        c.Nulls.append(0);
+    setNull(c, c.Size);
+    c.Size++;
+}
+
+void toQueryBatch::setNull(Column &c, unsigned row)
+{
+    c.Nulls[row / 32] |= 1u << (row % 32);
+}
+
+void toQueryBatch::pushValue(Column &c, toQValue const &value)
+{
+    ColumnType type = typeOf(value);
+    if (c.Type == NullColumn)
+    {
+        // Column contained NULLs only so far
+        c.Type = type;
+        switch (type)
+        {
+            case IntColumn:
+                c.Ints.fill(0, c.Size);
+                break;
+            case DoubleColumn:
+                c.Doubles.fill(0, c.Size);
+                break;
+            case StringColumn:
+                c.Offsets.fill(0, c.Size + 1);
+                break;
+            case VariantColumn:
+                c.Variants.resize(c.Size);
+                break;
+            case NullColumn:
+                break;
+        }
+    }
+    else if (c.Type != type && c.Type != VariantColumn && !toDouble(c, value))
+    {
+        toVariant(c);
+    }
+
+    switch (c.Type)
+    {
+        case IntColumn:
+            c.Ints.append(value.toLong());
+            c.LongInts |= value.isLong();
+            break;
+        case DoubleColumn:
+            c.Doubles.append(value.toDouble());
+            break;
+        case StringColumn:
+            c.Chars.append(value.toQVariant().toString());
+            c.Offsets.append(c.Chars.size());
+            break;
+        case VariantColumn:
+            c.Variants.push_back(value);
+            break;
+        case NullColumn:
+            Q_ASSERT_X(false, qPrintable(__QHERE__), "Invalid column type");
+            break;
+    }
+    pushed(c);
+}
+
+void toQueryBatch::pushed(Column &c)
+{
+    if (c.Size % 32 == 0)
+        c.Nulls.append(0);
+    c.Size++;
+}
+
+toQValue toQueryBatch::boxed(Column &c, unsigned row)
+{
+    if (c.Nulls.at(row / 32) & (1u << (row % 32)))
+        return toQValue();
+
+    switch (c.Type)
+    {
+        case IntColumn:
+            if (c.LongInts)
+                return toQValue((qlonglong) c.Ints.at(row));
+            return toQValue((int) c.Ints.at(row));
+        case DoubleColumn:
+            return toQValue(c.Doubles.at(row));
+        case StringColumn:
+            return toQValue(c.Chars.mid(c.Offsets.at(row), c.Offsets.at(row + 1) - c.Offsets.at(row)));
+        case VariantColumn:
+            return c.Variants[row];
+        case NullColumn:
+            break;
+    }
+    return toQValue();
+}
+
+bool toQueryBatch::toDouble(Column &c, toQValue const &value)
+{
+    if (c.Type == DoubleColumn)
+        return (value.isInt() || value.isLong()) && exactDouble(value.toLong());
+    if (c.Type != IntColumn || !value.isDouble())
+        return false;
+
+    for (unsigned row = 0; row < c.Size; row++)
+        if (!exactDouble(c.Ints.at(row)))
+            return false;
+    c.Doubles.reserve(c.Size + 1);
+    for (unsigned row = 0; row < c.Size; row++)
+        c.Doubles.append((double) c.Ints.at(row));
+    c.Ints.clear();
+    c.LongInts = false;
+    c.Type = DoubleColumn;
+    return true;
+}
+
+void toQueryBatch::toVariant(Column &c)
+{
+    std::vector<toQValue> variants;
+    variants.reserve(c.Size);
+    for (unsigned row = 0; row < c.Size; row++)
+        variants.push_back(boxed(c, row));
+
+    c.Ints.clear();
+    c.Doubles.clear();
+    c.Chars.clear();
+    c.Offsets.clear();
+    c.Variants.swap(variants);
+    c.Type = VariantColumn;
+}
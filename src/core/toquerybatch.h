@@ -0,0 +1,156 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TOQUERYBATCH_H
+#define TOQUERYBATCH_H
+
+#include "core/tora_export.h"
+#include "core/toqvalue.h"
+
+#include <QtCore/QString>
+#include <QtCore/QStringRef>
+#include <QtCore/QVector>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QMetaType>
+
+#include <vector>
+
+/**
+ * Chunk of rows read by @ref toEventQueryWorker, stored column by column.
+ *
+ * Each column holds one contiguous array of values (int64, double or string offsets
+ * into a single character arena) plus a null bitmap. The column type is chosen by the
+ * first non-null value appended. A column mixing integers and doubles (NUMBER) is kept
+ * as DoubleColumn while the integers are exact in double. Values which do not fit
+ * (binary data, LOBs and other complex types, or other mixed types) turn the column
+ * into a VariantColumn.
+ *
+ * Batches are passed between threads by @ref toQueryBatchPtr, cells are boxed into toQValue
+ * only when requested by value().
+ */
+class TORA_EXPORT toQueryBatch
+{
+    public:
+        enum ColumnType
+        {
+            NullColumn,     // no non-null value appended yet
+            IntColumn,
+            DoubleColumn,
+            StringColumn,
+            VariantColumn
+        };
+
+        explicit toQueryBatch(unsigned columns);
+
+        inline unsigned columns(void) const
+        {
+            return Columns.size();
+        }
+
+        /** Number of complete rows */
+        inline unsigned rows(void) const
+        {
+            return Rows;
+        }
+
+        /** Approximate size of the data held in the column arrays */
+        size_t byteSize(void) const;
+
+        /** Append the next cell, cells are appended row by row */
+        void append(toQValue const &value);
+
+        /** Typed variants of append(), used by providers reading straight from their fetch buffers.
+         * They append without boxing as long as the column already has the matching type.
+         */
+        void appendNull();
+        void appendInt(qint64 value, bool longInt);
+        void appendDouble(double value);
+        void appendUtf8(char const *data, int len);
+
+        ColumnType columnType(unsigned col) const;
+
+        /** True if the values of IntColumn were read as qlonglong */
+        bool longInts(unsigned col) const;
+
+        bool isNull(unsigned row, unsigned col) const;
+
+        /** Typed accessors, valid only for the columns of the matching type */
+        qint64 intAt(unsigned row, unsigned col) const;
+        double doubleAt(unsigned row, unsigned col) const;
+        QStringRef stringAt(unsigned row, unsigned col) const;
+
+        /** Box the cell into toQValue.
+         * Observe that complex types (LOBs, ...) are moved out of the batch
+         * like @ref toQValue's copy constructor does.
+         */
+        toQValue value(unsigned row, unsigned col);
+
+        /** Create a new batch from rows [first, first + count). Complex types are moved. */
+        QSharedPointer<toQueryBatch> extract(unsigned first, unsigned count);
+
+    private:
+        struct Column
+        {
+            Column();
+
+            ColumnType Type;
+            bool LongInts;                  // box IntColumn values as qlonglong (as they were read)
+            QVector<qint64> Ints;
+            QVector<double> Doubles;
+            QString Chars;                  // string arena
+            QVector<int> Offsets;           // Offsets[row] .. Offsets[row+1]
+            std::vector<toQValue> Variants;
+            QVector<quint32> Nulls;         // bit set for NULL cells
+            unsigned Size;                  // number of cells in this column
+        };
+
+        static ColumnType typeOf(toQValue const &value);
+        static void pushNull(Column &c);
+        static void setNull(Column &c, unsigned row);
+        static void pushValue(Column &c, toQValue const &value);
+        static toQValue boxed(Column &c, unsigned row);
+        static void pushed(Column &c);
+        void nextCell();
+        static bool toDouble(Column &c, toQValue const &value);
+        static void toVariant(Column &c);
+
+        std::vector<Column> Columns;
+        unsigned Rows;
+        unsigned Current;   // column of the next appended cell
+};
+
+typedef QSharedPointer<toQueryBatch> toQueryBatchPtr;
+Q_DECLARE_METATYPE(toQueryBatchPtr);
+
+#endif
@@ -0,0 +1,328 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/toqueryexport.h"
+#include "core/toeventquery.h"
+#include "core/togzipdevice.h"
+#include "core/tolistviewformatterfactory.h"
+#include "core/tologger.h"
+#include "core/utils.h"
+
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QTextStream>
+#include <QtCore/QThread>
+
+#include <climits>
+
+class toQueryExport::Writer : public QThread
+{
+    public:
+        Writer(toQueryExport *owner)
+            : Owner(owner)
+        {}
+
+        virtual void run()
+        {
+            toQueryExport &o = *Owner;
+            QIODevice *device = o.Compressed ? static_cast<QIODevice*>(o.Compressed.data()) : &o.File;
+            QTextStream out(device);
+            out.setCodec(Utils::toGetCodec());
+
+            int columns = o.Formatter->exportColumns().size();
+            QVector<QVariant> values(columns);
+            bool done = false;
+
+            o.Formatter->writeHeader(out);
+            while (!done)
+            {
+                toQueryBatchPtr batch;
+                {
+                    QMutexLocker lock(&o.Lock);
+                    while (o.Batches.isEmpty() && !o.End && !int(o.Cancelled))
+                        o.NotEmpty.wait(&o.Lock);
+                    if (int(o.Cancelled))
+                        return;
+                    if (!o.Batches.isEmpty())
+                        batch = o.Batches.dequeue();
+                    else
+                        done = true;
+                }
+                if (!batch)
+                    continue;
+
+                int rows = batch->rows();
+                for (int r = 0; r < rows; r++)
+                {
+                    for (int c = 0; c < columns; c++)
+                    {
+                        // same as toResultModel::data(Qt::EditRole)
+                        toQValue data(batch->value(r, c));
+                        if (data.isComplexType())
+                        {
+                            toQValue::complexType *i = data.toQVariant().value<toQValue::complexType*>();
+                            values[c] = QVariant(i->editData());
+                        }
+                        else
+                            values[c] = QVariant(data.editData());
+                    }
+                    o.Formatter->writeRow(out, values);
+                }
+                QMetaObject::invokeMethod(Owner, "slotWritten", Qt::QueuedConnection, Q_ARG(int, rows));
+            }
+            o.Formatter->writeFooter(out);
+            out.flush();
+
+            QString error;
+            if (out.status() != QTextStream::Ok)
+                error = device->errorString();
+            if (o.Compressed)
+            {
+                o.Compressed->close();
+                if (error.isEmpty() && o.File.error() != QFile::NoError)
+                    error = o.File.errorString();
+            }
+            QMetaObject::invokeMethod(Owner, "slotWriterDone", Qt::QueuedConnection, Q_ARG(QString, error));
+        }
+
+    private:
+        toQueryExport *Owner;
+};
+
+toQueryExport::toQueryExport(toConnection &conn,
+                             QString const &sql,
+                             toQueryParams const &params,
+                             toExportSettings const &settings,
+                             QString const &fileName,
+                             bool gzip,
+                             QObject *parent)
+    : QObject(parent)
+    , Connection(conn)
+    , Sql(sql)
+    , Params(params)
+    , Settings(settings)
+    , FileName(fileName)
+    , Gzip(gzip)
+    , Written(0)
+    , Running(false)
+    , FetchDone(false)
+    , End(false)
+{
+}
+
+toQueryExport::~toQueryExport()
+{
+    // Query is deleted as a child object, it stops the fetch
+    stopWriter();
+    if (Running)
+    {
+        Compressed.reset();
+        File.remove();
+    }
+}
+
+void toQueryExport::start()
+{
+    if (Running)
+        throw tr("Export of %1 is already running").arg(FileName);
+
+    Formatter.reset(toListViewFormatterFactory::Instance().CreateObject(Settings.type));
+    if (Formatter->needsMeasure())
+        throw tr("This format needs all the rows to be read first, it can not be exported directly from the query");
+    Formatter->setLineEnd(Utils::toLineEnd());
+
+    File.setFileName(FileName);
+    if (!File.open(QIODevice::WriteOnly))
+        throw tr("Couldn't open %1 for writing").arg(FileName);
+    if (Gzip)
+    {
+        Compressed.reset(new toGzipDevice(&File));
+        if (!Compressed->open(QIODevice::WriteOnly))
+        {
+            QString error = Compressed->errorString();
+            Compressed.reset();
+            File.remove();
+            throw error;
+        }
+    }
+
+    Written = 0;
+    FetchDone = false;
+    End = false;
+    Error.clear();
+    Cancelled.fetchAndStoreAcquire(0);
+    Running = true;
+
+    // fetch big arrays, the rows are not displayed
+    toQueryAbstr::FetchOptions options;
+    options.BulkRows = FETCH_ROWS;
+    options.PrefetchRows = FETCH_ROWS;
+
+    // READ_FIRST: the next array is fetched when takeBatches has taken the previous one,
+    // so at most one fetch runs while the writer works on QUEUED_BATCHES
+    Query = new toEventQuery(this, Connection, Sql, Params, toEventQuery::READ_FIRST);
+    Query->setFetchOptions(options);
+    connect(Query, SIGNAL(descriptionAvailable(toEventQuery*)),
+            this, SLOT(slotDescription(toEventQuery*)));
+    connect(Query, SIGNAL(dataAvailable(toEventQuery*)),
+            this, SLOT(slotData(toEventQuery*)));
+    connect(Query, SIGNAL(error(toEventQuery*, const toConnection::exception &)),
+            this, SLOT(slotError(toEventQuery*, const toConnection::exception &)));
+    connect(Query, SIGNAL(done(toEventQuery*, unsigned long)),
+            this, SLOT(slotDone(toEventQuery*, unsigned long)));
+    try
+    {
+        Query->start();
+    }
+    catch (...)
+    {
+        delete Query;
+        Compressed.reset();
+        File.remove();
+        Running = false;
+        throw;
+    }
+}
+
+void toQueryExport::cancel()
+{
+    if (!Running)
+        return;
+    if (Query)
+        Query->stop();
+    stopWriter();
+    Compressed.reset();
+    File.remove();
+    Running = false;
+    emit finished(false);
+}
+
+void toQueryExport::stopWriter()
+{
+    {
+        QMutexLocker lock(&Lock);
+        Cancelled.fetchAndStoreAcquire(1);
+        Batches.clear();
+        NotEmpty.wakeAll();
+    }
+    if (WriterThread)
+        WriterThread->wait();
+}
+
+void toQueryExport::fail(QString const &error)
+{
+    Error = error;
+    TLOG(1, toDecorator, __HERE__) << "Query export failed: " << error << std::endl;
+    cancel();
+}
+
+void toQueryExport::slotDescription(toEventQuery *query)
+{
+    if (!Running)
+        return;
+    Formatter->startExport(Settings, query->describe(), -1);
+    WriterThread.reset(new Writer(this));
+    WriterThread->start();
+    takeBatches();
+}
+
+void toQueryExport::slotData(toEventQuery *)
+{
+    takeBatches();
+}
+
+void toQueryExport::takeBatches()
+{
+    // rows are taken only when the writer is ready, the query waits meanwhile
+    if (!Running || !WriterThread || !Query)
+        return;
+
+    try
+    {
+        QMutexLocker lock(&Lock);
+        while (Batches.size() < QUEUED_BATCHES && Query->hasMore())
+            Batches.enqueue(Query->takeBatch(UINT_MAX));
+        if (FetchDone && !Query->hasMore())
+            End = true;
+        NotEmpty.wakeAll();
+    }
+    catch (QString const &str)
+    {
+        fail(str);
+    }
+}
+
+void toQueryExport::slotError(toEventQuery *, const toConnection::exception &msg)
+{
+    if (Running)
+        fail(msg);
+}
+
+void toQueryExport::slotDone(toEventQuery *, unsigned long)
+{
+    FetchDone = true;
+    if (Running && !WriterThread)
+    {
+        // statement without any columns
+        fail(tr("The statement did not return any rows"));
+        return;
+    }
+    takeBatches();
+}
+
+void toQueryExport::slotWritten(int rows)
+{
+    if (!Running)
+        return;
+    Written += rows;
+    emit progress(Written);
+    takeBatches();
+}
+
+void toQueryExport::slotWriterDone(QString error)
+{
+    if (!Running)
+        return;
+    WriterThread->wait();
+    Compressed.reset();
+    File.close();
+    if (!error.isEmpty())
+    {
+        fail(error);
+        return;
+    }
+    Running = false;
+    Utils::toStatusMessage(tr("%1 rows exported into %2").arg(Written).arg(FileName), false, false);
+    emit finished(true);
+}
@@ -0,0 +1,166 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TOQUERYEXPORT_H
+#define TOQUERYEXPORT_H
+
+#include "core/toconnection.h"
+#include "core/toquery.h"
+#include "core/toquerybatch.h"
+#include "core/tolistviewformatter.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QFile>
+#include <QtCore/QMutex>
+#include <QtCore/QPointer>
+#include <QtCore/QQueue>
+#include <QtCore/QScopedPointer>
+#include <QtCore/QWaitCondition>
+
+class toEventQuery;
+class toGzipDevice;
+
+/**
+ * Export the result of a query directly into a file, no model or view is created.
+ *
+ * Rows are fetched by @ref toEventQuery in large arrays (FETCH_ROWS), batches of rows
+ * are passed through a bounded queue (QUEUED_BATCHES) to a writer thread which formats
+ * them (@ref toListViewFormatter chosen by toExportSettings::type) and writes them into
+ * the file, optionally gzip compressed. The query is not asked for more rows while
+ * the queue is full, so memory use does not depend on the size of the result.
+ *
+ * The file is closed as soon as the last row is written, then finished() is emitted.
+ */
+class toQueryExport : public QObject
+{
+        Q_OBJECT;
+
+    public:
+        /** Rows fetched by one round trip */
+        static const unsigned FETCH_ROWS = 5000;
+
+        /** Batches waiting for the writer thread */
+        static const int QUEUED_BATCHES = 8;
+
+        toQueryExport(toConnection &conn,
+                      QString const &sql,
+                      toQueryParams const &params,
+                      toExportSettings const &settings,
+                      QString const &fileName,
+                      bool gzip,
+                      QObject *parent = 0);
+
+        /** Cancels the export and waits for the writer thread */
+        virtual ~toQueryExport();
+
+        /** Open the file and start the query, throws QString on error */
+        void start(void);
+
+        bool running(void) const
+        {
+            return Running;
+        }
+
+        /** Rows written so far */
+        qulonglong rows(void) const
+        {
+            return Written;
+        }
+
+        QString const& fileName(void) const
+        {
+            return FileName;
+        }
+
+        /** Error of the export, empty when successful or cancelled */
+        QString const& errorString(void) const
+        {
+            return Error;
+        }
+
+    public slots:
+        /** Stop the query and the writer, the incomplete file is removed */
+        void cancel(void);
+
+    signals:
+        /** Rows written so far */
+        void progress(qulonglong rows);
+
+        /** Emitted when the file is complete (ok) or the export failed or was cancelled */
+        void finished(bool ok);
+
+    private slots:
+        void slotDescription(toEventQuery*);
+        void slotData(toEventQuery*);
+        void slotError(toEventQuery*, const toConnection::exception &);
+        void slotDone(toEventQuery*, unsigned long);
+        void slotWritten(int rows);
+        void slotWriterDone(QString error);
+
+    private:
+        class Writer;
+        friend class Writer;
+
+        void takeBatches(void);
+        void stopWriter(void);
+        void fail(QString const &error);
+
+        toConnection &Connection;
+        QString Sql;
+        toQueryParams Params;
+        toExportSettings Settings;
+        QString FileName;
+        bool Gzip;
+
+        QPointer<toEventQuery> Query;
+        QScopedPointer<toListViewFormatter> Formatter;
+        QFile File;
+        QScopedPointer<toGzipDevice> Compressed;
+        QScopedPointer<Writer> WriterThread;
+
+        qulonglong Written;
+        bool Running;
+        bool FetchDone;     // the query has delivered all the rows
+        QString Error;
+
+        // queue shared with the writer thread
+        QMutex Lock;
+        QWaitCondition NotEmpty;
+        QQueue<toQueryBatchPtr> Batches;
+        bool End;
+        QAtomicInt Cancelled;
+};
+
+#endif
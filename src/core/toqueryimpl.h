@@ -37,6 +37,7 @@
 #include "core/tora_export.h"
 #include "core/tocache.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
 
 #include <QtCore/QObject>
 
@@ -80,10 +81,38 @@ class TORA_EXPORT queryImpl : public QObject
          */
         virtual void execute(QString const&) = 0;
 
+        /** Execute a DML statement once for each of rows (array binding), each row holds
+         * values of all the bind variables. Only called when @ref toConnectionTraits::hasArrayDML
+         */
+        virtual void executeArray(QList<toQueryParams> const&)
+        {
+            throw QString::fromLatin1("Array DML is not supported by this connection provider");
+        }
+
         /** Read the next value from the stream.
          * @return The value read from the query.
          */
         virtual toQValue readValue(void) = 0;
+        /** Read up to rows rows into batch.
+         * Default implementation boxes every cell through readValue, providers can append
+         * values directly from their fetch buffers.
+         * @return Number of rows read.
+         */
+        virtual unsigned readBatch(toQueryBatch &batch, unsigned rows)
+        {
+            unsigned row = 0;
+            for (; row < rows && !eof(); row++)
+                for (unsigned i = 0; i < batch.columns() && !eof(); i++)
+                    batch.append(readValue());
+            return row;
+        }
+        /** Time spent in fetch round trips to the server since the query was executed.
+         * @return Nanoseconds, -1 if the provider does not measure it.
+         */
+        virtual qint64 fetchNsecs(void)
+        {
+            return -1;
+        }
         /** Check if the end of the query has been reached.
          * @return True if all values have been read.
          */
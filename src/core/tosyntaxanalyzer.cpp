@@ -86,3 +86,8 @@ QColor toSyntaxAnalyzer::getColor(toSyntaxAnalyzer::WordClassEnum type) const
 toSyntaxAnalyzer::~toSyntaxAnalyzer()
 {
 }
+
+toSyntaxAnalyzer::statementList toSyntaxAnalyzer::getStatements(QString const& text, bool)
+{
+    return getStatements(text);
+}
@@ -167,6 +167,13 @@ class toSyntaxAnalyzer : public QObject
          */
         virtual statementList getStatements(QString const& text) = 0;
 
+        /** Split a part of the text, used by toSqlText to re-split only the statements touched by an edit.
+         * Statements are returned as long as they can not be affected by the text behind the part,
+         * posFrom of each statement is set to the index of its first character within its line.
+         * @param complete the part reaches the end of the text
+         */
+        virtual statementList getStatements(QString const& text, bool complete);
+
         virtual statement getStatementAt(unsigned line, unsigned linePos) = 0;
 
         virtual QsciLexer* createLexer(QObject *parent = 0) = 0;
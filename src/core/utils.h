@@ -73,6 +73,7 @@ typedef Qt::WFlags toWFlags;
 #endif
 
 class QComboBox;
+class QTextCodec;
 class toConnection;
 class toConnectionRegistry;
 
@@ -312,6 +313,18 @@ namespace Utils
     */
     bool toWriteFile(const QString &filename, const QString &data);
 
+    /** Get the encoding used to read/write files (see ToConfiguration::Main::Encoding).
+    */
+    QTextCodec* toGetCodec(void);
+
+    /** Replace $HOME in file name by the home directory. */
+    QString toExpandFile(const QString &file);
+
+    /** Line end configured for saved files (see ToConfiguration::Main::LineEnd),
+     * returns the platform line end when no particular one is set.
+     */
+    QString toLineEnd(void);
+
     /** Convert a font to a string representation.
      * @param fnt Font to convert.
      * @return String representation of font.
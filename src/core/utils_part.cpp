@@ -169,6 +169,22 @@ namespace Utils
             return QTextCodec::codecForName(codecConf.toLatin1());
     } // toGetCodec
 
+    QString toLineEnd(void)
+    {
+        QString lineEndSetting = toConfigurationNewSingle::Instance().option(ToConfiguration::Main::LineEnd).toString();
+        if (lineEndSetting == "Linux")
+            return QString::fromLatin1("\n");
+        else if (lineEndSetting == "Windows")
+            return QString::fromLatin1("\r\n");
+        else if (lineEndSetting == "Mac")
+            return QString::fromLatin1("\r");
+#ifdef Q_OS_WIN32
+        return QString::fromLatin1("\r\n");
+#else
+        return QString::fromLatin1("\n");
+#endif
+    } // toLineEnd
+
     QString toExpandFile(const QString &file)
     {
         QString ret(file);
@@ -54,11 +54,14 @@
 #include <QToolTip>
 #endif
 
+#include <QtCore/QSet>
 #include <QMenu>
 #include <QListWidget>
 #include <QVBoxLayout>
 #include <QApplication>
 
+#include <algorithm>
+
 #include <Qsci/qsciapis.h>
 #include <Qsci/qsciabstractapis.h>
 
@@ -76,6 +79,15 @@ toSqlText::toSqlText(QWidget *parent, const char *name)
     , m_parserTimer(new QTimer(this))
     , m_parserThread(new QThread(this))
     , m_haveFocus(true)
+    , m_dirtyFrom(-1)
+    , m_dirtyTo(-1)
+    , m_splitFrom(0)
+    , m_splitTo(0)
+    , m_splitExtend(1)
+    , m_splitComplete(false)
+    , m_splitting(false)
+    , m_generation(0)
+    , m_splitGeneration(0)
     , m_wrap(new QAction("Wrap", this))
     , m_indent(new QAction(QPixmap(const_cast<const char**>(indent_xpm)), "Indent", this))
 {
@@ -94,17 +106,19 @@ toSqlText::toSqlText(QWidget *parent, const char *name)
     QsciScintilla::setMarginType(2, TextMarginRightJustified);
     QsciScintilla::setMarginWidth(2, QString("009"));
 
-    m_parserTimer->setInterval(5000);   // every 5s
-    m_parserTimer->setSingleShot(true); // repeat only if bg thread responded
+    m_parserTimer->setInterval(500);    // split statements once typing pauses
+    m_parserTimer->setSingleShot(true); // started by edits only, idle editor does not parse
     m_parserThread->setObjectName("ParserThread");
     m_worker = new toSqlTextWorker(NULL);
     m_worker->moveToThread(m_parserThread);
     connect(m_parserTimer, SIGNAL(timeout()), this, SLOT(process()));
-    connect(this, SIGNAL(parsingRequested(QString)),  m_worker, SLOT(process(QString)));
+    connect(this, SIGNAL(parsingRequested(QString, bool)),  m_worker, SLOT(process(QString, bool)));
     connect(m_worker, SIGNAL(processed()), this, SLOT(processed()));
     connect(m_worker, SIGNAL(finished()),  m_parserThread, SLOT(quit()));
     connect(m_worker, SIGNAL(finished()),  m_worker, SLOT(deleteLater()));
     connect(m_parserThread, SIGNAL(finished()),  m_parserThread, SLOT(deleteLater()));
+    connect(this, SIGNAL(SCN_MODIFIED(int, int, const char *, int, int, int, int, int, int, int)),
+            this, SLOT(textModified(int, int, const char *, int, int)));
 
     // Connect signals&slots
     connect(&toHighlighterTypeButtonSingle::Instance(),
@@ -281,6 +295,13 @@ void toSqlText::setHighlighter(HighlighterTypeEnum h)
 	}
 #endif
 
+    // New analyzer, split all the text again
+    m_statements.clear();
+    m_dirtyFrom = 0;
+    m_dirtyTo = length();
+    m_generation++;
+    scheduleParsing();
+
     if (lexer) // delete the "old" lexer - if any
         delete lexer;
 
@@ -383,7 +404,7 @@ void toSqlText::indentPriv(SQLParser::Token const* root, QList<SQLParser::Token
         }
     }
 
-    foreach(QPointer<Token> child, root->getChildren())
+    foreach(Token const *child, root->getChildren())
     {
         Position child_position = child->getValidPosition();
 
@@ -597,7 +618,8 @@ void toSqlText::populateContextMenu(QMenu *popup)
 
 void toSqlText::scheduleParsing()
 {
-    if (m_haveFocus && !m_parserTimer->isActive())
+    // (re)start the timer, statements are split once typing pauses
+    if (m_haveFocus && m_dirtyFrom >= 0)
         m_parserTimer->start();
 }
 
@@ -647,20 +669,191 @@ bool toSqlText::showToolTip(toSqlText::ToolTipData const& t)
 }
 #endif
 
+namespace
+{
+    // Move document position by an edit at @param position, @param delta characters were inserted (deleted if negative)
+    int movePosition(int pos, int position, int delta)
+    {
+        if (delta >= 0)
+            return pos >= position ? pos + delta : pos;
+        if (pos >= position - delta)
+            return pos + delta;
+        return pos > position ? position : pos;
+    }
+
+    // Move line number by an edit at @param line, @param linesAdded lines were inserted (deleted if negative)
+    int moveLine(int l, int line, int linesAdded)
+    {
+        return l > line ? qMax(line, l + linesAdded) : l;
+    }
+}
+
+void toSqlText::textModified(int position, int type, const char *, int length, int linesAdded)
+{
+    bool insert = type & QsciScintillaBase::SC_MOD_INSERTTEXT;
+    if (!insert && !(type & QsciScintillaBase::SC_MOD_DELETETEXT))
+        return;
+
+    int delta = insert ? length : -length;
+    int line = SendScintilla(SCI_LINEFROMPOSITION, position);
+    for (toSyntaxAnalyzer::statementList::iterator i = m_statements.begin(); i != m_statements.end(); ++i)
+    {
+        i->posFrom = movePosition(i->posFrom, position, delta);
+        i->lineFrom = moveLine(i->lineFrom, line, linesAdded);
+        i->lineTo = moveLine(i->lineTo, line, linesAdded);
+    }
+
+    if (m_dirtyFrom < 0)
+    {
+        m_dirtyFrom = m_dirtyTo = position;
+    }
+    else
+    {
+        m_dirtyFrom = qMin(movePosition(m_dirtyFrom, position, delta), position);
+        m_dirtyTo = movePosition(m_dirtyTo, position, delta);
+    }
+    m_dirtyTo = qMax(m_dirtyTo, insert ? position + length : position);
+    m_generation++;
+    scheduleParsing();
+}
+
+/* Split the text from the statement in front of the edit till a few statements behind it.
+ * The worker's result is used in front of the first statement it found at the same position
+ * as before (behind the edit), statements from there on did not change.
+ */
 void toSqlText::process()
 {
-    emit parsingRequested(text());
+    if (m_splitting || m_dirtyFrom < 0)
+        return;
+
+    // The statement in front of the edit, its end may depend on the edited text
+    int first = 0;
+    while (first < m_statements.size() && m_statements[first].posFrom < m_dirtyFrom)
+        first++;
+    first--;
+    int next = first + 1;
+    while (next < m_statements.size() && m_statements[next].posFrom < m_dirtyTo)
+        next++;
+    int last = next + m_splitExtend;
+
+    m_splitFrom = first >= 0 ? m_statements[first].posFrom : 0;
+    m_splitComplete = last >= m_statements.size();
+    m_splitTo = m_splitComplete ? length() : m_statements[last].posFrom;
+    m_splitGeneration = m_generation;
+    m_splitting = true;
+
+    QByteArray buf(m_splitTo - m_splitFrom + 1, 0);
+    SendScintilla(SCI_GETTEXTRANGE, m_splitFrom, m_splitTo, buf.data());
+    emit parsingRequested(convertTextS2Q(buf.constData()), m_splitComplete);
 }
 
 void toSqlText::processed()
 {
-    if (!m_haveFocus) // response was received after the focus was lost
+    m_splitting = false;
+    if (m_splitGeneration != m_generation) // text was edited meanwhile
+    {
+        scheduleParsing();
         return;
+    }
+
+    // Worker's statements are relative to the text sent
+    int line, index;
+    lineIndexFromPosition(m_splitFrom, &line, &index);
+    toSyntaxAnalyzer::statementList split;
+    Q_FOREACH(toSyntaxAnalyzer::statement s, m_worker->statements)
+    {
+        s.posFrom = positionFromLineIndex(line + s.lineFrom, s.posFrom + (s.lineFrom == 0 ? index : 0));
+        s.lineFrom += line;
+        s.lineTo += line;
+        split << s;
+    }
 
-    Style style = OneLine;
-    unsigned lastLine = 0;
-    Q_FOREACH(const toSyntaxAnalyzer::statement &r, m_worker->statements)
+    int splitEnd = m_splitTo;
+    if (!m_splitComplete)
     {
+        QSet<int> starts;
+        Q_FOREACH(toSyntaxAnalyzer::statement const& s, m_statements)
+        {
+            if (s.posFrom >= m_dirtyTo && s.posFrom < m_splitTo)
+                starts.insert(s.posFrom);
+        }
+        int sync = 0;
+        while (sync < split.size() && !(split[sync].posFrom >= m_dirtyTo && starts.contains(split[sync].posFrom)))
+            sync++;
+        if (sync == split.size())
+        {
+            // Old statements were not found again (like when an unterminated comment was typed), split more text
+            m_splitExtend *= 2;
+            process();
+            return;
+        }
+        splitEnd = split[sync].posFrom;
+        split.erase(split.begin() + sync, split.end());
+    }
+
+    int first = 0;
+    while (first < m_statements.size() && m_statements[first].posFrom < m_splitFrom)
+        first++;
+    int last = first;
+    while (last < m_statements.size() && (m_splitComplete || m_statements[last].posFrom < splitEnd))
+        last++;
+    int removed = last - first;
+    m_statements.erase(m_statements.begin() + first, m_statements.begin() + last);
+    for (int i = 0; i < split.size(); i++)
+        m_statements.insert(first + i, split[i]);
+
+    m_dirtyFrom = m_dirtyTo = -1;
+    m_splitExtend = 1;
+
+    // Statements behind the split keep their line numbers, unless their colors alternate differently now
+    int fromLine = SendScintilla(SCI_LINEFROMPOSITION, m_splitFrom);
+    int toLine = SendScintilla(SCI_LINEFROMPOSITION, splitEnd);
+    if (m_splitComplete || (removed - split.size()) % 2 != 0)
+        toLine = lines();
+    updateMargins(fromLine, toLine);
+}
+
+bool toSqlText::statementRange(int line, int &posFrom, int &posTo) const
+{
+    if (m_statements.isEmpty())
+        return false;
+
+    // The last statement starting on the line or above it
+    toSyntaxAnalyzer::statementList::const_iterator i = std::upper_bound(m_statements.begin(), m_statements.end(), line,
+            [](int l, toSyntaxAnalyzer::statement const& s) { return l < s.lineFrom; });
+    int first = qMax(0, int(i - m_statements.begin()) - 1);
+    // More statements can share the line, take the first one
+    while (first > 0 && m_statements[first - 1].lineTo >= line)
+        first--;
+    // Line is between two statements, the next one is returned (like getStatementAt does)
+    int last = m_statements[first].lineTo < line ? first + 2 : first + 1;
+
+    if (m_dirtyFrom >= 0 && (last >= m_statements.size() || m_dirtyFrom < m_statements[last].posFrom))
+    {
+        // Statements around the edit were not split again yet
+        while (first > 0 && m_statements[first].posFrom >= m_dirtyFrom)
+            first--;
+        while (last < m_statements.size() && m_statements[last].posFrom <= m_dirtyTo)
+            last++;
+        last++;
+    }
+
+    posFrom = first == 0 ? 0 : m_statements[first].posFrom;
+    posTo = last >= m_statements.size() ? length() : m_statements[last].posFrom;
+    return true;
+}
+
+void toSqlText::updateMargins(int fromLine, int toLine)
+{
+    int lastLine = fromLine;
+    for (int i = 0; i < m_statements.size(); i++)
+    {
+        toSyntaxAnalyzer::statement const &r = m_statements[i];
+        if (r.lineTo < fromLine)
+            continue;
+        if (r.lineFrom >= toLine)
+            break;
+
         // "clear" line numbers before the statement
         while (lastLine < r.lineFrom)
         {
@@ -668,22 +861,19 @@ void toSqlText::processed()
         }
 
         // "draw" line numbers for the sql statement
-        for (unsigned int i=r.lineFrom, j=1; i <= r.lineTo; ++i, ++j)
+        Style style = i % 2 == 0 ? OneLine : OneLineAlt;
+        for (int l = qMax(r.lineFrom, fromLine); l <= r.lineTo && l < toLine; ++l)
         {
-            setMarginText(i, QString::number(j), style);
+            setMarginText(l, QString::number(l - r.lineFrom + 1), style);
         }
-        lastLine = r.lineTo + 1;
-        style = style == OneLine ? OneLineAlt : OneLine;
+        lastLine = qMax(lastLine, r.lineTo + 1);
     }
 
     // "clear" line numbers after the last statement
-    while (lastLine < lines())
+    while (lastLine < toLine)
     {
         setMarginText(lastLine++, QString(), Default);
     }
-
-    //emit parsingFinished();
-    scheduleParsing();
 }
 
 toSqlTextWorker::toSqlTextWorker(QObject *parent)
@@ -697,12 +887,12 @@ toSqlTextWorker::~toSqlTextWorker()
 {
 }
 
-void toSqlTextWorker::process(QString text)
+void toSqlTextWorker::process(QString text, bool complete)
 {
     statements.clear();
     if (analyzer)
     {
-        statements = analyzer->getStatements(text);
+        statements = analyzer->getStatements(text, complete);
     }
     emit processed();
 }
@@ -146,6 +146,13 @@ class toSqlText : public toScintilla
 
         toSyntaxAnalyzer* analyzer();
 
+        /** Text range [posFrom, posTo) holding the statement at @param line.
+         * Looked up in the statement index kept by the incremental splitter (binary search on lines)
+         * and widened over the text edited since the last split.
+         * @return false if the text was not split yet
+         */
+        bool statementRange(int line, int &posFrom, int &posTo) const;
+
         void indentPriv(SQLParser::Token const*, QList<SQLParser::Token const*>&);
 
     private slots:
@@ -153,6 +160,7 @@ class toSqlText : public toScintilla
         void setHighlighter(int);
         void process();
         void processed();
+        void textModified(int position, int type, const char *text, int length, int linesAdded);
 
 #ifdef QT_DEBUG
         // This function should diagnose focus "stealing"
@@ -160,7 +168,7 @@ class toSqlText : public toScintilla
 #endif
 
     signals:
-        void parsingRequested(QString);
+        void parsingRequested(QString, bool);
 
     protected:
         /*! \brief Override QScintilla event handler to display code completion popup */
@@ -175,6 +183,9 @@ class toSqlText : public toScintilla
 
         void scheduleParsing();
         void unScheduleParsing();
+
+        /** Draw statement line numbers for lines [fromLine, toLine) */
+        void updateMargins(int fromLine, int toLine);
 #ifdef TORA_EXPERIMENTAL
         bool showToolTip(ToolTipData const& t) override;
 #endif
@@ -191,6 +202,16 @@ class toSqlText : public toScintilla
         toSqlTextWorker *m_worker;
         bool m_haveFocus; // this flag handles situation when bg thread response is rececived after focus was lost
 
+        // Statements are split incrementally, only those touched by an edit are split again.
+        // Lines and posFrom (document position of the 1st token) are moved by edits, see textModified()
+        toSyntaxAnalyzer::statementList m_statements;
+        int m_dirtyFrom, m_dirtyTo;   // text edited since the last split, -1 if none
+        int m_splitFrom, m_splitTo;   // text sent to the worker
+        int m_splitExtend;            // number of statements behind the edit sent to the worker
+        bool m_splitComplete;         // text sent to the worker reaches the end of document
+        bool m_splitting;             // worker did not respond yet
+        unsigned m_generation, m_splitGeneration; // edits counter, result of a split is used only if no edit came meanwhile
+
         QAction *m_wrap, *m_indent;
 };
 
@@ -216,7 +237,7 @@ class toSqlTextWorker: public QObject
         ~toSqlTextWorker();
 
     public slots:
-        void process(QString);
+        void process(QString, bool);
 
     protected:
         void setAnalyzer(toSyntaxAnalyzer*);
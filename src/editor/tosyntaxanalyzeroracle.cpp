@@ -36,6 +36,7 @@
 
 #include "parsing/tolexeroracle.h"
 #include "core/toconfiguration.h"
+#include "core/tologger.h"
 #include "editor/tosqltext.h"
 #include <QtCore/QDebug>
 
@@ -43,6 +44,7 @@
 #include <Qsci/qscilexersql.h>
 
 #include <iostream>
+#include <climits>
 
 #include "core/toeditorconfiguration.h"
 #include "core/tostyle.h"
@@ -92,12 +94,82 @@ toSyntaxAnalyzer::statementList toSyntaxAnalyzerOracle::getStatements(const QStr
     return retval;
 }
 
+toSyntaxAnalyzer::statementList toSyntaxAnalyzerOracle::getStatements(const QString& text, bool complete)
+{
+    toSyntaxAnalyzer::statementList retval;
+    std::string str(text.toStdString());
+    try
+    {
+        std::unique_ptr <SQLLexer::Lexer> lexer = LexerFactTwoParmSing::Instance().create("OracleGuiLexer", "", "toCustomLexer");
+        lexer->setStatement(str.c_str(), (int)str.length());
+
+        // The first comment or string not terminated in the text, it might continue behind it
+        SQLLexer::Position open(UINT_MAX, UINT_MAX);
+        if (!complete)
+        {
+            for (SQLLexer::Lexer::token_const_iterator i = lexer->begin(); i->getTokenType() != SQLLexer::Token::X_EOF; ++i)
+            {
+                QString const& t = i->getText();
+                if ((t.startsWith("/*") && i->getTokenType() != SQLLexer::Token::X_COMMENT_ML)
+                        || (t.startsWith('\'') && i->getTokenType() != SQLLexer::Token::L_STRING))
+                {
+                    open = i->getPosition();
+                    break;
+                }
+            }
+        }
+
+        SQLLexer::Lexer::token_const_iterator start = lexer->begin();
+        start = lexer->findStartToken(start);
+        while (start->getTokenType() != SQLLexer::Token::X_EOF)
+        {
+            SQLLexer::Lexer::token_const_iterator end = lexer->findEndToken(start);
+            if (!(end->getPosition() < open))
+                break;
+            statement s(start->getPosition().getLine(), end->getPosition().getLine());
+            s.posFrom = start->getPosition().getLinePos();
+            retval << s;
+            start = lexer->findStartToken(end);
+        }
+    }
+    catch (std::exception const &e)
+    {
+        TLOG(1, toDecorator, __HERE__) << "Statement split failed: " << e.what() << std::endl;
+    }
+    catch (QString const& e)
+    {
+        TLOG(1, toDecorator, __HERE__) << "Statement split failed: " << e << std::endl;
+    }
+    catch (...)
+    {
+        TLOG(1, toDecorator, __HERE__) << "Statement split failed" << std::endl;
+    }
+    return retval;
+}
+
 toSyntaxAnalyzer::statement toSyntaxAnalyzerOracle::getStatementAt(unsigned line, unsigned linePos)
 {
     toSyntaxAnalyzer::statement retval;
 
-    toScintilla *editor = qobject_cast<toScintilla *>(parent());
-    std::string str(editor->text().toStdString());
+    toSqlText *editor = qobject_cast<toSqlText *>(parent());
+    // Lex only the statements around the line, as found in the editor's statement index
+    int from, to;
+    if (editor->analyzer() != this || !editor->statementRange(line, from, to))
+    {
+        from = 0;
+        to = editor->length();
+    }
+    int fromLine, fromIndex;
+    editor->lineIndexFromPosition(from, &fromLine, &fromIndex);
+    QByteArray buf(to - from + 1, 0);
+    editor->SendScintilla(QsciScintilla::SCI_GETTEXTRANGE, from, to, buf.data());
+    std::string str(editor->convertTextS2Q(buf.constData()).toStdString());
+
+    // Token positions are relative to the beginning of the range
+    auto position = [&](SQLLexer::Position const& p, int length)
+    {
+        return editor->positionFromLineIndex(fromLine + p.getLine(), p.getLinePos() + length + (p.getLine() == 0 ? fromIndex : 0));
+    };
     try
     {
         std::unique_ptr <SQLLexer::Lexer> lexer = LexerFactTwoParmSing::Instance().create("OracleGuiLexer", "", "toCustomLexer");
@@ -109,23 +181,20 @@ toSyntaxAnalyzer::statement toSyntaxAnalyzerOracle::getStatementAt(unsigned line
         {
             SQLLexer::Lexer::token_const_iterator end = lexer->findEndToken(start);
             SQLLexer::Lexer::token_const_iterator nextStart = lexer->findStartToken(end);
-            if (end->getPosition().getLine() < line)
+            if ((int)end->getPosition().getLine() + fromLine < (int)line)
             {
                 start = nextStart;
                 continue;
             }
 
             // The statement was found - setup retval
-            toScintilla *editor = qobject_cast<toScintilla *>(parent());
             retval = statement(
-                         start->getPosition().getLine(),
-                         end->getPosition().getLine());
+                         fromLine + start->getPosition().getLine(),
+                         fromLine + end->getPosition().getLine());
 
             retval.firstWord = start->getText();
-            retval.posFrom = editor->positionFromLineIndex(start->getPosition().getLine()
-                             , start->getPosition().getLinePos());
-            retval.posTo   = editor->positionFromLineIndex(end->getPosition().getLine()
-                             , end->getPosition().getLinePos() + ( end->getTokenType() == SQLLexer::Token::X_EOL ? 0 : end->getLength()));
+            retval.posFrom = position(start->getPosition(), 0);
+            retval.posTo   = position(end->getPosition(), end->getTokenType() == SQLLexer::Token::X_EOL ? 0 : end->getLength());
             switch (start->getTokenType())
             {
                 case SQLLexer::Token::L_LPAREN:
@@ -45,6 +45,7 @@ class toSyntaxAnalyzerOracle : public toSyntaxAnalyzer
         virtual ~toSyntaxAnalyzerOracle();
 
         statementList getStatements(QString const& text) override;
+        statementList getStatements(QString const& text, bool complete) override;
         statement getStatementAt(unsigned line, unsigned linePos) override;
         QsciLexer* createLexer(QObject *parent) override;
         void sanitizeStatement(statement&) override;
@@ -39,6 +39,7 @@
 #include "core/tosql.h"
 #include "core/tocache.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
 #include "core/toraversion.h"
 #include "widgets/toabout.h"
 #include "core/toconf.h"
@@ -357,6 +358,7 @@ int main(int argc, char **argv)
 
         qRegisterMetaType<toQColumnDescriptionList>("toQColumnDescriptionList&");
         qRegisterMetaType<ValuesList>("ValuesList&");
+        qRegisterMetaType<toQueryBatchPtr>("toQueryBatchPtr");
         qRegisterMetaType<toConnection::exception>("toConnection::exception");
 
         new toMain;
@@ -41,6 +41,7 @@
 #include "core/tosyntaxanalyzer.h"
 
 #include <QtCore/QDebug>
+#include <QtCore/QVector>
 #include <QtGui/QColor>
 #include <QtGui/QFont>
 #include <Qsci/qsciscintilla.h>
@@ -48,6 +49,69 @@
 
 #include <iostream>
 
+namespace
+{
+    // Scintilla line state of a styled line, 0 is a line not styled by this lexer yet
+    const int LINE_STYLED = 0x1;
+    const int LINE_IN_TOKEN = 0x2;   // line ends inside of a token (multi-line comment or string)
+
+    const int CHUNK_LINES = 128;
+    const int MAX_CHUNK_LINES = 8192;  // give up searching for the end of an unterminated comment
+
+    // Length of the N, Q or NQ prefix of a string literal at text
+    unsigned stringPrefix(const char *text, unsigned len)
+    {
+        unsigned p = 0;
+        if (p < len && (text[p] == 'n' || text[p] == 'N'))
+            p++;
+        if (p < len && (text[p] == 'q' || text[p] == 'Q'))
+            p++;
+        return p < len && text[p] == '\'' ? p : 0;
+    }
+
+    /* True if the token may continue behind the chunk end: a multi-line comment, a string
+     * (including q'[...]' and N'...') or a "quoted" identifier which is not terminated.
+     * The grammar needs the closing delimiter, so such a token is usually returned
+     * as a failure at its opening delimiter. len is the token length, available the rest of the chunk.
+     */
+    bool isOpenToken(SQLLexer::Token const &node, const char *text, unsigned len, unsigned available)
+    {
+        switch (node.getTokenType())
+        {
+            case SQLLexer::Token::X_COMMENT_ML:
+                return len < 4 || text[len - 2] != '*' || text[len - 1] != '/';
+            case SQLLexer::Token::L_STRING:
+                {
+                    if (text[0] == '"')
+                        return len < 2 || text[len - 1] != '"';
+                    unsigned p = stringPrefix(text, len);
+                    if (p == 0 || (text[p - 1] != 'q' && text[p - 1] != 'Q'))
+                        return len < p + 2 || text[len - 1] != '\'';
+                    // q'<delimiter>...<closing delimiter>'
+                    if (len < p + 4)
+                        return true;
+                    char close = text[p + 1];
+                    switch (close)
+                    {
+                        case '[': close = ']'; break;
+                        case '{': close = '}'; break;
+                        case '(': close = ')'; break;
+                        case '<': close = '>'; break;
+                    }
+                    return text[len - 2] != close || text[len - 1] != '\'';
+                }
+            case SQLLexer::Token::X_FAILURE:
+                // the failure can start at the prefix of q'... or N'...
+                return text[0] == '"'
+                       || (text[0] == '/' && available > 1 && text[1] == '*')
+                       || text[0] == '\''
+                       || stringPrefix(text, available) > 0;
+            default:
+                return false;
+        }
+    }
+}
+
 #define declareStyle(style,color, paper, font) \
     styleNames[style] = tr(#style); \
     setColor(color, style); \
@@ -60,6 +124,8 @@ toLexerOracle::toLexerOracle(QObject *parent)
     , bufferText(NULL)
     , lineLength(32)
     , bufferLength(1024)
+    , validEnd(0)
+    , dirtyEnd(-1)
     , lexer(LexerFactTwoParmSing::Instance().create("OracleGuiLexer", "", "toLexerOracle - OracleGuiLexer"))
 {
     using namespace ToConfiguration;
@@ -152,77 +218,185 @@ QString toLexerOracle::description(int style) const
     }
 }
 
-void toLexerOracle::styleText(int start, int end)
+void toLexerOracle::setEditor(QsciScintilla *editor)
 {
-    QString source;
-    int len = end - start;
+    if (this->editor())
+        disconnect(this->editor(), SIGNAL(SCN_MODIFIED(int, int, const char *, int, int, int, int, int, int, int)),
+                   this, SLOT(textModified(int, int, const char *, int)));
+
+    QsciLexerCustom::setEditor(editor);
+    validEnd = 0;
+    dirtyEnd = -1;
+
+    if (this->editor())
+        connect(this->editor(), SIGNAL(SCN_MODIFIED(int, int, const char *, int, int, int, int, int, int, int)),
+                this, SLOT(textModified(int, int, const char *, int)));
+}
 
+void toLexerOracle::textModified(int position, int type, const char *, int length)
+{
+    if (type & QsciScintillaBase::SC_MOD_INSERTTEXT)
+    {
+        if (position < validEnd)
+            validEnd += length;
+        if (position < dirtyEnd)
+            dirtyEnd += length;
+        dirtyEnd = qMax(dirtyEnd, position + length);
+    }
+    else if (type & QsciScintillaBase::SC_MOD_DELETETEXT)
+    {
+        if (position < validEnd)
+            validEnd = qMax(position, validEnd - length);
+        if (position < dirtyEnd)
+            dirtyEnd = qMax(position, dirtyEnd - length);
+        dirtyEnd = qMax(dirtyEnd, position);
+    }
+}
+
+int toLexerOracle::restartLine(int line) const
+{
+    while (line > 0 && editor()->SendScintilla(QsciScintilla::SCI_GETLINESTATE, line - 1) != LINE_STYLED)
+        line--;
+    return line;
+}
+
+/* Lexing restarts at the nearest line which does not continue a token from the line above
+ * (exit state of every styled line is kept in Scintilla's line state). The document is lexed
+ * in chunks of lines, styling stops as soon as a line behind the edited text ends in the same state
+ * as it did before - the rest of the document keeps its styles.
+ */
+void toLexerOracle::styleText(int start, int end)
+{
     if (!editor())
         return;
 
-    if ( lineLength < (end - start + 1)) // +1 for 0x00
+    int lineCount = editor()->SendScintilla(QsciScintilla::SCI_GETLINECOUNT);
+    int line = restartLine(editor()->SendScintilla(QsciScintilla::SCI_LINEFROMPOSITION, start));
+    int pos = editor()->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, line);
+    int chunk = CHUNK_LINES;
+
+    while (pos < end && line < lineCount)
+    {
+        int last = qMin(line + chunk, lineCount);
+        bool settled = false;
+        int styled = styleLines(line, last, last == lineCount || chunk >= MAX_CHUNK_LINES, settled);
+        if (styled == 0)
+        {
+            // a comment or a string continues behind the chunk
+            chunk *= 2;
+            continue;
+        }
+        chunk = CHUNK_LINES;
+        line += styled;
+        pos = line < lineCount
+              ? editor()->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, line)
+              : editor()->SendScintilla(QsciScintilla::SCI_GETLENGTH);
+
+        if (settled && dirtyEnd >= 0 && pos >= dirtyEnd && pos < validEnd)
+        {
+            // The text behind is not edited and lexer ends in the same state as before, so are the styles
+            int skip = restartLine(editor()->SendScintilla(QsciScintilla::SCI_LINEFROMPOSITION, validEnd));
+            if (skip > line)
+            {
+                line = skip;
+                pos = editor()->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, line);
+            }
+            dirtyEnd = -1;
+        }
+    }
+
+    startStyling(pos, 0x1f);
+    validEnd = qMax(validEnd, pos);
+    if (pos >= validEnd)
+        dirtyEnd = -1;
+}
+
+int toLexerOracle::styleLines(int first, int last, bool complete, bool &settled)
+{
+    int lineCount = editor()->SendScintilla(QsciScintilla::SCI_GETLINECOUNT);
+    int start = editor()->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, first);
+    int end = last < lineCount
+              ? editor()->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, last)
+              : editor()->SendScintilla(QsciScintilla::SCI_GETLENGTH);
+    unsigned len = end - start;
+
+    if ( lineLength < len + 1) // +1 for 0x00
     {
-        lineLength = Utils::toNextPowerOfTwo(end - start + 1);
+        lineLength = Utils::toNextPowerOfTwo(len + 1);
         lineText = (char*) realloc(lineText, lineLength);
     }
     editor()->SendScintilla(QsciScintilla::SCI_GETTEXTRANGE, start, end, lineText);
-    source = QString::fromUtf8(lineText, len);
     lexer->setStatement(lineText, len);
 
-    int line = editor()->SendScintilla(QsciScintilla::SCI_LINEFROMPOSITION, start);
-    int state = -1;
-    if ( line > 0)
+    // Line starts relative to chunk start, lineStarts[i] is a boundary between lines first+i-1 and first+i
+    QVector<unsigned> lineStarts;
+    for (int l = first; l < last; l++)
+        lineStarts.append(editor()->SendScintilla(QsciScintilla::SCI_POSITIONFROMLINE, l) - start);
+    lineStarts.append(len);
+    QVector<bool> tokenStarts(lineStarts.size(), false);
+    tokenStarts.last() = true;
+
+    // Find tokens starting at line boundaries and the first comment or string not terminated in the chunk,
+    // tokens in front of it are lexed the same way as if the whole document was lexed.
+    unsigned open = len;
+    unsigned offset = 0;
+    int boundary = 0;
+    for (SQLLexer::Lexer::token_const_iterator i = lexer->begin(); i != lexer->end(); ++i)
     {
-        // the previous state may be needed for multi-line styling
-        int pos = editor()->SendScintilla(QsciScintilla::SCI_GETLINEENDPOSITION, line -1);
-        state = editor()->SendScintilla(QsciScintilla::SCI_GETSTYLEAT, pos);
+        SQLLexer::Token const &node = *i;
+        if (node.getTokenType() == SQLLexer::Token::X_EOF)
+            break;
+        while (boundary < lineStarts.size() && lineStarts[boundary] < offset)
+            boundary++;
+        if (boundary < lineStarts.size() && lineStarts[boundary] == offset)
+            tokenStarts[boundary] = true;
+        if (open == len && offset < len && isOpenToken(node, lineText + offset, qMin(node.getLength(), len - offset), len - offset))
+            open = offset;
+        offset += node.getLength();
     }
 
-    //qDebug() << '[' << line << ',' << start << "," << end << ' ' << lexer->firstWord() << "] " << "source =" << source << '"';
+    // Style whole lines in front of the open token, ending at a token boundary
+    int lines = lineStarts.size() - 1;
+    if (!complete)
+    {
+        while (lines > 0 && (lineStarts[lines] > open || !tokenStarts[lines]))
+            lines--;
+        if (lines == 0)
+            return 0;
+    }
+    unsigned styleEnd = lineStarts[lines];
 
     startStyling(start, 0x1f);
-
-    SQLLexer::Lexer::token_const_iterator i = lexer->begin();
-    unsigned offset = 0;
-    if ( state == CommentMultiline)
+    offset = 0;
+    bool lineBegin = true, oneLine = false;
+    for (SQLLexer::Lexer::token_const_iterator i = lexer->begin(); i != lexer->end() && offset < styleEnd; ++i)
     {
-        for (; i != lexer->end(); ++i)
+        SQLLexer::Token const &node = *i;
+        unsigned len2 = node.getLength();
+        SQLLexer::Token::TokenType type = node.getTokenType();
+        //qDebug() << '\t' << len2 << ' ' << node.getTokenType();
+
+        // SQL*Plus command spans till the end of line
+        if (lineBegin && type == SQLLexer::Token::X_ONE_LINE)
+            oneLine = true;
+        if (type == SQLLexer::Token::X_EOL)
         {
-            //Q_ASSERT_X( , qPrintable(__QHERE__), "Pos1");
-            SQLLexer::Token const &node = *i;
-            unsigned len2 = node.getLength();
-            setStyling(len2, CommentMultiline);
-            offset += len2;
-            if ( node.getTokenType() == SQLLexer::Token::X_COMMENT_ML_END)
-            {
-                ++i;
-                break;
-            }
+            oneLine = false;
+            lineBegin = true;
         }
-    }
-    else if ( (*i).getTokenType() == SQLLexer::Token::X_ONE_LINE)
-    {
-        for (; i != lexer->end(); ++i)
+        else if (type != SQLLexer::Token::X_WHITE)
+        {
+            lineBegin = false;
+        }
+
+        if (oneLine)
         {
-            SQLLexer::Token const &node = *i;
-            if ( node.getTokenType() == SQLLexer::Token::X_EOL || node.getTokenType() == SQLLexer::Token::X_EOF)
-            {
-                ++i;
-                break;
-            }
-            unsigned len2 = node.getLength();
             setStyling(len2, OneLine);
             offset += len2;
+            continue;
         }
-    }
 
-    for (; i != lexer->end(); )
-    {
-        SQLLexer::Token const &node = *i;
-        unsigned len2 = node.getLength();
-        //qDebug() << '\t' << len2 << ' ' << node.getTokenType() << ' ' << state;
-
-        switch ( node.getTokenType())
+        switch (type)
         {
             case SQLLexer::Token::X_WHITE:
                 setStyling(len2, Default);
@@ -263,14 +437,16 @@ void toLexerOracle::styleText(int start, int end)
                 setStyling(len2, Default);
         }
         offset += len2;
-        SQLLexer::Token pnode(*i);
-        i++;
-        SQLLexer::Token const &nnode = *i;
-        if (nnode.getTokenType() == SQLLexer::Token::X_EOF)
-            break;
-        Q_ASSERT_X( nnode.getPosition() > pnode.getPosition(), qPrintable(__QHERE__), "Token position");
     }
 
-//	startStyling(start, 0x1f);
-//	setStyling(len, getStyle());
+    // Remember exit states, a line whose end is not a token boundary can not be a restart point
+    for (int l = 0; l < lines; l++)
+    {
+        int state = tokenStarts[l + 1] ? LINE_STYLED : LINE_STYLED | LINE_IN_TOKEN;
+        int old = editor()->SendScintilla(QsciScintilla::SCI_GETLINESTATE, first + l);
+        if (old != state)
+            editor()->SendScintilla(QsciScintilla::SCI_SETLINESTATE, first + l, state);
+        settled = old == state;
+    }
+    return lines;
 }
@@ -84,10 +84,29 @@ class toLexerOracle : public QsciLexerCustom
             return "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ$_#0123456789:.";
         }
 
+        void setEditor(QsciScintilla *editor) override;
+
+    private slots:
+        /** Track the range of edited text, see @ref styleText */
+        void textModified(int position, int type, const char *text, int length);
+
     protected:
+        /** Lex lines [first, last) of the document and style those which can not be affected by text behind them.
+         * @param complete last is the last line of the document
+         * @param settled set to true if the exit state of the last styled line did not change
+         * @return number of lines styled, 0 if the chunk has to be enlarged
+         */
+        int styleLines(int first, int last, bool complete, bool &settled);
+
+        /** Nearest line (not behind @param line) which starts outside of any token, lexing can restart there */
+        int restartLine(int line) const;
+
         char *lineText, *bufferText;
         unsigned lineLength, bufferLength;
 
+        // Styles in front of validEnd were set by this lexer, dirtyEnd is the end of text edited since (-1 if none)
+        int validEnd, dirtyEnd;
+
         QMap<int,QString> styleNames;
         QList<int> styleStack;
         std::unique_ptr <SQLLexer::Lexer> lexer;
@@ -43,10 +43,13 @@ namespace SQLLexer
 
     /*
      * Token - an element in Lexer stream
+     *
+     * Oracle lexers do not copy Token's text, it is a slice of Lexer's UTF-8 buffer decoded only when getText is called.
+     * Such a Token is valid until the Lexer is deleted or its statement is replaced by setStatement.
      */
-    class TORA_EXPORT Token : public QObject // inherit from QObject for QPointer
+    class TORA_EXPORT Token
     {
-            Q_OBJECT;
+            Q_GADGET;
             Q_ENUMS(TokenType);
         public:
 
@@ -95,8 +98,10 @@ namespace SQLLexer
             inline BlockContextEnum getBlockContext() const;
             inline void setBlockContext(BlockContextEnum);
 
-            inline const QString& getText() const;
+            inline QString getText() const;
             inline void setText(const QString&);
+            /** Refer to UTF-8 text owned by Lexer (or to a string literal), the text is not copied */
+            inline void setText(const char *utf8, unsigned length);
 
             inline Token& operator=(const Token& other);
             inline operator const Position&() const;
@@ -105,7 +110,9 @@ namespace SQLLexer
             Position _mPosition;
             unsigned _mLength, _mOrigType;
             BlockContextEnum _mBlockContext;
-            QString  _mText;
+            const char *_mSource;
+            unsigned _mSourceLength;
+            QString  _mText; // used only when _mSource is NULL
             TokenType _mTokenType;
 
         public:
@@ -65,6 +65,8 @@ namespace SQLLexer
 		, _mLength(0)
 		, _mOrigType(0) // TOKEN_INVALID
 		, _mBlockContext(BlkCtx::NONE)
+		, _mSource(NULL)
+		, _mSourceLength(0)
 		, _mTokenType(X_UNASSIGNED)
 	{};
 
@@ -73,6 +75,8 @@ namespace SQLLexer
 		, _mLength(len)
 		, _mOrigType(origType)
 		, _mBlockContext(BlkCtx::NONE) // NONE
+		, _mSource(NULL)
+		, _mSourceLength(0)
 		, _mTokenType(tokentype)
 	{};
 
@@ -81,6 +85,9 @@ namespace SQLLexer
 		, _mLength(other._mLength)
 		, _mOrigType(other._mOrigType)
 		, _mBlockContext(other._mBlockContext)
+		, _mSource(other._mSource)
+		, _mSourceLength(other._mSourceLength)
+		, _mText(other._mText)
 		, _mTokenType(other._mTokenType)
 #ifdef TORA_EXPERIMENTAL
 		, _mOrigTypeText(other._mOrigTypeText)
@@ -124,16 +131,27 @@ namespace SQLLexer
 		_mBlockContext = b;
 	}
 	
-	inline const QString& Token::getText() const
+	inline QString Token::getText() const
 	{
+		if (_mSource)
+			return QString::fromUtf8(_mSource, _mSourceLength);
 		return _mText;
 	};
 
 	inline void Token::setText(const QString &t)
 	{
+		_mSource = NULL;
+		_mSourceLength = 0;
 		_mText = t;
 	};
 
+	inline void Token::setText(const char *utf8, unsigned length)
+	{
+		_mSource = utf8;
+		_mSourceLength = length;
+		_mText.clear();
+	};
+
 	inline Token& Token::operator=(const Token& other)
 	{
 		_mPosition = other._mPosition;
@@ -141,6 +159,8 @@ namespace SQLLexer
 		_mTokenType = other._mTokenType;
 		_mOrigType = other._mOrigType;
 		_mBlockContext = other._mBlockContext;
+		_mSource = other._mSource;
+		_mSourceLength = other._mSourceLength;
 		_mText = other._mText;
 #ifdef TORA_EXPERIMENTAL
         _mOrigTypeText = other._mOrigTypeText;
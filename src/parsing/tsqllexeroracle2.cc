@@ -179,7 +179,7 @@ const Token& OracleGuiLexer::LA(int pos) const
 			// The buffer is empty - Only EOF_TOKEN is "present"
 			Token::TokenType type = Token::X_EOF;
 			retvalLA = Token(Position(0, 0), 0, PLSQLGuiLexer::EOF_TOKEN, type);
-			retvalLA.setText("EOF");
+			retvalLA.setText("EOF", 3);
 			retvalLA.setBlockContext(NONE);
 			return retvalLA;
 		}
@@ -191,10 +191,9 @@ const Token& OracleGuiLexer::LA(int pos) const
 		int line = token->get_line() - 1;
 		int column = token->get_charPositionInLine();
 		unsigned length = token->get_stopIndex() - token->get_startIndex() + 1;
-		QString txt = QString::fromUtf8(token->getText().c_str());
 		Token::TokenType type = Token::X_EOF;
 		retvalLA = Token(Position(line, column+length+1), 0, PLSQLGuiLexer::EOF_TOKEN, type);
-		retvalLA.setText("EOF");
+		retvalLA.setText("EOF", 3);
 		retvalLA.setBlockContext(NONE);
 		return retvalLA;
 	}
@@ -295,7 +294,8 @@ const Token& OracleGuiLexer::LA(int pos) const
 		}
 
 		retvalLA = Token(Position(line, column), length, token->getType(), type);
-		retvalLA.setText(QString::fromUtf8(token->getText().c_str()));
+		// ANTLR's start index points into QBAinput
+		retvalLA.setText((const char *)token->get_startIndex(), length);
 		retvalLA.setBlockContext(token->getBlockContext());
 #ifdef TORA_EXPERIMENTAL
 		retvalLA._mOrigTypeText = token->getType() == PLSQLGuiLexer::EOF_TOKEN ? "EOF" : (const char *)Antlr3GuiImpl::PLSQLGuiLexerTokens::getTokenName(token->getType());
@@ -3,6 +3,8 @@
 //// #include "tsqlparser_export.h"
 #include "parsing/tsqlparse.h"
 
+#include <string.h>
+
 namespace SQLParser
 {
     const char* SQLParser::Token::TokenType2Text[] =
@@ -144,6 +146,49 @@ namespace SQLParser
         return _mTableMap.end();
     };
 
+    TokenArena::TokenArena()
+        : _mCurrent(NULL)
+        , _mEnd(NULL)
+    {};
+
+    TokenArena::~TokenArena()
+    {
+        for (int i = _mTokens.size() - 1; i >= 0; --i)
+            _mTokens.at(i)->~Token();
+        foreach(char *block, _mBlocks)
+            delete[] block;
+    };
+
+    const char* TokenArena::copy(const char *text, unsigned length)
+    {
+        char *retval = static_cast<char*>(allocate(length, 1));
+        ::memcpy(retval, text, length);
+        return retval;
+    };
+
+    void* TokenArena::allocate(size_t size, size_t align)
+    {
+        // blocks allocated by new[] are aligned for any fundamental type
+        size_t pad = _mCurrent ? (align - reinterpret_cast<quintptr>(_mCurrent) % align) % align : 0;
+        if (_mCurrent == NULL || pad + size > size_t(_mEnd - _mCurrent))
+        {
+            if (size > BlockSize / 4)
+            {
+                // large chunk gets its own block, the current one is still usable
+                char *block = new char[size];
+                _mBlocks.append(block);
+                return block;
+            }
+            _mCurrent = new char[BlockSize];
+            _mEnd = _mCurrent + BlockSize;
+            _mBlocks.append(_mCurrent);
+            pad = 0;
+        }
+        void *retval = _mCurrent + pad;
+        _mCurrent += pad + size;
+        return retval;
+    };
+
     Token const* Statement::translateAlias(QString const& alias, Token const *context)
     {
         for ( SQLParser::Statement::token_const_iterator_to_root k(context); k->parent(); ++k)
@@ -17,6 +17,7 @@
 #include <QtCore/QMap>
 #include <QtCore/QSet>
 #include <QtCore/QPointer>
+#include <QtCore/QByteArray>
 #include <QtCore/QVariant>
 #include <QtCore/QVector>
 
@@ -24,6 +25,8 @@
 
 #include <iostream>
 #include <ostream>
+#include <new>
+#include <utility>
 
 namespace SQLParser
 {
@@ -163,8 +166,11 @@ namespace SQLParser
 
     /*
      * Token - an element in AST tree hierarchy
+     *
+     * Tokens are allocated from Statement's TokenArena and are owned by it. Token's text is not copied,
+     * it points either into Statement's UTF-8 source or into the arena.
      */
-    class TORA_EXPORT Token : public QObject // inherit from QObject for QPointer
+    class TORA_EXPORT Token
     {
         public:
             // TreeModel methods
@@ -249,19 +255,22 @@ namespace SQLParser
                 UsageL // Used in LVALUE
             };
 
-            Token(Token *parent, const Position &pos, const QString &str, const TokenType& tokentype = X_UNASSIGNED)
+            Token(Token *parent, const Position &pos, const char *text, unsigned length, const TokenType& tokentype = X_UNASSIGNED)
                 : _mParent(parent)
                 , _mPosition(pos)
-                , _mStr(str)
+                , _mText(text)
+                , _mTextLength(length)
                 , _mTokenType(tokentype) // will be overwritten by descendant
                 , _mUsageType(Unknown)
+                , _mTokenATypeName("")
                 , _mDepth(parent ? parent->_mDepth + 1 : 0)
             {};
 
             Token(const Token& other)
                 : _mParent(other._mParent)
                 , _mPosition(other._mPosition)
-                , _mStr(other._mStr)
+                , _mText(other._mText)
+                , _mTextLength(other._mTextLength)
                 , _mTokenType(other._mTokenType) // will be overwritten by descendant
                 , _mUsageType(other._mUsageType)
                 , _mTokenATypeName(other._mTokenATypeName)
@@ -307,29 +316,28 @@ namespace SQLParser
                 return root->getPosition();
             }
 
-            const QString& toString() const
+            QString toString() const
             {
-                static const QString Empty;
                 if (getPosition().getLine() == 0)
-                   return Empty;
+                   return QString();
                 if (getTokenType() == X_EOF)
-                	return Empty;
-                return _mStr;
+                	return QString();
+                return QString::fromUtf8(_mText, _mTextLength);
             };
 
-            operator const QString&() const
+            operator QString() const
             {
                 return toString();
             };
             QString toStringFull() const
             {
                 QString retval;
-                foreach(QPointer<Token> space, _mSpacesPrev)
+                foreach(Token const *space, _mSpacesPrev)
                 {
                     retval += space->toString();
                 }
                 retval += this->toString();
-                foreach(QPointer<Token> space, _mSpacesPost)
+                foreach(Token const *space, _mSpacesPost)
                 {
                     retval += space->toString();
                 }
@@ -342,7 +350,7 @@ namespace SQLParser
                 QString retval_pre, retval_post;
                 //retval_pre += '[';
                 //retval += getPosition().toString();
-                foreach(QPointer<Token> child, _mChildren)
+                foreach(Token const *child, _mChildren)
                 {
                     Position child_position = child->getValidPosition();
 
@@ -359,8 +367,8 @@ namespace SQLParser
             {
                 QString retval;
                 retval += "(";
-                retval += _mStr + "/" + getTokenATypeName() + "[" + getTokenTypeString() + "]";
-                foreach(QPointer<Token> child, _mChildren)
+                retval += QString::fromUtf8(_mText, _mTextLength) + "/" + getTokenATypeName() + "[" + getTokenTypeString() + "]";
+                foreach(Token const *child, _mChildren)
                 {
                     retval += "(";
                     retval += child->toLispStringRecursive();
@@ -384,11 +392,12 @@ namespace SQLParser
                 return TokenType2Text[_mTokenType];
             };
 
-            inline const QString& getTokenATypeName() const
+            inline QString getTokenATypeName() const
             {
-                return _mTokenATypeName;
+                return QString::fromLatin1(_mTokenATypeName);
             };
-            inline void setTokenATypeName(QString const& name)
+            // name must be a string literal (or ANTLR's static token name)
+            inline void setTokenATypeName(const char *name)
             {
                 _mTokenATypeName = name;
             };
@@ -403,11 +412,11 @@ namespace SQLParser
                 return _mDepth;
             }
 
-            inline void appendChild(QPointer<Token> child)
+            inline void appendChild(Token *child)
             {
                 _mChildren.append(child);
             };
-            inline void addSpacer(QPointer<Token> space)
+            inline void addSpacer(Token *space)
             {
                 if (space->getPosition() < getPosition())
                     _mSpacesPrev.append(space);
@@ -418,23 +427,23 @@ namespace SQLParser
             inline void replaceChild(int index, Token* newOne)
             {
                 _mChildren.replace(index, newOne);
-                foreach(QPointer<Token> child, newOne->_mChildren)
+                foreach(Token *child, newOne->_mChildren)
                 {
                     child->_mParent = newOne;
                 }
             };
 
-            inline QList<QPointer<Token> > const& getChildren() const
+            inline QList<Token*> const& getChildren() const
             {
                 return _mChildren;
             };
 
-            inline QList<QPointer<Token> > const& prevTokens() const
+            inline QList<Token*> const& prevTokens() const
             {
                 return _mSpacesPrev;
             }
 
-            inline QList<QPointer<Token> > const& postTokens() const
+            inline QList<Token*> const& postTokens() const
             {
                 return _mSpacesPost;
             }
@@ -455,13 +464,14 @@ namespace SQLParser
             const static char* TokenType2Text[];
             Token* _mParent;
             const Position _mPosition;
-            const QString _mStr;
+            const char * const _mText; // UTF-8, not null terminated
+            const unsigned _mTextLength;
             const TokenType _mTokenType;
             const UsageType _mUsageType;
-            QString _mTokenATypeName; //ANTLR token type - for debugging purposes only
+            const char *_mTokenATypeName; //ANTLR token type - for debugging purposes only
             // TODO use only one of them
-            QList<QPointer<Token> > _mChildren;
-            QList<QPointer<Token> > _mSpacesPrev, _mSpacesPost;
+            QList<Token*> _mChildren;
+            QList<Token*> _mSpacesPrev, _mSpacesPost;
             mutable QMap<QString, QVariant> _mMetadata;
             unsigned _mDepth;
     };
@@ -552,8 +562,8 @@ namespace SQLParser
     class TORA_EXPORT TokenSubquery: public Token
     {
         public:
-            TokenSubquery(Token *parent, const Position &pos, const QString &str, const TokenType& tokentype = X_UNASSIGNED)
-                : Token(parent, pos, str, tokentype)
+            TokenSubquery(Token *parent, const Position &pos, const char *text, unsigned length, const TokenType& tokentype = X_UNASSIGNED)
+                : Token(parent, pos, text, length, tokentype)
                 , _mAlias(NULL)
             {};
 
@@ -626,6 +636,38 @@ namespace SQLParser
             mutable QString _mNodeID;
     };
 
+    /*
+     * TokenArena - bump allocator for Statement's AST
+     *
+     * All Tokens of a Statement (including the ones replaced by disambiguation) are allocated here
+     * and destroyed at once when the Statement is deleted.
+     */
+    class TORA_EXPORT TokenArena
+    {
+        public:
+            TokenArena();
+            ~TokenArena();
+
+            template<class T, class... Args> T* create(Args&&... args)
+            {
+                T *t = new (allocate(sizeof(T), alignof(T))) T(std::forward<Args>(args)...);
+                _mTokens.append(t);
+                return t;
+            };
+
+            /* Copy a text which is not present in the Statement's source (ANTLR imaginary tokens) */
+            const char* copy(const char *text, unsigned length);
+
+        private:
+            Q_DISABLE_COPY(TokenArena);
+            void* allocate(size_t size, size_t align);
+
+            enum { BlockSize = 64 * 1024 };
+            QList<char*> _mBlocks;
+            char *_mCurrent, *_mEnd;
+            QVector<Token*> _mTokens;
+    };
+
     class TORA_EXPORT ParseException: public ::std::exception
     {
         public:
@@ -637,6 +679,13 @@ namespace SQLParser
 
     };
 
+    /*
+     * Statement - parsed SQL statement, owner of its AST
+     *
+     * Token pointers returned by root(), allLeaves(), declarations(), ... are borrowed from the Statement's
+     * TokenArena. They are valid only while the Statement exists, callers must not keep them longer
+     * (there is no QPointer to detect a dangling Token any more).
+     */
     class TORA_EXPORT Statement //: public QObject
     {
             friend class ParseException;
@@ -860,7 +909,9 @@ namespace SQLParser
             StatementType _mStatementType;
             ParserState _mState;
             virtual void parse() = 0;
-            QPointer<Token> _mAST;
+            TokenArena _mArena;
+            QByteArray _mSource; // UTF-8 encoded _mStatement, Tokens' text points here
+            Token *_mAST;
             mutable Token *_mEnd;
             //QSet<QString> _mTablesSet, _mAliasesSet;
             QVector<Token const*> _mTablesList;
@@ -11,6 +11,8 @@
 #include <QtCore/QPair>
 #include <QtCore/QtAlgorithms>
 
+#include <string.h>
+
 using namespace std;
 
 namespace SQLParser
@@ -21,11 +23,11 @@ class OracleDMLToken: public Token
 	using AntlrToken = Antlr3BackendImpl::OracleSQLParserTraits::CommonTokenType;
 	using AntlrNode = Antlr3BackendImpl::OracleSQLParserTraits::TreeType;
 public:
-	OracleDMLToken (Token *parent, AntlrNode &token);
+	OracleDMLToken (Token *parent, AntlrNode &token, const char *text, unsigned length);
 };
 
-OracleDMLToken::OracleDMLToken (Token *parent, AntlrNode &node)
-	: Token(parent, Position(node.get_token()->get_line(), node.get_token()->get_charPositionInLine()), node.getText().c_str())
+OracleDMLToken::OracleDMLToken (Token *parent, AntlrNode &node, const char *text, unsigned length)
+	: Token(parent, Position(node.get_token()->get_line(), node.get_token()->get_charPositionInLine()), text, length)
 {
 	using Tokens = Antlr3BackendImpl::OracleDMLLexerTokens;
 	_mTokenATypeName = node.getType() == Tokens::EOF_TOKEN ? "EOF" : (const char *)Antlr3BackendImpl::OracleDML::getTokenNames()[node.getType()];
@@ -185,7 +187,7 @@ OracleDMLToken::OracleDMLToken (Token *parent, AntlrNode &node)
 	{
 		// Resolve grammar ambiguity: SELECT * FROM A INNER JOIN B; (=> INNER is not a table alias)
 		// The same for NATURAL JOIN, CROSS JOIN, LEFT/RIGHT OUTER JOIN
-		QString str = QString::fromStdString(node.getText()).toUpper();
+		QString str = QString::fromUtf8(text, length).toUpper();
 		//cout << "Tokens::T_TABLE_ALIAS:" << qPrintable(str) << endl;
 		if( usageTypeRef == Tokens::T_DECL &&  (!str.compare("INNER", Qt::CaseInsensitive) ||
 							!str.compare("CROSS", Qt::CaseInsensitive) ||
@@ -296,8 +298,12 @@ public:
 private:
     void parse();
     /* Recursive walk through ANTLR3_BASE_TREE and create AST tree*/
-    void treeWalkAST(unique_ptr<Antlr3BackendImpl::OracleDML> &psr, QPointer<Token> root, Traits::TreeTypePtr& tree);
-    QList<Token*> treeWalkToken(QPointer<Token> root);
+    void treeWalkAST(unique_ptr<Antlr3BackendImpl::OracleDML> &psr, Token *root, Traits::TreeTypePtr& tree);
+    QList<Token*> treeWalkToken(Token *root);
+
+    /* Return token's text as a slice of _mSource. If the text was rewritten by the grammar (imaginary tokens),
+       return its copy allocated from the arena */
+    const char* sourceText(Traits::CommonTokenType const& token, std::string const& text);
 
     /* Walk through Token tree and look for table names, table aliases, ... and try to resolve them
        Note: this function also replaces some instances of Token* with Token's subclass instances
@@ -339,11 +345,12 @@ void OracleDMLStatement::parse()
 	using namespace std;
 
 	_mState = P_ERROR;
-	QByteArray QBAinput(_mStatement.toUtf8());
+	_mSource = _mStatement.toUtf8();
 	QByteArray QBAname(_mname.toUtf8());
 
 	_mState = P_INIT;
-	auto input = todocxx14::make_unique<InputStream>((const ANTLR_UINT8 *)QBAinput.data(), antlr3::ENC_8BIT, QBAinput.length(), (ANTLR_UINT8*)QBAname.data());
+	// ANTLR does not copy the input, token start/stop indexes point into _mSource
+	auto input = todocxx14::make_unique<InputStream>((const ANTLR_UINT8 *)_mSource.constData(), antlr3::ENC_8BIT, _mSource.length(), (ANTLR_UINT8*)QBAname.data());
 	if (input == NULL)
 		throw ParseException();
 	input->setUcaseLA(true); // ignore case
@@ -377,9 +384,10 @@ void OracleDMLStatement::parse()
 
 	_mState = P_PARSER;
 	
-	_mAST = new TokenSubquery( NULL
+	_mAST = _mArena.create<TokenSubquery>( nullptr
 				   , Position(0, 0)
 				   , ""
+				   , 0
 				   , Token::X_ROOT
 		);
 	_mAST->setTokenATypeName("ROOT");
@@ -447,9 +455,11 @@ CHECK:
 			    goto CHECK;
 		}
 
-		Token *spacerTokenNew = new Token(t3
+		std::string const& spacerText = spacerToken.getText();
+		Token *spacerTokenNew = _mArena.create<Token>(t3
 			, spacerPosition
-			, spacerToken.getText().c_str()
+			, sourceText(spacerToken, spacerText)
+			, spacerText.size()
 			, Token::X_COMMENT
 		);
 		const_cast<Traits::CommonTokenType&>(spacerToken).setConsumed();
@@ -462,8 +472,17 @@ CHECK:
 	lexerTokenVector->clear();
 };
 
+const char* OracleDMLStatement::sourceText(Traits::CommonTokenType const& token, std::string const& text)
+{
+	const char *begin = _mSource.constData();
+	const char *start = (const char*)token.get_startIndex();
+	if (start >= begin && start + text.size() <= begin + _mSource.size() && ::memcmp(start, text.data(), text.size()) == 0)
+		return start;
+	return _mArena.copy(text.data(), text.size());
+}
+
 /* recursively copy an AST tree into */
-void OracleDMLStatement::treeWalkAST(unique_ptr<Antlr3BackendImpl::OracleDML> &psr, QPointer<Token> root, Traits::TreeTypePtr &tree)
+void OracleDMLStatement::treeWalkAST(unique_ptr<Antlr3BackendImpl::OracleDML> &psr, Token *root, Traits::TreeTypePtr &tree)
 {
 	using LexerTokens = Antlr3BackendImpl::OracleDMLLexerTokens;
 	auto &children = tree->get_children();
@@ -513,7 +532,8 @@ void OracleDMLStatement::treeWalkAST(unique_ptr<Antlr3BackendImpl::OracleDML> &p
 			    continue;
 			}
 
-			Token *childTokenNew = new OracleDMLToken(root, *childNode);
+			std::string const& childText = childNode->getText();
+			Token *childTokenNew = _mArena.create<OracleDMLToken>(root, *childNode, sourceText(*childToken, childText), childText.size());
 			root->appendChild(childTokenNew);
 			// This token "select", "from", "where", "=" is already consumed. Do not prepend it to other tokens
 			if (childToken->isRealToken())
@@ -528,16 +548,17 @@ void OracleDMLStatement::treeWalkAST(unique_ptr<Antlr3BackendImpl::OracleDML> &p
 		else     // if child is a leaf node
 		{
 			/* this is a leaf node */
-			Token *childTokenNew = new OracleDMLToken(root, *childNode);
+			std::string const& childText = childNode->getText();
+			Token *childTokenNew = _mArena.create<OracleDMLToken>(root, *childNode, sourceText(*childToken, childText), childText.size());
 			root->appendChild(childTokenNew);
 		} // else for child is a leaf node
 	} // for each child
 };
 
-QList<Token*> OracleDMLStatement::treeWalkToken(QPointer<Token> root)
+QList<Token*> OracleDMLStatement::treeWalkToken(Token *root)
 {
     QList<Token*> tokens;
-    foreach(QPointer<Token> child, root->getChildren())
+    foreach(Token *child, root->getChildren())
     {
         tokens.append(treeWalkToken(child));
     }
@@ -560,7 +581,7 @@ void OracleDMLStatement::disambiguate()
             i--; // At this moment iterator's stack points onto node beeing replaced.
             Token *parent = node.parent();
             Token *me = const_cast<Token*>(&node);
-            TokenTable *newToken = new TokenTable(node);
+            TokenTable *newToken = _mArena.create<TokenTable>(node);
             parent->replaceChild(me->row(), newToken);
             i++;
             break;
@@ -575,7 +596,7 @@ void OracleDMLStatement::disambiguate()
             i--; // At this moment iterator's stack points onto node beeing replaced.
             Token *parent = node.parent();
             Token *me = const_cast<Token*>(&node);
-            TokenSubquery *newToken = new TokenSubquery(node);
+            TokenSubquery *newToken = _mArena.create<TokenSubquery>(node);
             parent->replaceChild(me->row(), newToken);
             i++;
             break;
@@ -585,7 +606,7 @@ void OracleDMLStatement::disambiguate()
             i--; // At this moment iterator's stack points onto node being replaced.
             Token *parent = node.parent();
             Token *me = const_cast<Token*>(&node);
-            TokenIdentifier *newToken = new TokenIdentifier(node);
+            TokenIdentifier *newToken = _mArena.create<TokenIdentifier>(node);
             parent->replaceChild(me->row(), newToken);
             i++;
             break;
@@ -612,7 +633,7 @@ void OracleDMLStatement::disambiguate()
             //    break;
 
             //loop over left brothers until you find either a reserved word or a table name
-            QList<QPointer<Token> > const& brothers = node.parent()->getChildren();
+            QList<Token*> const& brothers = node.parent()->getChildren();
             std::cout << "Alias found:" << node.toString().toLatin1().constData() << std::endl;
             for( int j = node.row() - 1 ; j >= 0; --j)
             {
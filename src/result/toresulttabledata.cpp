@@ -36,6 +36,7 @@
 #include "core/utils.h"
 #include "core/toconnection.h"
 #include "core/toconnectionsub.h"
+#include "core/toquery.h"
 #include "widgets/toresultmodeledit.h"
 #include "core/toconnectiontraits.h"
 #include "editor/toscintilla.h"
@@ -63,6 +64,12 @@
 #include "icons/single.xpm"
 #include "icons/trash.xpm"
 
+namespace
+{
+    // rows saved by one array DML statement
+    const int ARRAY_ROWS = 500;
+}
+
 toResultTableData::toResultTableData(QWidget *parent, const char *name, toWFlags f)
     : QWidget(parent, f)
     , Model(NULL)
@@ -405,45 +412,71 @@ bool toResultTableData::commitChanges()
 
     ProgressBar->setVisible(true);
     ProgressBar->setMaximum(Changes.size());
+    ProgressBar->setValue(0);
     Logging->setVisible(true);
 
     bool error = false;
-    unsigned updated = 0, added = 0, deleted = 0;
-
+    int total = Changes.size();
+    unsigned saved[3] = { 0, 0, 0 };   // indexed by toResultModelEdit::ChangeKind
 
     toConnectionSubLoan conn(connection());
-    // No primary keys
-    for (int changeIndex = 0; changeIndex < Changes.size(); changeIndex++)
+    try
     {
-        ProgressBar->setValue(changeIndex);
-
-        try
+        // Changes are grouped by kind and updated column. A change can join an earlier
+        // batch only if it does not depend on the changes of batches opened after it,
+        // otherwise all the open batches are saved first.
+        QList<ChangeBatch> batches;
+        for (int changeIndex = 0; changeIndex < Changes.size(); changeIndex++)
         {
-            struct toResultModelEdit::ChangeSet &change = Changes[changeIndex];
+            struct toResultModelEdit::ChangeSet const &change = Changes.at(changeIndex);
+            int column = change.kind == toResultModelEdit::Update ? change.column : -1;
+            QString key = rowKey(change);
+            // update of a primary key column changes the row identity, it is saved alone
+            bool barrier = change.kind == toResultModelEdit::Update && isPrimaryKey(change.columnName);
+
+            int open = -1;
+            for (int i = 0; i < batches.size() && open < 0; i++)
+                if (batches.at(i).kind == change.kind && batches.at(i).column == column)
+                    open = i;
+
+            bool conflict = barrier;
+            for (int i = open + 1; open >= 0 && i < batches.size() && !conflict; i++)
+            {
+                ChangeBatch const &later = batches.at(i);
+                if ((change.kind == toResultModelEdit::Add && later.kind == toResultModelEdit::Delete)
+                        || (change.kind == toResultModelEdit::Delete && later.kind == toResultModelEdit::Add))
+                    conflict = true;
+                else if (change.kind != toResultModelEdit::Add && later.kind != toResultModelEdit::Add
+                         && change.kind != later.kind)
+                    conflict = later.rows.contains(key);    // update and delete of the same row
+            }
 
-            switch (change.kind)
+            if (conflict)
             {
-                case toResultModelEdit::Delete:
-                    deleted += commitDelete(conn, change);
-                    break;
-                case toResultModelEdit::Add:
-                    added += commitAdd(conn, change);
-                    break;
-                case toResultModelEdit::Update:
-                    updated += commitUpdate(conn, change);
-                    break;
-                default:
-                    Utils::toStatusMessage(tr("Internal error."));
-                    break;
+                commitBatches(conn, batches, saved);
+                open = -1;
             }
+            if (open < 0)
+            {
+                ChangeBatch batch;
+                batch.kind = change.kind;
+                batch.column = column;
+                batches.append(batch);
+                open = batches.size() - 1;
+            }
+            batches[open].changes.append(changeIndex);
+            batches[open].rows.insert(key);
+            if (barrier)
+                commitBatches(conn, batches, saved);
         }
-        catch (const QString &str)
-        {
-            conn->rollback();
-            Utils::toStatusMessage(str);
-            error = true;
-            break;
-        }
+        commitBatches(conn, batches, saved);
+    }
+    catch (const QString &str)
+    {
+        conn->rollback();
+        Logging->appendPlainText("Rollback;");
+        Utils::toStatusMessage(str);
+        error = true;
     }
 
     if (!error)
@@ -451,14 +484,14 @@ bool toResultTableData::commitChanges()
         conn->commit();
         ProgressBar->setValue(Changes.size());
         Changes.clear();
-    }
 
-    Utils::toStatusMessage(tr("Saved %1 changes(updated %2, added %3, deleted %4)")
-                           .arg(Changes.size(), 0, 10)
-                           .arg(updated, 0, 10)
-                           .arg(added, 0, 10)
-                           .arg(deleted, 0, 10)
-                           , false, false);
+        Utils::toStatusMessage(tr("Saved %1 changes(updated %2, added %3, deleted %4)")
+                               .arg(total, 0, 10)
+                               .arg(saved[toResultModelEdit::Update], 0, 10)
+                               .arg(saved[toResultModelEdit::Add], 0, 10)
+                               .arg(saved[toResultModelEdit::Delete], 0, 10)
+                               , false, false);
+    }
 
     return !error;
 }
@@ -623,7 +656,7 @@ unsigned toResultTableData::commitAdd(toConnectionSubLoan &conn, toResultModelEd
 
         // Everything else --> varchar
         {
-            if (Headers[col].datatype.toUpper().contains("LOB"))
+            if (Headers[i].datatype.toUpper().contains("LOB"))
             {
                 sqlValuePlaceHolders += ("empty_clob()");
                 continue;
@@ -681,3 +714,268 @@ unsigned toResultTableData::commitDelete(toConnectionSubLoan &conn, toResultMode
         return q.rowsProcessed();
     }
 }
+
+void toResultTableData::commitBatches(toConnectionSubLoan &conn, QList<ChangeBatch> &batches, unsigned saved[3])
+{
+    foreach (ChangeBatch const &batch, batches)
+        saved[batch.kind] += commitBatch(conn, batch);
+    batches.clear();
+}
+
+unsigned toResultTableData::commitBatch(toConnectionSubLoan &conn, ChangeBatch const &batch)
+{
+    QList<struct toResultModelEdit::ChangeSet>& Changes = Model->changes();
+    unsigned saved = 0;
+
+    if (batch.kind != toResultModelEdit::Add && Model->getPriKeys().empty())
+    {
+        Utils::toStatusMessage(tr("This table has no known primary keys"));
+        ProgressBar->setValue(ProgressBar->value() + batch.changes.size());
+        return 0;
+    }
+
+    if (conn.ParentConnection.getTraits().hasArrayDML())
+    {
+        for (int first = 0; first < batch.changes.size(); first += ARRAY_ROWS)
+        {
+            int count = qMin(ARRAY_ROWS, batch.changes.size() - first);
+            saved += commitArray(conn, batch, first, count);
+            ProgressBar->setValue(ProgressBar->value() + count);
+        }
+        return saved;
+    }
+
+    // the provider does not support bind variables, save changes one by one
+    for (int i = 0; i < batch.changes.size(); i++)
+    {
+        struct toResultModelEdit::ChangeSet &change = Changes[batch.changes.at(i)];
+        try
+        {
+            switch (batch.kind)
+            {
+                case toResultModelEdit::Delete:
+                    saved += commitDelete(conn, change);
+                    break;
+                case toResultModelEdit::Add:
+                    saved += commitAdd(conn, change);
+                    break;
+                case toResultModelEdit::Update:
+                    saved += commitUpdate(conn, change);
+                    break;
+            }
+        }
+        catch (const QString &str)
+        {
+            throw batchError(batch, i, 1, str);
+        }
+        ProgressBar->setValue(ProgressBar->value() + 1);
+    }
+    return saved;
+}
+
+unsigned toResultTableData::commitArray(toConnectionSubLoan &conn, ChangeBatch const &batch, int first, int count)
+{
+    static const QString UPDATE = QString::fromLatin1("UPDATE %1.%2 SET %3 = %4 WHERE %5");
+    static const QString INSERT = QString::fromLatin1("INSERT INTO %1.%2 ( %3 ) VALUES( %4 )");
+    static const QString DELETESTAT = QString::fromLatin1("DELETE FROM %1.%2 WHERE %3");
+    static const QString CONDITION = QString::fromLatin1("%1 = %2");
+    static const QString BIND = QString::fromLatin1(":b%1<char[%2],in[%3]>");
+
+    QList<struct toResultModelEdit::ChangeSet>& Changes = Model->changes();
+    toConnectionTraits const& connTraits = conn.ParentConnection.getTraits();
+    const toResultModel::HeaderList & Headers = Model->headers();
+    int keys = Model->getPriKeys().size();
+
+    struct toResultModelEdit::ChangeSet const &head = Changes.at(batch.changes.at(first));
+
+    // Values of bind variables, one row for each change. For INSERT the LOB columns
+    // get an empty LOB instead of a bind variable.
+    QStringList columns;
+    QStringList values;         // constant or empty for a bind variable
+    QList<int> bound;           // model columns bound (INSERT only)
+    if (batch.kind == toResultModelEdit::Add)
+    {
+        for (int i = 1 + keys; i < head.row.size(); i++)
+        {
+            columns << connTraits.quote(Model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString());
+            QString datatype = Headers[i].datatype.toUpper();
+            if (datatype.contains("BLOB"))
+                values << QString::fromLatin1("empty_blob()");
+            else if (datatype.contains("LOB"))
+                values << QString::fromLatin1("empty_clob()");
+            else
+            {
+                values << QString();
+                bound << i;
+            }
+        }
+    }
+
+    QList<toQueryParams> rows;
+    for (int r = first; r < first + count; r++)
+    {
+        struct toResultModelEdit::ChangeSet const &change = Changes.at(batch.changes.at(r));
+        toQueryParams row;
+        if (batch.kind == toResultModelEdit::Add)
+        {
+            foreach (int i, bound)
+            {
+                toQValue const &val = change.row[i];
+                if (val.isComplexType())
+                    throw batchError(batch, r, 1, tr("This table contains complex/user defined columns "
+                                                     "and can not be edited"));
+                if (val.isBinary())
+                    throw batchError(batch, r, 1, tr("Unsupported datatype(%1)").arg(Headers[i].datatype));
+                row << toQValue(val.editData());
+            }
+        }
+        else
+        {
+            if (batch.kind == toResultModelEdit::Update)
+                row << toQValue(change.newValue.editData());
+            for (int i = 1; i < keys + 1; i++)
+                row << toQValue(change.row[i].editData());
+        }
+        rows << row;
+    }
+
+    // bind variables sized by the longest value, rounded to limit the number of distinct statements
+    QStringList binds;
+    int positions = rows.first().size();
+    for (int c = 0; c < positions; c++)
+    {
+        int length = 32;
+        foreach (toQueryParams const &row, rows)
+        {
+            int size = ((QString) row.at(c)).toUtf8().size();
+            while (length < size)
+                length *= 2;
+        }
+        binds << BIND.arg(c + 1).arg(length).arg(count);
+    }
+
+    QString sql;
+    switch (batch.kind)
+    {
+        case toResultModelEdit::Add:
+        {
+            for (int i = 0, bind = 0; i < values.size(); i++)
+                if (values.at(i).isEmpty())
+                    values[i] = binds.at(bind++);
+            sql = INSERT.arg(connTraits.quote(Owner)).arg(connTraits.quote(Table)).arg(columns.join(", ")).arg(values.join(", "));
+            break;
+        }
+        case toResultModelEdit::Update:
+        case toResultModelEdit::Delete:
+        {
+            // Update binds the new value first
+            int key = batch.kind == toResultModelEdit::Update ? 1 : 0;
+            QStringList conditions;
+            for (int i = 1; i < keys + 1; i++, key++)
+                conditions << CONDITION
+                           .arg(connTraits.quote(Model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString()))
+                           .arg(binds.at(key));
+            if (batch.kind == toResultModelEdit::Update)
+                sql = UPDATE.arg(connTraits.quote(Owner)).arg(connTraits.quote(Table))
+                      .arg(connTraits.quote(head.columnName)).arg(binds.at(0)).arg(conditions.join(" AND "));
+            else
+                sql = DELETESTAT.arg(connTraits.quote(Owner)).arg(connTraits.quote(Table)).arg(conditions.join(" AND "));
+            break;
+        }
+    }
+
+    Logging->appendPlainText(sql + QString::fromLatin1(" -- %1 rows").arg(count));
+
+    unsigned processed = 0;
+    try
+    {
+        if (positions)
+        {
+            toQueryArray q(conn, sql, rows);
+            processed = q.rowsProcessed();
+        }
+        else
+        {
+            // nothing to bind (only LOB columns)
+            for (int r = 0; r < count; r++)
+            {
+                toQuery q(conn, sql, toQueryParams());
+                q.eof();
+                processed += q.rowsProcessed();
+            }
+        }
+    }
+    catch (const toConnection::exception &exc)
+    {
+        // the row of the array which failed is the failing change
+        if (exc.row() >= 0 && exc.row() < count)
+            throw batchError(batch, first + exc.row(), 1, exc);
+        throw batchError(batch, first, count, exc);
+    }
+    catch (const QString &str)
+    {
+        throw batchError(batch, first, count, str);
+    }
+
+    // each change has to match one row by its primary key
+    if (batch.kind != toResultModelEdit::Add && processed > unsigned(count))
+        throw batchError(batch, first, count, tr("%1 rows would be changed by %2 changes").arg(processed).arg(count));
+    return processed;
+}
+
+QString toResultTableData::rowKey(toResultModelEdit::ChangeSet const &change)
+{
+    if (change.kind == toResultModelEdit::Add)
+        return QString::fromLatin1("+%1").arg(change.row[0].getRowDesc().key);
+
+    QStringList key;
+    for (int i = 1; i < Model->getPriKeys().size() + 1 && i < change.row.size(); i++)
+        key << change.row[i].editData();
+    return key.join(QChar(0x1f));
+}
+
+bool toResultTableData::isPrimaryKey(QString const &column)
+{
+    for (int i = 1; i < Model->getPriKeys().size() + 1; i++)
+        if (Model->headerData(i, Qt::Horizontal, Qt::DisplayRole).toString() == column)
+            return true;
+    return false;
+}
+
+QString toResultTableData::batchError(ChangeBatch const &batch, int first, int count, QString const &error)
+{
+    static const int MAX_ROWS = 10;
+
+    QList<struct toResultModelEdit::ChangeSet>& Changes = Model->changes();
+    QStringList rows;
+    for (int i = first; i < first + count && rows.size() < MAX_ROWS; i++)
+    {
+        struct toResultModelEdit::ChangeSet const &change = Changes.at(batch.changes.at(i));
+        if (change.kind == toResultModelEdit::Add)
+            rows << tr("new row %1").arg(change.row[0].getRowDesc().key);
+        else
+            rows << QString::fromLatin1("(%1)").arg(rowKey(change).replace(QChar(0x1f), QString::fromLatin1(", ")));
+    }
+    if (count > MAX_ROWS)
+        rows << QString::fromLatin1("...");
+
+    QString what;
+    switch (batch.kind)
+    {
+        case toResultModelEdit::Add:
+            what = tr("Insert");
+            break;
+        case toResultModelEdit::Delete:
+            what = tr("Delete");
+            break;
+        case toResultModelEdit::Update:
+            what = tr("Update of %1").arg(Changes.at(batch.changes.at(first)).columnName);
+            break;
+    }
+
+    return tr("%1 failed for %2 row(s): %3\n%4")
+           .arg(what)
+           .arg(count)
+           .arg(rows.join(", "))
+           .arg(error);
+}
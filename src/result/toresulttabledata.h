@@ -41,6 +41,7 @@
 
 #include <QWidget>
 #include <QtCore/QMap>
+#include <QtCore/QSet>
 
 class QAction;
 class QCloseEvent;
@@ -113,6 +114,26 @@ class toResultTableData
         unsigned commitAdd(toConnectionSubLoan &conn, toResultModelEdit::ChangeSet &change);
         unsigned commitDelete(toConnectionSubLoan &conn, toResultModelEdit::ChangeSet &change);
 
+        // Changes of the same kind (and updated column) saved by one statement
+        struct ChangeBatch
+        {
+            toResultModelEdit::ChangeKind kind;
+            int column;                 // updated column, -1 for Add and Delete
+            QList<int> changes;         // indexes into Model->changes()
+            QSet<QString> rows;         // rowKey() of the changed rows
+        };
+
+        // Save the batches in order, saved[kind] is increased by the number of processed rows
+        void commitBatches(toConnectionSubLoan &conn, QList<ChangeBatch> &batches, unsigned saved[3]);
+        unsigned commitBatch(toConnectionSubLoan &conn, ChangeBatch const &batch);
+        // Save changes [first, first + count) of the batch by array DML (toQueryArray)
+        unsigned commitArray(toConnectionSubLoan &conn, ChangeBatch const &batch, int first, int count);
+
+        // primary key values of the changed row
+        QString rowKey(toResultModelEdit::ChangeSet const &change);
+        bool isPrimaryKey(QString const &column);
+        QString batchError(ChangeBatch const &batch, int first, int count, QString const &error);
+
         toResultModelEdit* Model;
 
         // toolbar actions
@@ -0,0 +1,181 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "connection/tooraclenumber.h"
+
+#include "trotl.h"
+
+#include <QtCore/QElapsedTimer>
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+/* Microbenchmark of OCINumber decoding
+ * compares OCINumberIsInt + OCINumberToInt/OCINumberToReal (oracleQuery's original path)
+ * with toOracleNumber::decodeColumn. No database connection is needed.
+ *
+ * Also checks toOracleNumber::ColumnCache across fetch chunk boundaries.
+ */
+
+static void usage()
+{
+    printf("Usage:\n\n  test14 [rows] [rounds]\n\n");
+    exit(2);
+}
+
+static void fillChunk(OCIError *errh, std::vector<OCINumber> &chunk, long long first)
+{
+    for (unsigned i = 0; i < chunk.size(); i++)
+    {
+        long long v = first + i;
+        ::trotl::oci_check_error(__TROTL_HERE__, errh, OCINumberFromInt(errh, &v, sizeof(v), OCI_NUMBER_SIGNED, &chunk[i]));
+    }
+}
+
+// Reads rows 1.. of every chunk (row 0 is null, so it is never decoded), like oracleQuery does
+static unsigned checkChunks(OCIError *errh)
+{
+    static const unsigned sizes[] = { 8, 4, 4, 8 };
+    toOracleNumber::ColumnCache cache;
+    std::vector<OCINumber> chunk;
+    unsigned failed = 0;
+    for (unsigned generation = 1; generation <= sizeof(sizes) / sizeof(sizes[0]); generation++)
+    {
+        chunk.resize(sizes[generation - 1]);
+        fillChunk(errh, chunk, generation * 100);
+        for (unsigned row = 1; row < chunk.size(); row++)
+        {
+            toOracleNumber::Cell const &cell = cache.at(generation, row, (unsigned char const*)&chunk[0], sizeof(OCINumber), chunk.size());
+            if (cell.Type != toOracleNumber::Integer || cell.Int != (qint64)(generation * 100 + row))
+            {
+                printf("chunk %u row %u: stale value\n", generation, row);
+                failed++;
+            }
+        }
+    }
+    return failed;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 3)
+        usage();
+    unsigned rows = argc > 1 ? atoi(argv[1]) : 100000;
+    unsigned rounds = argc > 2 ? atoi(argv[2]) : 10;
+    if (rows == 0 || rounds == 0)
+        usage();
+
+    ::trotl::OciEnvAlloc envalloc;
+    ::trotl::OciEnv env(envalloc);
+    OCIError *errh = env._errh;
+
+    // define buffer like column: integers, prices with two decimal places and a few big numbers
+    std::vector<OCINumber> buffer(rows);
+    for (unsigned i = 0; i < rows; i++)
+    {
+        sword res;
+        switch (i % 4)
+        {
+            case 0:
+            case 1:
+                {
+                    long long v = (long long)i * 7919 - 1000000;
+                    res = OCINumberFromInt(errh, &v, sizeof(v), OCI_NUMBER_SIGNED, &buffer[i]);
+                }
+                break;
+            case 2:
+                {
+                    char text[32];
+                    ub4 len = sprintf(text, "%u.%02u", i, i % 100);
+                    res = OCINumberFromText(errh, (oratext*)text, len, (oratext*)"99999999999D99", 14, NULL, 0, &buffer[i]);
+                }
+                break;
+            default:
+                {
+                    double v = i / 3.0;
+                    res = OCINumberFromReal(errh, &v, sizeof(v), &buffer[i]);
+                }
+                break;
+        }
+        ::trotl::oci_check_error(__TROTL_HERE__, errh, res);
+    }
+
+    std::vector<long long> ints(rows);
+    std::vector<double> reals(rows);
+    QElapsedTimer timer;
+
+    timer.start();
+    for (unsigned r = 0; r < rounds; r++)
+        for (unsigned i = 0; i < rows; i++)
+        {
+            boolean isint;
+            OCINumberIsInt(errh, &buffer[i], &isint);
+            if (isint)
+                OCINumberToInt(errh, &buffer[i], sizeof(long long), OCI_NUMBER_SIGNED, &ints[i]);
+            else
+                OCINumberToReal(errh, &buffer[i], sizeof(double), &reals[i]);
+        }
+    qint64 ociTime = timer.elapsed();
+
+    std::vector<toOracleNumber::Cell> cells(rows);
+    timer.start();
+    for (unsigned r = 0; r < rounds; r++)
+        toOracleNumber::decodeColumn((unsigned char const*)&buffer[0], sizeof(OCINumber), rows, &cells[0]);
+    qint64 nativeTime = timer.elapsed();
+
+    unsigned mismatch = 0, fallback = 0;
+    for (unsigned i = 0; i < rows; i++)
+    {
+        switch (cells[i].Type)
+        {
+            case toOracleNumber::Integer:
+                mismatch += cells[i].Int != ints[i];
+                break;
+            case toOracleNumber::Real:
+                mismatch += cells[i].Real != reals[i];
+                break;
+            default:
+                fallback++;
+        }
+    }
+
+    printf("rows: %u rounds: %u\n", rows, rounds);
+    printf("OCI:    %lld ms\n", (long long)ociTime);
+    printf("native: %lld ms (%u left to OCI, %u differ)\n", (long long)nativeTime, fallback, mismatch);
+
+    unsigned stale = checkChunks(errh);
+    printf("chunk boundaries: %u stale\n", stale);
+    return mismatch || stale ? 1 : 0;
+}
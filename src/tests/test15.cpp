@@ -0,0 +1,305 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/tocache.h"
+#include "core/toconnection.h"
+#include "core/toconnectionprovider.h"
+#include "core/toconnectionsub.h"
+#include "core/toconnectiontraits.h"
+#include "core/persistenttrie.h"
+#include "connection/absfact.h"
+
+#include <QApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QReadWriteLock>
+#include <QtCore/QStringList>
+
+#include <cstdio>
+#include <cstdlib>
+
+/* Benchmark of toCache object cache fill, no database connection is needed.
+ * A synthetic catalogue is loaded per object like toCache::upsertEntry did before
+ * (write lock, entry map and QmlJS::PersistentTrie inserts per object), per object
+ * through the current toCache::upsertEntry and by toCache::BulkLoad.
+ * The toCache belongs to a connection of the stub provider below, its sessions
+ * never run any query.
+ */
+
+#define TEST15_PROVIDER "test15"
+
+class test15Sub : public toConnectionSub
+{
+    public:
+        virtual void close(void) {}
+        virtual void commit(void) {}
+        virtual void rollback(void) {}
+        virtual QString version()
+        {
+            return QString::fromLatin1("0000");
+        }
+        virtual toQueryParams sessionId()
+        {
+            return toQueryParams();
+        }
+        virtual queryImpl* createQuery(toQueryAbstr *)
+        {
+            throw QString::fromLatin1("test15: no queries on the stub connection");
+        }
+        virtual toQAdditionalDescriptions* decribe(toCache::ObjectRef const&)
+        {
+            return NULL;
+        }
+};
+
+class test15ConnectionImpl : public toConnection::connectionImpl
+{
+    public:
+        test15ConnectionImpl(toConnection &conn) : toConnection::connectionImpl(conn) {}
+        virtual toConnectionSub* createConnection(void)
+        {
+            return new test15Sub();
+        }
+        virtual void closeConnection(toConnectionSub *) {}
+};
+
+class test15Traits : public toConnectionTraits
+{
+    public:
+        virtual QString quote(const QString &name) const
+        {
+            return name;
+        }
+        virtual QString unQuote(const QString &name) const
+        {
+            return name;
+        }
+        virtual QString schemaSwitchSQL(QString const&) const
+        {
+            return QString();
+        }
+        virtual bool hasTableComments() const
+        {
+            return false;
+        }
+        virtual bool hasAsyncBreak() const
+        {
+            return false;
+        }
+};
+
+class test15Provider : public toConnectionProvider
+{
+    public:
+        test15Provider(toConnectionProviderFinder::ConnectionProvirerParams const& p) : toConnectionProvider(p) {}
+        virtual bool initialize()
+        {
+            return true;
+        }
+        virtual QString const& name() const
+        {
+            return m_name;
+        }
+        virtual QString const& displayName() const
+        {
+            return m_name;
+        }
+        virtual QList<QString> hosts() const
+        {
+            return QList<QString>();
+        }
+        virtual QList<QString> databases(const QString &, const QString &, const QString &) const
+        {
+            return QList<QString>();
+        }
+        virtual QList<QString> options() const
+        {
+            return QList<QString>();
+        }
+        virtual QWidget *configurationTab(QWidget *)
+        {
+            return NULL;
+        }
+        virtual toConnection::connectionImpl* createConnectionImpl(toConnection &con)
+        {
+            return new test15ConnectionImpl(con);
+        }
+        virtual toConnectionTraits* createConnectionTrait(void)
+        {
+            static test15Traits *t = new test15Traits();
+            return t;
+        }
+    private:
+        static QString m_name;
+};
+
+QString test15Provider::m_name = TEST15_PROVIDER;
+
+class test15Finder : public toConnectionProviderFinder
+{
+    public:
+        inline test15Finder(unsigned int i) : toConnectionProviderFinder(i) {}
+        virtual QString name() const
+        {
+            return QString::fromLatin1(TEST15_PROVIDER);
+        }
+        virtual QList<ConnectionProvirerParams> find()
+        {
+            return QList<ConnectionProvirerParams>();
+        }
+        virtual void load(ConnectionProvirerParams const&) {}
+};
+
+Util::RegisterInFactory<test15Provider, ConnectionProvirerFactory> regTest15Provider(TEST15_PROVIDER);
+Util::RegisterInFactory<test15Finder, ConnectionProviderFinderFactory> regTest15Finder(TEST15_PROVIDER);
+
+static void usage()
+{
+    printf("Usage:\n\n  test15 [objects] [schemas]\n\n");
+    exit(2);
+}
+
+static const char *types[] = { "TABLE", "VIEW", "SYNONYM", "INDEX", "PACKAGE", "PACKAGE BODY", "FUNCTION", "SEQUENCE" };
+
+static QList<toCache::CacheEntry*> catalogue(unsigned objects, unsigned schemas, unsigned first, unsigned count)
+{
+    QList<toCache::CacheEntry*> retval;
+    for (unsigned i = first; i < first + count && i < objects; i++)
+    {
+        QString owner = QString("SCHEMA_%1").arg(i % schemas, 4, 10, QChar('0'));
+        QString name = QString("OBJ_%1_%2").arg(types[i % 8]).arg(i / 8, 7, 10, QChar('0')).replace(' ', '_');
+        retval.append(toCache::createCacheEntry(owner, name, QString(types[i % 8]), QString()));
+    }
+    return retval;
+}
+
+// toCache::upsertEntry before the completion index: one write lock, entry map and trie inserts per object
+static qint64 baselineUpsert(QList<toCache::CacheEntry*> const& rows)
+{
+    QReadWriteLock lock;
+    QMap<toCache::ObjectRef, toCache::CacheEntry const*> entryMap;
+    QmlJS::PersistentTrie::Trie trie;
+    QMap<QString, QmlJS::PersistentTrie::Trie> schemaTrie;
+
+    QElapsedTimer timer;
+    timer.start();
+    Q_FOREACH(toCache::CacheEntry * e, rows)
+    {
+        QWriteLocker locker(&lock);
+        switch (e->type)
+        {
+            case toCache::SYNONYM:
+            case toCache::TABLE:
+            case toCache::VIEW:
+                trie.insert(e->name.second);
+                schemaTrie[e->name.first].insert(e->name.second);
+                break;
+            default:
+                break;
+        }
+        delete entryMap.value(e->name, NULL);
+        entryMap.insert(e->name, e);
+    }
+    qint64 retval = timer.elapsed();
+    qDeleteAll(entryMap);
+    return retval;
+}
+
+int main(int argc, char **argv)
+{
+    QApplication app(argc, argv);
+    if (argc > 3)
+        usage();
+    unsigned objects = argc > 1 ? atoi(argv[1]) : 500000;
+    unsigned schemas = argc > 2 ? atoi(argv[2]) : 200;
+    if (objects == 0 || schemas == 0)
+        usage();
+
+    const unsigned batchRows = 4096;
+    QElapsedTimer timer;
+
+    toConnectionProviderFinder::ConnectionProvirerParams params;
+    params.insert("KEY", TEST15_PROVIDER);
+    params.insert("PROVIDER", TEST15_PROVIDER);
+    try
+    {
+        toConnectionProviderRegistrySing::Instance().load(params);
+    }
+    catch (QString const& e)
+    {
+        printf("%s\n", qPrintable(e));
+        return 1;
+    }
+
+    // Baseline: per object inserts into the tries
+    qint64 baselineTime = baselineUpsert(catalogue(objects, schemas, 0, objects));
+
+    // toCache::upsertEntry, one write lock per object, names are merged into the completion
+    // indexes by the first completion of every schema (timed too)
+    qint64 perObjectTime;
+    {
+        toConnection conn(TEST15_PROVIDER, "", "", "", "", "", "", QSet<QString>() << "TEST");
+        toCache cache(conn, TEST15_PROVIDER);
+        QList<toCache::CacheEntry*> rows = catalogue(objects, schemas, 0, objects);
+        timer.start();
+        Q_FOREACH(toCache::CacheEntry * e, rows)
+            cache.upsertEntry(e); // the cache owns the entries
+        for (unsigned i = 0; i < schemas; i++)
+            cache.completeEntry(QString("SCHEMA_%1").arg(i, 4, 10, QChar('0')), "OBJ_TABLE");
+        perObjectTime = timer.elapsed();
+    }
+
+    // Bulk path: batches added off-lock, completion indexes built once by finish()
+    qint64 bulkTime, finishTime;
+    int loaded;
+    toCache::BulkLoad image;
+    {
+        QList<QList<toCache::CacheEntry*> > batches;
+        for (unsigned first = 0; first < objects; first += batchRows)
+            batches.append(catalogue(objects, schemas, first, batchRows));
+        timer.start();
+        Q_FOREACH(QList<toCache::CacheEntry*> const& batch, batches)
+            image.add(batch);
+        bulkTime = timer.elapsed();
+        timer.start();
+        image.finish();
+        finishTime = timer.elapsed();
+        loaded = image.size();
+    }
+
+    printf("objects: %u schemas: %u\n", objects, schemas);
+    printf("baseline:   %lld ms (per object, tries)\n", (long long)baselineTime);
+    printf("per object: %lld ms (upsertEntry and first completion)\n", (long long)perObjectTime);
+    printf("bulk:       %lld ms (add %lld ms, completion %lld ms)\n", (long long)(bulkTime + finishTime), (long long)bulkTime, (long long)finishTime);
+    return loaded == (int)objects ? 0 : 1;
+}
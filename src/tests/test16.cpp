@@ -0,0 +1,156 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "core/tocompletionindex.h"
+#include "core/persistenttrie.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QStringList>
+
+#include <cstdio>
+#include <cstdlib>
+
+/* Benchmark of code completion over a synthetic catalogue, no database connection is needed.
+ * Compares QmlJS::PersistentTrie (used by toCache before) with toCompletionIndex:
+ * build time, case insensitive prefix completion and subsequence matching.
+ * Exits with non-zero status if prefix completions of both differ.
+ */
+
+static void usage()
+{
+    printf("Usage:\n\n  test16 [names] [queries]\n\n");
+    exit(2);
+}
+
+static const char *words[] = { "CUSTOMER", "ORDER", "LINE", "ITEM", "PRODUCT", "PRICE", "ACCOUNT", "LEDGER",
+                               "INVOICE", "PAYMENT", "ADDRESS", "CONTACT", "STOCK", "WAREHOUSE", "SHIPMENT", "AUDIT"
+                             };
+
+static QStringList catalogue(unsigned count)
+{
+    QStringList retval;
+    srand(42);
+    for (unsigned i = 0; i < count; i++)
+    {
+        QString name(words[rand() % 16]);
+        name += '_';
+        name += words[rand() % 16];
+        if (i % 3 == 0)
+            name = name.toLower(); // mixed case, quoted identifiers
+        retval.append(QString("%1_%2").arg(name).arg(i, 6, 10, QChar('0')));
+    }
+    return retval;
+}
+
+static QStringList queries(unsigned count, int len)
+{
+    QStringList retval;
+    for (unsigned i = 0; i < count; i++)
+    {
+        QString q(words[rand() % 16]);
+        retval.append(q.left(1 + rand() % len).toLower());
+    }
+    return retval;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc > 3)
+        usage();
+    unsigned count = argc > 1 ? atoi(argv[1]) : 500000;
+    unsigned queryCount = argc > 2 ? atoi(argv[2]) : 200;
+    if (count == 0 || queryCount == 0)
+        usage();
+
+    using namespace QmlJS::PersistentTrie;
+    QStringList names = catalogue(count);
+    QStringList prefixes = queries(queryCount, 8);
+    QElapsedTimer timer;
+
+    timer.start();
+    Trie trie;
+    {
+        QStringList sorted(names);
+        sorted.sort();
+        Q_FOREACH(QString const& name, sorted)
+            trie.insert(name);
+    }
+    qint64 trieBuild = timer.elapsed();
+
+    timer.start();
+    toCompletionIndex index(names);
+    qint64 indexBuild = timer.elapsed();
+
+    int mismatches = 0;
+    qint64 triePrefix = 0, indexPrefix = 0;
+    Q_FOREACH(QString const& prefix, prefixes)
+    {
+        timer.start();
+        QStringList t = trie.complete(prefix, "S.", LookupFlags(CaseInsensitive));
+        triePrefix += timer.elapsed();
+
+        timer.start();
+        QStringList i = index.complete(prefix, "S.");
+        indexPrefix += timer.elapsed();
+
+        t.sort();
+        i.sort();
+        if (t != i)
+            mismatches++;
+    }
+
+    // Subsequence: trie skips characters and results are ranked by matchStrengthSort
+    QStringList patterns;
+    Q_FOREACH(QString const& prefix, prefixes.mid(0, 20))
+        patterns.append(prefix.left(2) + "ln");
+    qint64 trieFuzzy = 0, indexFuzzy = 0;
+    Q_FOREACH(QString const& pattern, patterns)
+    {
+        timer.start();
+        QStringList t = trie.complete(pattern, QString(), LookupFlags(CaseInsensitive | SkipChars));
+        matchStrengthSort(pattern, t);
+        trieFuzzy += timer.elapsed();
+
+        timer.start();
+        QStringList i = index.match(pattern, QString(), 100);
+        indexFuzzy += timer.elapsed();
+    }
+
+    printf("names: %u prefix queries: %d subsequence queries: %d\n", count, prefixes.size(), patterns.size());
+    printf("build:       trie %lld ms, index %lld ms\n", (long long)trieBuild, (long long)indexBuild);
+    printf("prefix:      trie %lld ms, index %lld ms\n", (long long)triePrefix, (long long)indexPrefix);
+    printf("subsequence: trie %lld ms, index %lld ms (top 100)\n", (long long)trieFuzzy, (long long)indexFuzzy);
+    printf("prefix mismatches: %d\n", mismatches);
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,158 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+#include "parsing/tsqllexer.h"
+#include "parsing/tsqlparse.h"
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QFile>
+#include <QtCore/QStringList>
+
+#include <sys/resource.h>
+
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <vector>
+
+/* Measures the lexer and the parser on the sql files from src/tests (or on files given as arguments):
+ * time needed to lex (OracleGuiLexer) and to parse (OracleDML) each file and the peak memory (RSS)
+ * used while parse trees for all the files are held in memory.
+ */
+
+static void usage()
+{
+    printf("Usage:\n\n  test18 [-n iterations] [-k statements kept] [file.sql ...]\n\n");
+    exit(2);
+}
+
+static QString readFile(QString const& name)
+{
+    QFile f(name);
+    if (!f.open(QIODevice::ReadOnly))
+    {
+        printf("Can not open: %s\n", qPrintable(name));
+        exit(2);
+    }
+    return QString::fromUtf8(f.readAll());
+}
+
+// peak resident set size in kB
+static long maxRSS()
+{
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    return usage.ru_maxrss;
+}
+
+static std::unique_ptr<SQLParser::Statement> parse(QString const& text)
+{
+    try
+    {
+        return StatementFactTwoParmSing::Instance().create("OracleDML", text, "test18");
+    }
+    catch (...) // ParseException, ANTLR errors
+    {
+        return std::unique_ptr<SQLParser::Statement>();
+    }
+}
+
+int main(int argc, char **argv)
+{
+    QStringList files;
+    int iterations = 20, kept = 50;
+    for (int a = 1; a < argc; a++)
+    {
+        if (QString(argv[a]) == "-n" && a + 1 < argc)
+            iterations = atoi(argv[++a]);
+        else if (QString(argv[a]) == "-k" && a + 1 < argc)
+            kept = atoi(argv[++a]);
+        else if (argv[a][0] == '-')
+            usage();
+        else
+            files.append(argv[a]);
+    }
+    if (iterations <= 0 || kept <= 0)
+        usage();
+    if (files.isEmpty())
+        files << ":/complex05.sql" << ":/complex05-new.sql" << ":/condition02.sql" << ":/new.sql" << ":/old.sql" << ":/test13.sql";
+
+    QList<QString> texts;
+    Q_FOREACH(QString const& name, files)
+        texts.append(readFile(name));
+
+    // OracleDMLStatement traces aliases onto std::cout, keep it quiet while measuring
+    std::streambuf *coutBuf = std::cout.rdbuf(NULL);
+
+    std::unique_ptr <SQLLexer::Lexer> lexer = LexerFactTwoParmSing::Instance().create("OracleGuiLexer", "", "test18");
+    QElapsedTimer timer;
+    printf("%-24s %10s %10s %12s %12s\n", "file", "bytes", "tokens", "lexer us", "parser us");
+    for (int f = 0; f < files.size(); f++)
+    {
+        QString const& text = texts.at(f);
+        unsigned tokens = 0;
+        timer.start();
+        for (int n = 0; n < iterations; n++)
+        {
+            lexer->setStatement(text);
+            for (SQLLexer::Lexer::token_const_iterator i = lexer->begin(); i != lexer->end(); ++i)
+                tokens++;
+        }
+        qint64 lexerTime = timer.nsecsElapsed();
+
+        bool parsed = true;
+        timer.start();
+        for (int n = 0; n < iterations; n++)
+            parsed = parse(text) != nullptr;
+        qint64 parserTime = timer.nsecsElapsed();
+
+        printf("%-24s %10d %10u %12lld %12s\n", qPrintable(files.at(f)), text.toUtf8().size(), tokens / iterations
+               , (long long)(lexerTime / 1000 / iterations)
+               , parsed ? qPrintable(QString::number(parserTime / 1000 / iterations)) : "failed");
+    }
+
+    // Keep parse trees of all the files in memory
+    long rssBefore = maxRSS();
+    std::vector<std::unique_ptr<SQLParser::Statement> > statements;
+    for (int n = 0; n < kept; n++)
+        Q_FOREACH(QString const& text, texts)
+            statements.push_back(parse(text));
+    long rssAfter = maxRSS();
+    statements.clear();
+
+    std::cout.rdbuf(coutBuf);
+    printf("peak RSS: %ld kB, %ld kB for %d copies of parse trees (%ld kB per copy)\n", rssAfter, rssAfter - rssBefore, kept
+           , (rssAfter - rssBefore) / kept);
+    return 0;
+}
@@ -45,6 +45,7 @@
 #include "core/tologger.h"
 #include "core/toquery.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
 #include "core/toraversion.h"
 #include "widgets/tosplash.h"
 #include "core/tosql.h"
@@ -92,6 +93,7 @@ int main(int argc, char **argv)
 
         qRegisterMetaType<toQColumnDescriptionList>("toQColumnDescriptionList&");
         qRegisterMetaType<ValuesList>("ValuesList&");
+        qRegisterMetaType<toQueryBatchPtr>("toQueryBatchPtr");
         qRegisterMetaType<toConnection::exception>("toConnection::exception");
 
         if (argc == 1)
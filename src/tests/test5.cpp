@@ -40,6 +40,7 @@
 #include "core/tologger.h"
 #include "core/tooracleconst.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
 #include "widgets/tosplash.h"
 #include "core/utils.h"
 #include "core/toconfiguration.h"
@@ -66,6 +67,7 @@ int main(int argc, char **argv)
 
     qRegisterMetaType<toQColumnDescriptionList>("toQColumnDescriptionList&");
     qRegisterMetaType<ValuesList>("ValuesList&");
+    qRegisterMetaType<toQueryBatchPtr>("toQueryBatchPtr");
     qRegisterMetaType<toConnection::exception>("toConnection::exception");
 
     try
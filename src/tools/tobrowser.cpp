@@ -373,11 +373,11 @@ class toBrowserFilter
 //                     item->text(2));
 //    }
 
-        virtual bool check(const toResultModel *model, const int row)
+        virtual bool check(toResultStore::Snapshot::Cursor const &row)
         {
-            return check(model->data(row, 1).toString(),
-                         model->data(row, 2).toString(),
-                         model->data(row, 3).toString());
+            return check(row.columns() > 0 ? row.text(0) : QString(),
+                         row.columns() > 1 ? row.text(1) : QString(),
+                         row.columns() > 2 ? row.text(2) : QString());
         }
 
         bool check(QString one, QString two, QString three)
@@ -74,6 +74,7 @@ void toResultLine::query(const QString &sql, const toQueryParams &param)
         Query = new toEventQuery(this, connection(), sql, param, toEventQuery::READ_ALL);
         connect(Query, SIGNAL(dataAvailable(toEventQuery*)), this, SLOT(poll()));
         connect(Query, SIGNAL(done(toEventQuery*, unsigned long)), this, SLOT(queryDone()));
+        Query->setPriority(toEventQuery::PRIORITY_BACKGROUND);
         Query->start();
     }
     TOCATCH
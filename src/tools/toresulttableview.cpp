@@ -35,6 +35,7 @@
 #include "tools/toresulttableview.h"
 
 #include "widgets/toresultmodel.h"
+#include "widgets/toresultfilter.h"
 #include "core/toeventquery.h"
 #include "core/utils.h"
 #include "core/toconfiguration.h"
@@ -43,6 +44,7 @@
 #include "core/tomainwindow.h"
 #include "widgets/toresultlistformat.h"
 #include "core/tolistviewformatter.h"
+#include "core/tolistviewexport.h"
 #include "core/tolistviewformatterfactory.h"
 #include "core/tolistviewformatteridentifier.h"
 #include "widgets/toworkingwidget.h"
@@ -50,6 +52,8 @@
 #include "core/todatabaseconfig.h"
 #include "core/tocontextmenu.h"
 
+#include <QtCore/QEventLoop>
+#include <QtCore/QFile>
 #include <QtCore/QSize>
 #include <QtCore/QTimer>
 #include <QtCore/QtDebug>
@@ -108,12 +112,17 @@ void toResultTableView::setup(bool readable, bool numberColumn, bool editable)
     Statistics      = NULL;
     ReadAll         = false;
     Filter          = NULL;
+    FilterRegExp    = false;
+    FilterCaseSensitivity = Qt::CaseInsensitive;
     VisibleColumns  = 0;
     ReadableColumns = readable;
     NumberColumn    = numberColumn;
     ColumnsResized  = false;
     Ready           = false;
     Finished        = false;
+    QueryPriority   = toEventQuery::PRIORITY_NORMAL;
+
+    TextFilter = new toResultFilter(this);
 
     Working = new toWorkingWidget(this);
     connect(Working, SIGNAL(stop()), this, SLOT(slotStop()));
@@ -206,6 +215,7 @@ void toResultTableView::query(const QString &sql, toQueryParams const& param)
                 this,
                 SLOT(slotHandleFirst(const toConnection::exception &, bool)));
         setSortingEnabled(true);
+        query->setPriority(QueryPriority);
         query->start();
     }
     catch (const toConnection::exception &str)
@@ -271,6 +281,7 @@ void toResultTableView::querySub(QSharedPointer<toConnectionSubLoan> &con, const
                 this,
                 SLOT(slotHandleFirst(const toConnection::exception &, bool)));
         setSortingEnabled(true);
+        query->setPriority(QueryPriority);
         query->start();
     }
     catch (const toConnection::exception &str)
@@ -339,20 +350,27 @@ void toResultTableView::clearData()
 
 void toResultTableView::applyFilter()
 {
-    if (!Filter || !Model)
+    if (!Model)
         return;
 
-    Filter->startingQuery();
-
-    setUpdatesEnabled(false);
-    for (int row = 0; row < Model->rowCount(); row++)
+    if (!FilterText.isEmpty() || !Filter)
     {
-        if (!Filter->check(Model, row))
-            hideRow(row);
-        else
-            showRow(row);
+        TextFilter->apply(Model, FilterText, FilterRegExp, FilterCaseSensitivity);
+        return;
     }
-    setUpdatesEnabled(true);
+
+    // the view filter runs in the same background job as the text one, on its own copy
+    TextFilter->apply(Model, Filter->clone());
+}
+
+void toResultTableView::setTextFilter(QString const &text,
+                                      bool regExp,
+                                      Qt::CaseSensitivity cs)
+{
+    FilterText = text;
+    FilterRegExp = regExp;
+    FilterCaseSensitivity = cs;
+    applyFilter();
 }
 
 
@@ -678,6 +696,64 @@ QModelIndex toResultTableView::selectedIndex(int col)
 
 
 QString toResultTableView::exportAsText(toExportSettings settings)
+{
+    prepareExport(settings);
+
+    std::unique_ptr<toListViewFormatter> pFormatter(toListViewFormatterFactory::Instance().CreateObject(settings.type));
+    // TODO WTF? Owner and Table are now defined in the sub-class toResultTableViewEdit
+    //    settings.owner = Owner;
+    //    settings.objectName = Table;
+    return pFormatter->getFormattedString(settings, model());
+}
+
+bool toResultTableView::exportToFile(toExportSettings settings, QString const &filename)
+{
+    prepareExport(settings);
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly))
+        throw tr("Couldn't open %1 for writing").arg(filename);
+
+    toListViewExport exporter(toListViewFormatterFactory::Instance().CreateObject(settings.type),
+                              settings,
+                              model(),
+                              &file);
+
+    QProgressDialog progress(tr("Exporting data..."), tr("Abort"), 0, 0, parentWidget());
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    connect(&exporter, SIGNAL(progress(int, int)), &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()), &exporter, SLOT(cancel()));
+
+    QEventLoop loop;
+    connect(&exporter, SIGNAL(finished(bool)), &loop, SLOT(quit()));
+
+    // the model must not change until all the rows are written
+    setEnabled(false);
+    exporter.start();
+    progress.setMaximum(exporter.total());
+    if (exporter.running())
+        loop.exec();
+    setEnabled(true);
+    // reset() clears the cancel flag
+    bool canceled = progress.wasCanceled();
+    progress.reset();
+    file.close();
+
+    if (canceled || !exporter.errorString().isEmpty())
+    {
+        // do not leave a truncated file behind
+        file.remove();
+        if (canceled)
+            return false;
+        throw exporter.errorString();
+    }
+
+    Utils::toStatusMessage(tr("File saved successfully"), false, false);
+    return true;
+}
+
+void toResultTableView::prepareExport(toExportSettings &settings)
 {
     if (settings.requireSelection())
         settings.selected = selectedIndexes();
@@ -706,12 +782,6 @@ QString toResultTableView::exportAsText(toExportSettings settings)
         this->setEnabled(true);
         progress.setValue(2);
     }
-
-    std::unique_ptr<toListViewFormatter> pFormatter(toListViewFormatterFactory::Instance().CreateObject(settings.type));
-    // TODO WTF? Owner and Table are now defined in the sub-class toResultTableViewEdit
-    //    settings.owner = Owner;
-    //    settings.objectName = Table;
-    return pFormatter->getFormattedString(settings, model());
 }
 
 // ---------------------------------------- overrides toEditWidget
@@ -730,7 +800,7 @@ bool toResultTableView::editSave(bool askfile)
         if (filename.isEmpty())
             return false;
 
-        return Utils::toWriteFile(filename, exportAsText(settings));
+        return exportToFile(settings, Utils::toExpandFile(filename));
     }
     TOCATCH;
 
@@ -750,7 +820,7 @@ void toResultTableView::editCopy()
         md->setText(exportAsText(settings));
         md->setData("application/x-tora", QByteArray(Utils::ptr2str(this).c_str())); // store pointer to self in clipboard see tobindvar.cpp insertFromMimeData
 #ifdef Q_OS_WIN32
-        std::unique_ptr<toListViewFormatter> pFormatter(toListViewFormatterFactory::Instance().CreateObject(toListViewFormatterIdentifier::XLSX));
+        std::unique_ptr<toListViewFormatter> pFormatter(toListViewFormatterFactory::Instance().CreateObject(toListViewFormatterIdentifier::XML_SPREADSHEET));
         md->setData("XML Spreadsheet", pFormatter->getFormattedString(settings, model()).toUtf8());
 #endif
         clip->setMimeData(md, QClipboard::Clipboard);
@@ -39,7 +39,9 @@
 #include "core/toresult.h"
 #include "core/utils.h"
 #include "core/toconnection.h"
+#include "core/toeventquery.h"
 #include "widgets/toresultmodel.h"
+#include "widgets/toresultfilter.h"
 #include "core/toeditwidget.h"
 
 #include <QtCore/QAbstractTableModel>
@@ -123,6 +125,14 @@ class toResultTableView : public QTableView, public toResult, public toEditWidge
         bool running(void);
 
 
+        /**
+         * Priority of queries started by this view (see @ref toEventQueryPool)
+         */
+        void setQueryPriority(toEventQuery::PRIORITY p)
+        {
+            QueryPriority = p;
+        }
+
         /**
          * Enable or disable vertical header
          */
@@ -141,10 +151,20 @@ class toResultTableView : public QTableView, public toResult, public toEditWidge
         }
 
         /**
-         * apply Filter to row visibility
+         * apply Filter (or the text filter) to row visibility.
+         * Visible rows are computed first and then swapped into the model at once.
          */
         void applyFilter(void);
 
+        /**
+         * Show only the rows containing text (or matching regular expression) in any column.
+         * Rows are matched in a background thread, an empty text removes the filter.
+         * The text filter takes precedence over the filter set by setFilter().
+         */
+        void setTextFilter(QString const &text,
+                           bool regExp = false,
+                           Qt::CaseSensitivity cs = Qt::CaseInsensitive);
+
         /**
          * Sets the model for the view to present.
          *
@@ -179,6 +199,14 @@ class toResultTableView : public QTableView, public toResult, public toEditWidge
          * Export list as a string.
          */
         QString exportAsText(toExportSettings settings);
+
+        /**
+         * Export list into a file. Rows are written by a background thread
+         * as they are read from the model, progress dialog allows to cancel the export.
+         * Throws QString on error.
+         * @return false if the export was cancelled
+         */
+        bool exportToFile(toExportSettings settings, QString const &filename);
         // ----- overrides toEditWidget
         /**
          * Perform a save on this widget.
@@ -294,6 +322,11 @@ class toResultTableView : public QTableView, public toResult, public toEditWidge
         virtual void slotApplyColumnRules(void);
 
     protected:
+        /**
+         * Fill in the selection and fetch all the rows if needed before export.
+         */
+        void prepareExport(toExportSettings &settings);
+
         //! \reimp
         void focusInEvent(QFocusEvent *e) override;
 
@@ -370,6 +403,12 @@ class toResultTableView : public QTableView, public toResult, public toEditWidge
         // filter object if set
         toViewFilter *Filter;
 
+        // background text filter, see setTextFilter()
+        toResultFilter *TextFilter;
+        QString FilterText;
+        bool FilterRegExp;
+        Qt::CaseSensitivity FilterCaseSensitivity;
+
         // superimposed until model is ready
         toWorkingWidget *Working;
 
@@ -380,6 +419,9 @@ class toResultTableView : public QTableView, public toResult, public toEditWidge
         // helps work around determining when query.eof has been reached.
         bool Finished;
 
+        // priority of toEventQuery(s) started by this view
+        toEventQuery::PRIORITY QueryPriority;
+
         /**
          * context menu items. may be null
          */
@@ -473,8 +515,10 @@ class toTableViewIterator
  * Baseclass for filters to apply to the view to hide out rows that
  * you don't want.
  *
+ * A clone of the filter is run by @ref toResultFilter on a worker thread,
+ * check() must not touch any widget or model.
  */
-class toViewFilter
+class toViewFilter : public toResultFilter::RowCheck
 {
 
     public:
@@ -494,11 +538,10 @@ class toViewFilter
          *  This function can inspect the item to be added and decide if
          *  it is valid for adding or not.
          *
-         * @param model toResultModel for fetching data.
-         * @param row to inspect.
+         * @param row to inspect, cells are numbered from 0 without the row number column.
          * @return If false is returned the item isn't added.
          */
-        virtual bool check(const toResultModel *model, const int row) = 0;
+        virtual bool check(toResultStore::Snapshot::Cursor const &row) = 0;
 
         /**
          * Create a copy of this filter.
@@ -37,6 +37,7 @@
 #include "core/utils.h"
 #include "core/tolistviewformatter.h"
 #include "core/tolistviewformatterfactory.h"
+#include "core/tolistviewformatteridentifier.h"
 #include "editor/tomemoeditor.h"
 #include "widgets/toresultlistformat.h"
 #include "core/toconfiguration.h"
@@ -45,6 +46,8 @@
 #include "core/toconfiguration.h"
 #include "core/toeditorconfiguration.h"
 
+#include <QtCore/QFile>
+#include <QtCore/QTextStream>
 #include <QtCore/QTimer>
 #include <QtCore/QMimeData>
 #include <QtGui/QClipboard>
@@ -962,9 +965,26 @@ bool toListView::editSave(bool)
         QString filename = Utils::toSaveFilename(QString::null, settings.extension, this);
         if (filename.isEmpty())
             return false;
+        if (settings.type != toListViewFormatterIdentifier::XLSX)
+            return Utils::toWriteFile(filename, exportAsText(settings));
+
+        // the workbook is a zip archive, it is written into the file directly
+        QFile file(filename);
+        if (!file.open(QIODevice::WriteOnly))
+            throw tr("Couldn't open %1 for writing").arg(filename);
+        prepareExport(settings);
         std::unique_ptr<toListViewFormatter> pFormatter(
             toListViewFormatterFactory::Instance().CreateObject(settings.type));
-        return Utils::toWriteFile(filename, exportAsText(settings));
+        QTextStream out(&file);
+        pFormatter->writeFormatted(out, settings, model());
+        file.close();
+        if (out.status() != QTextStream::Ok || file.error() != QFile::NoError)
+        {
+            file.remove();
+            throw tr("Couldn't write data to file");
+        }
+        Utils::toStatusMessage(tr("File saved successfully"), false, false);
+        return true;
     }
     TOCATCH
     return false;
@@ -1017,6 +1037,13 @@ QString toListView::exportAsText(toExportSettings settings)
 
     return result;
 #endif
+    prepareExport(settings);
+    std::unique_ptr<toListViewFormatter> pFormatter(toListViewFormatterFactory::Instance().CreateObject(settings.type));
+    return pFormatter->getFormattedString(settings, model());
+}
+
+void toListView::prepareExport(toExportSettings &settings)
+{
     if (settings.requireSelection())
         settings.selected = selectedIndexes();
 
@@ -1034,10 +1061,8 @@ QString toListView::exportAsText(toExportSettings settings)
         progress.setValue(2);
     }
 
-    std::unique_ptr<toListViewFormatter> pFormatter(toListViewFormatterFactory::Instance().CreateObject(settings.type));
     settings.owner = owner;
     settings.objectName = objectName;
-    return pFormatter->getFormattedString(settings, model());
 }
 
 #ifdef TORA3_SESSION
@@ -636,6 +636,9 @@ public:
      */
     virtual QString exportAsText(toExportSettings settings);
 
+    /** Read the rows to be exported, set selection and object of settings */
+    void prepareExport(toExportSettings &settings);
+
 #ifdef TORA3_SESSION
         /** Export data to a map.
          * @param data A map that can be used to recreate the data of a chart.
@@ -185,15 +185,14 @@ class toSessionFilter  : public toViewFilter
          * return true to show, false to hide
          *
          */
-        virtual bool check(const toResultModel *model, const int row)
+        virtual bool check(toResultStore::Snapshot::Cursor const &row)
         {
             if (Filter.isEmpty())
                 return true;
 
-            int rows = model->rowCount();
-            for (int col = 0; col < rows; col++)
+            for (int col = 0; col < row.columns(); col++)
             {
-                QString data = model->data(row, col).toString();
+                QString data = row.text(col);
                 if (data.isEmpty())
                     continue;
 
@@ -1082,7 +1081,8 @@ void toSession::slotRefreshTabs(void)
 void toSession::slotFilterChanged(const QString &text)
 {
     SessionFilter->setFilterString(text);
-    Sessions->applyFilter();
+    // substring match in the background, same rows as SessionFilter's "*text*"
+    Sessions->setTextFilter(text);
 }
 
 bool toSession::eventFilter(QObject *obj, QEvent *event)
@@ -271,6 +271,7 @@ void toTuningFileIO::refresh(void)
             Query = new toEventQuery(this, conn, toSQL::string(SQLFileIO, conn), toQueryParams(), toEventQuery::READ_ALL);
             connect(Query, SIGNAL(dataAvailable(toEventQuery*)), this, SLOT(poll()));
             connect(Query, SIGNAL(done(toEventQuery*, unsigned long)), this, SLOT(queryDone()));
+            Query->setPriority(toEventQuery::PRIORITY_BACKGROUND);
             Query->start();
             LastTablespace = QString::null;
         }
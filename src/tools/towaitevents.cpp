@@ -643,6 +643,7 @@ void toWaitEvents::refresh(void)
         connect(Query, SIGNAL(done(toEventQuery*, unsigned long)), this, SLOT(slotQueryDone(toEventQuery*)));
         connect(Query, SIGNAL(error(toEventQuery*,toConnection::exception const &)), this, SLOT(slotErrorHanler(toEventQuery*, toConnection::exception  const &)));
 
+        Query->setPriority(toEventQuery::PRIORITY_BACKGROUND);
         Query->start();
     }
     TOCATCH
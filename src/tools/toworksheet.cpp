@@ -43,6 +43,7 @@
 #include "core/tochangeconnection.h"
 #include "core/toconnectionsub.h"
 #include "core/toconnectiontraits.h"
+#include "core/toqueryexport.h"
 #include "tools/toparamget.h"
 #include "tools/toresultbar.h"
 #include "tools/toresultcols.h"
@@ -50,6 +51,7 @@
 #include "tools/toresultstats.h"
 #include "tools/toresulttableview.h"
 #include "tools/toresultview.h"
+#include "widgets/toresultlistformat.h"
 #include "widgets/toresultschema.h"
 #include "widgets/toresultitem.h"
 #include "widgets/toresultresources.h"
@@ -333,6 +335,11 @@ void toWorksheet::createActions()
                               tr("Save last SQL"),
                               this);
     connect(saveLastAct, SIGNAL(triggered()), this, SLOT(slotSaveLast(void)));
+
+    exportQueryAct = new QAction(QPixmap(const_cast<const char**>(filesave_xpm)),
+                                 tr("Export query into file..."),
+                                 this);
+    connect(exportQueryAct, SIGNAL(triggered()), this, SLOT(slotExportQuery(void)));
 }
 
 
@@ -656,6 +663,7 @@ void toWorksheet::slotWindowActivated(toToolWidget *widget)
             ToolMenu->addAction(SavedMenu->menuAction());
 
             ToolMenu->addAction(saveLastAct);
+            ToolMenu->addAction(exportQueryAct);
 
             ToolMenu->addSeparator();
 
@@ -1247,6 +1255,7 @@ void toWorksheet::query(toSyntaxAnalyzer::statement const& statement, execTypeEn
                 Started->setToolTip(tr("Duration while query has been running\n\n") + statement.sql);
                 stopAct->setEnabled(true);
                 Result->setNumberColumn(toConfigurationNewSingle::Instance().option(ToConfiguration::Worksheet::DisplayNumberColumnBool).toBool());
+                Result->setQueryPriority(toEventQuery::PRIORITY_INTERACTIVE);
                 // it fixes crash running statements from Schema Browser - PV
                 if (ResultTab)
                     ResultTab->setCurrentIndex(0);
@@ -1291,6 +1300,97 @@ void toWorksheet::query(toSyntaxAnalyzer::statement const& statement, execTypeEn
     }
 }
 
+void toWorksheet::slotExportQuery()
+{
+    if (QueryExport)
+    {
+        Utils::toStatusMessage(tr("Export of %1 is still running").arg(QueryExport->fileName()));
+        return;
+    }
+
+    toSyntaxAnalyzer::statement stat;
+    if (Editor->hasSelectedText())
+    {
+        int lineFrom, indexFrom, lineTo, indexTo;
+        Editor->getSelection(&lineFrom, &indexFrom, &lineTo, &indexTo);
+        if (indexTo == 0)
+            lineTo = (std::max)(lineFrom, lineTo - 1);
+        stat = toSyntaxAnalyzer::statement(lineFrom, lineTo);
+    }
+    else
+        stat = currentStatement();
+    Editor->analyzer()->sanitizeStatement(stat);
+
+    if (stat.statementType != toSyntaxAnalyzer::SELECT)
+    {
+        Utils::toStatusMessage(tr("Only queries can be exported into a file"));
+        return;
+    }
+
+    try
+    {
+        toResultListFormat exp(this, toResultListFormat::TypeExport);
+        if (!exp.exec())
+            return;
+        toExportSettings settings = exp.exportSettings();
+
+        // the file is gzip compressed when saved as .gz
+        QString fileName = Utils::toSaveFilename(QString::null,
+                           settings.extension + " " + settings.extension + ".gz",
+                           this);
+        if (fileName.isEmpty())
+            return;
+
+        toQueryParams param = toParamGet::getParam(connection(), this, stat.sql);
+
+        QueryExport = new toQueryExport(connection(),
+                                        stat.sql,
+                                        param,
+                                        settings,
+                                        Utils::toExpandFile(fileName),
+                                        fileName.endsWith(".gz", Qt::CaseInsensitive),
+                                        this);
+        connect(QueryExport, SIGNAL(progress(qulonglong)), this, SLOT(slotExportProgress(qulonglong)));
+        connect(QueryExport, SIGNAL(finished(bool)), this, SLOT(slotExportDone(bool)));
+
+        ExportProgress = new QProgressDialog(tr("Exporting query into %1").arg(fileName), tr("Abort"), 0, 0, this);
+        ExportProgress->setAttribute(Qt::WA_DeleteOnClose);
+        connect(ExportProgress, SIGNAL(canceled()), QueryExport, SLOT(cancel()));
+        ExportProgress->show();
+
+        QueryExport->start();
+    }
+    catch (const QString &exc)
+    {
+        if (ExportProgress)
+            ExportProgress->close();
+        delete QueryExport;
+        Utils::toStatusMessage(exc);
+    }
+    catch (...)
+    {
+        // toParamGet cancelled
+        delete QueryExport;
+    }
+}
+
+void toWorksheet::slotExportProgress(qulonglong rows)
+{
+    if (ExportProgress)
+        ExportProgress->setLabelText(tr("Exporting query into %1\n%2 rows written")
+                                     .arg(QueryExport->fileName())
+                                     .arg(rows));
+}
+
+void toWorksheet::slotExportDone(bool ok)
+{
+    if (ExportProgress)
+        ExportProgress->close();
+    if (!ok && !QueryExport->errorString().isEmpty())
+        Utils::toStatusMessage(QueryExport->errorString());
+    QueryExport->deleteLater();
+}
+
 void toWorksheet::querySelection(execTypeEnum execType)
 {
     toSyntaxAnalyzer *analyzer = Editor->analyzer();
@@ -1550,6 +1650,10 @@ void toWorksheet::slotQueryDone(void)
 {
     stopAct->setDisabled(true);
 
+    if (Result && Result->model() && !Result->model()->fetchStatistics().isEmpty())
+        Started->setToolTip(tr("Duration while query has been running\n\n") + m_lastQuery.sql
+                            + "\n\n" + Result->model()->fetchStatistics());
+
     // Possibly the toConnectionSub.Schema got changed after ~toQuery
     // could be possible if something like:
     //   BEGIN
@@ -44,6 +44,7 @@
 #include <QtCore/QTimer>
 #include <QtCore/QString>
 #include <QtCore/QSharedPointer>
+#include <QtCore/QPointer>
 #include <QLabel>
 #include <QAction>
 #include <QToolBar>
@@ -73,6 +74,8 @@ class toResultStats;
 class toTabWidget;
 class toTreeWidgetItem;
 class toEditableMenu;
+class toQueryExport;
+class QProgressDialog;
 class toRefreshCombo;
 
 namespace ToConfiguration
@@ -189,6 +192,9 @@ class toWorksheet : public toToolWidget, public toContextMenuHandler
         void slotStop(void);
         void slotLockConnection(bool);
         void slotRefreshModel(toResultModel*);
+        void slotExportQuery(void);
+        void slotExportProgress(qulonglong rows);
+        void slotExportDone(bool ok);
 
     protected:
         void closeEvent(QCloseEvent *event) override;
@@ -285,7 +291,11 @@ class toWorksheet : public toToolWidget, public toContextMenuHandler
         QAction *parseAct, *lockConnectionAct, *executeAct, *executeStepAct,
                 *executeAllAct,
                 *refreshAct, *describeAct, *describeActNew, *explainAct, *stopAct, *eraseAct,
-                *statisticAct, *previousAct, *nextAct, *saveLastAct;
+                *statisticAct, *previousAct, *nextAct, *saveLastAct, *exportQueryAct;
+
+        // query exported directly into a file (see toQueryExport)
+        QPointer<toQueryExport> QueryExport;
+        QPointer<QProgressDialog> ExportProgress;
 
         QSharedPointer<toConnectionSubLoan> LockedConnection;
         bool lockConnectionActClicked;
@@ -0,0 +1,238 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "widgets/toresultfilter.h"
+#include "widgets/toresultmodel.h"
+#include "core/tologger.h"
+
+#include <QtCore/QMetaObject>
+#include <QtCore/QMutexLocker>
+#include <QtCore/QRunnable>
+#include <QtCore/QThreadPool>
+
+class toResultFilter::Job : public QRunnable
+{
+    public:
+        Job(QSharedPointer<Shared> const &state,
+            int generation,
+            toResultStore::Snapshot const &snapshot,
+            QString const &text,
+            bool regExp,
+            Qt::CaseSensitivity cs,
+            QBitArray const &candidates,
+            RowCheck *check = NULL)
+            : State(state)
+            , Generation(generation)
+            , Snapshot(snapshot)
+            , Text(text)
+            , RegExp(regExp)
+            , CaseSensitivity(cs)
+            , Candidates(candidates)
+            , Check(check)
+        {
+            setAutoDelete(true);
+        }
+
+        virtual void run()
+        {
+            QBitArray visible;
+            try
+            {
+                if (Check)
+                    visible = checkRows();
+                else
+                    visible = Snapshot.match(Text, RegExp, CaseSensitivity, Candidates, State->Generation, Generation);
+            }
+            catch (QString const &str)
+            {
+                // spilled rows could not be read, show everything
+                TLOG(1, toDecorator, __HERE__) << "Result filter failed: " << str << std::endl;
+                visible = QBitArray();
+            }
+
+            QMutexLocker lock(&State->Lock);
+            if (State->Owner && int(State->Generation) == Generation)
+                QMetaObject::invokeMethod(State->Owner,
+                                          "slotMatched",
+                                          Qt::QueuedConnection,
+                                          Q_ARG(int, Generation),
+                                          Q_ARG(QBitArray, visible));
+        }
+
+    private:
+        QBitArray checkRows()
+        {
+            QBitArray visible(Snapshot.rows(), false);
+            toResultStore::Snapshot::Cursor row(Snapshot);
+            Check->startingQuery();
+            for (int phys = 0; phys < Snapshot.rows(); phys++)
+            {
+                if (phys % 4096 == 0 && int(State->Generation) != Generation)
+                    return QBitArray();
+                row.seek(phys);
+                visible.setBit(phys, Check->check(row));
+            }
+            return visible;
+        }
+
+        QSharedPointer<Shared> State;
+        int Generation;
+        toResultStore::Snapshot Snapshot;
+        QString Text;
+        bool RegExp;
+        Qt::CaseSensitivity CaseSensitivity;
+        QBitArray Candidates;
+        QScopedPointer<RowCheck> Check;
+};
+
+toResultFilter::toResultFilter(QObject *parent)
+    : QObject(parent)
+    , State(new Shared)
+    , RegExp(false)
+    , CaseSensitivity(Qt::CaseInsensitive)
+    , Checked(false)
+    , Running(false)
+    , MatchedCaseSensitivity(Qt::CaseInsensitive)
+{
+    State->Owner = this;
+}
+
+toResultFilter::~toResultFilter()
+{
+    QMutexLocker lock(&State->Lock);
+    State->Generation.fetchAndAddAcquire(1);
+    State->Owner = NULL;
+}
+
+void toResultFilter::apply(toResultModel *model,
+                           QString const &text,
+                           bool regExp,
+                           Qt::CaseSensitivity cs)
+{
+    int generation = State->Generation.fetchAndAddAcquire(1) + 1;
+
+    if (Model != model)
+    {
+        Matched.clear();
+        MatchedText.clear();
+    }
+    Model = model;
+    Text = text;
+    RegExp = regExp;
+    CaseSensitivity = cs;
+    Checked = false;
+    Running = false;
+
+    if (!model)
+        return;
+
+    if (text.isEmpty())
+    {
+        Matched.clear();
+        MatchedText.clear();
+        model->setRowFilter(QBitArray());
+        emit filtered(model->rowCount());
+        return;
+    }
+
+    // Substring contained in the last matched one can only hide more rows
+    QBitArray candidates;
+    if (!regExp
+            && !MatchedText.isEmpty()
+            && (cs == MatchedCaseSensitivity || MatchedCaseSensitivity == Qt::CaseInsensitive)
+            && text.contains(MatchedText, MatchedCaseSensitivity))
+        candidates = Matched;
+
+    Running = true;
+    QThreadPool::globalInstance()->start(new Job(State,
+                                         generation,
+                                         model->snapshot(),
+                                         text,
+                                         regExp,
+                                         cs,
+                                         candidates));
+}
+
+void toResultFilter::apply(toResultModel *model, RowCheck *check)
+{
+    QScopedPointer<RowCheck> owned(check);
+    int generation = State->Generation.fetchAndAddAcquire(1) + 1;
+
+    Matched.clear();
+    MatchedText.clear();
+    Model = model;
+    Text.clear();
+    Checked = true;
+    Running = false;
+
+    if (!model)
+        return;
+
+    Running = true;
+    QThreadPool::globalInstance()->start(new Job(State,
+                                         generation,
+                                         model->snapshot(),
+                                         QString(),
+                                         false,
+                                         Qt::CaseInsensitive,
+                                         QBitArray(),
+                                         owned.take()));
+}
+
+void toResultFilter::cancel()
+{
+    State->Generation.fetchAndAddAcquire(1);
+    Running = false;
+}
+
+void toResultFilter::slotMatched(int generation, QBitArray visible)
+{
+    if (generation != int(State->Generation) || !Model)
+        return;
+
+    Running = false;
+    if (RegExp || Checked)
+    {
+        Matched.clear();
+        MatchedText.clear();
+    }
+    else
+    {
+        Matched = visible;
+        MatchedText = visible.isEmpty() ? QString() : Text;
+        MatchedCaseSensitivity = CaseSensitivity;
+    }
+    Model->setRowFilter(visible);
+    emit filtered(Model->rowCount());
+}
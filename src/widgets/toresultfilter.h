@@ -0,0 +1,141 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TORESULTFILTER_H
+#define TORESULTFILTER_H
+
+#include "widgets/toresultstore.h"
+
+#include <QtCore/QObject>
+#include <QtCore/QAtomicInt>
+#include <QtCore/QBitArray>
+#include <QtCore/QMutex>
+#include <QtCore/QPointer>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QString>
+
+class toResultModel;
+
+/**
+ * Text filter for the rows of @ref toResultModel.
+ *
+ * Matching runs on QThreadPool over a @ref toResultStore::Snapshot and produces
+ * the set of visible rows. The set is then swapped into the model at once
+ * (@ref toResultModel::setRowFilter), rows are never hidden one by one.
+ *
+ * Each apply() cancels the previous one. When the new (substring) text contains
+ * the last applied one only the rows visible so far are checked again,
+ * so the filter gets faster as the user types.
+ *
+ * Filters other than text ones implement @ref RowCheck, they run in the same job.
+ */
+class toResultFilter : public QObject
+{
+        Q_OBJECT;
+
+    public:
+        /** Row test run on the worker thread, rows are passed in physical (fetch) order */
+        class RowCheck
+        {
+            public:
+                virtual ~RowCheck() {}
+
+                /** Called once before the first row is checked */
+                virtual void startingQuery(void) {}
+
+                /** Return true to show the row. Cells are numbered as store columns (without the row number) */
+                virtual bool check(toResultStore::Snapshot::Cursor const &row) = 0;
+        };
+
+        explicit toResultFilter(QObject *parent = 0);
+        virtual ~toResultFilter();
+
+        /** Start filtering the model, an empty text shows all the rows */
+        void apply(toResultModel *model,
+                   QString const &text,
+                   bool regExp = false,
+                   Qt::CaseSensitivity cs = Qt::CaseInsensitive);
+
+        /** Start filtering the model by check and take its ownership.
+         * The check is used by the worker thread only, pass a copy of a filter kept elsewhere.
+         */
+        void apply(toResultModel *model, RowCheck *check);
+
+        /** Stop the running filter, the model keeps the rows visible at the moment */
+        void cancel(void);
+
+        /** True if a filter is being computed */
+        bool running(void) const
+        {
+            return Running;
+        }
+
+        QString const& text(void) const
+        {
+            return Text;
+        }
+
+    signals:
+        /** Emitted when the visible rows were swapped into the model */
+        void filtered(int visibleRows);
+
+    private slots:
+        void slotMatched(int generation, QBitArray visible);
+
+    private:
+        class Job;
+
+        // Shared with the running jobs, the filter may be deleted before they finish
+        struct Shared
+        {
+            QAtomicInt Generation;
+            QMutex Lock;
+            toResultFilter *Owner;
+        };
+
+        QSharedPointer<Shared> State;
+        QPointer<toResultModel> Model;
+        QString Text;
+        bool RegExp;
+        Qt::CaseSensitivity CaseSensitivity;
+        bool Checked;       // last apply() was given a RowCheck
+        bool Running;
+
+        // Last completed match, used to refine the next one
+        QString MatchedText;
+        Qt::CaseSensitivity MatchedCaseSensitivity;
+        QBitArray Matched;
+};
+
+#endif
@@ -52,6 +52,7 @@ toResultListFormat::toResultListFormat(QWidget *parent, DialogType type, const c
     formatCombo->addItem(tr("CSV"));
     formatCombo->addItem(tr("HTML"));
     formatCombo->addItem(tr("SQL"));
+    formatCombo->addItem(tr("Excel (xlsx)"));
 
     int num = toConfigurationNewSingle::Instance().option(Global::DefaultListFormatInt).toInt();
     formatCombo->setCurrentIndex(num);
@@ -44,6 +44,10 @@
 #include <QtCore/QDebug>
 #include <QtCore/QMimeData>
 
+#include <QApplication>
+
+#include <climits>
+
 toResultModel::toResultModel(toEventQuery *query,
                              QObject *parent,
                              bool read)
@@ -58,6 +62,7 @@ toResultModel::toResultModel(toEventQuery *query,
     , ReadAll(false)
 {
     MaxRowsToAdd = MaxRows = toConfigurationNewSingle::Instance().option(ToConfiguration::Database::InitialFetchInt).toInt();
+    Store.setSpillThreshold(qint64(toConfigurationNewSingle::Instance().option(ToConfiguration::Database::ResultSpillThresholdInt).toInt()) * 1024 * 1024);
 
     Query = query;
     Query->setParent(this); // this will satisfy QObject's disposal
@@ -131,15 +136,13 @@ toResultModel::toResultModel(const QString &owner,
         toRowDesc rowDesc;
         rowDesc.key = counter++;
         rowDesc.status = EXISTED;
-        row.append(toQValue(rowDesc));
-        //row.append(toQValue(counter++));
         // Copy all values of a record
         ////for (toCache::Row::iterator ii = (*i).begin(); ii != (*i).end(); ii++)
         ///{
         ///    row.append((*ii).toString());
         ///}
         row.append((*i)->name.second);
-        Rows.append(row);
+        Store.appendRow(rowDesc, row);
         row.clear();
     }
     endInsertRows();
@@ -157,6 +160,7 @@ void toResultModel::cleanup()
     {
         disconnect(Query, 0, this, 0);
 
+        FetchStats = Query->fetchStatistics().toString();
         Query->stop();
         delete Query;
         Query = NULL;
@@ -209,44 +213,26 @@ void toResultModel::slotReadData()
         if (cols < 1)
             return;
 
-        // don't actually modify any data until we can call
-        // beginInsertRows(). but to do that, we have to know how many
-        // records we're going to add.
-        toQueryAbstr::RowList tmp;
-        int     current = Rows.size();
-
+        // take whole batches of rows, do not read cell by cell
+        int added = 0;
         while (Query->hasMore() &&
-                (MaxRows < 0 || MaxRows > current))
+                (MaxRows < 0 || MaxRows > Store.rows()))
         {
-            toQueryAbstr::Row row;
-
-            // The number column (rowKey). should never change
-            toRowDesc rowDesc;
-            rowDesc.key = CurrRowKey++;
-            rowDesc.status = EXISTED;
-            row.append(toQValue(rowDesc));
-            //row.append(toQValue(CurrRowKey++));
-
-            for (int j = 1; (j < cols || j == 0) && Query->hasMore(); j++)
-                row.append(Query->readValue());
-
-            tmp.append(row);
-            current++;
+            unsigned maxRows = MaxRows < 0 ? UINT_MAX : MaxRows - Store.rows();
+            added += appendBatch(Query->takeBatch(maxRows));
         }
 
-        // if we read some data, then go ahead and insert them now.
-        if (tmp.size() > 0)
-        {
-            beginInsertRows(QModelIndex(), Rows.size(), current - 1);
-            Rows << tmp;
-            endInsertRows();
-        }
+        if (added > 0 && Store.spilledRows() > 0)
+            Utils::toStatusMessage(tr("Result rows: %1 in memory, %2 spilled to disk")
+                                   .arg(toQValue((qulonglong) Store.byteSize()).toSIsize())
+                                   .arg(toQValue((qulonglong) Store.spilledSize()).toSIsize()),
+                                   false, false);
 
         // not really first, but just be sure to emit before done()
         // must be emitted even if there's no data....
         if (First)
         {
-            if (tmp.size() > 0 || !Query || Query->eof())
+            if (added > 0 || !Query || Query->eof())
             {
                 First = !First;
 
@@ -298,6 +284,26 @@ void toResultModel::slotReadData()
     }
 }
 
+QString toResultModel::fetchStatistics(void) const
+{
+    if (Query)
+        return Query->fetchStatistics().toString();
+    return FetchStats;
+}
+
+int toResultModel::appendBatch(toQueryBatchPtr const& batch)
+{
+    int rows = batch->rows();
+    if (rows == 0)
+        return 0;
+
+    // The number column (rowKey) is assigned here and should never change
+    beginInsertRows(QModelIndex(), Store.rows(), Store.rows() + rows - 1);
+    Store.appendBatch(*batch, CurrRowKey);
+    endInsertRows();
+    return rows;
+}
+
 QStringList toResultModel::mimeTypes() const
 {
     QStringList types;
@@ -491,7 +497,7 @@ int toResultModel::rowCount(const QModelIndex &parent) const
     if (parent.isValid())
         return 0;
 
-    return Rows.size();
+    return Store.rows();
 }
 
 
@@ -504,15 +510,25 @@ QVariant toResultModel::data(const QModelIndex &index, int role) const
     if (!index.isValid())
         return QVariant();
 
-    if (index.row() > Rows.size() - 1 || index.column() > Headers.size() - 1)
+    if (index.row() > Store.rows() - 1 || index.column() > Headers.size() - 1)
         return QVariant();
 
-    toQueryAbstr::Row const& row = Rows.at(index.row());
-    if (index.column() >= row.size())
-        return QVariant();
-    toQValue const &data = row.at(index.column());
+    toRowDesc rowDesc = Store.rowDesc(index.row());
+
+    // Cells held as toQValue (complex types, edited cells) are referenced in place,
+    // all the others are materialized from the column store
+    toQValue boxed;
+    toQValue const *cell = index.column() == 0 ? NULL : Store.cell(index.row(), index.column() - 1);
+    if (cell == NULL)
+    {
+        if (index.column() == 0)
+            boxed = toQValue(rowDesc);
+        else
+            boxed = Store.value(index.row(), index.column() - 1);
+        cell = &boxed;
+    }
+    toQValue const &data = *cell;
 
-    toRowDesc rowDesc = row[0].getRowDesc();
     QFont fontRet;
 
 	try
@@ -624,9 +640,9 @@ QVariant toResultModel::headerData(int section, Qt::Orientation orientation, int
             return section + 1;
         else if (role == Qt::ForegroundRole)
         {
-            if (section < 0 || section > Rows.size())
+            if (section < 0 || section >= Store.rows())
                 return QVariant();
-            toRowDesc rowDesc = Rows[section][0].getRowDesc();
+            toRowDesc rowDesc = Store.rowDesc(section);
             switch (rowDesc.status)
             {
                 case REMOVED:
@@ -738,7 +754,7 @@ void toResultModel::slotFetchMore(toEventQuery*)
         MaxRows = -1;
         slotReadData();
     }
-    else if (Rows.size() < MaxRows)
+    else if (Store.rows() < MaxRows)
     {
         QModelIndex ind;
         fetchMore(ind);
@@ -761,7 +777,7 @@ void toResultModel::fetchMore(const QModelIndex &parent)
 
     // sometimes the view calls this before the query has even
     // run. don't actually increase max until we've hit it.
-    if (MaxRows < 0 || MaxRows <= Rows.size())
+    if (MaxRows < 0 || MaxRows <= Store.rows())
         MaxRows += MaxRowsToAdd;
 
     slotReadData();
@@ -776,17 +792,15 @@ Qt::ItemFlags toResultModel::flags(const QModelIndex &index) const
     if (index.column() == 0)
         return fl;              // row number column
 
-    if (!index.isValid() || index.row() >= Rows.size())
+    if (!index.isValid() || index.row() >= Store.rows())
     {
         return defaultFlags;
     }
 
-    toQueryAbstr::Row const& row = Rows.at(index.row());
-    if (index.column() >= row.size())
+    if (index.column() > Store.columns())
         return defaultFlags;
 
-    toQValue const &data = row.at(index.column());
-    if (data.isComplexType())
+    if (Store.isComplex(index.row(), index.column() - 1))
     {
         return ( defaultFlags | fl ) & ~Qt::ItemIsEditable;
     }
@@ -794,7 +808,7 @@ Qt::ItemFlags toResultModel::flags(const QModelIndex &index) const
     fl |= defaultFlags;
 
     //Check the status of current record
-    toRowDesc rowDesc = row.at(0).getRowDesc();
+    toRowDesc rowDesc = Store.rowDesc(index.row());
     if (rowDesc.status == REMOVED)
         fl &= ~Qt::ItemIsEditable;
     return fl;
@@ -812,67 +826,97 @@ void toResultModel::sort(int column, Qt::SortOrder order)
     if (column > Headers.size() - 1)
         return;
 
-    // Do nothing if data was already sorted in the requested way
-    if (SortedOnColumn == column &&
-            SortedOrder == order)
+    SortColumnList columns;
+    if (QApplication::keyboardModifiers() & Qt::ShiftModifier)
+    {
+        // Shift+click on the header adds a secondary sort column
+        columns = SortColumns;
+        for (SortColumnList::iterator i = columns.begin(); i != columns.end(); ++i)
+        {
+            if (i->first == column)
+            {
+                columns.erase(i);
+                break;
+            }
+        }
+    }
+    else if (SortedOnColumn == column &&
+             SortedOrder == order)
+    {
+        // Do nothing if data was already sorted in the requested way
+        return;
+    }
+    columns.append(qMakePair(column, order));
+    sort(columns);
+}
+
+void toResultModel::sort(SortColumnList const &columns)
+{
+    // 0th column contains row description (including row number)
+    QList<toResultStore::SortColumn> keys;
+    foreach(SortColumnList::value_type const &c, columns)
+    {
+        if (c.first < 0 || c.first > Headers.size() - 1)
+            continue;
+        toResultStore::SortColumn key;
+        key.Column = c.first - 1;
+        key.Order = c.second;
+        keys.append(key);
+    }
+    if (keys.isEmpty())
         return;
 
-    Rows = mergesort(Rows, column, order);
-    SortedOnColumn = column;
-    SortedOrder = order;
+    Store.setOrder(Store.sortedOrder(keys));
+
+    SortColumns = columns;
+    SortedOnColumn = columns.size() == 1 ? columns.first().first : -1;
+    SortedOrder = columns.first().second;
     emit dataChanged(createIndex(0, 0),
                      createIndex(rowCount(), columnCount()));
 }
 
-
-toQueryAbstr::RowList toResultModel::mergesort(toQueryAbstr::RowList &rows,
-        int column,
-        Qt::SortOrder order)
+toQueryAbstr::RowList toResultModel::getRawData(void) const
 {
-    if (rows.size() <= 1)
-        return rows;
-
-    toQueryAbstr::RowList left, right;
-
-    int middle = (int) (rows.size() / 2);
-    left = rows.mid(0, middle);
-    right = rows.mid(middle);
-
-    left = mergesort(left, column, order);
-    right = mergesort(right, column, order);
-
-    return merge(left, right, column, order);
+    toQueryAbstr::RowList retval;
+    retval.reserve(Store.rows());
+    for (int row = 0; row < Store.rows(); row++)
+        retval.append(Store.row(row));
+    return retval;
 }
 
-
-toQueryAbstr::RowList toResultModel::merge(toQueryAbstr::RowList &left,
-                                      toQueryAbstr::RowList &right,
-                                      int column,
-                                      Qt::SortOrder order)
+void toResultModel::setRowFilter(QBitArray const &visible)
 {
-    toQueryAbstr::RowList result;
+    if (visible.isEmpty() && !Store.isFiltered())
+        return;
+    // layout change keeps the column sizes of the views (model reset would not)
+    emit layoutAboutToBeChanged();
 
-    while (left.size() > 0 && right.size() > 0)
-    {
-        // 0th column contains row description (including row number)
-        toQValue lkey = column == 0 ? left.at(0).at(0).getRowDesc().key : left.at(0).at(column);
-        toQValue rkey = column == 0 ? right.at(0).at(0).getRowDesc().key : right.at(0).at(column);
-        if ((order == Qt::AscendingOrder && lkey <= rkey) || (order == Qt::DescendingOrder && lkey >= rkey))
-            result.append(left.takeAt(0));
-        else
-            result.append(right.takeAt(0));
-    }
+    // Persistent indexes (selection, current index, editors) follow their physical rows
+    QModelIndexList from = persistentIndexList();
+    QVector<int> phys(from.size(), -1);
+    for (int i = 0; i < from.size(); i++)
+        if (from.at(i).row() < Store.rows())
+            phys[i] = Store.order().at(from.at(i).row());
 
-    if (left.size() > 0)
-        result << left;
-    if (right.size() > 0)
-        result << right;
-    return result;
-}
+    Store.setVisible(visible);
 
-toQueryAbstr::RowList& toResultModel::getRawData(void)
-{
-    return Rows;
+    if (!from.isEmpty())
+    {
+        QHash<int, int> logical; // physical => logical row
+        QVector<int> const &order = Store.order();
+        for (int r = 0; r < order.size(); r++)
+            logical.insert(order.at(r), r);
+
+        QModelIndexList to;
+        to.reserve(from.size());
+        for (int i = 0; i < from.size(); i++)
+        {
+            int row = logical.value(phys.at(i), -1);
+            to.append(row < 0 ? QModelIndex() : index(row, from.at(i).column()));
+        }
+        changePersistentIndexList(from, to);
+    }
+    emit layoutChanged();
 }
 
 void toResultModel::setInitialRows(int r)
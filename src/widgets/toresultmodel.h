@@ -39,9 +39,12 @@
 #include "core/toresult.h"
 #include "core/toconnection.h"
 #include "core/toqvalue.h"
+#include "core/toquerybatch.h"
+#include "widgets/toresultstore.h"
 
 #include <QtCore/QObject>
 #include <QtCore/QAbstractTableModel>
+#include <QtCore/QBitArray>
 #include <QtCore/QModelIndex>
 #include <QtCore/QList>
 #include <QtCore/QMap>
@@ -65,6 +68,9 @@ class toResultModel : public QAbstractTableModel
 
         typedef QList<HeaderDesc> HeaderList;
 
+        /** Sort columns (model column, order), the first one is the primary key */
+        typedef QList<QPair<int, Qt::SortOrder> > SortColumnList;
+
         toResultModel(toEventQuery *query,
                       QObject *parent = 0,
                       bool read = false);
@@ -168,9 +174,16 @@ class toResultModel : public QAbstractTableModel
 
         /**
          * Sorts the model by column in the given order.
+         * When Shift is held the column is added to the current sort columns.
          */
         virtual void sort(int column, Qt::SortOrder order = Qt::AscendingOrder);
 
+        /**
+         * Sorts the model by several columns. Only the row order is changed,
+         * row data stay in place.
+         */
+        void sort(SortColumnList const &columns);
+
         /**
          * override parent to make public
          */
@@ -234,10 +247,60 @@ class toResultModel : public QAbstractTableModel
 
         /** Get raw data of the data model. This is currently used to
          * prepare and send data to cache.
+         * Rows are materialized from the column store in the displayed order.
          */
-        toQueryAbstr::RowList &getRawData(void);
+        toQueryAbstr::RowList getRawData(void) const;
+
+        /** Approximate size of the data held by the model in memory */
+        size_t residentSize(void) const
+        {
+            return Store.byteSize();
+        }
+
+        /** Size of the rows spilled into a temporary file (see Database::ResultSpillThresholdInt) */
+        qint64 spilledSize(void) const
+        {
+            return Store.spilledSize();
+        }
+
+        /** Show only the rows whose (physical) bit is set, an empty array shows all the rows.
+         * Rows appended later stay visible until the filter is applied again.
+         */
+        void setRowFilter(QBitArray const &visible);
+
+        /** True if some rows are hidden by setRowFilter() */
+        bool isFiltered(void) const
+        {
+            return Store.isFiltered();
+        }
+
+        /** Physical (storage) index of the visible row, see @ref toResultStore */
+        int physicalRow(int row) const
+        {
+            return Store.order().at(row);
+        }
+
+        /** Number of rows including the ones hidden by setRowFilter() */
+        int totalRowCount(void) const
+        {
+            return Store.totalRows();
+        }
+
+        /** Read only copy of the data for a background filter (see @ref toResultFilter) */
+        toResultStore::Snapshot snapshot(void) const
+        {
+            return Store.snapshot();
+        }
 
         void setInitialRows(int);
+
+        /** Append all the rows from batch (taken from toEventQuery::takeBatch)
+         * @return number of rows added
+         */
+        int appendBatch(toQueryBatchPtr const& batch);
+
+        /** Sizes of row chunks fetched by the query (also available after the query is done) */
+        QString fetchStatistics(void) const;
     signals:
 
         /**
@@ -292,19 +355,18 @@ class toResultModel : public QAbstractTableModel
     protected:
         void cleanup(void);
 
-        // helpers for sort implementation
-        toQueryAbstr::RowList mergesort(toQueryAbstr::RowList&, int, Qt::SortOrder);
-        toQueryAbstr::RowList merge(toQueryAbstr::RowList&, toQueryAbstr::RowList&, int, Qt::SortOrder);
-
         toEventQuery *Query;
 
-        toQueryAbstr::RowList Rows;
+        // Column store, model column N is the store column N - 1,
+        // model column 0 is the row description
+        toResultStore Store;
         HeaderList Headers;
 
         // Following two variables hold information on how was data last sorted by sort() function.
         // This is used by sort() function in order not to waste CPU on resorting.
         int SortedOnColumn;
         Qt::SortOrder SortedOrder;
+        SortColumnList SortColumns;
 
         // max rows to read until
         int MaxRows;
@@ -328,6 +390,9 @@ class toResultModel : public QAbstractTableModel
 
         // should read all data
         bool ReadAll;
+
+        // toEventQuery::FetchStatistics saved before Query is deleted
+        QString FetchStats;
 };
 
 
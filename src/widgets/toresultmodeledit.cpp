@@ -65,50 +65,41 @@ int toResultModelEdit::addRow(QModelIndex ind, bool duplicate)
         newRowPos = ind.row() + 1; // new row is inserted right after the current one
     else
     {
-        if (!duplicate || Rows.size() > 0)
-            newRowPos = Rows.size() + 1; // new row is appended at the end
+        if (!duplicate || Store.rows() > 0)
+            newRowPos = Store.rows(); // new row is appended at the end
         else
             return -1; // unable to duplicate a record if there are no records
     }
     beginInsertRows(QModelIndex(), newRowPos, newRowPos);
 
-    toQueryAbstr::Row row;
     toRowDesc rowDesc;
     rowDesc.key = CurrRowKey++;
     rowDesc.status = ADDED;
 
+    // Create a new empty row, values of the new row are kept in the edit overlay
+    Store.insertRow(newRowPos, rowDesc);
+
     if (duplicate)
     {
-        // Create a duplicate of current row
-        row = Rows[ind.row()];
-        // Reset a 0'th column
-        row[0] = rowDesc;
-    }
-    else
-    {
-        // Create a new empty row
-        row.append(toQValue(rowDesc));
-
-        // null out the rest of the row
-        int cols = Headers.size();
-        for (int j = 1; j < cols; j++)
-            row.append(toQValue());
+        // Create a duplicate of current row (complex types can not be copied)
+        for (int col = 0; col < Store.columns(); col++)
+            if (!Store.isComplex(ind.row(), col) && !Store.isNull(ind.row(), col))
+                Store.setValue(newRowPos, col, Store.value(ind.row(), col));
     }
 
-    Rows.insert(newRowPos, row);
     endInsertRows();
-    recordAdd(row);
+    recordAdd(Store.row(newRowPos));
     return newRowPos;
 } // addRow
 
 
 void toResultModelEdit::deleteRow(QModelIndex index)
 {
-    if (!index.isValid() || index.row() >= Rows.size())
+    if (!index.isValid() || index.row() >= Store.rows())
         return;
 
-    toQueryAbstr::Row deleted = Rows[index.row()];
-    toRowDesc rowDesc = deleted[0].getRowDesc();
+    toQueryAbstr::Row deleted = Store.row(index.row());
+    toRowDesc rowDesc = Store.rowDesc(index.row());
 
     if (rowDesc.status == REMOVED)
     {
@@ -119,13 +110,13 @@ void toResultModelEdit::deleteRow(QModelIndex index)
     {
         //Newly added record can be removed regularly
         beginRemoveRows(QModelIndex(), index.row(), index.row());
-        Rows.takeAt(index.row());
+        Store.removeRow(index.row());
         endRemoveRows();
     }
     else  //Existed and Modified
     {
         rowDesc.status = REMOVED;
-        Rows[index.row()][0] = toQValue(rowDesc);
+        Store.setRowDesc(index.row(), rowDesc);
     }
     recordDelete(deleted);
 }
@@ -133,22 +124,20 @@ void toResultModelEdit::deleteRow(QModelIndex index)
 void toResultModelEdit::clearStatus()
 {
     // Go through all records and set their status to be existed
-    for (toQueryAbstr::RowList::iterator ite = Rows.begin(); ite != Rows.end(); ite++)
+    for (int row = Store.rows() - 1; row >= 0; row--)
     {
-        toRowDesc rowDesc = ite->at(0).getRowDesc();
+        toRowDesc rowDesc = Store.rowDesc(row);
         if (rowDesc.status == REMOVED)
         {
-            ite = Rows.erase(ite);
-            if (ite == Rows.end())
-                break;
+            Store.removeRow(row);
         }
         else if (rowDesc.status != EXISTED)
         {
             rowDesc.status = EXISTED;
-            (*ite)[0] = toQValue(rowDesc);
+            Store.setRowDesc(row, rowDesc);
         }
     }
-    emit headerDataChanged(Qt::Vertical, 0, Rows.size() - 1);
+    emit headerDataChanged(Qt::Vertical, 0, Store.rows() - 1);
 }
 
 bool toResultModelEdit::changed(void)
@@ -270,29 +259,31 @@ bool toResultModelEdit::setData(const QModelIndex &index,
     if (index.column() == 0)
         return false;           // can't change number column
 
-    if (index.row() >= Rows.size() || index.column() >= Headers.size())
+    if (index.row() >= Store.rows() || index.column() >= Headers.size())
+        return false;
+
+    // complex types (LOBs) can not be updated in place
+    if (Store.isComplex(index.row(), index.column() - 1))
         return false;
 
-    toQueryAbstr::Row &row = Rows[index.row()];
     toQValue newValue = toQValue::fromVariant(_value);
-    toRowDesc rowDesc = Rows.at(index.row())[0].getRowDesc();
-    if (rowDesc.status == EXISTED && !(row[index.column()] == newValue))
+    toQueryAbstr::Row oldRow = Store.row(index.row());  // keep old version
+    toRowDesc rowDesc = Store.rowDesc(index.row());
+    if (rowDesc.status == EXISTED && !(oldRow[index.column()] == newValue))
     {
         // leave row that's added as in status added
         rowDesc.status = MODIFIED;
-        Rows[index.row()][0] = toQValue(rowDesc);
+        Store.setRowDesc(index.row(), rowDesc);
     }
 
     {
         // If no prikey is used, data is recorded in change list
-        toQueryAbstr::Row oldRow = row;           // keep old version
-        row[index.column()] = newValue;
         // for writing to the database
         recordChange(index, newValue, oldRow);
 
-        if (!row[index.column()].updateNewValue(newValue))
-            return false;
-        qDebug() << "Value is changed from " << (QString)row[index.column()] << " to " << (QString)newValue << "At " << index;
+        // the new value goes into the edit overlay of the column store
+        Store.setValue(index.row(), index.column() - 1, newValue);
+        qDebug() << "Value is changed from " << (QString)oldRow[index.column()] << " to " << (QString)newValue << "At " << index;
     }
 
     // for the view
@@ -309,17 +300,15 @@ Qt::ItemFlags toResultModelEdit::flags(const QModelIndex &index) const
     if (index.column() == 0)
         return fl;              // row number column
 
-    if (!index.isValid() || index.row() >= Rows.size())
+    if (!index.isValid() || index.row() >= Store.rows())
     {
         return Qt::ItemIsDropEnabled | defaultFlags;
     }
 
-    toQueryAbstr::Row const& row = Rows.at(index.row());
-    if (index.column() >= row.size())
+    if (index.column() >= Headers.size())
         return defaultFlags;
 
-    toQValue const &data = row.at(index.column());
-    if (data.isComplexType())
+    if (Store.isComplex(index.row(), index.column() - 1))
     {
         return ( defaultFlags | fl ) & ~Qt::ItemIsEditable;
     }
@@ -327,7 +316,7 @@ Qt::ItemFlags toResultModelEdit::flags(const QModelIndex &index) const
     fl |= defaultFlags | Qt::ItemIsEditable | Qt::ItemIsDropEnabled;
 
     //Check the status of current record
-    toRowDesc rowDesc = row.at(0).getRowDesc();
+    toRowDesc rowDesc = Store.rowDesc(index.row());
     if (rowDesc.status == REMOVED)
         fl &= ~Qt::ItemIsEditable;
     return fl;
@@ -0,0 +1,370 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "widgets/toresultspill.h"
+
+#include <QtCore/QDataStream>
+#include <QtCore/QDir>
+#include <QtCore/QObject>
+
+#include <cstring>
+
+// Rows are written into the file in chunks of this size
+static const int FLUSH_SIZE = 1024 * 1024;
+
+toResultSpill::toResultSpill(int columns)
+    : Columns(columns)
+    , Written(0)
+    , Map(NULL)
+    , MapSize(0)
+    , Pages(CACHED_PAGES)
+{
+    File.setFileTemplate(QDir::tempPath() + QString::fromLatin1("/tora_result_XXXXXX"));
+}
+
+toResultSpill::~toResultSpill()
+{
+    if (Map)
+        File.unmap(Map);
+    // QTemporaryFile removes the file
+}
+
+void toResultSpill::open()
+{
+    if (!File.open())
+        throw QObject::tr("Can not create temporary file for result rows: %1").arg(File.errorString());
+}
+
+qint64 toResultSpill::fileSize() const
+{
+    return Written + Buffer.size();
+}
+
+size_t toResultSpill::byteSize() const
+{
+    size_t retval = Offsets.size() * sizeof(qint64);
+    retval += Buffer.capacity();
+    retval += Pages.totalCost() * PAGE_ROWS * Columns * sizeof(toQValue);
+    retval += Complex.size() * (sizeof(quint64) + sizeof(toQValue));
+    return retval;
+}
+
+void toResultSpill::appendBatch(toQueryBatch &batch)
+{
+    unsigned count = batch.rows();
+    for (unsigned r = 0; r < count; r++)
+    {
+        beginRow();
+        for (unsigned col = 0; col < (unsigned) Columns; col++)
+        {
+            if (col >= batch.columns() || batch.columnType(col) == toQueryBatch::NullColumn || batch.isNull(r, col))
+            {
+                writeTag(NullTag);
+                continue;
+            }
+            switch (batch.columnType(col))
+            {
+                case toQueryBatch::IntColumn:
+                    writeInt(batch.longInts(col) ? LongTag : IntTag, batch.intAt(r, col));
+                    break;
+                case toQueryBatch::DoubleColumn:
+                    writeDouble(batch.doubleAt(r, col));
+                    break;
+                case toQueryBatch::StringColumn:
+                    {
+                        QStringRef s = batch.stringAt(r, col);
+                        writeBytes(StringTag, (char const*) s.unicode(), s.size() * sizeof(QChar));
+                    }
+                    break;
+                case toQueryBatch::VariantColumn:
+                    writeValue(rows() - 1, col, batch.value(r, col)); // moves complex types out of the batch
+                    break;
+                case toQueryBatch::NullColumn:
+                    break;
+            }
+        }
+        if (Buffer.size() > FLUSH_SIZE)
+            flush();
+    }
+}
+
+void toResultSpill::appendRow(toQueryAbstr::Row const &cells)
+{
+    beginRow();
+    for (int col = 0; col < Columns; col++)
+        if (col < cells.size())
+            writeValue(rows() - 1, col, cells.at(col));
+        else
+            writeTag(NullTag);
+    if (Buffer.size() > FLUSH_SIZE)
+        flush();
+}
+
+toQValue toResultSpill::value(int row, int col) const
+{
+    if (col < 0 || col >= Columns)
+        return toQValue();
+    Page const *p = page(row);
+    return p->Cells.at((row % PAGE_ROWS) * Columns + col);
+}
+
+toQValue const* toResultSpill::complex(int row, int col) const
+{
+    if (Complex.isEmpty())
+        return NULL;
+    QHash<quint64, toQValue>::const_iterator i = Complex.constFind(complexKey(row, col));
+    if (i == Complex.constEnd())
+        return NULL;
+    return &i.value();
+}
+
+bool toResultSpill::isNull(int row, int col) const
+{
+    if (complex(row, col))
+        return false;
+    return value(row, col).isNull();
+}
+
+void toResultSpill::beginRow()
+{
+    // The page of the new row, if cached, was decoded without it
+    int row = rows();
+    Pages.remove(row - row % PAGE_ROWS);
+    Offsets.append(fileSize());
+}
+
+void toResultSpill::writeTag(Tag tag)
+{
+    Buffer.append((char) tag);
+}
+
+void toResultSpill::writeInt(Tag tag, qint64 value)
+{
+    writeTag(tag);
+    Buffer.append((char const*) &value, sizeof(value));
+}
+
+void toResultSpill::writeDouble(double value)
+{
+    writeTag(DoubleTag);
+    Buffer.append((char const*) &value, sizeof(value));
+}
+
+void toResultSpill::writeBytes(Tag tag, char const *data, int len)
+{
+    qint32 l = len;
+    writeTag(tag);
+    Buffer.append((char const*) &l, sizeof(l));
+    Buffer.append(data, len);
+}
+
+void toResultSpill::writeString(QString const &value)
+{
+    writeBytes(StringTag, (char const*) value.unicode(), value.size() * sizeof(QChar));
+}
+
+void toResultSpill::writeValue(int row, int col, toQValue const &value)
+{
+    if (value.isNull())
+        writeTag(NullTag);
+    else if (value.isInt())
+        writeInt(IntTag, value.toInt());
+    else if (value.isLong())
+        writeInt(LongTag, value.toLong());
+    else if (value.isDouble())
+        writeDouble(value.toDouble());
+    else if (value.isString())
+        writeString(value.toQVariant().toString());
+    else if (value.isBinary())
+    {
+        QByteArray const &raw = value.toQVariant().toByteArray();
+        writeBytes(BinaryTag, raw.constData(), raw.size());
+    }
+    else if (value.isComplexType())
+    {
+        // LOBs are still bound to the session, keep them in memory
+        Complex.insert(complexKey(row, col), value);
+        writeTag(MemoryTag);
+    }
+    else
+    {
+        QByteArray raw;
+        QDataStream stream(&raw, QIODevice::WriteOnly);
+        stream << value.toQVariant();
+        writeBytes(VariantTag, raw.constData(), raw.size());
+    }
+}
+
+void toResultSpill::flush() const
+{
+    if (Buffer.isEmpty())
+        return;
+    if (File.write(Buffer) != Buffer.size() || !File.flush())
+        throw QObject::tr("Can not write result rows into temporary file: %1").arg(File.errorString());
+    Written += Buffer.size();
+    Buffer.clear();
+}
+
+void toResultSpill::map(qint64 end) const
+{
+    if (end <= MapSize)
+        return;
+    flush();
+    if (Map)
+        File.unmap(Map);
+    Map = File.map(0, Written);
+    if (Map == NULL)
+    {
+        MapSize = 0;
+        throw QObject::tr("Can not map temporary file of result rows: %1").arg(File.errorString());
+    }
+    MapSize = Written;
+}
+
+toResultSpill::Page const* toResultSpill::page(int row) const
+{
+    int first = row - row % PAGE_ROWS;
+    Page *retval = Pages.object(first);
+    if (retval)
+        return retval;
+
+    int last = qMin(first + PAGE_ROWS, rows());
+    map(last < rows() ? Offsets.at(last) : fileSize());
+
+    retval = new Page;
+    retval->Cells.reserve((last - first) * Columns);
+    decode(Map + Offsets.at(first), last - first, Columns, retval->Cells);
+    Pages.insert(first, retval);
+    return retval;
+}
+
+QSharedPointer<toResultSpill::Reader> toResultSpill::reader() const
+{
+    flush();
+    return QSharedPointer<Reader>(new Reader(File.fileName(), Offsets, Written, Columns));
+}
+
+toResultSpill::Reader::Reader(QString const &fileName, QVector<qint64> const &offsets, qint64 size, int columns)
+    : File(fileName)
+    , Offsets(offsets)
+    , Size(size)
+    , Columns(columns)
+    , Map(NULL)
+{}
+
+toResultSpill::Reader::~Reader()
+{
+    if (Map)
+        File.unmap(Map);
+}
+
+void toResultSpill::Reader::read(int first, int count, QVector<toQValue> &cells)
+{
+    if (Map == NULL && Size > 0)
+    {
+        if (!File.open(QIODevice::ReadOnly) || (Map = File.map(0, Size)) == NULL)
+            throw QObject::tr("Can not read temporary file of result rows: %1").arg(File.errorString());
+    }
+    cells.clear();
+    if (count <= 0)
+        return;
+    cells.reserve(count * Columns);
+    toResultSpill::decode(Map + Offsets.at(first), count, Columns, cells);
+}
+
+void toResultSpill::decode(uchar const *data, int rows, int columns, QVector<toQValue> &cells)
+{
+    for (int r = 0; r < rows; r++)
+    {
+        for (int col = 0; col < columns; col++)
+        {
+            Tag tag = (Tag) * data++;
+            switch (tag)
+            {
+                case NullTag:
+                case MemoryTag:
+                    cells.append(toQValue());
+                    break;
+                case IntTag:
+                case LongTag:
+                    {
+                        qint64 v;
+                        memcpy(&v, data, sizeof(v));
+                        data += sizeof(v);
+                        if (tag == LongTag)
+                            cells.append(toQValue((qlonglong) v));
+                        else
+                            cells.append(toQValue((int) v));
+                    }
+                    break;
+                case DoubleTag:
+                    {
+                        double v;
+                        memcpy(&v, data, sizeof(v));
+                        data += sizeof(v);
+                        cells.append(toQValue(v));
+                    }
+                    break;
+                case StringTag:
+                case BinaryTag:
+                case VariantTag:
+                    {
+                        qint32 len;
+                        memcpy(&len, data, sizeof(len));
+                        data += sizeof(len);
+                        if (tag == StringTag)
+                        {
+                            QString s(len / sizeof(QChar), Qt::Uninitialized);
+                            memcpy(s.data(), data, len);
+                            cells.append(toQValue(s));
+                        }
+                        else if (tag == BinaryTag)
+                        {
+                            cells.append(toQValue::createBinary(QByteArray((char const*) data, len)));
+                        }
+                        else
+                        {
+                            QByteArray raw = QByteArray::fromRawData((char const*) data, len);
+                            QDataStream stream(raw);
+                            QVariant v;
+                            stream >> v;
+                            cells.append(toQValue::fromVariant(v));
+                        }
+                        data += len;
+                    }
+                    break;
+            }
+        }
+    }
+}
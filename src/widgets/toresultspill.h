@@ -0,0 +1,191 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TORESULTSPILL_H
+#define TORESULTSPILL_H
+
+#include "core/toqvalue.h"
+#include "core/toquery.h"
+#include "core/toquerybatch.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCache>
+#include <QtCore/QFile>
+#include <QtCore/QHash>
+#include <QtCore/QSharedPointer>
+#include <QtCore/QTemporaryFile>
+#include <QtCore/QVector>
+
+/**
+ * Temporary file holding the rows of @ref toResultStore which did not fit
+ * into the memory threshold.
+ *
+ * Rows are written in a compact binary row format, each cell is one tag byte
+ * followed by the value (int64, double, length prefixed UTF-16 string or bytes).
+ * Complex types (LOBs, ...) can not be serialized, they stay in memory.
+ *
+ * The file is memory mapped for reading, decoded rows are kept
+ * in a small page cache.
+ */
+class toResultSpill
+{
+    public:
+        /** Number of rows decoded at once */
+        static const int PAGE_ROWS = 256;
+
+        /** Number of decoded pages kept in memory */
+        static const int CACHED_PAGES = 64;
+
+        explicit toResultSpill(int columns);
+        ~toResultSpill();
+
+        /** Create the temporary file, throws QString on failure */
+        void open(void);
+
+        inline int rows(void) const
+        {
+            return Offsets.size();
+        }
+
+        inline int columns(void) const
+        {
+            return Columns;
+        }
+
+        /** Size of the data written into the file */
+        qint64 fileSize(void) const;
+
+        /** Approximate size of the memory used (row offsets, page cache and complex types) */
+        size_t byteSize(void) const;
+
+        /** Append all the rows from the batch */
+        void appendBatch(toQueryBatch &batch);
+
+        /** Append one row, missing cells are nulls */
+        void appendRow(toQueryAbstr::Row const &cells);
+
+        /** Box the cell, complex types are accessed by complex() */
+        toQValue value(int row, int col) const;
+
+        /** Return complex type stored in memory or NULL */
+        toQValue const* complex(int row, int col) const;
+
+        bool isNull(int row, int col) const;
+
+        /**
+         * Reader of the rows written so far, independent of the spill
+         * so it can be used by another thread (see @ref toResultFilter).
+         * Complex types are read as nulls.
+         */
+        class Reader
+        {
+            public:
+                Reader(QString const &fileName, QVector<qint64> const &offsets, qint64 size, int columns);
+                ~Reader();
+
+                inline int rows(void) const
+                {
+                    return Offsets.size();
+                }
+
+                inline int columns(void) const
+                {
+                    return Columns;
+                }
+
+                /** Decode rows [first, first + count) into cells (row by row), throws QString */
+                void read(int first, int count, QVector<toQValue> &cells);
+
+            private:
+                QFile File;
+                QVector<qint64> Offsets;
+                qint64 Size;
+                int Columns;
+                uchar *Map;
+        };
+
+        /** Write pending rows into the file and create a reader of them */
+        QSharedPointer<Reader> reader(void) const;
+
+    private:
+        enum Tag
+        {
+            NullTag,
+            IntTag,
+            LongTag,
+            DoubleTag,
+            StringTag,
+            BinaryTag,
+            VariantTag,     // QDataStream serialized QVariant
+            MemoryTag       // complex type kept in Complex
+        };
+
+        // Decoded rows [first, first + PAGE_ROWS) stored row by row
+        struct Page
+        {
+            QVector<toQValue> Cells;
+        };
+
+        static inline quint64 complexKey(int row, int col)
+        {
+            return (quint64(row) << 32) | quint32(col);
+        }
+
+        void beginRow(void);
+        void writeTag(Tag tag);
+        void writeInt(Tag tag, qint64 value);
+        void writeDouble(double value);
+        void writeBytes(Tag tag, char const *data, int len);
+        void writeString(QString const &value);
+        void writeValue(int row, int col, toQValue const &value);
+        void flush(void) const;
+
+        /** Decode rows stored from data, cells are appended row by row */
+        static void decode(uchar const *data, int rows, int columns, QVector<toQValue> &cells);
+
+        Page const* page(int row) const;
+        void map(qint64 end) const;
+
+        int Columns;
+        mutable QTemporaryFile File;
+        mutable QByteArray Buffer;          // rows not written into the file yet
+        mutable qint64 Written;             // bytes written into the file
+        mutable uchar *Map;
+        mutable qint64 MapSize;
+        QVector<qint64> Offsets;            // file offset of each row
+        QHash<quint64, toQValue> Complex;
+        mutable QCache<int, Page> Pages;
+};
+
+#endif
@@ -0,0 +1,1135 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#include "widgets/toresultstore.h"
+#include "core/utils.h"
+
+#include <QtCore/QRegExp>
+#include <QtCore/QThread>
+
+#include <algorithm>
+#include <thread>
+
+// integers up to 2^53 are stored in double without loss
+static inline bool exactDouble(qint64 value)
+{
+    return value >= -(Q_INT64_C(1) << 53) && value <= (Q_INT64_C(1) << 53);
+}
+
+toResultStore::Column::Column()
+    : Type(NullColumn)
+    , LongInts(false)
+    , Size(0)
+{}
+
+toResultStore::toResultStore()
+    : Resident(0)
+    , SpillThreshold(0)
+    , SpillFailed(false)
+{}
+
+void toResultStore::clear()
+{
+    Columns.clear();
+    Resident = 0;
+    Spill.reset();
+    SpillFailed = false;
+    RowDescs.clear();
+    AllRows.clear();
+    Order.clear();
+    Visible.clear();
+    Overlay.clear();
+}
+
+size_t toResultStore::byteSize() const
+{
+    size_t retval = 0;
+    for (std::vector<Column>::const_iterator c = Columns.begin(); c != Columns.end(); ++c)
+    {
+        retval += c->Ints.size() * sizeof(qint64);
+        retval += c->Doubles.size() * sizeof(double);
+        retval += c->Codes.size() * sizeof(quint16);
+        foreach(QString const& s, c->Dictionary)
+            retval += s.size() * sizeof(QChar);
+        retval += c->Chars.size() * sizeof(QChar);
+        retval += c->Offsets.size() * sizeof(int);
+        retval += c->Variants.size() * sizeof(toQValue);
+        retval += c->Nulls.size() * sizeof(quint32);
+    }
+    retval += RowDescs.size() * sizeof(toRowDesc);
+    retval += (AllRows.size() + Order.size()) * sizeof(int);
+    retval += Overlay.size() * (sizeof(quint64) + sizeof(toQValue));
+    if (Spill)
+        retval += Spill->byteSize();
+    return retval;
+}
+
+qint64 toResultStore::spilledSize() const
+{
+    return Spill ? Spill->fileSize() : 0;
+}
+
+int toResultStore::spilledRows() const
+{
+    return Spill ? Spill->rows() : 0;
+}
+
+void toResultStore::setSpillThreshold(qint64 bytes)
+{
+    SpillThreshold = bytes;
+}
+
+toResultStore::ColumnType toResultStore::columnType(int col) const
+{
+    return Columns.at(col).Type;
+}
+
+void toResultStore::appendBatch(toQueryBatch &batch, int &currRowKey)
+{
+    int rows = batch.rows();
+    if (rows == 0)
+        return;
+
+    ensureColumns(batch.columns());
+    if (!Spill && !SpillFailed && SpillThreshold > 0 && (qint64) byteSize() > SpillThreshold)
+        startSpill();
+
+    if (Spill)
+        Spill->appendBatch(batch);
+    else
+        appendColumns(batch);
+
+    RowDescs.reserve(RowDescs.size() + rows);
+    AllRows.reserve(AllRows.size() + rows);
+    Order.reserve(Order.size() + rows);
+    for (int r = 0; r < rows; r++)
+    {
+        toRowDesc desc;
+        desc.key = currRowKey++;
+        desc.status = EXISTED;
+        AllRows.append(RowDescs.size());
+        Order.append(RowDescs.size());
+        RowDescs.append(desc);
+    }
+}
+
+void toResultStore::appendColumns(toQueryBatch &batch)
+{
+    int rows = batch.rows();
+    for (unsigned col = 0; col < batch.columns(); col++)
+    {
+        Column &c = Columns[col];
+        switch (batch.columnType(col))
+        {
+            case toQueryBatch::NullColumn:
+                for (int r = 0; r < rows; r++)
+                    pushNull(c);
+                break;
+            case toQueryBatch::IntColumn:
+                {
+                    bool isLong = batch.longInts(col);
+                    for (int r = 0; r < rows; r++)
+                        if (batch.isNull(r, col))
+                            pushNull(c);
+                        else
+                            pushInt(c, batch.intAt(r, col), isLong);
+                }
+                break;
+            case toQueryBatch::DoubleColumn:
+                for (int r = 0; r < rows; r++)
+                    if (batch.isNull(r, col))
+                        pushNull(c);
+                    else
+                        pushDouble(c, batch.doubleAt(r, col));
+                break;
+            case toQueryBatch::StringColumn:
+                for (int r = 0; r < rows; r++)
+                    if (batch.isNull(r, col))
+                        pushNull(c);
+                    else
+                        pushString(c, batch.stringAt(r, col).toString());
+                break;
+            case toQueryBatch::VariantColumn:
+                for (int r = 0; r < rows; r++)
+                    pushValue(c, batch.value(r, col)); // moves complex types out of the batch
+                break;
+        }
+    }
+    for (unsigned col = batch.columns(); col < Columns.size(); col++)
+        for (int r = 0; r < rows; r++)
+            pushNull(Columns[col]);
+    Resident += rows;
+}
+
+void toResultStore::appendRow(toRowDesc const &desc, toQueryAbstr::Row const &cells)
+{
+    ensureColumns(cells.size());
+    if (Spill)
+        Spill->appendRow(cells);
+    else
+    {
+        for (int col = 0; col < (int) Columns.size(); col++)
+            if (col < cells.size())
+                pushValue(Columns[col], cells.at(col));
+            else
+                pushNull(Columns[col]);
+        Resident++;
+    }
+
+    AllRows.append(RowDescs.size());
+    Order.append(RowDescs.size());
+    RowDescs.append(desc);
+}
+
+void toResultStore::insertRow(int row, toRowDesc const &desc)
+{
+    if (Spill)
+        Spill->appendRow(toQueryAbstr::Row());
+    else
+    {
+        for (std::vector<Column>::iterator c = Columns.begin(); c != Columns.end(); ++c)
+            pushNull(*c);
+        Resident++;
+    }
+
+    // among all the rows the new one goes right after the visible row above it
+    int phys = RowDescs.size();
+    AllRows.insert(row == 0 ? 0 : AllRows.indexOf(Order.at(row - 1)) + 1, phys);
+    Order.insert(row, phys);
+    RowDescs.append(desc);
+}
+
+void toResultStore::removeRow(int row)
+{
+    int phys = physical(row);
+    if (!Overlay.isEmpty())
+        for (int col = 0; col < (int) Columns.size(); col++)
+            Overlay.remove(overlayKey(phys, col));
+    // Physical row stays allocated, only rows added by the user are removed
+    AllRows.remove(AllRows.indexOf(phys));
+    Order.remove(row);
+}
+
+toRowDesc const& toResultStore::rowDesc(int row) const
+{
+    return RowDescs.at(physical(row));
+}
+
+void toResultStore::setRowDesc(int row, toRowDesc const &desc)
+{
+    RowDescs[physical(row)] = desc;
+}
+
+bool toResultStore::isNull(int row, int col) const
+{
+    if (col < 0 || col >= (int) Columns.size())
+        return true;
+    int phys = physical(row);
+    if (!Overlay.isEmpty())
+    {
+        QHash<quint64, toQValue>::const_iterator i = Overlay.constFind(overlayKey(phys, col));
+        if (i != Overlay.constEnd())
+            return i->isNull();
+    }
+    if (phys >= Resident)
+        return Spill->isNull(phys - Resident, col);
+    return isNull(Columns.at(col), phys);
+}
+
+bool toResultStore::isComplex(int row, int col) const
+{
+    toQValue const *v = cell(row, col);
+    return v && v->isComplexType();
+}
+
+toQValue const* toResultStore::cell(int row, int col) const
+{
+    return cellAt(physical(row), col);
+}
+
+toQValue const* toResultStore::cellAt(int phys, int col) const
+{
+    if (col < 0 || col >= (int) Columns.size())
+        return NULL;
+    if (!Overlay.isEmpty())
+    {
+        QHash<quint64, toQValue>::const_iterator i = Overlay.constFind(overlayKey(phys, col));
+        if (i != Overlay.constEnd())
+            return &i.value();
+    }
+    if (phys >= Resident)
+        return Spill->complex(phys - Resident, col);
+    Column const &c = Columns.at(col);
+    if (c.Type == VariantColumn)
+        return &c.Variants.at(phys);
+    return NULL;
+}
+
+toQValue toResultStore::value(int row, int col) const
+{
+    return valueAt(physical(row), col);
+}
+
+toQValue toResultStore::valueAt(int phys, int col) const
+{
+    toQValue const *v = cellAt(phys, col);
+    if (v == NULL)
+    {
+        if (col < 0 || col >= (int) Columns.size())
+            return toQValue();
+        if (phys >= Resident)
+            return Spill->value(phys - Resident, col);
+        return boxed(Columns.at(col), phys);
+    }
+    if (v->isComplexType())
+    {
+        toQValue::complexType *i = v->toQVariant().value<toQValue::complexType*>();
+        return toQValue(i->displayData());
+    }
+    return *v;
+}
+
+void toResultStore::setValue(int row, int col, toQValue const &value)
+{
+    ensureColumns(col + 1);
+    Overlay.insert(overlayKey(physical(row), col), value);
+}
+
+toQueryAbstr::Row toResultStore::row(int row) const
+{
+    toQueryAbstr::Row retval;
+    retval.reserve(Columns.size() + 1);
+    retval.append(toQValue(rowDesc(row)));
+    for (int col = 0; col < (int) Columns.size(); col++)
+        retval.append(value(row, col));
+    return retval;
+}
+
+void toResultStore::setOrder(QVector<int> const &order)
+{
+    Q_ASSERT_X(order.size() == AllRows.size(), qPrintable(__QHERE__), "Row order size mismatch");
+    AllRows = order;
+    updateVisibleOrder();
+}
+
+void toResultStore::setVisible(QBitArray const &visible)
+{
+    Visible = visible;
+    updateVisibleOrder();
+}
+
+void toResultStore::updateVisibleOrder()
+{
+    if (Visible.isEmpty())
+    {
+        Order = AllRows;
+        return;
+    }
+
+    QVector<int> order;
+    order.reserve(AllRows.size());
+    for (QVector<int>::const_iterator i = AllRows.constBegin(); i != AllRows.constEnd(); ++i)
+        if (*i >= Visible.size() || Visible.testBit(*i))
+            order.append(*i);
+    Order = order;
+}
+
+// Sort key extracted from one column, indexed by logical row
+struct toResultStore::SortKey
+{
+    enum KeyType
+    {
+        IntKey,
+        RealKey,
+        TextKey
+    };
+
+    KeyType Type;
+    bool Descending;
+    QVector<qint64> Ints;
+    QVector<double> Reals;
+    QVector<QString> Texts;
+    QVector<bool> Nulls;
+
+    inline int compare(int left, int right) const
+    {
+        int retval = 0;
+        bool leftNull = Nulls.at(left), rightNull = Nulls.at(right);
+        if (leftNull || rightNull)
+            retval = leftNull == rightNull ? 0 : (leftNull ? -1 : 1); // NULLs first
+        else
+            switch (Type)
+            {
+                case IntKey:
+                    retval = Ints.at(left) < Ints.at(right) ? -1 : (Ints.at(left) > Ints.at(right) ? 1 : 0);
+                    break;
+                case RealKey:
+                    retval = Reals.at(left) < Reals.at(right) ? -1 : (Reals.at(left) > Reals.at(right) ? 1 : 0);
+                    break;
+                case TextKey:
+                    retval = QString::compare(Texts.at(left), Texts.at(right));
+                    break;
+            }
+        return Descending ? -retval : retval;
+    }
+};
+
+struct toResultStore::SortLess
+{
+    SortLess(std::vector<SortKey> const &keys)
+        : Keys(keys)
+    {}
+
+    bool operator()(int left, int right) const
+    {
+        for (std::vector<SortKey>::const_iterator k = Keys.begin(); k != Keys.end(); ++k)
+        {
+            int c = k->compare(left, right);
+            if (c != 0)
+                return c < 0;
+        }
+        return false;
+    }
+
+    std::vector<SortKey> const &Keys;
+};
+
+namespace
+{
+    // Sort chunks of data in threads, then merge the sorted chunks pairwise (also in threads)
+    template <typename Less>
+    void parallelStableSort(int *data, int size, Less const &less)
+    {
+        int threads = qMin(QThread::idealThreadCount(), size / toResultStore::PARALLEL_SORT_CHUNK);
+        if (threads <= 1)
+        {
+            std::stable_sort(data, data + size, less);
+            return;
+        }
+
+        std::vector<int> bounds;
+        for (int t = 0; t <= threads; t++)
+            bounds.push_back(qint64(size) * t / threads);
+
+        std::vector<std::thread> workers;
+        for (int t = 0; t < threads; t++)
+        {
+            int *first = data + bounds[t], *last = data + bounds[t + 1];
+            workers.push_back(std::thread([first, last, &less]()
+            {
+                std::stable_sort(first, last, less);
+            }));
+        }
+        for (std::vector<std::thread>::iterator w = workers.begin(); w != workers.end(); ++w)
+            w->join();
+
+        std::vector<int> buffer(size);
+        int *src = data, *dst = &buffer[0];
+        while (bounds.size() > 2)
+        {
+            std::vector<int> merged;
+            workers.clear();
+            size_t i = 0;
+            for (; i + 2 < bounds.size(); i += 2)
+            {
+                int *first = src + bounds[i], *middle = src + bounds[i + 1], *last = src + bounds[i + 2];
+                int *out = dst + bounds[i];
+                // std::merge takes the left element first on equal keys, it is stable
+                workers.push_back(std::thread([first, middle, last, out, &less]()
+                {
+                    std::merge(first, middle, middle, last, out, less);
+                }));
+                merged.push_back(bounds[i]);
+            }
+            if (i + 1 < bounds.size())
+            {
+                // odd chunk, nothing to merge with
+                std::copy(src + bounds[i], src + bounds[i + 1], dst + bounds[i]);
+                merged.push_back(bounds[i]);
+            }
+            merged.push_back(size);
+            for (std::vector<std::thread>::iterator w = workers.begin(); w != workers.end(); ++w)
+                w->join();
+            bounds.swap(merged);
+            std::swap(src, dst);
+        }
+        if (src != data)
+            std::copy(src, src + size, data);
+    }
+}
+
+QVector<int> toResultStore::sortedOrder(QList<SortColumn> const &columns) const
+{
+    std::vector<SortKey> keys(columns.size());
+    for (int k = 0; k < columns.size(); k++)
+        extractKey(columns.at(k), keys[k]);
+
+    // Sort logical rows, the data stay in place
+    QVector<int> rows(AllRows.size());
+    for (int i = 0; i < rows.size(); i++)
+        rows[i] = i;
+    if (!rows.isEmpty())
+        parallelStableSort(rows.data(), rows.size(), SortLess(keys));
+
+    QVector<int> retval(rows.size());
+    for (int i = 0; i < rows.size(); i++)
+        retval[i] = AllRows.at(rows.at(i));
+    return retval;
+}
+
+void toResultStore::extractKey(SortColumn const &column, SortKey &key) const
+{
+    int rows = AllRows.size();
+    key.Descending = column.Order == Qt::DescendingOrder;
+    key.Nulls.fill(false, rows);
+
+    if (column.Column < 0)
+    {
+        key.Type = SortKey::IntKey;
+        key.Ints.resize(rows);
+        for (int i = 0; i < rows; i++)
+            key.Ints[i] = RowDescs.at(AllRows.at(i)).key;
+        return;
+    }
+
+    if (column.Column >= (int) Columns.size())
+    {
+        key.Type = SortKey::IntKey;
+        key.Ints.fill(0, rows);
+        key.Nulls.fill(true, rows);
+        return;
+    }
+
+    // Column arrays can be used directly unless some cells are edited or spilled
+    Column const &c = Columns.at(column.Column);
+    bool typed = !Spill && Overlay.isEmpty();
+    if (typed && c.Type == IntColumn)
+    {
+        key.Type = SortKey::IntKey;
+        key.Ints.resize(rows);
+        for (int i = 0; i < rows; i++)
+        {
+            int phys = AllRows.at(i);
+            key.Nulls[i] = isNull(c, phys);
+            key.Ints[i] = c.Ints.at(phys);
+        }
+        return;
+    }
+    if (typed && c.Type == DoubleColumn)
+    {
+        key.Type = SortKey::RealKey;
+        key.Reals.resize(rows);
+        for (int i = 0; i < rows; i++)
+        {
+            int phys = AllRows.at(i);
+            key.Nulls[i] = isNull(c, phys);
+            key.Reals[i] = c.Doubles.at(phys);
+        }
+        return;
+    }
+    if (typed && c.Type == DictColumn)
+    {
+        // Numbers (as strings) are compared as numbers, see toQValue::operator<
+        bool numeric = true;
+        QVector<double> numbers(c.Dictionary.size());
+        for (int d = 0; d < c.Dictionary.size() && numeric; d++)
+            numbers[d] = c.Dictionary.at(d).toDouble(&numeric);
+
+        // Otherwise the dictionary is sorted once and rows are compared by rank
+        QVector<qint64> rank(c.Dictionary.size());
+        if (!numeric)
+        {
+            QVector<int> sorted(c.Dictionary.size());
+            for (int d = 0; d < sorted.size(); d++)
+                sorted[d] = d;
+            QVector<QString> const &dict = c.Dictionary;
+            std::sort(sorted.begin(), sorted.end(), [&dict](int left, int right)
+            {
+                return dict.at(left) < dict.at(right);
+            });
+            for (int d = 0; d < sorted.size(); d++)
+                rank[sorted.at(d)] = d;
+        }
+
+        key.Type = numeric ? SortKey::RealKey : SortKey::IntKey;
+        if (numeric)
+            key.Reals.resize(rows);
+        else
+            key.Ints.resize(rows);
+        for (int i = 0; i < rows; i++)
+        {
+            int phys = AllRows.at(i);
+            key.Nulls[i] = isNull(c, phys);
+            if (numeric)
+                key.Reals[i] = numbers.at(c.Codes.at(phys));
+            else
+                key.Ints[i] = rank.at(c.Codes.at(phys));
+        }
+        return;
+    }
+
+    // Box the cells (string arena, mixed types, edited or spilled rows).
+    // The column is compared as numbers if all the values are numbers.
+    bool numeric = true;
+    key.Reals.resize(rows);
+    key.Texts.resize(rows);
+    for (int i = 0; i < rows; i++)
+    {
+        toQValue v = valueAt(AllRows.at(i), column.Column);
+        if (v.isNull())
+        {
+            key.Nulls[i] = true;
+            continue;
+        }
+        key.Texts[i] = v.toQVariant().toString();
+        if (v.isNumber())
+            key.Reals[i] = v.toDouble();
+        else if (numeric)
+            key.Reals[i] = key.Texts.at(i).toDouble(&numeric);
+    }
+    key.Type = numeric ? SortKey::RealKey : SortKey::TextKey;
+    if (numeric)
+        key.Texts.clear();
+    else
+        key.Reals.clear();
+}
+
+namespace
+{
+    // Text of the cell as displayed by toResultModel
+    QString textOf(toQValue const &v)
+    {
+        if (v.isComplexType())
+            return v.toQVariant().value<toQValue::complexType*>()->displayData();
+        return v.displayData();
+    }
+
+    inline bool testNull(QVector<quint32> const &nulls, int phys)
+    {
+        return nulls.at(phys / 32) & (1u << (phys % 32));
+    }
+}
+
+toResultStore::Snapshot::Snapshot()
+    : Resident(0)
+    , Rows(0)
+{}
+
+QString toResultStore::Snapshot::residentText(int phys, int col) const
+{
+    TextColumn const &c = Columns.at(col);
+    if (c.Type == NullColumn || testNull(c.Nulls, phys))
+        return QString();
+    switch (c.Type)
+    {
+        case IntColumn:
+            return QString::number(c.Ints.at(phys));
+        case DoubleColumn:
+            return QVariant(c.Doubles.at(phys)).toString();
+        case DictColumn:
+            return c.Dictionary.at(c.Codes.at(phys));
+        case StringColumn:
+            {
+                int from = c.Offsets.at(phys);
+                return QString(c.Chars.unicode() + from, c.Offsets.at(phys + 1) - from);
+            }
+        case VariantColumn:
+            return c.Texts.at(phys);
+        case NullColumn:
+            break;
+    }
+    return QString();
+}
+
+toResultStore::Snapshot::Cursor::Cursor(Snapshot const &snapshot)
+    : Data(&snapshot)
+    , Phys(-1)
+    , PageFirst(-1)
+{}
+
+void toResultStore::Snapshot::Cursor::seek(int phys)
+{
+    Phys = phys;
+    if (phys < Data->Resident || !Data->Spilled)
+        return;
+    int row = phys - Data->Resident;
+    if (row >= Data->Spilled->rows())
+    {
+        PageFirst = -1;
+        Page.clear();
+        return;
+    }
+    if (PageFirst >= 0 && row >= PageFirst && row < PageFirst + toResultSpill::PAGE_ROWS)
+        return;
+    PageFirst = row - row % toResultSpill::PAGE_ROWS;
+    Data->Spilled->read(PageFirst, qMin(toResultSpill::PAGE_ROWS, Data->Spilled->rows() - PageFirst), Page);
+}
+
+QString toResultStore::Snapshot::Cursor::text(int col) const
+{
+    if (!Data->Edited.isEmpty())
+    {
+        QHash<quint64, QString>::const_iterator i = Data->Edited.constFind(overlayKey(Phys, col));
+        if (i != Data->Edited.constEnd())
+            return i.value();
+    }
+    if (Phys < Data->Resident)
+        return Data->residentText(Phys, col);
+    if (PageFirst < 0 || col >= Data->Spilled->columns())
+        return QString();
+    toQValue const &v = Page.at((Phys - Data->Resident - PageFirst) * Data->Spilled->columns() + col);
+    return v.isNull() ? QString() : textOf(v);
+}
+
+toResultStore::Snapshot toResultStore::snapshot() const
+{
+    Snapshot retval;
+    retval.Resident = Resident;
+    retval.Rows = RowDescs.size();
+    retval.Columns.resize(Columns.size());
+    for (size_t col = 0; col < Columns.size(); col++)
+    {
+        // QVector and QString are implicitly shared, these are cheap copies
+        Column const &c = Columns.at(col);
+        Snapshot::TextColumn &t = retval.Columns[col];
+        t.Type = c.Type;
+        t.Nulls = c.Nulls;
+        switch (c.Type)
+        {
+            case IntColumn:
+                t.Ints = c.Ints;
+                break;
+            case DoubleColumn:
+                t.Doubles = c.Doubles;
+                break;
+            case DictColumn:
+                t.Codes = c.Codes;
+                t.Dictionary = c.Dictionary;
+                break;
+            case StringColumn:
+                t.Chars = c.Chars;
+                t.Offsets = c.Offsets;
+                break;
+            case VariantColumn:
+                // toQValue can not be shared between threads (LOBs), take the text
+                t.Texts.reserve(c.Size);
+                for (int phys = 0; phys < c.Size; phys++)
+                    t.Texts.append(isNull(c, phys) ? QString() : textOf(c.Variants.at(phys)));
+                break;
+            case NullColumn:
+                break;
+        }
+    }
+    for (QHash<quint64, toQValue>::const_iterator i = Overlay.constBegin(); i != Overlay.constEnd(); ++i)
+        retval.Edited.insert(i.key(), i.value().isNull() ? QString() : textOf(i.value()));
+    if (Spill)
+        retval.Spilled = Spill->reader();
+    return retval;
+}
+
+QBitArray toResultStore::Snapshot::match(QString const &text,
+        bool regExp,
+        Qt::CaseSensitivity cs,
+        QBitArray const &candidates,
+        QAtomicInt const &generation,
+        int expected) const
+{
+    QBitArray visible(Rows, false);
+    QRegExp re(text, cs, QRegExp::RegExp2); // used by this thread only, QRegExp is not thread safe
+
+    auto matches = [&](QString const & s) -> bool
+    {
+        if (s.isEmpty())
+            return false;
+        return regExp ? re.indexIn(s) >= 0 : s.contains(text, cs);
+    };
+    auto candidate = [&](int phys) -> bool
+    {
+        return !visible.testBit(phys) && (phys >= candidates.size() || candidates.testBit(phys));
+    };
+    auto edited = [&](int phys, int col, bool & found) -> bool
+    {
+        found = false;
+        if (Edited.isEmpty())
+            return false;
+        QHash<quint64, QString>::const_iterator i = Edited.constFind(overlayKey(phys, col));
+        if (i == Edited.constEnd())
+            return false;
+        found = true;
+        return matches(i.value());
+    };
+
+    for (size_t col = 0; col < Columns.size(); col++)
+    {
+        TextColumn const &c = Columns.at(col);
+
+        // Dictionary entries are matched once
+        QVector<bool> dict(c.Dictionary.size());
+        for (int d = 0; d < c.Dictionary.size(); d++)
+            dict[d] = matches(c.Dictionary.at(d));
+
+        for (int phys = 0; phys < Resident; phys++)
+        {
+            if (phys % 4096 == 0 && int(generation) != expected)
+                return QBitArray();
+            if (!candidate(phys))
+                continue;
+
+            bool found, m = edited(phys, col, found);
+            if (!found)
+            {
+                if (c.Type == NullColumn || testNull(c.Nulls, phys))
+                    continue;
+                switch (c.Type)
+                {
+                    case IntColumn:
+                        m = matches(QString::number(c.Ints.at(phys)));
+                        break;
+                    case DoubleColumn:
+                        m = matches(QVariant(c.Doubles.at(phys)).toString());
+                        break;
+                    case DictColumn:
+                        m = dict.at(c.Codes.at(phys));
+                        break;
+                    case StringColumn:
+                        {
+                            int from = c.Offsets.at(phys);
+                            m = matches(QString::fromRawData(c.Chars.unicode() + from, c.Offsets.at(phys + 1) - from));
+                        }
+                        break;
+                    case VariantColumn:
+                        m = matches(c.Texts.at(phys));
+                        break;
+                    case NullColumn:
+                        break;
+                }
+            }
+            if (m)
+                visible.setBit(phys);
+        }
+    }
+
+    if (Spilled)
+    {
+        // Rows written to disk are decoded page by page
+        QVector<toQValue> cells;
+        int columns = Spilled->columns();
+        for (int first = 0; first < Spilled->rows() && Resident + first < Rows; first += toResultSpill::PAGE_ROWS)
+        {
+            if (int(generation) != expected)
+                return QBitArray();
+            int count = qMin(toResultSpill::PAGE_ROWS, Spilled->rows() - first);
+            Spilled->read(first, count, cells);
+            for (int r = 0; r < count && Resident + first + r < Rows; r++)
+            {
+                int phys = Resident + first + r;
+                for (int col = 0; col < columns && candidate(phys); col++)
+                {
+                    bool found, m = edited(phys, col, found);
+                    if (!found)
+                    {
+                        toQValue const &v = cells.at(r * columns + col);
+                        m = !v.isNull() && matches(textOf(v));
+                    }
+                    if (m)
+                        visible.setBit(phys);
+                }
+            }
+        }
+    }
+    return visible;
+}
+
+void toResultStore::ensureColumns(int cols)
+{
+    while ((int) Columns.size() < cols)
+    {
+        Columns.push_back(Column());
+        for (int r = 0; r < Resident; r++)
+            pushNull(Columns.back());
+    }
+}
+
+void toResultStore::startSpill()
+{
+    try
+    {
+        QScopedPointer<toResultSpill> spill(new toResultSpill(Columns.size()));
+        spill->open();
+        Spill.swap(spill);
+    }
+    catch (const QString &str)
+    {
+        // keep all the rows in memory
+        SpillFailed = true;
+        Utils::toStatusMessage(str);
+    }
+}
+
+void toResultStore::prepare(Column &c, ColumnType type)
+{
+    // Column contained NULLs only so far
+    Q_ASSERT_X(c.Type == NullColumn, qPrintable(__QHERE__), "Column type already set");
+    c.Type = type;
+    switch (type)
+    {
+        case IntColumn:
+            c.Ints.fill(0, c.Size);
+            break;
+        case DoubleColumn:
+            c.Doubles.fill(0, c.Size);
+            break;
+        case DictColumn:
+            c.Codes.fill(0, c.Size);
+            break;
+        case StringColumn:
+            c.Offsets.fill(0, c.Size + 1);
+            break;
+        case VariantColumn:
+            c.Variants.resize(c.Size);
+            break;
+        case NullColumn:
+            break;
+    }
+}
+
+void toResultStore::pushNull(Column &c)
+{
+    switch (c.Type)
+    {
+        case NullColumn:
+            break; // arrays are filled in once the first value is known
+        case IntColumn:
+            c.Ints.append(0);
+            break;
+        case DoubleColumn:
+            c.Doubles.append(0);
+            break;
+        case DictColumn:
+            c.Codes.append(0);
+            break;
+        case StringColumn:
+            c.Offsets.append(c.Chars.size());
+            break;
+        case VariantColumn:
+            c.Variants.push_back(toQValue());
+            break;
+    }
+    if (c.Size % 32 == 0)
+        c.Nulls.append(0);
+    c.Nulls[c.Size / 32] |= 1u << (c.Size % 32);
+    c.Size++;
+}
+
+void toResultStore::pushNotNull(Column &c)
+{
+    if (c.Size % 32 == 0)
+        c.Nulls.append(0);
+    c.Size++;
+}
+
+void toResultStore::pushInt(Column &c, qint64 value, bool isLong)
+{
+    if (c.Type == NullColumn)
+        prepare(c, IntColumn);
+    if (c.Type == DoubleColumn && exactDouble(value))
+    {
+        // NUMBER column mixing integral and fractional values
+        pushDouble(c, (double) value);
+        return;
+    }
+    if (c.Type != IntColumn)
+    {
+        pushVariant(c, isLong ? toQValue((qlonglong) value) : toQValue((int) value));
+        return;
+    }
+    c.Ints.append(value);
+    c.LongInts |= isLong;
+    pushNotNull(c);
+}
+
+void toResultStore::pushDouble(Column &c, double value)
+{
+    if (c.Type == NullColumn)
+        prepare(c, DoubleColumn);
+    if (c.Type != DoubleColumn && !toDouble(c))
+    {
+        pushVariant(c, toQValue(value));
+        return;
+    }
+    c.Doubles.append(value);
+    pushNotNull(c);
+}
+
+void toResultStore::pushString(Column &c, QString const &value)
+{
+    if (c.Type == NullColumn)
+        prepare(c, DictColumn);
+
+    if (c.Type == DictColumn)
+    {
+        QHash<QString, quint16>::const_iterator i = c.DictionaryIndex.constFind(value);
+        if (i != c.DictionaryIndex.constEnd())
+        {
+            c.Codes.append(i.value());
+            pushNotNull(c);
+            return;
+        }
+        if (c.Dictionary.size() < DICTIONARY_LIMIT)
+        {
+            quint16 code = c.Dictionary.size();
+            c.Dictionary.append(value);
+            c.DictionaryIndex.insert(value, code);
+            c.Codes.append(code);
+            pushNotNull(c);
+            return;
+        }
+        // too many distinct values, dictionary does not pay off
+        toArena(c);
+    }
+
+    if (c.Type != StringColumn)
+    {
+        pushVariant(c, toQValue(value));
+        return;
+    }
+    c.Chars.append(value);
+    c.Offsets.append(c.Chars.size());
+    pushNotNull(c);
+}
+
+void toResultStore::pushVariant(Column &c, toQValue const &value)
+{
+    if (c.Type == NullColumn)
+        prepare(c, VariantColumn);
+    else if (c.Type != VariantColumn)
+        toVariant(c);
+    c.Variants.push_back(value);
+    pushNotNull(c);
+}
+
+void toResultStore::pushValue(Column &c, toQValue const &value)
+{
+    if (value.isNull())
+        pushNull(c);
+    else if (value.isInt() || value.isLong())
+        pushInt(c, value.toLong(), value.isLong());
+    else if (value.isDouble())
+        pushDouble(c, value.toDouble());
+    else if (value.isString())
+        pushString(c, value.toQVariant().toString());
+    else
+        pushVariant(c, value);
+}
+
+bool toResultStore::isNull(Column const &c, int phys)
+{
+    return c.Nulls.at(phys / 32) & (1u << (phys % 32));
+}
+
+toQValue toResultStore::boxed(Column const &c, int phys)
+{
+    if (isNull(c, phys))
+        return toQValue();
+
+    switch (c.Type)
+    {
+        case IntColumn:
+            if (c.LongInts)
+                return toQValue((qlonglong) c.Ints.at(phys));
+            return toQValue((int) c.Ints.at(phys));
+        case DoubleColumn:
+            return toQValue(c.Doubles.at(phys));
+        case DictColumn:
+            return toQValue(c.Dictionary.at(c.Codes.at(phys))); // implicitly shared
+        case StringColumn:
+            return toQValue(c.Chars.mid(c.Offsets.at(phys), c.Offsets.at(phys + 1) - c.Offsets.at(phys)));
+        case VariantColumn:
+            return c.Variants.at(phys);
+        case NullColumn:
+            break;
+    }
+    return toQValue();
+}
+
+void toResultStore::toArena(Column &c)
+{
+    Q_ASSERT_X(c.Type == DictColumn, qPrintable(__QHERE__), "Not a DictColumn");
+    c.Offsets.reserve(c.Size + 1);
+    c.Offsets.append(0);
+    for (int row = 0; row < c.Size; row++)
+    {
+        if (!isNull(c, row))
+            c.Chars.append(c.Dictionary.at(c.Codes.at(row)));
+        c.Offsets.append(c.Chars.size());
+    }
+    c.Codes.clear();
+    c.Dictionary.clear();
+    c.DictionaryIndex.clear();
+    c.Type = StringColumn;
+}
+
+bool toResultStore::toDouble(Column &c)
+{
+    if (c.Type != IntColumn)
+        return false;
+    for (int row = 0; row < c.Size; row++)
+        if (!exactDouble(c.Ints.at(row)))
+            return false;
+    c.Doubles.reserve(c.Size + 1);
+    for (int row = 0; row < c.Size; row++)
+        c.Doubles.append((double) c.Ints.at(row));
+    c.Ints.clear();
+    c.LongInts = false;
+    c.Type = DoubleColumn;
+    return true;
+}
+
+void toResultStore::toVariant(Column &c)
+{
+    std::vector<toQValue> variants;
+    variants.reserve(c.Size);
+    for (int row = 0; row < c.Size; row++)
+        variants.push_back(boxed(c, row));
+
+    c.Ints.clear();
+    c.Doubles.clear();
+    c.Codes.clear();
+    c.Dictionary.clear();
+    c.DictionaryIndex.clear();
+    c.Chars.clear();
+    c.Offsets.clear();
+    c.Variants.swap(variants);
+    c.Type = VariantColumn;
+}
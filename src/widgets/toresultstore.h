@@ -0,0 +1,344 @@
+
+/* BEGIN_COMMON_COPYRIGHT_HEADER
+ *
+ * TOra - An Oracle Toolkit for DBA's and developers
+ *
+ * Shared/mixed copyright is held throughout files in this product
+ *
+ * Portions Copyright (C) 2000-2001 Underscore AB
+ * Portions Copyright (C) 2003-2005 Quest Software, Inc.
+ * Portions Copyright (C) 2004-2013 Numerous Other Contributors
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License
+ * as published by the Free Software Foundation;  only version 2 of
+ * the License is valid for this program.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program as the file COPYING.txt; if not, please see
+ * http://www.gnu.org/licenses/old-licenses/gpl-2.0.txt.
+ *
+ *      As a special exception, you have permission to link this program
+ *      with the Oracle Client libraries and distribute executables, as long
+ *      as you follow the requirements of the GNU GPL in regard to all of the
+ *      software in the executable aside from Oracle client libraries.
+ *
+ * All trademarks belong to their respective owners.
+ *
+ * END_COMMON_COPYRIGHT_HEADER */
+
+#ifndef TORESULTSTORE_H
+#define TORESULTSTORE_H
+
+#include "core/toqvalue.h"
+#include "core/toquery.h"
+#include "core/toquerybatch.h"
+#include "widgets/toresultspill.h"
+
+#include <QtCore/QAtomicInt>
+#include <QtCore/QBitArray>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+#include <QtCore/QHash>
+#include <QtCore/QScopedPointer>
+
+#include <vector>
+
+/**
+ * Column oriented storage of the rows displayed by @ref toResultModel.
+ *
+ * Numbers are kept in fixed width arrays, strings either dictionary encoded
+ * (while the column has few distinct values) or in a single character arena.
+ * Nulls are kept in a bitmap. Integers mixed with doubles are stored as doubles.
+ * Only LOBs and other complex types, binary data and columns of other mixed
+ * types are stored as toQValue.
+ *
+ * Rows are appended physically and never moved, the logical (displayed) order
+ * is kept in a separate index. Rows hidden by a filter are left out of the logical
+ * order only. Cells changed by @ref toResultModelEdit are kept in an overlay which
+ * takes precedence over the column data.
+ *
+ * Once the store grows over the spill threshold all the following rows
+ * are written into @ref toResultSpill instead of the columns.
+ *
+ * Columns are numbered from 0 here, the model column 0 (row number) is
+ * represented by rowDesc().
+ */
+class toResultStore
+{
+    public:
+        enum ColumnType
+        {
+            NullColumn,     // no non-null value appended yet
+            IntColumn,
+            DoubleColumn,
+            DictColumn,     // low cardinality strings, codes into the dictionary
+            StringColumn,   // offsets into the string arena
+            VariantColumn
+        };
+
+        /** Max number of distinct values kept in the dictionary of a string column */
+        static const int DICTIONARY_LIMIT = 1024;
+
+        /** Minimal number of rows sorted by one thread */
+        static const int PARALLEL_SORT_CHUNK = 16384;
+
+        struct SortColumn
+        {
+            int Column;             // store column, -1 for the row number (key)
+            Qt::SortOrder Order;
+        };
+
+        /**
+         * Read only copy of the store for a background thread (see @ref toResultFilter).
+         * Column arrays are implicitly shared with the store, cells held as toQValue
+         * and edited cells are converted to text, spilled rows are read from the file.
+         */
+        class Snapshot
+        {
+            public:
+                Snapshot();
+
+                /** Number of physical rows */
+                inline int rows(void) const
+                {
+                    return Rows;
+                }
+
+                /** Find the rows containing text (or matching regular expression) in any cell.
+                 * Only the rows set in candidates (or behind its end) are checked.
+                 * @return visible bit for each physical row, an empty array when
+                 * generation no more equals expected (the filter was cancelled)
+                 */
+                QBitArray match(QString const &text,
+                                bool regExp,
+                                Qt::CaseSensitivity cs,
+                                QBitArray const &candidates,
+                                QAtomicInt const &generation,
+                                int expected) const;
+
+                /** Reads the text of the cells of one physical row, spilled rows page by page */
+                class Cursor
+                {
+                    public:
+                        explicit Cursor(Snapshot const &snapshot);
+
+                        /** Move to the physical row, throws QString when a spilled row can not be read */
+                        void seek(int phys);
+
+                        inline int columns(void) const
+                        {
+                            return int(Data->Columns.size());
+                        }
+
+                        /** Cell text as displayed by the model, empty for NULL */
+                        QString text(int col) const;
+
+                    private:
+                        Snapshot const *Data;
+                        int Phys;
+                        int PageFirst;              // first spilled row in Page, -1 for none
+                        QVector<toQValue> Page;
+                };
+
+            private:
+                friend class toResultStore;
+
+                /** Text of an in-memory cell (phys < Resident) */
+                QString residentText(int phys, int col) const;
+
+                struct TextColumn
+                {
+                    ColumnType Type;
+                    QVector<qint64> Ints;
+                    QVector<double> Doubles;
+                    QVector<quint16> Codes;
+                    QVector<QString> Dictionary;
+                    QString Chars;
+                    QVector<int> Offsets;
+                    QVector<QString> Texts;         // VariantColumn cells converted to text
+                    QVector<quint32> Nulls;
+                };
+
+                std::vector<TextColumn> Columns;
+                int Resident;
+                int Rows;
+                QHash<quint64, QString> Edited;
+                QSharedPointer<toResultSpill::Reader> Spilled;
+        };
+
+        toResultStore();
+
+        /** Number of rows in logical order (including rows marked as REMOVED) */
+        inline int rows(void) const
+        {
+            return Order.size();
+        }
+
+        /** Number of rows including the ones hidden by setVisible() */
+        inline int totalRows(void) const
+        {
+            return AllRows.size();
+        }
+
+        inline int columns(void) const
+        {
+            return (int) Columns.size();
+        }
+
+        void clear(void);
+
+        /** Approximate size of the data held in memory */
+        size_t byteSize(void) const;
+
+        /** Size of the rows written into the temporary file */
+        qint64 spilledSize(void) const;
+
+        /** Number of rows written into the temporary file */
+        int spilledRows(void) const;
+
+        /** Memory size (bytes) after which the rows are written to disk, 0 = never */
+        void setSpillThreshold(qint64 bytes);
+
+        ColumnType columnType(int col) const;
+
+        /** Append all the rows from the batch, each row gets its own key */
+        void appendBatch(toQueryBatch &batch, int &currRowKey);
+
+        /** Append a row of cells (without the row description column) */
+        void appendRow(toRowDesc const &desc, toQueryAbstr::Row const &cells);
+
+        /** Insert an empty (all nulls) row at the logical position row */
+        void insertRow(int row, toRowDesc const &desc);
+
+        /** Remove row from the logical order */
+        void removeRow(int row);
+
+        toRowDesc const& rowDesc(int row) const;
+        void setRowDesc(int row, toRowDesc const &desc);
+
+        bool isNull(int row, int col) const;
+
+        /** True if the cell holds a complex type (LOB, cursor, ...) */
+        bool isComplex(int row, int col) const;
+
+        /** Return the stored cell if the cell is held as toQValue
+         * (complex types, binary data, edited cells), NULL otherwise.
+         * Use this to access complex types, they can not be copied.
+         */
+        toQValue const* cell(int row, int col) const;
+
+        /** Box the cell into toQValue.
+         * Complex types are not copied (see @ref toQValue copy constructor),
+         * their display text is returned instead.
+         */
+        toQValue value(int row, int col) const;
+
+        /** Set the cell value in the edit overlay */
+        void setValue(int row, int col, toQValue const &value);
+
+        /** Materialize the whole row, column 0 holds the row description */
+        toQueryAbstr::Row row(int row) const;
+
+        /** Logical to physical row mapping of the visible rows */
+        inline QVector<int> const& order(void) const
+        {
+            return Order;
+        }
+
+        /** Set the order of all the rows (including hidden ones),
+         * new order must be a permutation of the current one
+         */
+        void setOrder(QVector<int> const &order);
+
+        /** Hide the rows, visible bit for each physical row.
+         * Rows behind the end of visible stay visible, an empty array shows all the rows.
+         */
+        void setVisible(QBitArray const &visible);
+
+        inline bool isFiltered(void) const
+        {
+            return !Visible.isEmpty();
+        }
+
+        /** Take a read only copy of the data (call from the thread owning the store) */
+        Snapshot snapshot(void) const;
+
+        /** Stable sort of all the rows by the columns (the first one is the primary key).
+         * Typed keys are extracted from the columns first, then the row index is sorted
+         * in parallel.
+         * @return new order to be passed to setOrder()
+         */
+        QVector<int> sortedOrder(QList<SortColumn> const &columns) const;
+
+    private:
+        struct Column
+        {
+            Column();
+
+            ColumnType Type;
+            bool LongInts;                  // box IntColumn values as qlonglong (as they were read)
+            QVector<qint64> Ints;
+            QVector<double> Doubles;
+            QVector<quint16> Codes;         // DictColumn codes
+            QVector<QString> Dictionary;
+            QHash<QString, quint16> DictionaryIndex;
+            QString Chars;                  // string arena
+            QVector<int> Offsets;           // Offsets[row] .. Offsets[row+1]
+            std::vector<toQValue> Variants;
+            QVector<quint32> Nulls;         // bit set for NULL cells
+            int Size;                       // number of cells in this column
+        };
+
+        static inline quint64 overlayKey(int phys, int col)
+        {
+            return (quint64(phys) << 32) | quint32(col);
+        }
+
+        struct SortKey;
+        struct SortLess;
+        void extractKey(SortColumn const &column, SortKey &key) const;
+
+        void ensureColumns(int cols);
+        void startSpill(void);
+        void appendColumns(toQueryBatch &batch);
+        inline int physical(int row) const
+        {
+            return Order.at(row);
+        }
+        toQValue const* cellAt(int phys, int col) const;
+        toQValue valueAt(int phys, int col) const;
+        void updateVisibleOrder(void);
+
+        static void prepare(Column &c, ColumnType type);
+        static void pushNull(Column &c);
+        static void pushInt(Column &c, qint64 value, bool isLong);
+        static void pushDouble(Column &c, double value);
+        static void pushString(Column &c, QString const &value);
+        static void pushVariant(Column &c, toQValue const &value);
+        static void pushValue(Column &c, toQValue const &value);
+        static void pushNotNull(Column &c);
+        static bool isNull(Column const &c, int phys);
+        static toQValue boxed(Column const &c, int phys);
+        static void toArena(Column &c);
+        static bool toDouble(Column &c);
+        static void toVariant(Column &c);
+
+        std::vector<Column> Columns;
+        int Resident;                       // physical rows held by Columns, the rest is in Spill
+        QScopedPointer<toResultSpill> Spill;
+        qint64 SpillThreshold;
+        bool SpillFailed;
+        QVector<toRowDesc> RowDescs;        // indexed by physical row
+        QVector<int> AllRows;               // all the rows (including hidden ones) in logical order
+        QVector<int> Order;                 // logical row => physical row, visible rows only
+        QBitArray Visible;                  // by physical row, empty = all visible
+        QHash<quint64, toQValue> Overlay;   // edited cells
+};
+
+#endif